@@ -28,6 +28,7 @@
 #include "itkLimiterFunctionBase.h"
 #include "itkFixedArray.h"
 #include "itkAdvancedTransform.h"
+#include "itkSampleTransformCache.h"
 #include "vnl/vnl_sparse_matrix.h"
 
 #include "itkImageMaskSpatialObject.h"
@@ -35,8 +36,14 @@
 // Needed for checking for B-spline for faster implementation
 #include "itkAdvancedBSplineDeformableTransform.h"
 #include "itkAdvancedCombinationTransform.h"
+#include "itkImageFullSampler.h"
+#include "itkImageGridSampler.h"
 
 #include "itkPlatformMultiThreader.h"
+#include "itkPoolMultiThreader.h"
+
+#include <atomic>
+#include <vector>
 
 namespace itk
 {
@@ -153,15 +160,23 @@ public:
   typedef typename TransformType::ScalarType                                       ScalarType;
   typedef AdvancedTransform<ScalarType, FixedImageDimension, MovingImageDimension> AdvancedTransformType;
   typedef typename AdvancedTransformType::NumberOfParametersType                   NumberOfParametersType;
+  typedef typename AdvancedTransformType::MovingImageGradientType                  TransformMovingImageGradientType;
+
+  /** Cache of mapped points and transform Jacobians, which can be shared between metrics. */
+  typedef SampleTransformCache<ScalarType, FixedImageDimension, MovingImageDimension> SampleTransformCacheType;
+  typedef typename SampleTransformCacheType::Pointer                                  SampleTransformCachePointer;
 
   /** Typedef's for the B-spline transform. */
-  typedef AdvancedCombinationTransform<ScalarType, FixedImageDimension>          CombinationTransformType;
-  typedef AdvancedBSplineDeformableTransform<ScalarType, FixedImageDimension, 1> BSplineOrder1TransformType;
-  typedef AdvancedBSplineDeformableTransform<ScalarType, FixedImageDimension, 2> BSplineOrder2TransformType;
-  typedef AdvancedBSplineDeformableTransform<ScalarType, FixedImageDimension, 3> BSplineOrder3TransformType;
-  typedef typename BSplineOrder1TransformType::Pointer                           BSplineOrder1TransformPointer;
-  typedef typename BSplineOrder2TransformType::Pointer                           BSplineOrder2TransformPointer;
-  typedef typename BSplineOrder3TransformType::Pointer                           BSplineOrder3TransformPointer;
+  typedef AdvancedCombinationTransform<ScalarType, FixedImageDimension>           CombinationTransformType;
+  typedef AdvancedBSplineDeformableTransform<ScalarType, FixedImageDimension, 1>  BSplineOrder1TransformType;
+  typedef AdvancedBSplineDeformableTransform<ScalarType, FixedImageDimension, 2>  BSplineOrder2TransformType;
+  typedef AdvancedBSplineDeformableTransform<ScalarType, FixedImageDimension, 3>  BSplineOrder3TransformType;
+  typedef typename BSplineOrder1TransformType::Pointer                            BSplineOrder1TransformPointer;
+  typedef typename BSplineOrder2TransformType::Pointer                            BSplineOrder2TransformPointer;
+  typedef typename BSplineOrder3TransformType::Pointer                            BSplineOrder3TransformPointer;
+  typedef AdvancedBSplineDeformableTransformBase<ScalarType, FixedImageDimension> BSplineBaseTransformType;
+  typedef typename BSplineBaseTransformType::IndexType                            BSplineSupportIndexType;
+  typedef typename BSplineBaseTransformType::FixedParametersType                  BSplineGridParametersType;
 
   /** Hessian type; for SelfHessian (experimental feature) */
   typedef typename DerivativeType::ValueType  HessianValueType;
@@ -170,6 +185,7 @@ public:
   /** Typedefs for multi-threading. */
   typedef itk::PlatformMultiThreader          ThreaderType;
   typedef typename ThreaderType::WorkUnitInfo ThreadInfoType;
+  typedef itk::PoolMultiThreader              ThreadPoolType;
 
   /** Public methods ********************/
 
@@ -278,12 +294,91 @@ public:
   itkGetConstReferenceMacro(UseMetricSingleThreaded, bool);
   itkBooleanMacro(UseMetricSingleThreaded);
 
+  /** Tells if GetValueAndDerivative() may run concurrently with other metrics that share the
+   * transform and image sampler, once BeforeThreadedGetValueAndDerivative() has been called with
+   * UseMetricSingleThreaded on. This holds for the metrics that do not set the transform
+   * parameters or update the image sampler anywhere else. Default: false.
+   */
+  virtual bool
+  CanBeEvaluatedConcurrently(void) const
+  {
+    return false;
+  }
+
   /** Select the use of multi-threading*/
   // \todo: maybe these can be united, check base class.
   itkSetMacro(UseMultiThread, bool);
   itkGetConstReferenceMacro(UseMultiThread, bool);
   itkBooleanMacro(UseMultiThread);
 
+  /** Select the use of a persistent thread pool for the multi-threaded computations.
+   * When switched on, the work units are handed to the (global) ITK thread pool,
+   * whose threads remain parked between iterations. The image sampler shares the
+   * same pool. When switched off, threads are spawned and joined at every launch.
+   */
+  itkSetMacro(UseThreadPool, bool);
+  itkGetConstReferenceMacro(UseThreadPool, bool);
+  itkBooleanMacro(UseThreadPool);
+
+  /** Select dynamic scheduling of the samples over the threads.
+   * By default the sample container is split into equal contiguous blocks, one
+   * per thread. With dynamic scheduling the threads repeatedly claim chunks of
+   * samples from a shared counter, until all samples are processed. This balances
+   * the load when the cost per sample varies, e.g. near mask borders or for
+   * samples that map outside the moving image. Note that the order in which the
+   * per-sample contributions are summed then differs from run to run.
+   */
+  itkSetMacro(UseDynamicSampleScheduling, bool);
+  itkGetConstReferenceMacro(UseDynamicSampleScheduling, bool);
+  itkBooleanMacro(UseDynamicSampleScheduling);
+
+  /** Set/Get the number of samples per chunk for dynamic scheduling.
+   * When set to 0 (default), about eight chunks per thread are used. */
+  itkSetMacro(SampleChunkSize, SizeValueType);
+  itkGetConstMacro(SampleChunkSize, SizeValueType);
+
+  /** Select single precision for the per-thread derivatives of the multi-threaded GetValueAndDerivative().
+   * This halves the memory of the per-thread derivative arrays, and the memory traffic of accumulating
+   * them, which dominates for transforms with millions of parameters. The contribution of each sample
+   * is still computed in double precision, but it is rounded to single precision every time it is added
+   * to a per-thread derivative. The rounding errors therefore add up with the number of samples that a
+   * thread adds to a parameter: with n samples the relative error may grow to about n * 2^-24, or
+   * sqrt(n) * 2^-24 for errors of random sign. Only the sum over the threads is computed in double precision.
+   * Only used by metrics that support it, see GetSupportsSinglePrecisionThreadDerivatives().
+   * Should be set before Initialize(). Default: false.
+   */
+  itkSetMacro(UseSinglePrecisionThreadDerivatives, bool);
+  itkGetConstReferenceMacro(UseSinglePrecisionThreadDerivatives, bool);
+  itkBooleanMacro(UseSinglePrecisionThreadDerivatives);
+
+  /** Whether this metric accumulates its per-thread derivatives in single precision when
+   * UseSinglePrecisionThreadDerivatives is on. Other metrics ignore that option.
+   */
+  itkGetConstReferenceMacro(SupportsSinglePrecisionThreadDerivatives, bool);
+
+  /** Set/Get a cache of mapped points and transform Jacobians that is shared with other metrics
+   * using the same image sampler. The owner of the cache is responsible for synchronizing it with
+   * the samples and the transform parameters before the metric is evaluated. Default: nullptr.
+   */
+  itkSetObjectMacro(SampleTransformCache, SampleTransformCacheType);
+  itkGetModifiableObjectMacro(SampleTransformCache, SampleTransformCacheType);
+
+  /** Select the use of precomputed B-spline weights. The full and grid samplers return the
+   * same samples in every iteration. When such a sampler is combined with a B-spline transform,
+   * the support start index and the one-dimensional B-spline weights of every sample are then
+   * computed once per resolution, instead of in every iteration. Ignored for other samplers and
+   * transforms. Default: false.
+   */
+  itkSetMacro(UsePrecomputedBSplineWeights, bool);
+  itkGetConstReferenceMacro(UsePrecomputedBSplineWeights, bool);
+  itkBooleanMacro(UsePrecomputedBSplineWeights);
+
+  /** Set/Get the maximum number of one-dimensional weights that are precomputed, to limit
+   * the memory use. When more are needed, the weights are not precomputed. Default: 2^25.
+   */
+  itkSetMacro(MaximumNumberOfPrecomputedBSplineWeights, SizeValueType);
+  itkGetConstMacro(MaximumNumberOfPrecomputedBSplineWeights, SizeValueType);
+
   /** Contains calls from GetValueAndDerivative that are thread-unsafe,
    * together with preparation for multi-threading.
    * Note that the only reason why this function is not protected, is
@@ -410,10 +505,61 @@ protected:
   static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
   AccumulateDerivativesThreaderCallback(void * arg);
 
+  /** Launch a threader callback, using the thread pool when UseThreadPool is on,
+   * or otherwise using the platform threader. All work units receive arg as user data.
+   */
+  void
+  LaunchThreaderCallback(ThreadFunctionType callback, void * arg) const;
+
+  /** Get the next range [pos_begin, pos_end[ of the sample container that
+   * thread threadId should process. Returns false when no samples are left.
+   * Set firstRange to true before the first call; it is updated by this function.
+   * With static scheduling each thread receives a single contiguous block,
+   * with dynamic scheduling chunks are claimed until all samples are taken.
+   */
+  bool
+  GetNextSampleRange(ThreadIdType    threadId,
+                     unsigned long   numberOfSamples,
+                     bool &          firstRange,
+                     unsigned long & pos_begin,
+                     unsigned long & pos_end) const;
+
   /** Variables for multi-threading. */
-  bool m_UseMetricSingleThreaded;
-  bool m_UseMultiThread;
-  bool m_UseOpenMP;
+  bool                    m_UseMetricSingleThreaded;
+  bool                    m_UseMultiThread;
+  bool                    m_UseOpenMP;
+  bool                    m_UseThreadPool;
+  ThreadPoolType::Pointer m_ThreadPool;
+  bool                    m_UseDynamicSampleScheduling;
+  SizeValueType           m_SampleChunkSize;
+
+  /** Single precision per-thread derivatives. Metrics that accumulate their derivatives in
+   * st_SinglePrecisionDerivative instead of st_Derivative set m_SupportsSinglePrecisionThreadDerivatives.
+   */
+  bool m_UseSinglePrecisionThreadDerivatives;
+  bool m_SupportsSinglePrecisionThreadDerivatives;
+
+  /** The cache of mapped points and transform Jacobians, shared with other metrics. */
+  SampleTransformCachePointer m_SampleTransformCache;
+
+  /** The table of precomputed B-spline weights. m_PrecomputedWeightsTransform is nullptr when
+   * the table is not in use. The remaining members identify the samples and the B-spline grid
+   * for which the table was built.
+   */
+  bool                                         m_UsePrecomputedBSplineWeights;
+  SizeValueType                                m_MaximumNumberOfPrecomputedBSplineWeights;
+  mutable const BSplineBaseTransformType *     m_PrecomputedWeightsTransform;
+  mutable const DataObject *                   m_PrecomputedWeightsSampleContainer;
+  mutable ModifiedTimeType                     m_PrecomputedWeightsSampleContainerMTime;
+  mutable BSplineGridParametersType            m_PrecomputedWeightsGridParameters;
+  mutable unsigned int                         m_NumberOfPrecomputedWeights;
+  mutable std::vector<BSplineSupportIndexType> m_PrecomputedSupportIndices;
+  mutable std::vector<double>                  m_PrecomputedWeights;
+  mutable std::vector<unsigned char>           m_PrecomputedWeightsInside;
+  mutable std::vector<FixedImagePointType>     m_PrecomputedBSplinePoints;
+
+  /** Shared counter from which the threads claim sample chunks; reset at every launch. */
+  mutable std::atomic<unsigned long> m_SampleRangeCounter;
 
   /** Helper structs that multi-threads the computation of
    * the metric derivative using ITK threads.
@@ -449,11 +595,17 @@ protected:
   mutable ThreadIdType                     m_GetValuePerThreadVariablesSize;
 
   // test per thread struct with padding and alignment
+  typedef Array<float> SinglePrecisionDerivativeType;
   struct GetValueAndDerivativePerThreadStruct
   {
-    SizeValueType  st_NumberOfPixelsCounted;
-    MeasureType    st_Value;
-    DerivativeType st_Derivative;
+    SizeValueType                 st_NumberOfPixelsCounted;
+    MeasureType                   st_Value;
+    DerivativeType                st_Derivative;
+    SinglePrecisionDerivativeType st_SinglePrecisionDerivative;
+
+    /** Scratch space for the image Jacobians of a batch of samples, reused over the iterations. */
+    std::vector<DerivativeType>             st_BatchImageJacobians;
+    std::vector<NonZeroJacobianIndicesType> st_BatchNonZeroJacobianIndices;
   };
   itkPadStruct(ITK_CACHE_LINE_ALIGNMENT,
                GetValueAndDerivativePerThreadStruct,
@@ -468,6 +620,13 @@ protected:
   virtual void
   InitializeThreadingParameters(void) const;
 
+  /** Whether the per-thread derivatives are accumulated in st_SinglePrecisionDerivative. */
+  bool
+  GetUseSinglePrecisionThreadDerivativesInternal(void) const
+  {
+    return this->m_UseSinglePrecisionThreadDerivatives && this->m_SupportsSinglePrecisionThreadDerivatives;
+  }
+
   /** Protected methods ************** */
 
   /** Methods for image sampler support **********/
@@ -534,6 +693,42 @@ protected:
   virtual bool
   TransformPoint(const FixedImagePointType & fixedImagePoint, MovingImagePointType & mappedPoint) const;
 
+  /** The maximum number of samples that the threaded loops pass to the batched transform functions at once. */
+  itkStaticConstMacro(SampleBatchSize, unsigned int, 64);
+
+  /** Transform a batch of points from FixedImage domain to MovingImage domain.
+   * For advanced transforms this calls the batched TransformPoints() of the transform,
+   * which shares the setup costs between the points.
+   */
+  virtual void
+  TransformPoints(const FixedImagePointType * fixedImagePoints,
+                  MovingImagePointType *      mappedPoints,
+                  SizeValueType               numberOfPoints) const;
+
+  /** Transform the point of a sample, identified by its index in the sample container.
+   * If a sample transform cache has been set, the mapped point is looked up in, or stored in, the cache.
+   */
+  bool
+  TransformSamplePoint(SizeValueType               sampleIndex,
+                       const FixedImagePointType & fixedImagePoint,
+                       MovingImagePointType &      mappedPoint) const;
+
+  /** Transform the points of a batch of consecutive samples, starting at sample firstSampleIndex.
+   * If a sample transform cache has been set, the mapped points are looked up in, or stored in, the cache.
+   */
+  void
+  TransformSamplePoints(SizeValueType               firstSampleIndex,
+                        const FixedImagePointType * fixedImagePoints,
+                        MovingImagePointType *      mappedPoints,
+                        SizeValueType               numberOfPoints) const;
+
+  /** Transform the point of a sample using its precomputed B-spline weights, see GetPrecomputedBSplineWeights(). */
+  void
+  TransformSamplePointUsingPrecomputedBSplineWeights(SizeValueType               sampleIndex,
+                                                     const FixedImagePointType & fixedImagePoint,
+                                                     const double *              weights1D,
+                                                     MovingImagePointType &      mappedPoint) const;
+
   /** This function returns a reference to the transform Jacobians.
    * This is either a reference to the full TransformJacobian or
    * a reference to a sparse Jacobians.
@@ -545,6 +740,63 @@ protected:
                             TransformJacobianType &      jacobian,
                             NonZeroJacobianIndicesType & nzji) const;
 
+  /** Evaluate the transform Jacobian of a sample, identified by its index in the sample container.
+   * If a sample transform cache has been set, the Jacobian is looked up in, or stored in, the cache.
+   */
+  bool
+  EvaluateSampleTransformJacobian(SizeValueType                sampleIndex,
+                                  const FixedImagePointType &  fixedImagePoint,
+                                  TransformJacobianType &      jacobian,
+                                  NonZeroJacobianIndicesType & nzji) const;
+
+  /** Compute the inner product of the transform Jacobian of a sample with the moving image gradient.
+   * Without a sample transform cache this calls EvaluateJacobianWithImageGradientProduct() of the
+   * transform. With a cache, the product is computed from the cached Jacobian; the jacobian argument
+   * is used as workspace when the Jacobian has not been cached yet.
+   */
+  void
+  EvaluateSampleTransformJacobianWithImageGradientProduct(SizeValueType                     sampleIndex,
+                                                          const FixedImagePointType &       fixedImagePoint,
+                                                          const MovingImageDerivativeType & movingImageDerivative,
+                                                          TransformJacobianType &           jacobian,
+                                                          DerivativeType &                  imageJacobian,
+                                                          NonZeroJacobianIndicesType &      nzji) const;
+
+  /** Batched version of EvaluateSampleTransformJacobianWithImageGradientProduct(), for the samples with the
+   * given indices. Without a sample transform cache that stores Jacobians and without precomputed B-spline
+   * weights, all products are computed by one call to EvaluateJacobianWithImageGradientProducts() of the
+   * transform. Otherwise they are computed sample by sample, from the cache or the precomputed weights.
+   */
+  void
+  EvaluateSampleTransformJacobiansWithImageGradientProducts(
+    const SizeValueType *                    sampleIndices,
+    const FixedImagePointType *              fixedImagePoints,
+    const TransformMovingImageGradientType * movingImageDerivatives,
+    TransformJacobianType &                  jacobian,
+    DerivativeType *                         imageJacobians,
+    NonZeroJacobianIndicesType *             nzjis,
+    SizeValueType                            numberOfSamples) const;
+
+  /** Build the table of precomputed B-spline weights, if it is requested and not up-to-date.
+   * Called by BeforeThreadedGetValueAndDerivative(), after the image sampler has been updated.
+   */
+  virtual void
+  UpdatePrecomputedBSplineWeights(void) const;
+
+  /** Return the precomputed one-dimensional B-spline weights of a sample, or nullptr
+   * when they are not available, e.g. because the support region is outside the grid.
+   */
+  const double *
+  GetPrecomputedBSplineWeights(SizeValueType sampleIndex) const
+  {
+    if (this->m_PrecomputedWeightsTransform == nullptr || sampleIndex >= this->m_PrecomputedWeightsInside.size() ||
+        !this->m_PrecomputedWeightsInside[sampleIndex])
+    {
+      return nullptr;
+    }
+    return &this->m_PrecomputedWeights[sampleIndex * this->m_NumberOfPrecomputedWeights];
+  }
+
   /** Convenience method: check if point is inside the moving mask. *****************/
   virtual bool
   IsInsideMovingMask(const MovingImagePointType & point) const;
@@ -86,6 +86,21 @@ AdvancedImageToImageMetric<TFixedImage, TMovingImage>::AdvancedImageToImageMetri
   /** Threading related variables. */
   this->m_UseMetricSingleThreaded = true;
   this->m_UseMultiThread = false;
+  this->m_UseThreadPool = false;
+  this->m_ThreadPool = nullptr;
+  this->m_UseDynamicSampleScheduling = false;
+  this->m_SampleChunkSize = 0;
+  this->m_SampleRangeCounter = 0;
+  this->m_UseSinglePrecisionThreadDerivatives = false;
+  this->m_SupportsSinglePrecisionThreadDerivatives = false;
+
+  /** Precomputed B-spline weights. */
+  this->m_UsePrecomputedBSplineWeights = false;
+  this->m_MaximumNumberOfPrecomputedBSplineWeights = 1 << 25;
+  this->m_PrecomputedWeightsTransform = nullptr;
+  this->m_PrecomputedWeightsSampleContainer = nullptr;
+  this->m_PrecomputedWeightsSampleContainerMTime = 0;
+  this->m_NumberOfPrecomputedWeights = 0;
 
   /** OpenMP related. Switch to on when available */
 #ifdef ELASTIX_USE_OPENMP
@@ -166,12 +181,45 @@ AdvancedImageToImageMetric<TFixedImage, TMovingImage>::Initialize(void)
   /** Check if the transform is a B-spline transform. */
   this->CheckForBSplineTransform();
 
+  /** The B-spline grid may change between resolutions, so rebuild the precomputed weights. */
+  this->m_PrecomputedWeightsTransform = nullptr;
+  this->m_PrecomputedWeightsSampleContainer = nullptr;
+
   /** Initialize some threading related parameters. */
   if (this->m_UseMultiThread)
   {
     this->InitializeThreadingParameters();
   }
 
+  /** Create the threader that dispatches work to the persistent thread pool.
+   * The pool itself is a process-wide singleton, so all metrics, samplers,
+   * and other users of a PoolMultiThreader share the same parked threads.
+   */
+  if (this->m_UseThreadPool)
+  {
+    if (this->m_ThreadPool.IsNull())
+    {
+      this->m_ThreadPool = ThreadPoolType::New();
+    }
+
+    /** Let the image sampler use the thread pool as well. */
+    if (this->GetUseImageSampler() && this->m_ImageSampler->GetMultiThreader() != this->m_ThreadPool.GetPointer())
+    {
+      this->m_ImageSampler->SetMultiThreader(this->m_ThreadPool);
+    }
+  }
+  else if (this->m_ThreadPool.IsNotNull())
+  {
+    /** The thread pool was switched off again: give the image sampler back a platform threader. */
+    if (this->GetUseImageSampler() && this->m_ImageSampler->GetMultiThreader() == this->m_ThreadPool.GetPointer())
+    {
+      const ThreadIdType numberOfWorkUnits = this->m_ImageSampler->GetMultiThreader()->GetNumberOfWorkUnits();
+      this->m_ImageSampler->SetMultiThreader(PlatformMultiThreader::New());
+      this->m_ImageSampler->GetMultiThreader()->SetNumberOfWorkUnits(numberOfWorkUnits);
+    }
+    this->m_ThreadPool = nullptr;
+  }
+
 } // end Initialize()
 
 
@@ -219,9 +267,16 @@ AdvancedImageToImageMetric<TFixedImage, TMovingImage>::InitializeThreadingParame
 
     this->m_GetValueAndDerivativePerThreadVariables[i].st_NumberOfPixelsCounted = NumericTraits<SizeValueType>::Zero;
     this->m_GetValueAndDerivativePerThreadVariables[i].st_Value = NumericTraits<MeasureType>::Zero;
-    this->m_GetValueAndDerivativePerThreadVariables[i].st_Derivative.SetSize(this->GetNumberOfParameters());
+
+    /** Only allocate the derivative of the selected precision. */
+    const unsigned int numberOfParameters = this->GetNumberOfParameters();
+    const bool         singlePrecision = this->GetUseSinglePrecisionThreadDerivativesInternal();
+    this->m_GetValueAndDerivativePerThreadVariables[i].st_Derivative.SetSize(singlePrecision ? 0 : numberOfParameters);
     this->m_GetValueAndDerivativePerThreadVariables[i].st_Derivative.Fill(
       NumericTraits<DerivativeValueType>::ZeroValue());
+    this->m_GetValueAndDerivativePerThreadVariables[i].st_SinglePrecisionDerivative.SetSize(
+      singlePrecision ? numberOfParameters : 0);
+    this->m_GetValueAndDerivativePerThreadVariables[i].st_SinglePrecisionDerivative.Fill(0.0f);
   }
 
 } // end InitializeThreadingParameters()
@@ -747,6 +802,31 @@ AdvancedImageToImageMetric<TFixedImage, TMovingImage>::TransformPoint(const Fixe
 } // end TransformPoint()
 
 
+/**
+ * ********************** TransformPoints ************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+AdvancedImageToImageMetric<TFixedImage, TMovingImage>::TransformPoints(const FixedImagePointType * fixedImagePoints,
+                                                                       MovingImagePointType *      mappedPoints,
+                                                                       SizeValueType               numberOfPoints) const
+{
+  if (this->m_TransformIsAdvanced)
+  {
+    this->m_AdvancedTransform->TransformPoints(fixedImagePoints, mappedPoints, numberOfPoints);
+  }
+  else
+  {
+    for (SizeValueType i = 0; i < numberOfPoints; ++i)
+    {
+      this->TransformPoint(fixedImagePoints[i], mappedPoints[i]);
+    }
+  }
+
+} // end TransformPoints()
+
+
 /**
  * *************** EvaluateTransformJacobian ****************
  */
@@ -768,6 +848,279 @@ AdvancedImageToImageMetric<TFixedImage, TMovingImage>::EvaluateTransformJacobian
 } // end EvaluateTransformJacobian()
 
 
+/**
+ * ********************** TransformSamplePoint ************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+bool
+AdvancedImageToImageMetric<TFixedImage, TMovingImage>::TransformSamplePoint(
+  SizeValueType               sampleIndex,
+  const FixedImagePointType & fixedImagePoint,
+  MovingImagePointType &      mappedPoint) const
+{
+  /** Look up the mapped point in the cache, if any. */
+  SampleTransformCacheType * cache = this->m_SampleTransformCache.GetPointer();
+  if (cache != nullptr && cache->GetMappedPoint(sampleIndex, mappedPoint))
+  {
+    return true;
+  }
+
+  /** Compute the mapped point, using the precomputed B-spline weights if available. */
+  bool           valid = true;
+  const double * weights1D = this->GetPrecomputedBSplineWeights(sampleIndex);
+  if (weights1D != nullptr)
+  {
+    this->TransformSamplePointUsingPrecomputedBSplineWeights(sampleIndex, fixedImagePoint, weights1D, mappedPoint);
+  }
+  else
+  {
+    valid = this->TransformPoint(fixedImagePoint, mappedPoint);
+  }
+
+  /** Store it in the cache, if any. */
+  if (cache != nullptr)
+  {
+    cache->SetMappedPoint(sampleIndex, mappedPoint);
+  }
+  return valid;
+
+} // end TransformSamplePoint()
+
+
+/**
+ * ********************** TransformSamplePoints ************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+AdvancedImageToImageMetric<TFixedImage, TMovingImage>::TransformSamplePoints(
+  SizeValueType               firstSampleIndex,
+  const FixedImagePointType * fixedImagePoints,
+  MovingImagePointType *      mappedPoints,
+  SizeValueType               numberOfPoints) const
+{
+  /** With precomputed B-spline weights there is nothing to share between the points of the batch. */
+  if (this->m_PrecomputedWeightsTransform != nullptr)
+  {
+    for (SizeValueType i = 0; i < numberOfPoints; ++i)
+    {
+      this->TransformSamplePoint(firstSampleIndex + i, fixedImagePoints[i], mappedPoints[i]);
+    }
+    return;
+  }
+
+  SampleTransformCacheType * cache = this->m_SampleTransformCache.GetPointer();
+  if (cache == nullptr)
+  {
+    this->TransformPoints(fixedImagePoints, mappedPoints, numberOfPoints);
+    return;
+  }
+
+  /** Look up the mapped points. If any of them is missing, the whole batch is
+   * transformed at once, which is cheaper than transforming the points one by one.
+   */
+  bool allCached = true;
+  for (SizeValueType i = 0; i < numberOfPoints && allCached; ++i)
+  {
+    allCached = cache->GetMappedPoint(firstSampleIndex + i, mappedPoints[i]);
+  }
+  if (allCached)
+  {
+    return;
+  }
+
+  this->TransformPoints(fixedImagePoints, mappedPoints, numberOfPoints);
+  for (SizeValueType i = 0; i < numberOfPoints; ++i)
+  {
+    cache->SetMappedPoint(firstSampleIndex + i, mappedPoints[i]);
+  }
+
+} // end TransformSamplePoints()
+
+
+/**
+ * ********************** TransformSamplePointUsingPrecomputedBSplineWeights ************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+AdvancedImageToImageMetric<TFixedImage, TMovingImage>::TransformSamplePointUsingPrecomputedBSplineWeights(
+  SizeValueType               sampleIndex,
+  const FixedImagePointType & fixedImagePoint,
+  const double *              weights1D,
+  MovingImagePointType &      mappedPoint) const
+{
+  /** The B-spline is evaluated at the point mapped by the initial transform, if any. */
+  const FixedImagePointType & bsplinePoint = this->m_PrecomputedBSplinePoints.empty()
+                                               ? fixedImagePoint
+                                               : this->m_PrecomputedBSplinePoints[sampleIndex];
+
+  typename BSplineBaseTransformType::OutputPointType outputPoint;
+  this->m_PrecomputedWeightsTransform->TransformPointUsingPrecomputedWeights(
+    bsplinePoint, this->m_PrecomputedSupportIndices[sampleIndex], weights1D, outputPoint);
+  for (unsigned int d = 0; d < MovingImageDimension; ++d)
+  {
+    mappedPoint[d] = outputPoint[d];
+  }
+
+} // end TransformSamplePointUsingPrecomputedBSplineWeights()
+
+
+/**
+ * *************** EvaluateSampleTransformJacobian ****************
+ */
+
+template <class TFixedImage, class TMovingImage>
+bool
+AdvancedImageToImageMetric<TFixedImage, TMovingImage>::EvaluateSampleTransformJacobian(
+  SizeValueType                sampleIndex,
+  const FixedImagePointType &  fixedImagePoint,
+  TransformJacobianType &      jacobian,
+  NonZeroJacobianIndicesType & nzji) const
+{
+  /** Look up the Jacobian in the cache, if any. */
+  SampleTransformCacheType * cache = this->m_SampleTransformCache.GetPointer();
+  if (cache != nullptr && cache->GetJacobian(sampleIndex, jacobian, nzji))
+  {
+    return true;
+  }
+
+  /** Compute the Jacobian, using the precomputed B-spline weights if available. */
+  bool           valid = true;
+  const double * weights1D = this->GetPrecomputedBSplineWeights(sampleIndex);
+  if (weights1D != nullptr)
+  {
+    this->m_PrecomputedWeightsTransform->GetJacobianUsingPrecomputedWeights(
+      this->m_PrecomputedSupportIndices[sampleIndex], weights1D, jacobian, nzji);
+  }
+  else
+  {
+    valid = this->EvaluateTransformJacobian(fixedImagePoint, jacobian, nzji);
+  }
+
+  /** Store it in the cache, if any. */
+  if (cache != nullptr)
+  {
+    cache->SetJacobian(sampleIndex, jacobian, nzji);
+  }
+  return valid;
+
+} // end EvaluateSampleTransformJacobian()
+
+
+/**
+ * *************** EvaluateSampleTransformJacobianWithImageGradientProduct ****************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+AdvancedImageToImageMetric<TFixedImage, TMovingImage>::EvaluateSampleTransformJacobianWithImageGradientProduct(
+  SizeValueType                     sampleIndex,
+  const FixedImagePointType &       fixedImagePoint,
+  const MovingImageDerivativeType & movingImageDerivative,
+  TransformJacobianType &           jacobian,
+  DerivativeType &                  imageJacobian,
+  NonZeroJacobianIndicesType &      nzji) const
+{
+  SampleTransformCacheType * cache = this->m_SampleTransformCache.GetPointer();
+  if (cache == nullptr || !cache->GetCachesJacobians())
+  {
+    const double * weights1D = this->GetPrecomputedBSplineWeights(sampleIndex);
+    if (weights1D != nullptr)
+    {
+      typename BSplineBaseTransformType::MovingImageGradientType movingImageGradient;
+      for (unsigned int d = 0; d < FixedImageDimension; ++d)
+      {
+        movingImageGradient[d] = movingImageDerivative[d];
+      }
+      this->m_PrecomputedWeightsTransform->EvaluateJacobianWithImageGradientProductUsingPrecomputedWeights(
+        this->m_PrecomputedSupportIndices[sampleIndex], weights1D, movingImageGradient, imageJacobian, nzji);
+    }
+    else
+    {
+      this->m_AdvancedTransform->EvaluateJacobianWithImageGradientProduct(
+        fixedImagePoint, movingImageDerivative, imageJacobian, nzji);
+    }
+    return;
+  }
+
+  /** If the Jacobian has not been cached yet, compute and store it. */
+  const typename SampleTransformCacheType::JacobianValueType * cachedJacobian = cache->GetJacobian(sampleIndex, nzji);
+  if (cachedJacobian == nullptr)
+  {
+    this->EvaluateSampleTransformJacobian(sampleIndex, fixedImagePoint, jacobian, nzji);
+    this->EvaluateTransformJacobianInnerProduct(jacobian, movingImageDerivative, imageJacobian);
+    return;
+  }
+
+  /** Multiply the cached row-major dim-by-nnzji Jacobian with the moving image derivative. */
+  const unsigned int nnzji = nzji.size();
+  if (this->m_TransformIsBSpline)
+  {
+    /** The B-spline Jacobian is block diagonal, see EvaluateTransformJacobianInnerProduct(). */
+    const unsigned int numberOfParametersPerDimension = nnzji / FixedImageDimension;
+    unsigned int       counter = 0;
+    for (unsigned int dim = 0; dim < FixedImageDimension; ++dim)
+    {
+      const double imDeriv = movingImageDerivative[dim];
+      for (unsigned int mu = 0; mu < numberOfParametersPerDimension; ++mu)
+      {
+        imageJacobian[counter] = cachedJacobian[dim * nnzji + counter] * imDeriv;
+        ++counter;
+      }
+    }
+  }
+  else
+  {
+    imageJacobian.Fill(0.0);
+    for (unsigned int dim = 0; dim < FixedImageDimension; ++dim)
+    {
+      const double imDeriv = movingImageDerivative[dim];
+      for (unsigned int mu = 0; mu < nnzji; ++mu)
+      {
+        imageJacobian[mu] += cachedJacobian[dim * nnzji + mu] * imDeriv;
+      }
+    }
+  }
+
+} // end EvaluateSampleTransformJacobianWithImageGradientProduct()
+
+
+/**
+ * *************** EvaluateSampleTransformJacobiansWithImageGradientProducts ****************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+AdvancedImageToImageMetric<TFixedImage, TMovingImage>::EvaluateSampleTransformJacobiansWithImageGradientProducts(
+  const SizeValueType *                    sampleIndices,
+  const FixedImagePointType *              fixedImagePoints,
+  const TransformMovingImageGradientType * movingImageDerivatives,
+  TransformJacobianType &                  jacobian,
+  DerivativeType *                         imageJacobians,
+  NonZeroJacobianIndicesType *             nzjis,
+  SizeValueType                            numberOfSamples) const
+{
+  /** Let the transform compute all products at once, when there is nothing to reuse. */
+  const bool useCachedJacobians =
+    this->m_SampleTransformCache.IsNotNull() && this->m_SampleTransformCache->GetCachesJacobians();
+  if (!useCachedJacobians && this->m_PrecomputedWeightsTransform == nullptr)
+  {
+    this->m_AdvancedTransform->EvaluateJacobianWithImageGradientProducts(
+      fixedImagePoints, movingImageDerivatives, imageJacobians, nzjis, numberOfSamples);
+    return;
+  }
+
+  for (SizeValueType i = 0; i < numberOfSamples; ++i)
+  {
+    this->EvaluateSampleTransformJacobianWithImageGradientProduct(
+      sampleIndices[i], fixedImagePoints[i], movingImageDerivatives[i], jacobian, imageJacobians[i], nzjis[i]);
+  }
+
+} // end EvaluateSampleTransformJacobiansWithImageGradientProducts()
+
+
 /**
  * ************************** IsInsideMovingMask *************************
  */
@@ -831,9 +1184,105 @@ AdvancedImageToImageMetric<TFixedImage, TMovingImage>::BeforeThreadedGetValueAnd
     }
   }
 
+  /** The samples are up-to-date now, which is needed for the precomputed weights. */
+  this->UpdatePrecomputedBSplineWeights();
+
 } // end BeforeThreadedGetValueAndDerivative()
 
 
+/**
+ * *********************** UpdatePrecomputedBSplineWeights ***********************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+AdvancedImageToImageMetric<TFixedImage, TMovingImage>::UpdatePrecomputedBSplineWeights(void) const
+{
+  /** Only the full and grid samplers return the same samples in every iteration. */
+  typedef ImageFullSampler<FixedImageType> FullSamplerType;
+  typedef ImageGridSampler<FixedImageType> GridSamplerType;
+  const ImageSampleContainerType *         sampleContainer = nullptr;
+  if (this->m_UsePrecomputedBSplineWeights && this->m_UseImageSampler && this->m_TransformIsAdvanced &&
+      FixedImageDimension == MovingImageDimension)
+  {
+    ImageSamplerType * sampler = this->GetImageSampler();
+    if (dynamic_cast<FullSamplerType *>(sampler) != nullptr || dynamic_cast<GridSamplerType *>(sampler) != nullptr)
+    {
+      sampleContainer = sampler->GetOutput();
+    }
+  }
+
+  /** Find the B-spline transform. Like the Jacobian of the combination transform, the B-spline
+   * is evaluated at the point mapped by the initial transform, if any. Adding the initial
+   * transform is not supported.
+   */
+  typedef typename CombinationTransformType::InitialTransformType InitialTransformType;
+  const BSplineBaseTransformType *                                bsplineTransform = nullptr;
+  const InitialTransformType *                                    initialTransform = nullptr;
+  if (sampleContainer != nullptr)
+  {
+    bsplineTransform = dynamic_cast<const BSplineBaseTransformType *>(this->m_AdvancedTransform.GetPointer());
+    const CombinationTransformType * combinationTransform =
+      dynamic_cast<const CombinationTransformType *>(this->m_AdvancedTransform.GetPointer());
+    if (combinationTransform != nullptr &&
+        (combinationTransform->GetInitialTransform() == nullptr || combinationTransform->GetUseComposition()))
+    {
+      bsplineTransform = dynamic_cast<const BSplineBaseTransformType *>(combinationTransform->GetCurrentTransform());
+      initialTransform = combinationTransform->GetInitialTransform();
+    }
+  }
+
+  /** Check if the weights can be precomputed within the memory limit. */
+  const unsigned int numberOfWeights = bsplineTransform ? bsplineTransform->GetNumberOfPrecomputedWeights() : 0;
+  if (numberOfWeights == 0 ||
+      sampleContainer->Size() * numberOfWeights > this->m_MaximumNumberOfPrecomputedBSplineWeights)
+  {
+    this->m_PrecomputedWeightsTransform = nullptr;
+    return;
+  }
+
+  /** Nothing to do if the table matches the samples and the B-spline grid. */
+  if (this->m_PrecomputedWeightsTransform == bsplineTransform &&
+      this->m_PrecomputedWeightsSampleContainer == sampleContainer &&
+      this->m_PrecomputedWeightsSampleContainerMTime == sampleContainer->GetUpdateMTime() &&
+      this->m_PrecomputedWeightsGridParameters == bsplineTransform->GetFixedParameters())
+  {
+    return;
+  }
+
+  /** Build the table. */
+  const SizeValueType numberOfSamples = sampleContainer->Size();
+  this->m_PrecomputedSupportIndices.resize(numberOfSamples);
+  this->m_PrecomputedWeights.resize(numberOfSamples * numberOfWeights);
+  this->m_PrecomputedWeightsInside.resize(numberOfSamples);
+  this->m_PrecomputedBSplinePoints.resize(initialTransform ? numberOfSamples : 0);
+
+  typename ImageSampleContainerType::ConstIterator fiter;
+  typename ImageSampleContainerType::ConstIterator fbegin = sampleContainer->Begin();
+  typename ImageSampleContainerType::ConstIterator fend = sampleContainer->End();
+  for (fiter = fbegin; fiter != fend; ++fiter)
+  {
+    const SizeValueType i = fiter.Index();
+    FixedImagePointType point = fiter.Value().m_ImageCoordinates;
+    if (initialTransform)
+    {
+      point = initialTransform->TransformPoint(point);
+      this->m_PrecomputedBSplinePoints[i] = point;
+    }
+    this->m_PrecomputedWeightsInside[i] = bsplineTransform->PrecomputeWeights(
+      point, this->m_PrecomputedSupportIndices[i], &this->m_PrecomputedWeights[i * numberOfWeights]);
+  }
+
+  /** Store what the table was built for. */
+  this->m_PrecomputedWeightsTransform = bsplineTransform;
+  this->m_PrecomputedWeightsSampleContainer = sampleContainer;
+  this->m_PrecomputedWeightsSampleContainerMTime = sampleContainer->GetUpdateMTime();
+  this->m_PrecomputedWeightsGridParameters = bsplineTransform->GetFixedParameters();
+  this->m_NumberOfPrecomputedWeights = numberOfWeights;
+
+} // end UpdatePrecomputedBSplineWeights()
+
+
 /**
  * **************** GetValueThreaderCallback *******
  */
@@ -862,12 +1311,9 @@ template <class TFixedImage, class TMovingImage>
 void
 AdvancedImageToImageMetric<TFixedImage, TMovingImage>::LaunchGetValueThreaderCallback(void) const
 {
-  /** Setup threader. */
-  this->m_Threader->SetSingleMethod(this->GetValueThreaderCallback,
-                                    const_cast<void *>(static_cast<const void *>(&this->m_ThreaderMetricParameters)));
-
-  /** Launch. */
-  this->m_Threader->SingleMethodExecute();
+  /** Setup threader and launch. */
+  this->LaunchThreaderCallback(this->GetValueThreaderCallback,
+                               const_cast<void *>(static_cast<const void *>(&this->m_ThreaderMetricParameters)));
 
 } // end LaunchGetValueThreaderCallback()
 
@@ -900,12 +1346,9 @@ template <class TFixedImage, class TMovingImage>
 void
 AdvancedImageToImageMetric<TFixedImage, TMovingImage>::LaunchGetValueAndDerivativeThreaderCallback(void) const
 {
-  /** Setup threader. */
-  this->m_Threader->SetSingleMethod(this->GetValueAndDerivativeThreaderCallback,
-                                    const_cast<void *>(static_cast<const void *>(&this->m_ThreaderMetricParameters)));
-
-  /** Launch. */
-  this->m_Threader->SingleMethodExecute();
+  /** Setup threader and launch. */
+  this->LaunchThreaderCallback(this->GetValueAndDerivativeThreaderCallback,
+                               const_cast<void *>(static_cast<const void *>(&this->m_ThreaderMetricParameters)));
 
 } // end LaunchGetValueAndDerivativeThreaderCallback()
 
@@ -936,6 +1379,27 @@ AdvancedImageToImageMetric<TFixedImage, TMovingImage>::AccumulateDerivativesThre
    */
   const DerivativeValueType zero = NumericTraits<DerivativeValueType>::Zero;
   const DerivativeValueType normalization = 1.0 / temp->st_NormalizationFactor;
+
+  /** Single precision per-thread derivatives are summed in double precision. */
+  if (temp->st_Metric->GetUseSinglePrecisionThreadDerivativesInternal())
+  {
+    for (unsigned int j = jmin; j < jmax; ++j)
+    {
+      DerivativeValueType tmp = zero;
+      for (ThreadIdType i = 0; i < nrOfThreads; ++i)
+      {
+        float & threadDerivative =
+          temp->st_Metric->m_GetValueAndDerivativePerThreadVariables[i].st_SinglePrecisionDerivative[j];
+        tmp += threadDerivative;
+
+        /** Reset this variable for the next iteration. */
+        threadDerivative = 0.0f;
+      }
+      temp->st_DerivativePointer[j] = tmp * normalization;
+    }
+    return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+  }
+
   for (unsigned int j = jmin; j < jmax; ++j)
   {
     DerivativeValueType tmp = zero;
@@ -954,6 +1418,91 @@ AdvancedImageToImageMetric<TFixedImage, TMovingImage>::AccumulateDerivativesThre
 } // end AccumulateDerivativesThreaderCallback()
 
 
+/**
+ * *********************** LaunchThreaderCallback ***************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+AdvancedImageToImageMetric<TFixedImage, TMovingImage>::LaunchThreaderCallback(ThreadFunctionType callback,
+                                                                              void *             arg) const
+{
+  /** Start claiming sample chunks from the beginning of the sample container. */
+  this->m_SampleRangeCounter = 0;
+
+  /** The per-thread variables are sized to the number of work units of
+   * the platform threader, so the thread pool should use the same number.
+   */
+  if (this->m_UseThreadPool && this->m_ThreadPool.IsNotNull())
+  {
+    this->m_ThreadPool->SetNumberOfWorkUnits(this->m_Threader->GetNumberOfWorkUnits());
+    this->m_ThreadPool->SetSingleMethod(callback, arg);
+    this->m_ThreadPool->SingleMethodExecute();
+  }
+  else
+  {
+    this->m_Threader->SetSingleMethod(callback, arg);
+    this->m_Threader->SingleMethodExecute();
+  }
+
+} // end LaunchThreaderCallback()
+
+
+/**
+ * *********************** GetNextSampleRange ***************
+ */
+
+template <class TFixedImage, class TMovingImage>
+bool
+AdvancedImageToImageMetric<TFixedImage, TMovingImage>::GetNextSampleRange(ThreadIdType    threadId,
+                                                                          unsigned long   numberOfSamples,
+                                                                          bool &          firstRange,
+                                                                          unsigned long & pos_begin,
+                                                                          unsigned long & pos_end) const
+{
+  const ThreadIdType numberOfThreads = Self::GetNumberOfWorkUnits();
+
+  /** Static scheduling: a single contiguous block of samples per thread. */
+  if (!this->m_UseDynamicSampleScheduling)
+  {
+    if (!firstRange)
+    {
+      return false;
+    }
+    firstRange = false;
+
+    const unsigned long nrOfSamplesPerThreads = static_cast<unsigned long>(
+      std::ceil(static_cast<double>(numberOfSamples) / static_cast<double>(numberOfThreads)));
+
+    pos_begin = nrOfSamplesPerThreads * threadId;
+    pos_end = nrOfSamplesPerThreads * (threadId + 1);
+    pos_begin = (pos_begin > numberOfSamples) ? numberOfSamples : pos_begin;
+    pos_end = (pos_end > numberOfSamples) ? numberOfSamples : pos_end;
+    return true;
+  }
+
+  /** Dynamic scheduling: claim the next chunk from the shared counter.
+   * Without a user-defined chunk size, aim for about eight chunks per thread,
+   * while keeping the chunks large enough to amortize the atomic operation.
+   */
+  firstRange = false;
+  unsigned long chunkSize = this->m_SampleChunkSize;
+  if (chunkSize == 0)
+  {
+    chunkSize = std::max(numberOfSamples / (8 * static_cast<unsigned long>(numberOfThreads)), 16ul);
+  }
+
+  pos_begin = this->m_SampleRangeCounter.fetch_add(chunkSize, std::memory_order_relaxed);
+  if (pos_begin >= numberOfSamples)
+  {
+    return false;
+  }
+  pos_end = std::min(pos_begin + chunkSize, numberOfSamples);
+  return true;
+
+} // end GetNextSampleRange()
+
+
 /**
  * *********************** CheckNumberOfSamples ***********************
  */
@@ -1019,6 +1568,19 @@ AdvancedImageToImageMetric<TFixedImage, TMovingImage>::PrintSelf(std::ostream &
   os << indent.GetNextIndent() << "TransformIsAdvanced: " << this->m_TransformIsAdvanced << std::endl;
   os << indent.GetNextIndent() << "AdvancedTransform: " << this->m_AdvancedTransform.GetPointer() << std::endl;
 
+  /** Variables related to multi-threading. */
+  os << indent << "Variables related to multi-threading: " << std::endl;
+  os << indent.GetNextIndent() << "UseMultiThread: " << this->m_UseMultiThread << std::endl;
+  os << indent.GetNextIndent() << "UseThreadPool: " << this->m_UseThreadPool << std::endl;
+  os << indent.GetNextIndent() << "UseDynamicSampleScheduling: " << this->m_UseDynamicSampleScheduling << std::endl;
+  os << indent.GetNextIndent() << "SampleChunkSize: " << this->m_SampleChunkSize << std::endl;
+  os << indent.GetNextIndent() << "UseSinglePrecisionThreadDerivatives: " << this->m_UseSinglePrecisionThreadDerivatives
+     << std::endl;
+  os << indent.GetNextIndent() << "SampleTransformCache: " << this->m_SampleTransformCache.GetPointer() << std::endl;
+  os << indent.GetNextIndent() << "UsePrecomputedBSplineWeights: " << this->m_UsePrecomputedBSplineWeights << std::endl;
+  os << indent.GetNextIndent() << "MaximumNumberOfPrecomputedBSplineWeights: "
+     << this->m_MaximumNumberOfPrecomputedBSplineWeights << std::endl;
+
   /** Other variables. */
   os << indent << "Other variables of the AdvancedImageToImageMetric: " << std::endl;
   os << indent.GetNextIndent() << "RequiredRatioOfValidSamples: " << this->m_RequiredRatioOfValidSamples << std::endl;
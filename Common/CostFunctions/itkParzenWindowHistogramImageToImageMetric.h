@@ -305,10 +305,19 @@ protected:
   };
   ParzenWindowHistogramMultiThreaderParameterType m_ParzenWindowHistogramThreaderParameters;
 
+  /** The per-thread joint histograms only store the bins within
+   * [st_MovingBinBegin, st_MovingBinEnd) x [st_FixedBinBegin, st_FixedBinEnd),
+   * all other bins are zero. This bounding box is used to limit the work
+   * of resetting and merging the per-thread histograms.
+   */
   struct ParzenWindowHistogramGetValueAndDerivativePerThreadStruct
   {
     SizeValueType   st_NumberOfPixelsCounted;
     JointPDFPointer st_JointPDF;
+    OffsetValueType st_MovingBinBegin;
+    OffsetValueType st_MovingBinEnd;
+    OffsetValueType st_FixedBinBegin;
+    OffsetValueType st_FixedBinEnd;
   };
   itkPadStruct(ITK_CACHE_LINE_ALIGNMENT,
                ParzenWindowHistogramGetValueAndDerivativePerThreadStruct,
@@ -328,14 +337,24 @@ protected:
   inline void
   ThreadedComputePDFs(ThreadIdType threadId);
 
-  /** Single-threadedly accumulate results. */
+  /** Accumulate the results of the threads. The per-thread joint histograms
+   * are merged multi-threadedly for large histograms and many threads.
+   */
   inline void
   AfterThreadedComputePDFs(void) const;
 
+  /** Merge the per-thread joint histograms for a block of fixed histogram bins. */
+  inline void
+  ThreadedAccumulateJointPDFs(ThreadIdType threadId) const;
+
   /** Helper function to launch the threads. */
   static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
   ComputePDFsThreaderCallback(void * arg);
 
+  /** Helper function to launch the threads that merge the joint histograms. */
+  static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+  AccumulateJointPDFsThreaderCallback(void * arg);
+
   /** Helper function to launch the threads. */
   void
   LaunchComputePDFsThreaderCallback(void) const;
@@ -352,6 +371,25 @@ protected:
                        const KernelFunctionType * kernel,
                        ParzenValueContainerType & parzenValues) const;
 
+  /** Compute the range [binBegin, binEnd) of histogram bins that is affected
+   * by image values within [minimumValue, maximumValue]. For direction = 0 the
+   * moving histogram bins are considered, for direction = 1 the fixed bins.
+   * An empty range is returned when minimumValue > maximumValue.
+   */
+  void
+  ComputeAffectedBinRange(double             minimumValue,
+                          double             maximumValue,
+                          const unsigned int direction,
+                          OffsetValueType &  binBegin,
+                          OffsetValueType &  binEnd) const;
+
+  /** Collect the bins of a marginal pdf with a value larger than 1e-16.
+   * The joint pdf is (nearly) zero in the rows and columns of the other bins,
+   * so these can be skipped when summing over the joint pdf.
+   */
+  void
+  ComputeNonZeroMarginalPDFBins(const MarginalPDFType & marginalPDF, std::vector<unsigned int> & bins) const;
+
   /** Update the joint PDF with a pixel pair; on demand also updates the
    * pdf derivatives (if the Jacobian pointers are nonzero).
    */
@@ -26,6 +26,8 @@
 #include "itkImageScanlineIterator.h"
 #include "vnl/vnl_math.h"
 
+#include <algorithm>
+
 namespace itk
 {
 
@@ -482,6 +484,12 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::InitializeTh
     {
       jointPDF->SetRegions(jointPDFRegion);
       jointPDF->Allocate();
+
+      /** Mark the complete histogram as non-zero, so that it is reset in ThreadedComputePDFs(). */
+      this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[i].st_MovingBinBegin = 0;
+      this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[i].st_MovingBinEnd = jointPDFSize[0];
+      this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[i].st_FixedBinBegin = 0;
+      this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[i].st_FixedBinEnd = jointPDFSize[1];
     }
   }
 
@@ -544,6 +552,68 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::EvaluateParz
 } // end EvaluateParzenValues()
 
 
+/**
+ * ********************** ComputeAffectedBinRange ***************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ComputeAffectedBinRange(
+  double             minimumValue,
+  double             maximumValue,
+  const unsigned int direction,
+  OffsetValueType &  binBegin,
+  OffsetValueType &  binEnd) const
+{
+  binBegin = 0;
+  binEnd = 0;
+  if (minimumValue > maximumValue)
+  {
+    return;
+  }
+
+  /** The same computation as in UpdateJointPDFAndDerivatives(), which is monotonic in the image value. */
+  const bool            moving = direction == 0;
+  const double          binSize = moving ? this->m_MovingImageBinSize : this->m_FixedImageBinSize;
+  const double          normalizedMin = moving ? this->m_MovingImageNormalizedMin : this->m_FixedImageNormalizedMin;
+  const double          termToIndexOffset =
+    moving ? this->m_MovingParzenTermToIndexOffset : this->m_FixedParzenTermToIndexOffset;
+  const OffsetValueType numberOfBins =
+    moving ? this->m_NumberOfMovingHistogramBins : this->m_NumberOfFixedHistogramBins;
+  const OffsetValueType windowSize = this->m_JointPDFWindow.GetSize()[direction];
+
+  const OffsetValueType first =
+    static_cast<OffsetValueType>(std::floor(minimumValue / binSize - normalizedMin + termToIndexOffset));
+  const OffsetValueType last =
+    static_cast<OffsetValueType>(std::floor(maximumValue / binSize - normalizedMin + termToIndexOffset));
+  binBegin = std::max<OffsetValueType>(first, 0);
+  binEnd = std::min<OffsetValueType>(last + windowSize, numberOfBins);
+
+} // end ComputeAffectedBinRange()
+
+
+/**
+ * ********************** ComputeNonZeroMarginalPDFBins ***************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ComputeNonZeroMarginalPDFBins(
+  const MarginalPDFType &     marginalPDF,
+  std::vector<unsigned int> & bins) const
+{
+  bins.clear();
+  for (unsigned int i = 0; i < marginalPDF.GetSize(); ++i)
+  {
+    if (marginalPDF[i] > 1e-16)
+    {
+      bins.push_back(i);
+    }
+  }
+
+} // end ComputeNonZeroMarginalPDFBins()
+
+
 /**
  * ********************** UpdateJointPDFAndDerivatives ***************
  */
@@ -584,29 +654,32 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::UpdateJointP
   pdfWindowIndex[0] = movingImageParzenWindowIndex;
   pdfWindowIndex[1] = fixedImageParzenWindowIndex;
 
-  /** For thread-safety, make a local copy of the support region,
-   * and use that one. Because each thread will modify it.
-   */
-  JointPDFRegionType jointPDFWindow = this->m_JointPDFWindow;
-  jointPDFWindow.SetIndex(pdfWindowIndex);
-  PDFIteratorType it(jointPDF, jointPDFWindow);
-
   if (!imageJacobian)
   {
-    /** Loop over the Parzen window region and increment the values. */
-    for (unsigned int f = 0; f < fixedParzenValues.GetSize(); ++f)
+    /** Loop over the Parzen window region and increment the values.
+     * The window is a small contiguous tile of the joint histogram, which
+     * is addressed directly to avoid constructing an iterator per sample.
+     */
+    const OffsetValueType rowStride = jointPDF->GetOffsetTable()[1];
+    PDFValueType *        row = jointPDF->GetBufferPointer() + jointPDF->ComputeOffset(pdfWindowIndex);
+    for (unsigned int f = 0; f < fixedParzenValues.GetSize(); ++f, row += rowStride)
     {
       const double fv = fixedParzenValues[f];
       for (unsigned int m = 0; m < movingParzenValues.GetSize(); ++m)
       {
-        it.Value() += static_cast<PDFValueType>(fv * movingParzenValues[m]);
-        ++it;
+        row[m] += static_cast<PDFValueType>(fv * movingParzenValues[m]);
       }
-      it.NextLine();
     }
   }
   else
   {
+    /** For thread-safety, make a local copy of the support region,
+     * and use that one. Because each thread will modify it.
+     */
+    JointPDFRegionType jointPDFWindow = this->m_JointPDFWindow;
+    jointPDFWindow.SetIndex(pdfWindowIndex);
+    PDFIteratorType it(jointPDF, jointPDFWindow);
+
     /** Compute the derivatives of the moving Parzen window. */
     ParzenValueContainerType derivativeMovingParzenValues(this->m_JointPDFWindow.GetSize()[0]);
     this->EvaluateParzenValues(movingImageParzenWindowTerm,
@@ -1035,7 +1108,7 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ComputePDFsS
     MovingImagePointType        mappedPoint;
 
     /** Transform point and check if it is inside the B-spline support region. */
-    bool sampleOk = this->TransformPoint(fixedPoint, mappedPoint);
+    bool sampleOk = this->TransformSamplePoint(fiter.Index(), fixedPoint, mappedPoint);
 
     /** Check if point is inside mask. */
     if (sampleOk)
@@ -1127,78 +1200,101 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ThreadedComp
   /** Get a handle to the pre-allocated joint PDF for the current thread.
    * The initialization is performed here, so that it is done multi-threadedly
    * instead of sequentially in InitializeThreadingParameters().
+   * Only the bins that were touched in the previous call need to be reset.
    */
-  JointPDFPointer & jointPDF =
-    this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[threadId].st_JointPDF;
-  jointPDF->FillBuffer(NumericTraits<PDFValueType>::ZeroValue());
+  AlignedParzenWindowHistogramGetValueAndDerivativePerThreadStruct & perThread =
+    this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[threadId];
+  JointPDFPointer &     jointPDF = perThread.st_JointPDF;
+  PDFValueType *        jointPDFBuffer = jointPDF->GetBufferPointer();
+  const OffsetValueType jointPDFRowStride = jointPDF->GetOffsetTable()[1];
+  for (OffsetValueType f = perThread.st_FixedBinBegin; f < perThread.st_FixedBinEnd; ++f)
+  {
+    PDFValueType * row = jointPDFBuffer + f * jointPDFRowStride;
+    std::fill(row + perThread.st_MovingBinBegin, row + perThread.st_MovingBinEnd, 0.0);
+  }
+
+  /** Keep track of the range of (limited) image values, to determine the touched bins. */
+  double fixedImageValueMin = NumericTraits<double>::max();
+  double fixedImageValueMax = NumericTraits<double>::NonpositiveMin();
+  double movingImageValueMin = NumericTraits<double>::max();
+  double movingImageValueMax = NumericTraits<double>::NonpositiveMin();
 
   /** Get a handle to the sample container. */
   ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
   const unsigned long         sampleContainerSize = sampleContainer->Size();
 
-  /** Get the samples for this thread. */
-  const unsigned long nrOfSamplesPerThreads = static_cast<unsigned long>(
-    std::ceil(static_cast<double>(sampleContainerSize) / static_cast<double>(Self::GetNumberOfWorkUnits())));
-
-  unsigned long pos_begin = nrOfSamplesPerThreads * threadId;
-  unsigned long pos_end = nrOfSamplesPerThreads * (threadId + 1);
-  pos_begin = (pos_begin > sampleContainerSize) ? sampleContainerSize : pos_begin;
-  pos_end = (pos_end > sampleContainerSize) ? sampleContainerSize : pos_end;
-
-  /** Create iterator over the sample container. */
-  typename ImageSampleContainerType::ConstIterator fiter;
-  typename ImageSampleContainerType::ConstIterator fbegin = sampleContainer->Begin();
-  typename ImageSampleContainerType::ConstIterator fend = sampleContainer->Begin();
-  fbegin += (int)pos_begin;
-  fend += (int)pos_end;
-
   /** Create variables to store intermediate results. circumvent false sharing */
   unsigned long numberOfPixelsCounted = 0;
 
-  /** Loop over sample container and compute contribution of each sample to pdfs. */
-  for (fiter = fbegin; fiter != fend; ++fiter)
+  /** The fixed and mapped points of a batch of samples. */
+  FixedImagePointType  fixedPoints[Superclass::SampleBatchSize];
+  MovingImagePointType mappedPoints[Superclass::SampleBatchSize];
+
+  /** Loop over the ranges of samples assigned to this thread. */
+  unsigned long pos_begin = 0;
+  unsigned long pos_end = 0;
+  bool          firstRange = true;
+  while (this->GetNextSampleRange(threadId, sampleContainerSize, firstRange, pos_begin, pos_end))
   {
-    /** Read fixed coordinates and initialize some variables. */
-    const FixedImagePointType & fixedPoint = (*fiter).Value().m_ImageCoordinates;
-    RealType                    movingImageValue;
-    MovingImagePointType        mappedPoint;
+    /** Split the range into batches, of which all points are transformed at once. */
+    for (unsigned long batch_begin = pos_begin; batch_begin < pos_end; batch_begin += Superclass::SampleBatchSize)
+    {
+      const unsigned long batchSize =
+        std::min(pos_end - batch_begin, static_cast<unsigned long>(Superclass::SampleBatchSize));
 
-    /** Transform point and check if it is inside the B-spline support region. */
-    bool sampleOk = this->TransformPoint(fixedPoint, mappedPoint);
+      /** Transform the points and check if they are inside the B-spline support region. */
+      for (unsigned long i = 0; i < batchSize; ++i)
+      {
+        fixedPoints[i] = sampleContainer->ElementAt(batch_begin + i).m_ImageCoordinates;
+      }
+      this->TransformSamplePoints(batch_begin, fixedPoints, mappedPoints, batchSize);
 
-    /** Check if point is inside mask. */
-    if (sampleOk)
-    {
-      sampleOk = this->IsInsideMovingMask(mappedPoint);
-    }
+      /** Loop over the samples of the batch and compute contribution of each sample to pdfs. */
+      for (unsigned long i = 0; i < batchSize; ++i)
+      {
+        const MovingImagePointType & mappedPoint = mappedPoints[i];
+        RealType                     movingImageValue;
 
-    /** Compute the moving image value and check if the point is
-     * inside the moving image buffer.
-     */
-    if (sampleOk)
-    {
-      sampleOk = this->EvaluateMovingImageValueAndDerivative(mappedPoint, movingImageValue, nullptr);
-    }
+        /** Check if point is inside mask. */
+        bool sampleOk = this->IsInsideMovingMask(mappedPoint);
 
-    if (sampleOk)
-    {
-      numberOfPixelsCounted++;
+        /** Compute the moving image value and check if the point is
+         * inside the moving image buffer.
+         */
+        if (sampleOk)
+        {
+          sampleOk = this->EvaluateMovingImageValueAndDerivative(mappedPoint, movingImageValue, nullptr);
+        }
 
-      /** Get the fixed image value. */
-      RealType fixedImageValue = static_cast<RealType>((*fiter).Value().m_ImageValue);
+        if (sampleOk)
+        {
+          numberOfPixelsCounted++;
 
-      /** Make sure the values fall within the histogram range. */
-      fixedImageValue = this->GetFixedImageLimiter()->Evaluate(fixedImageValue);
-      movingImageValue = this->GetMovingImageLimiter()->Evaluate(movingImageValue);
+          /** Get the fixed image value. */
+          RealType fixedImageValue = static_cast<RealType>(sampleContainer->ElementAt(batch_begin + i).m_ImageValue);
 
-      /** Compute this sample's contribution to the joint distributions. */
-      this->UpdateJointPDFAndDerivatives(fixedImageValue, movingImageValue, nullptr, nullptr, jointPDF.GetPointer());
-    }
-  } // end iterating over fixed image spatial sample container for loop
+          /** Make sure the values fall within the histogram range. */
+          fixedImageValue = this->GetFixedImageLimiter()->Evaluate(fixedImageValue);
+          movingImageValue = this->GetMovingImageLimiter()->Evaluate(movingImageValue);
+          fixedImageValueMin = std::min(fixedImageValueMin, static_cast<double>(fixedImageValue));
+          fixedImageValueMax = std::max(fixedImageValueMax, static_cast<double>(fixedImageValue));
+          movingImageValueMin = std::min(movingImageValueMin, static_cast<double>(movingImageValue));
+          movingImageValueMax = std::max(movingImageValueMax, static_cast<double>(movingImageValue));
+
+          /** Compute this sample's contribution to the joint distributions. */
+          this->UpdateJointPDFAndDerivatives(
+            fixedImageValue, movingImageValue, nullptr, nullptr, jointPDF.GetPointer());
+        }
+      } // end for loop over the samples of the batch
+    }   // end for loop over the batches
+  }     // end while loop over the sample ranges
 
   /** Only update these variables at the end to prevent unnecessary "false sharing". */
-  this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[threadId].st_NumberOfPixelsCounted =
-    numberOfPixelsCounted;
+  perThread.st_NumberOfPixelsCounted = numberOfPixelsCounted;
+  this->ComputeAffectedBinRange(
+    movingImageValueMin, movingImageValueMax, 0, perThread.st_MovingBinBegin, perThread.st_MovingBinEnd);
+  this->ComputeAffectedBinRange(
+    fixedImageValueMin, fixedImageValueMax, 1, perThread.st_FixedBinBegin, perThread.st_FixedBinEnd);
 
 } // end ThreadedComputePDFs()
 
@@ -1232,39 +1328,75 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::AfterThreade
   /** Compute alpha. */
   this->m_Alpha = 1.0 / static_cast<double>(this->m_NumberOfPixelsCounted);
 
-  /** Accumulate joint histogram. */
-  // could be multi-threaded too, by each thread updating only a part of the JointPDF.
-  typedef ImageScanlineIterator<JointPDFType> JointPDFIteratorType;
-  JointPDFIteratorType                        it(this->m_JointPDF, this->m_JointPDF->GetBufferedRegion());
-  std::vector<JointPDFIteratorType>           itT(numberOfThreads);
-  for (ThreadIdType i = 0; i < numberOfThreads; ++i)
+  /** Accumulate the joint histograms. The merge reads at most numberOfThreads * numberOfBins
+   * values and is memory bound. Below 2^16 values (512 KiB of doubles, about the size of an
+   * L2 cache) one thread adds them in some tens of microseconds, which is about the cost of
+   * launching and joining the threads, so then the histograms are merged single-threadedly.
+   */
+  const SizeValueType minimumNumberOfValuesForThreadedMerge = 1UL << 16;
+  const SizeValueType numberOfBins = this->m_NumberOfFixedHistogramBins * this->m_NumberOfMovingHistogramBins;
+  if (numberOfThreads > 1 && numberOfThreads * numberOfBins >= minimumNumberOfValuesForThreadedMerge)
   {
-    itT[i] = JointPDFIteratorType(this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[i].st_JointPDF,
-                                  this->m_JointPDF->GetBufferedRegion());
+    this->LaunchThreaderCallback(
+      this->AccumulateJointPDFsThreaderCallback,
+      const_cast<void *>(static_cast<const void *>(&this->m_ParzenWindowHistogramThreaderParameters)));
   }
-
-  PDFValueType sum;
-  while (!it.IsAtEnd())
+  else
   {
-    while (!it.IsAtEndOfLine())
+    for (ThreadIdType i = 0; i < numberOfThreads; ++i)
     {
-      sum = NumericTraits<PDFValueType>::Zero;
-      for (ThreadIdType i = 0; i < numberOfThreads; ++i)
-      {
-        sum += itT[i].Value();
-        ++itT[i];
-      }
-      it.Set(sum);
-      ++it;
+      this->ThreadedAccumulateJointPDFs(i);
     }
-    it.NextLine();
+  }
+
+} // end AfterThreadedComputePDFs()
+
+
+/**
+ * ******************* ThreadedAccumulateJointPDFs *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ThreadedAccumulateJointPDFs(
+  ThreadIdType threadId) const
+{
+  /** Each thread merges a block of rows (fixed bins) over all per-thread histograms.
+   * Per bin the histograms are added in the order of the threads, so the result
+   * does not depend on the number of threads that performs the merge.
+   */
+  const ThreadIdType    numberOfThreads = Self::GetNumberOfWorkUnits();
+  const OffsetValueType numberOfFixedBins = this->m_NumberOfFixedHistogramBins;
+  const OffsetValueType numberOfMovingBins = this->m_NumberOfMovingHistogramBins;
+  const OffsetValueType rowsPerThread = (numberOfFixedBins + numberOfThreads - 1) / numberOfThreads;
+  const OffsetValueType rowBegin = std::min<OffsetValueType>(threadId * rowsPerThread, numberOfFixedBins);
+  const OffsetValueType rowEnd = std::min<OffsetValueType>(rowBegin + rowsPerThread, numberOfFixedBins);
+
+  PDFValueType *        jointPDFBuffer = this->m_JointPDF->GetBufferPointer();
+  const OffsetValueType rowStride = this->m_JointPDF->GetOffsetTable()[1];
+  for (OffsetValueType f = rowBegin; f < rowEnd; ++f)
+  {
+    PDFValueType * row = jointPDFBuffer + f * rowStride;
+    std::fill(row, row + numberOfMovingBins, 0.0);
+
+    /** Only visit the per-thread histograms that have non-zero bins in this row. */
     for (ThreadIdType i = 0; i < numberOfThreads; ++i)
     {
-      itT[i].NextLine();
+      const AlignedParzenWindowHistogramGetValueAndDerivativePerThreadStruct & perThread =
+        this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[i];
+      if (f < perThread.st_FixedBinBegin || f >= perThread.st_FixedBinEnd)
+      {
+        continue;
+      }
+      const PDFValueType * threadRow = perThread.st_JointPDF->GetBufferPointer() + f * rowStride;
+      for (OffsetValueType m = perThread.st_MovingBinBegin; m < perThread.st_MovingBinEnd; ++m)
+      {
+        row[m] += threadRow[m];
+      }
     }
   }
 
-} // end AfterThreadedComputePDFs()
+} // end ThreadedAccumulateJointPDFs()
 
 
 /**
@@ -1288,6 +1420,27 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ComputePDFsT
 } // end ComputePDFsThreaderCallback()
 
 
+/**
+ * **************** AccumulateJointPDFsThreaderCallback *******
+ */
+
+template <class TFixedImage, class TMovingImage>
+ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::AccumulateJointPDFsThreaderCallback(void * arg)
+{
+  ThreadInfoType * infoStruct = static_cast<ThreadInfoType *>(arg);
+  ThreadIdType     threadId = infoStruct->WorkUnitID;
+
+  ParzenWindowHistogramMultiThreaderParameterType * temp =
+    static_cast<ParzenWindowHistogramMultiThreaderParameterType *>(infoStruct->UserData);
+
+  temp->m_Metric->ThreadedAccumulateJointPDFs(threadId);
+
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+
+} // end AccumulateJointPDFsThreaderCallback()
+
+
 /**
  * *********************** LaunchComputePDFsThreaderCallback***************
  */
@@ -1296,14 +1449,11 @@ template <class TFixedImage, class TMovingImage>
 void
 ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::LaunchComputePDFsThreaderCallback(void) const
 {
-  /** Setup threader. */
-  this->m_Threader->SetSingleMethod(
+  /** Setup threader and launch. */
+  this->LaunchThreaderCallback(
     this->ComputePDFsThreaderCallback,
     const_cast<void *>(static_cast<const void *>(&this->m_ParzenWindowHistogramThreaderParameters)));
 
-  /** Launch. */
-  this->m_Threader->SingleMethodExecute();
-
 } // end LaunchComputePDFsThreaderCallback()
 
 
@@ -1360,7 +1510,7 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ComputePDFsA
     MovingImageDerivativeType   movingImageDerivative;
 
     /** Transform point and check if it is inside the B-spline support region. */
-    bool sampleOk = this->TransformPoint(fixedPoint, mappedPoint);
+    bool sampleOk = this->TransformSamplePoint(fiter.Index(), fixedPoint, mappedPoint);
 
     /** Check if point is inside mask. */
     if (sampleOk)
@@ -1388,7 +1538,7 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ComputePDFsA
       movingImageValue = this->GetMovingImageLimiter()->Evaluate(movingImageValue, movingImageDerivative);
 
       /** Get the TransformJacobian dT/dmu. */
-      this->EvaluateTransformJacobian(fixedPoint, jacobian, nzji);
+      this->EvaluateSampleTransformJacobian(fiter.Index(), fixedPoint, jacobian, nzji);
 
       /** Compute the inner product (dM/dx)^T (dT/dmu). */
       this->EvaluateTransformJacobianInnerProduct(jacobian, movingImageDerivative, imageJacobian);
@@ -1477,7 +1627,7 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ComputePDFsA
      * if not, skip this sample.
      */
     MovingImagePointType mappedPoint;
-    bool                 sampleOk = this->TransformPoint(fixedPoint, mappedPoint);
+    bool                 sampleOk = this->TransformSamplePoint(fiter.Index(), fixedPoint, mappedPoint);
 
     if (sampleOk)
     {
@@ -1528,7 +1678,7 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ComputePDFsA
        * function of its parameters, so that we can evaluate T(x;\mu+delta_ek)
        * as T(x) + delta * dT/dmu_k.
        */
-      this->EvaluateTransformJacobian(fixedPoint, jacobian, nzji);
+      this->EvaluateSampleTransformJacobian(fiter.Index(), fixedPoint, jacobian, nzji);
 
       MovingImagePointType mappedPointRight;
       MovingImagePointType mappedPointLeft;
@@ -0,0 +1,184 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef itkSampleTransformCache_h
+#define itkSampleTransformCache_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkDataObject.h"
+#include "itkAdvancedTransform.h"
+
+#include <vector>
+
+namespace itk
+{
+
+/**
+ * \class SampleTransformCache
+ * \brief Stores the mapped points and transform Jacobians of the samples of an image sampler.
+ *
+ * When several metrics of a multi-metric registration draw their samples from the same image
+ * sampler, they all map the same fixed image points through the same transform in each iteration.
+ * This cache allows the first metric to store the mapped points T(x) and the sparse Jacobians
+ * dT/dmu, with their nonzero Jacobian indices, so that the other metrics can reuse them.
+ *
+ * The cache is keyed by the sample container, the time at which it was last generated, and the
+ * transform parameters. Synchronize() must be called single-threadedly before the metrics are
+ * evaluated; it invalidates all entries when the samples or the parameters changed since the
+ * previous call. The entries may then be read and written concurrently, provided that each
+ * sample is written by at most one thread at a time.
+ * Metrics that are evaluated concurrently should therefore not share a cache.
+ *
+ * The Jacobians are only cached when they fit in MaximumNumberOfJacobianValues values.
+ *
+ * \ingroup Metrics
+ */
+
+template <class TScalarType, unsigned int NInputDimensions, unsigned int NOutputDimensions>
+class SampleTransformCache : public Object
+{
+public:
+  /** Standard class typedefs. */
+  typedef SampleTransformCache     Self;
+  typedef Object                   Superclass;
+  typedef SmartPointer<Self>       Pointer;
+  typedef SmartPointer<const Self> ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(SampleTransformCache, Object);
+
+  /** Typedefs from the transform. */
+  typedef AdvancedTransform<TScalarType, NInputDimensions, NOutputDimensions> AdvancedTransformType;
+  typedef typename AdvancedTransformType::ScalarType                         ScalarType;
+  typedef typename AdvancedTransformType::InputPointType                     InputPointType;
+  typedef typename AdvancedTransformType::OutputPointType                    OutputPointType;
+  typedef typename AdvancedTransformType::ParametersType                     ParametersType;
+  typedef typename AdvancedTransformType::NumberOfParametersType             NumberOfParametersType;
+  typedef typename AdvancedTransformType::JacobianType                       JacobianType;
+  typedef typename AdvancedTransformType::NonZeroJacobianIndicesType         NonZeroJacobianIndicesType;
+  typedef typename JacobianType::ValueType                                   JacobianValueType;
+
+  /** Set/Get the maximum number of Jacobian values that are stored. Default: 2^25. */
+  itkSetMacro(MaximumNumberOfJacobianValues, SizeValueType);
+  itkGetConstMacro(MaximumNumberOfJacobianValues, SizeValueType);
+
+  /** Prepare the cache for the samples in sampleContainer and the transform parameters.
+   * The entries are invalidated if the samples or the parameters changed since the previous call.
+   * Not thread-safe.
+   */
+  void
+  Synchronize(const DataObject *       sampleContainer,
+              SizeValueType          numberOfSamples,
+              const ParametersType & parameters,
+              NumberOfParametersType numberOfNonZeroJacobianIndices);
+
+  /** Invalidate all entries. */
+  void
+  Clear(void);
+
+  /** Get the mapped point of a sample. Returns false if it has not been cached. */
+  bool
+  GetMappedPoint(SizeValueType sampleIndex, OutputPointType & mappedPoint) const
+  {
+    if (sampleIndex >= this->m_NumberOfSamples || !this->m_MappedPointIsCached[sampleIndex])
+    {
+      return false;
+    }
+    mappedPoint = this->m_MappedPoints[sampleIndex];
+    return true;
+  }
+
+  /** Store the mapped point of a sample. */
+  void
+  SetMappedPoint(SizeValueType sampleIndex, const OutputPointType & mappedPoint)
+  {
+    if (sampleIndex < this->m_NumberOfSamples)
+    {
+      this->m_MappedPoints[sampleIndex] = mappedPoint;
+      this->m_MappedPointIsCached[sampleIndex] = 1;
+    }
+  }
+
+  /** Get a pointer to the row-major NOutputDimensions x NumberOfNonZeroJacobianIndices Jacobian
+   * of a sample, and copy its nonzero Jacobian indices to nzji. Returns nullptr if the Jacobian
+   * has not been cached.
+   */
+  const JacobianValueType *
+  GetJacobian(SizeValueType sampleIndex, NonZeroJacobianIndicesType & nzji) const;
+
+  /** Get the Jacobian and the nonzero Jacobian indices of a sample. Returns false if they have not been cached. */
+  bool
+  GetJacobian(SizeValueType sampleIndex, JacobianType & jacobian, NonZeroJacobianIndicesType & nzji) const;
+
+  /** Store the Jacobian and the nonzero Jacobian indices of a sample.
+   * Jacobians of which the size does not match the cache are ignored.
+   */
+  void
+  SetJacobian(SizeValueType sampleIndex, const JacobianType & jacobian, const NonZeroJacobianIndicesType & nzji);
+
+  /** Returns true if the Jacobians are cached. */
+  bool
+  GetCachesJacobians(void) const
+  {
+    return this->m_CachesJacobians;
+  }
+
+protected:
+  SampleTransformCache();
+  ~SampleTransformCache() override = default;
+
+  /** PrintSelf. */
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+private:
+  SampleTransformCache(const Self &) = delete;
+  void
+  operator=(const Self &) = delete;
+
+  /** The key of the current entries. */
+  const DataObject * m_SampleContainer;
+  ModifiedTimeType   m_SampleContainerMTime;
+  ParametersType     m_Parameters;
+
+  SizeValueType          m_NumberOfSamples;
+  NumberOfParametersType m_NumberOfNonZeroJacobianIndices;
+  SizeValueType          m_MaximumNumberOfJacobianValues;
+  bool                   m_CachesJacobians;
+
+  /** The cached data. The flags are stored as unsigned char, so that the
+   * entries of different samples can be written concurrently.
+   */
+  std::vector<OutputPointType>   m_MappedPoints;
+  std::vector<unsigned char>     m_MappedPointIsCached;
+  std::vector<JacobianValueType> m_Jacobians;
+  std::vector<unsigned long>     m_NonZeroJacobianIndices;
+  std::vector<unsigned char>     m_JacobianIsCached;
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "itkSampleTransformCache.hxx"
+#endif
+
+#endif // end #ifndef itkSampleTransformCache_h
@@ -0,0 +1,208 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkSampleTransformCache_hxx
+#define itkSampleTransformCache_hxx
+
+#include "itkSampleTransformCache.h"
+#include <algorithm>
+
+namespace itk
+{
+
+/**
+ * ********************* Constructor ******************************
+ */
+
+template <class TScalarType, unsigned int NInputDimensions, unsigned int NOutputDimensions>
+SampleTransformCache<TScalarType, NInputDimensions, NOutputDimensions>::SampleTransformCache()
+{
+  this->m_SampleContainer = nullptr;
+  this->m_SampleContainerMTime = 0;
+  this->m_NumberOfSamples = 0;
+  this->m_NumberOfNonZeroJacobianIndices = 0;
+  this->m_MaximumNumberOfJacobianValues = 1 << 25;
+  this->m_CachesJacobians = false;
+
+} // end Constructor
+
+
+/**
+ * ********************* Synchronize ******************************
+ */
+
+template <class TScalarType, unsigned int NInputDimensions, unsigned int NOutputDimensions>
+void
+SampleTransformCache<TScalarType, NInputDimensions, NOutputDimensions>::Synchronize(
+  const DataObject *     sampleContainer,
+  SizeValueType          numberOfSamples,
+  const ParametersType & parameters,
+  NumberOfParametersType numberOfNonZeroJacobianIndices)
+{
+  /** Check if the samples and the transform parameters are still the same. */
+  const ModifiedTimeType mtime = sampleContainer != nullptr ? sampleContainer->GetUpdateMTime() : 0;
+  if (sampleContainer == this->m_SampleContainer && mtime == this->m_SampleContainerMTime &&
+      numberOfSamples == this->m_NumberOfSamples &&
+      numberOfNonZeroJacobianIndices == this->m_NumberOfNonZeroJacobianIndices && parameters == this->m_Parameters)
+  {
+    return;
+  }
+
+  /** Store the new key. */
+  this->m_SampleContainer = sampleContainer;
+  this->m_SampleContainerMTime = mtime;
+  this->m_Parameters = parameters;
+  this->m_NumberOfSamples = numberOfSamples;
+  this->m_NumberOfNonZeroJacobianIndices = numberOfNonZeroJacobianIndices;
+
+  /** Allocate the storage; only the Jacobians are subject to the memory limit. */
+  const SizeValueType numberOfJacobianValues =
+    numberOfSamples * NOutputDimensions * static_cast<SizeValueType>(numberOfNonZeroJacobianIndices);
+  this->m_CachesJacobians =
+    numberOfJacobianValues > 0 && numberOfJacobianValues <= this->m_MaximumNumberOfJacobianValues;
+
+  this->m_MappedPoints.resize(numberOfSamples);
+  if (this->m_CachesJacobians)
+  {
+    this->m_Jacobians.resize(numberOfJacobianValues);
+    this->m_NonZeroJacobianIndices.resize(numberOfSamples * numberOfNonZeroJacobianIndices);
+  }
+  else
+  {
+    std::vector<JacobianValueType>().swap(this->m_Jacobians);
+    std::vector<unsigned long>().swap(this->m_NonZeroJacobianIndices);
+  }
+
+  /** Invalidate all entries. */
+  this->Clear();
+
+} // end Synchronize()
+
+
+/**
+ * ********************* Clear ******************************
+ */
+
+template <class TScalarType, unsigned int NInputDimensions, unsigned int NOutputDimensions>
+void
+SampleTransformCache<TScalarType, NInputDimensions, NOutputDimensions>::Clear(void)
+{
+  this->m_MappedPointIsCached.assign(this->m_NumberOfSamples, 0);
+  this->m_JacobianIsCached.assign(this->m_CachesJacobians ? this->m_NumberOfSamples : 0, 0);
+
+} // end Clear()
+
+
+/**
+ * ********************* GetJacobian ******************************
+ */
+
+template <class TScalarType, unsigned int NInputDimensions, unsigned int NOutputDimensions>
+auto
+SampleTransformCache<TScalarType, NInputDimensions, NOutputDimensions>::GetJacobian(
+  SizeValueType                sampleIndex,
+  NonZeroJacobianIndicesType & nzji) const -> const JacobianValueType *
+{
+  if (!this->m_CachesJacobians || sampleIndex >= this->m_NumberOfSamples || !this->m_JacobianIsCached[sampleIndex])
+  {
+    return nullptr;
+  }
+
+  const SizeValueType nnzji = this->m_NumberOfNonZeroJacobianIndices;
+  const auto          nzjiBegin = this->m_NonZeroJacobianIndices.begin() + sampleIndex * nnzji;
+  nzji.assign(nzjiBegin, nzjiBegin + nnzji);
+
+  return this->m_Jacobians.data() + sampleIndex * NOutputDimensions * nnzji;
+
+} // end GetJacobian()
+
+
+/**
+ * ********************* GetJacobian ******************************
+ */
+
+template <class TScalarType, unsigned int NInputDimensions, unsigned int NOutputDimensions>
+bool
+SampleTransformCache<TScalarType, NInputDimensions, NOutputDimensions>::GetJacobian(
+  SizeValueType                sampleIndex,
+  JacobianType &               jacobian,
+  NonZeroJacobianIndicesType & nzji) const
+{
+  const JacobianValueType * cachedJacobian = this->GetJacobian(sampleIndex, nzji);
+  if (cachedJacobian == nullptr)
+  {
+    return false;
+  }
+
+  jacobian.SetSize(NOutputDimensions, this->m_NumberOfNonZeroJacobianIndices);
+  std::copy(cachedJacobian, cachedJacobian + jacobian.size(), jacobian.data_block());
+  return true;
+
+} // end GetJacobian()
+
+
+/**
+ * ********************* SetJacobian ******************************
+ */
+
+template <class TScalarType, unsigned int NInputDimensions, unsigned int NOutputDimensions>
+void
+SampleTransformCache<TScalarType, NInputDimensions, NOutputDimensions>::SetJacobian(
+  SizeValueType                      sampleIndex,
+  const JacobianType &               jacobian,
+  const NonZeroJacobianIndicesType & nzji)
+{
+  const SizeValueType nnzji = this->m_NumberOfNonZeroJacobianIndices;
+  if (!this->m_CachesJacobians || sampleIndex >= this->m_NumberOfSamples || nzji.size() != nnzji ||
+      jacobian.rows() != NOutputDimensions || jacobian.cols() != nnzji)
+  {
+    return;
+  }
+
+  std::copy(nzji.begin(), nzji.end(), this->m_NonZeroJacobianIndices.begin() + sampleIndex * nnzji);
+  std::copy(jacobian.data_block(),
+            jacobian.data_block() + jacobian.size(),
+            this->m_Jacobians.begin() + sampleIndex * NOutputDimensions * nnzji);
+  this->m_JacobianIsCached[sampleIndex] = 1;
+
+} // end SetJacobian()
+
+
+/**
+ * ********************* PrintSelf ******************************
+ */
+
+template <class TScalarType, unsigned int NInputDimensions, unsigned int NOutputDimensions>
+void
+SampleTransformCache<TScalarType, NInputDimensions, NOutputDimensions>::PrintSelf(std::ostream & os,
+                                                                                  Indent         indent) const
+{
+  /** Call the superclass' PrintSelf. */
+  Superclass::PrintSelf(os, indent);
+
+  /** Add debugging information. */
+  os << indent << "NumberOfSamples: " << this->m_NumberOfSamples << std::endl;
+  os << indent << "NumberOfNonZeroJacobianIndices: " << this->m_NumberOfNonZeroJacobianIndices << std::endl;
+  os << indent << "MaximumNumberOfJacobianValues: " << this->m_MaximumNumberOfJacobianValues << std::endl;
+  os << indent << "CachesJacobians: " << this->m_CachesJacobians << std::endl;
+
+} // end PrintSelf()
+
+
+} // end namespace itk
+
+#endif // end #ifndef itkSampleTransformCache_hxx
@@ -172,6 +172,15 @@ public:
   itkGetConstReferenceMacro(UseMetricSingleThreaded, bool);
   itkBooleanMacro(UseMetricSingleThreaded);
 
+  /** Tells if GetValueAndDerivative() may run concurrently with other metrics that share the
+   * transform, once BeforeThreadedGetValueAndDerivative() has been called. Default: false.
+   */
+  virtual bool
+  CanBeEvaluatedConcurrently(void) const
+  {
+    return false;
+  }
+
 protected:
   SingleValuedPointSetToPointSetMetric();
   ~SingleValuedPointSetToPointSetMetric() override = default;
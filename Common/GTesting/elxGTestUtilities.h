@@ -0,0 +1,107 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef elxGTestUtilities_h
+#define elxGTestUtilities_h
+
+#include <itkImageRegionIteratorWithIndex.h>
+#include <itkMersenneTwisterRandomVariateGenerator.h>
+#include <itkOptimizerParameters.h>
+
+#include <cmath>
+
+namespace elastix
+{
+namespace GTestUtilities
+{
+
+/// Creates a B-spline transform with the specified grid, and an identity grid direction.
+template <typename TTransform>
+typename TTransform::Pointer
+CreateBSplineTransform(const typename TTransform::OriginType &           gridOrigin,
+                       const typename TTransform::SpacingType &          gridSpacing,
+                       const typename TTransform::RegionType::SizeType & gridSize)
+{
+  typename TTransform::RegionType    gridRegion;
+  typename TTransform::DirectionType gridDirection;
+  gridRegion.SetSize(gridSize);
+  gridDirection.SetIdentity();
+
+  const auto transform = TTransform::New();
+  transform->SetGridOrigin(gridOrigin);
+  transform->SetGridSpacing(gridSpacing);
+  transform->SetGridRegion(gridRegion);
+  transform->SetGridDirection(gridDirection);
+  return transform;
+}
+
+
+/// Creates a B-spline transform with the same grid origin, spacing and size in every dimension.
+template <typename TTransform>
+typename TTransform::Pointer
+CreateBSplineTransform(const double gridOrigin, const double gridSpacing, const unsigned int gridSize)
+{
+  typename TTransform::OriginType           origin;
+  typename TTransform::SpacingType          spacing;
+  typename TTransform::RegionType::SizeType size;
+  origin.Fill(gridOrigin);
+  spacing.Fill(gridSpacing);
+  size.Fill(gridSize);
+  return CreateBSplineTransform<TTransform>(origin, spacing, size);
+}
+
+
+/// Generates parameters that are uniformly distributed within [minimum, maximum]. The fixed seed makes the
+/// parameters reproducible.
+inline itk::OptimizerParameters<double>
+GeneratePseudoRandomParameters(const unsigned int numberOfParameters, const double minimum, const double maximum)
+{
+  const auto randomGenerator = itk::Statistics::MersenneTwisterRandomVariateGenerator::New();
+  randomGenerator->SetSeed(12345);
+
+  itk::OptimizerParameters<double> parameters(numberOfParameters);
+  for (unsigned int i = 0; i < numberOfParameters; ++i)
+  {
+    parameters[i] = randomGenerator->GetUniformVariate(minimum, maximum);
+  }
+  return parameters;
+}
+
+
+/// Creates an image with a smooth pattern along its first two dimensions, which is shifted by the specified offset.
+template <typename TImage>
+typename TImage::Pointer
+CreateSmoothImage(const typename TImage::SizeType & imageSize, const double offset)
+{
+  const auto image = TImage::New();
+  image->SetRegions(imageSize);
+  image->Allocate();
+
+  itk::ImageRegionIteratorWithIndex<TImage> it(image, image->GetBufferedRegion());
+  for (; !it.IsAtEnd(); ++it)
+  {
+    const typename TImage::IndexType index = it.GetIndex();
+    it.Set(static_cast<typename TImage::PixelType>(100.0 * std::sin((index[0] + offset) / 4.0) *
+                                                   std::cos((index[1] - offset) / 5.0)));
+  }
+  return image;
+}
+
+} // namespace GTestUtilities
+} // namespace elastix
+
+#endif // end #ifndef elxGTestUtilities_h
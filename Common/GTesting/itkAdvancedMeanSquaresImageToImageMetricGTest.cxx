@@ -0,0 +1,119 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+// First include the header file to be tested:
+#include "AdvancedMeanSquares/itkAdvancedMeanSquaresImageToImageMetric.h"
+
+#include "elxGTestUtilities.h"
+#include "itkAdvancedBSplineDeformableTransform.h"
+#include "itkImageFullSampler.h"
+
+#include <itkBSplineInterpolateImageFunction.h>
+#include <itkImage.h>
+
+#include <cmath>
+
+#include <gtest/gtest.h>
+
+namespace
+{
+constexpr unsigned int ImageDimension = 2;
+
+using ImageType = itk::Image<float, ImageDimension>;
+using MetricType = itk::AdvancedMeanSquaresImageToImageMetric<ImageType, ImageType>;
+using TransformType = itk::AdvancedBSplineDeformableTransform<double, ImageDimension, 3>;
+using SamplerType = itk::ImageFullSampler<ImageType>;
+using InterpolatorType = itk::BSplineInterpolateImageFunction<ImageType, double, double>;
+
+
+// Creates a 32x32 image with a smooth pattern, which is shifted by the specified offset.
+ImageType::Pointer
+CreateImage(const double offset)
+{
+  return elastix::GTestUtilities::CreateSmoothImage<ImageType>(ImageType::SizeType{ { 32, 32 } }, offset);
+}
+
+
+// Creates a B-spline transform whose grid covers the 32x32 images, with random parameters.
+TransformType::Pointer
+CreateTransform(TransformType::ParametersType & parameters)
+{
+  const auto transform = elastix::GTestUtilities::CreateBSplineTransform<TransformType>(-6.0, 6.0, 10);
+  parameters = elastix::GTestUtilities::GeneratePseudoRandomParameters(transform->GetNumberOfParameters(), -2.0, 2.0);
+  transform->SetParameters(parameters);
+  return transform;
+}
+
+
+// Evaluates the value and derivative of the multi-threaded mean squares metric.
+void
+EvaluateMetric(const bool                   usePrecomputedBSplineWeights,
+               MetricType::MeasureType &    value,
+               MetricType::MeasureType &    valueOnly,
+               MetricType::DerivativeType & derivative)
+{
+  const ImageType::Pointer fixedImage = CreateImage(0.0);
+  const ImageType::Pointer movingImage = CreateImage(1.5);
+
+  TransformType::ParametersType parameters;
+  const TransformType::Pointer  transform = CreateTransform(parameters);
+
+  const auto metric = MetricType::New();
+  metric->SetFixedImage(fixedImage);
+  metric->SetMovingImage(movingImage);
+  metric->SetFixedImageRegion(fixedImage->GetBufferedRegion());
+  metric->SetTransform(transform.GetPointer());
+  metric->SetInterpolator(InterpolatorType::New());
+  metric->SetImageSampler(SamplerType::New());
+  metric->SetUseMultiThread(true);
+  metric->SetNumberOfWorkUnits(3);
+  metric->SetUsePrecomputedBSplineWeights(usePrecomputedBSplineWeights);
+  metric->Initialize();
+
+  metric->GetValueAndDerivative(parameters, value, derivative);
+  valueOnly = metric->GetValue(parameters);
+}
+
+} // namespace
+
+
+// Tests that the batched evaluation with precomputed B-spline weights gives the same result as without.
+GTEST_TEST(AdvancedMeanSquaresImageToImageMetric, PrecomputedBSplineWeightsEqualRegularEvaluation)
+{
+  MetricType::MeasureType    value = 0.0;
+  MetricType::MeasureType    valueOnly = 0.0;
+  MetricType::DerivativeType derivative;
+  EvaluateMetric(false, value, valueOnly, derivative);
+
+  MetricType::MeasureType    precomputedValue = 0.0;
+  MetricType::MeasureType    precomputedValueOnly = 0.0;
+  MetricType::DerivativeType precomputedDerivative;
+  EvaluateMetric(true, precomputedValue, precomputedValueOnly, precomputedDerivative);
+
+  // The weights are computed by other code, so allow for round-off differences.
+  const double tolerance = 1e-10;
+  EXPECT_NE(value, 0.0);
+  EXPECT_NEAR(precomputedValue, value, tolerance * std::abs(value));
+  EXPECT_NEAR(precomputedValueOnly, valueOnly, tolerance * std::abs(valueOnly));
+  ASSERT_EQ(precomputedDerivative.GetSize(), derivative.GetSize());
+  const double derivativeTolerance = tolerance * derivative.inf_norm();
+  for (unsigned int i = 0; i < derivative.GetSize(); ++i)
+  {
+    EXPECT_NEAR(precomputedDerivative[i], derivative[i], derivativeTolerance);
+  }
+}
@@ -0,0 +1,184 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+// First include the header file to be tested:
+#include "MultiMetricMultiResolutionRegistration/itkCombinationImageToImageMetric.h"
+
+#include "AdvancedMeanSquares/itkAdvancedMeanSquaresImageToImageMetric.h"
+#include "AdvancedNormalizedCorrelation/itkAdvancedNormalizedCorrelationImageToImageMetric.h"
+#include "BendingEnergyPenalty/itkTransformBendingEnergyPenaltyTerm.h"
+#include "elxGTestUtilities.h"
+#include "itkAdvancedBSplineDeformableTransform.h"
+#include "itkImageFullSampler.h"
+
+#include <itkBSplineInterpolateImageFunction.h>
+#include <itkImage.h>
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace
+{
+constexpr unsigned int ImageDimension = 2;
+
+using ImageType = itk::Image<float, ImageDimension>;
+using CombinationMetricType = itk::CombinationImageToImageMetric<ImageType, ImageType>;
+using ImageMetricType = CombinationMetricType::ImageMetricType;
+using MeanSquaresType = itk::AdvancedMeanSquaresImageToImageMetric<ImageType, ImageType>;
+using NormalizedCorrelationType = itk::AdvancedNormalizedCorrelationImageToImageMetric<ImageType, ImageType>;
+using BendingEnergyType = itk::TransformBendingEnergyPenaltyTerm<ImageType, double>;
+using TransformType = itk::AdvancedBSplineDeformableTransform<double, ImageDimension, 3>;
+using SamplerType = itk::ImageFullSampler<ImageType>;
+using InterpolatorType = itk::BSplineInterpolateImageFunction<ImageType, double, double>;
+
+
+// A mean squares metric that may not be evaluated concurrently, like a metric that sets the transform parameters.
+class SequentialMeanSquaresType : public MeanSquaresType
+{
+public:
+  using Self = SequentialMeanSquaresType;
+  using Pointer = itk::SmartPointer<Self>;
+  itkNewMacro(Self);
+
+  bool
+  CanBeEvaluatedConcurrently(void) const override
+  {
+    return false;
+  }
+};
+
+
+// The result of an evaluation of the combination metric.
+struct Evaluation
+{
+  CombinationMetricType::MeasureType    value = 0.0;
+  CombinationMetricType::DerivativeType derivative;
+  TransformType::ParametersType         transformParameters;
+};
+
+
+// Creates a combination of mean squares, normalized correlation, the bending energy penalty, and optionally a metric
+// that may not be evaluated concurrently.
+CombinationMetricType::Pointer
+CreateCombinationMetric(const bool                      useSequentialMetric,
+                        const bool                      useParallelMetricEvaluation,
+                        TransformType::Pointer &        transform,
+                        TransformType::ParametersType & parameters)
+{
+  const ImageType::SizeType imageSize{ { 32, 32 } };
+  const auto                fixedImage = elastix::GTestUtilities::CreateSmoothImage<ImageType>(imageSize, 0.0);
+  const auto                movingImage = elastix::GTestUtilities::CreateSmoothImage<ImageType>(imageSize, 1.5);
+  const auto                sampler = SamplerType::New();
+
+  std::vector<ImageMetricType::Pointer> metrics;
+  metrics.push_back(MeanSquaresType::New().GetPointer());
+  metrics.push_back(NormalizedCorrelationType::New().GetPointer());
+  metrics.push_back(BendingEnergyType::New().GetPointer());
+  if (useSequentialMetric)
+  {
+    metrics.push_back(SequentialMeanSquaresType::New().GetPointer());
+  }
+
+  const auto combination = CombinationMetricType::New();
+  combination->SetNumberOfMetrics(static_cast<unsigned int>(metrics.size()));
+  for (unsigned int i = 0; i < metrics.size(); ++i)
+  {
+    metrics[i]->SetImageSampler(sampler);
+    metrics[i]->SetUseMultiThread(true);
+    combination->SetMetric(metrics[i], i);
+    combination->SetMetricWeight(1.0 / (i + 1.0), i);
+  }
+
+  // The transform starts at other parameters than the evaluated ones, so that a missed update would show.
+  transform = elastix::GTestUtilities::CreateBSplineTransform<TransformType>(-6.0, 6.0, 10);
+  parameters = elastix::GTestUtilities::GeneratePseudoRandomParameters(transform->GetNumberOfParameters(), -2.0, 2.0);
+  transform->SetParameters(TransformType::ParametersType(parameters.GetSize(), 0.0));
+
+  combination->SetFixedImage(fixedImage);
+  combination->SetMovingImage(movingImage);
+  combination->SetFixedImageRegion(fixedImage->GetBufferedRegion());
+  combination->SetTransform(transform.GetPointer());
+  combination->SetInterpolator(InterpolatorType::New());
+  combination->SetUseMultiThread(true);
+  combination->SetNumberOfWorkUnits(3);
+  combination->SetUseParallelMetricEvaluation(useParallelMetricEvaluation);
+  combination->Initialize();
+  return combination;
+}
+
+
+// Evaluates the value and derivative of the combination metric.
+Evaluation
+EvaluateCombinationMetric(const bool useSequentialMetric, const bool useParallelMetricEvaluation)
+{
+  TransformType::Pointer               transform;
+  TransformType::ParametersType        parameters;
+  const CombinationMetricType::Pointer combination =
+    CreateCombinationMetric(useSequentialMetric, useParallelMetricEvaluation, transform, parameters);
+
+  Evaluation result;
+  combination->GetValueAndDerivative(parameters, result.value, result.derivative);
+  result.transformParameters = transform->GetParameters();
+  EXPECT_EQ(result.transformParameters, parameters);
+  return result;
+}
+
+
+// Expects that two evaluations have exactly the same results.
+void
+ExpectEqualEvaluations(const Evaluation & actual, const Evaluation & expected)
+{
+  EXPECT_NE(expected.value, 0.0);
+  EXPECT_EQ(actual.value, expected.value);
+  EXPECT_EQ(actual.transformParameters, expected.transformParameters);
+  ASSERT_EQ(actual.derivative.GetSize(), expected.derivative.GetSize());
+  for (unsigned int i = 0; i < expected.derivative.GetSize(); ++i)
+  {
+    EXPECT_EQ(actual.derivative[i], expected.derivative[i]);
+  }
+}
+
+} // namespace
+
+
+// Tests that the metrics are only evaluated concurrently when all of them allow it.
+GTEST_TEST(CombinationImageToImageMetric, CanEvaluateMetricsInParallel)
+{
+  TransformType::Pointer        transform;
+  TransformType::ParametersType parameters;
+  EXPECT_TRUE(CreateCombinationMetric(false, true, transform, parameters)->CanEvaluateMetricsInParallel());
+  EXPECT_FALSE(CreateCombinationMetric(true, true, transform, parameters)->CanEvaluateMetricsInParallel());
+}
+
+
+// Tests that the concurrent evaluation of the image metrics and the bending energy penalty gives the same result as
+// the sequential evaluation.
+GTEST_TEST(CombinationImageToImageMetric, ParallelMetricEvaluationEqualsSequentialEvaluation)
+{
+  // Every sub-metric keeps its own work units, so it sums in the same order as in the sequential evaluation.
+  ExpectEqualEvaluations(EvaluateCombinationMetric(false, true), EvaluateCombinationMetric(false, false));
+}
+
+
+// Tests that a combination with a metric that may not be evaluated concurrently falls back to the sequential
+// evaluation.
+GTEST_TEST(CombinationImageToImageMetric, ParallelMetricEvaluationWithSequentialMetricIsSequential)
+{
+  ExpectEqualEvaluations(EvaluateCombinationMetric(true, true), EvaluateCombinationMetric(true, false));
+}
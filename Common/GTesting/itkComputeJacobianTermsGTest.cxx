@@ -0,0 +1,120 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+// First include the header file to be tested:
+#include "itkComputeJacobianTerms.h"
+
+#include "elxGTestUtilities.h"
+#include "itkAdvancedBSplineDeformableTransform.h"
+
+#include <itkImage.h>
+
+#include <gtest/gtest.h>
+
+namespace
+{
+constexpr unsigned int ImageDimension = 2;
+
+using ImageType = itk::Image<float, ImageDimension>;
+using TransformType = itk::AdvancedBSplineDeformableTransform<double, ImageDimension, 3>;
+using ComputeJacobianTermsType = itk::ComputeJacobianTerms<ImageType, TransformType>;
+
+
+// The four terms that are computed by ComputeJacobianTerms.
+struct JacobianTerms
+{
+  double TrC = 0.0;
+  double TrCC = 0.0;
+  double maxJJ = 0.0;
+  double maxJCJ = 0.0;
+};
+
+
+// Creates a B-spline transform whose grid covers a 40x40 image.
+TransformType::Pointer
+CreateTransform(void)
+{
+  const auto transform = elastix::GTestUtilities::CreateBSplineTransform<TransformType>(-6.0, 6.0, 10);
+  transform->SetIdentity();
+  return transform;
+}
+
+
+// Computes the Jacobian terms with the specified number of work units, like the ASGD optimizer does.
+JacobianTerms
+ComputeTerms(const itk::ThreadIdType numberOfWorkUnits, const bool useThreadPool, const bool useScales)
+{
+  const auto image = ImageType::New();
+  image->SetRegions(ImageType::SizeType{ { 40, 40 } });
+  image->Allocate(true);
+
+  const TransformType::Pointer transform = CreateTransform();
+
+  ComputeJacobianTermsType::ScalesType scales(transform->GetNumberOfParameters());
+  for (unsigned int i = 0; i < scales.GetSize(); ++i)
+  {
+    scales[i] = 1.0 + 0.25 * (i % 5);
+  }
+
+  const auto computeJacobianTerms = ComputeJacobianTermsType::New();
+  computeJacobianTerms->SetFixedImage(image);
+  computeJacobianTerms->SetFixedImageRegion(image->GetBufferedRegion());
+  computeJacobianTerms->SetTransform(transform);
+  computeJacobianTerms->SetMaxBandCovSize(192);
+  computeJacobianTerms->SetNumberOfBandStructureSamples(10);
+  // More samples than fit in one chunk of buffered Jacobians (1024).
+  computeJacobianTerms->SetNumberOfJacobianMeasurements(1600);
+  computeJacobianTerms->SetScales(scales);
+  computeJacobianTerms->SetUseScales(useScales);
+  computeJacobianTerms->SetUseThreadPool(useThreadPool);
+  computeJacobianTerms->SetNumberOfWorkUnits(numberOfWorkUnits);
+
+  JacobianTerms terms;
+  computeJacobianTerms->Compute(terms.TrC, terms.TrCC, terms.maxJJ, terms.maxJCJ);
+  return terms;
+}
+
+} // namespace
+
+
+// Tests that the multi-threaded computation gives exactly the same terms as the single-threaded computation.
+GTEST_TEST(ComputeJacobianTerms, ThreadedEqualsSingleThreaded)
+{
+  for (const bool useScales : { false, true })
+  {
+    const JacobianTerms expected = ComputeTerms(1, false, useScales);
+    EXPECT_GT(expected.TrC, 0.0);
+    EXPECT_GT(expected.TrCC, 0.0);
+    EXPECT_GT(expected.maxJJ, 0.0);
+    EXPECT_GT(expected.maxJCJ, 0.0);
+
+    // The Jacobians are computed once per sample, and each work unit accumulates its own rows of the covariance
+    // matrix in sample order, so the result should not depend on the number of work units nor on the threader.
+    for (const itk::ThreadIdType numberOfWorkUnits : { 2u, 3u, 7u })
+    {
+      for (const bool useThreadPool : { false, true })
+      {
+        const JacobianTerms actual = ComputeTerms(numberOfWorkUnits, useThreadPool, useScales);
+        EXPECT_EQ(actual.TrC, expected.TrC);
+        EXPECT_EQ(actual.TrCC, expected.TrCC);
+        EXPECT_EQ(actual.maxJJ, expected.maxJJ);
+        EXPECT_EQ(actual.maxJCJ, expected.maxJCJ);
+      }
+    }
+  }
+}
@@ -0,0 +1,174 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+// First include the header file to be tested:
+#include "FullSearch/itkFullSearchOptimizer.h"
+
+#include <itkSingleValuedCostFunction.h>
+
+#include <set>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace
+{
+using OptimizerType = itk::FullSearchOptimizer;
+using ParametersType = OptimizerType::ParametersType;
+using SearchSpaceIndexType = OptimizerType::SearchSpaceIndexType;
+using PositionType = std::pair<double, double>;
+
+
+// A smooth bowl in the first two parameters, with its minimum in between the grid points. It remembers the positions
+// at which it is evaluated.
+class BowlCostFunction : public itk::SingleValuedCostFunction
+{
+public:
+  using Self = BowlCostFunction;
+  using Pointer = itk::SmartPointer<Self>;
+  itkNewMacro(Self);
+
+  MeasureType
+  GetValue(const ParametersType & parameters) const override
+  {
+    m_EvaluatedPositions.emplace_back(parameters[0], parameters[1]);
+    return (parameters[0] - 1.3) * (parameters[0] - 1.3) + 2.0 * (parameters[1] + 0.8) * (parameters[1] + 0.8);
+  }
+
+  void
+  GetDerivative(const ParametersType &, DerivativeType &) const override
+  {
+    itkExceptionMacro(<< "The full search does not use the derivative.");
+  }
+
+  unsigned int
+  GetNumberOfParameters(void) const override
+  {
+    return 3;
+  }
+
+  const std::vector<PositionType> &
+  GetEvaluatedPositions(void) const
+  {
+    return m_EvaluatedPositions;
+  }
+
+private:
+  mutable std::vector<PositionType> m_EvaluatedPositions;
+};
+
+
+// Searches the bowl on a grid of 42 x 15 points, on which its minimum is at index (25, 4), position (1.25, -1.0).
+OptimizerType::Pointer
+CreateOptimizer(BowlCostFunction & costFunction,
+                const unsigned int numberOfRefinementLevels,
+                const unsigned int numberOfBestCells)
+{
+  ParametersType initialPosition(3);
+  initialPosition.Fill(0.5);
+
+  const auto optimizer = OptimizerType::New();
+  optimizer->SetCostFunction(&costFunction);
+  optimizer->SetInitialPosition(initialPosition);
+  optimizer->AddSearchDimension(0, -5.0, 5.25, 0.25);
+  optimizer->AddSearchDimension(1, -3.0, 4.0, 0.5);
+  optimizer->SetNumberOfRefinementLevels(numberOfRefinementLevels);
+  optimizer->SetNumberOfBestCells(numberOfBestCells);
+  return optimizer;
+}
+
+
+// Expects that the optimizer has found the grid point at which the bowl is minimal.
+void
+ExpectMinimumOfBowl(OptimizerType & optimizer)
+{
+  const SearchSpaceIndexType & bestIndex = optimizer.GetBestIndexInSearchSpace();
+  ASSERT_EQ(bestIndex.GetSize(), 2u);
+  EXPECT_EQ(bestIndex[0], 25);
+  EXPECT_EQ(bestIndex[1], 4);
+  EXPECT_EQ(optimizer.GetCurrentPosition()[0], 1.25);
+  EXPECT_EQ(optimizer.GetCurrentPosition()[1], -1.0);
+  EXPECT_EQ(optimizer.GetCurrentPosition()[2], 0.5);
+  EXPECT_EQ(optimizer.GetStopCondition(), OptimizerType::FullRangeSearched);
+}
+
+} // namespace
+
+
+// Tests that the full search evaluates every grid point once, in scan order, and finds the minimum of a bowl.
+GTEST_TEST(FullSearchOptimizer, FullSearchFindsMinimumOfBowl)
+{
+  const auto costFunction = BowlCostFunction::New();
+  const auto optimizer = CreateOptimizer(*costFunction, 0, 1);
+  ASSERT_EQ(optimizer->GetNumberOfIterations(), 42UL * 15UL);
+
+  optimizer->StartOptimization();
+  ExpectMinimumOfBowl(*optimizer);
+
+  // Dimension 0 varies fastest, and the linear index is the number in the scan order.
+  const std::vector<PositionType> & positions = costFunction->GetEvaluatedPositions();
+  ASSERT_EQ(positions.size(), optimizer->GetNumberOfIterations());
+  for (unsigned long i = 0; i < positions.size(); ++i)
+  {
+    const SearchSpaceIndexType index = optimizer->LinearIndexToIndex(i);
+    EXPECT_EQ(index[0], static_cast<itk::IndexValueType>(i % 42));
+    EXPECT_EQ(index[1], static_cast<itk::IndexValueType>(i / 42));
+    EXPECT_EQ(optimizer->IndexToLinearIndex(index), i);
+    EXPECT_EQ(positions[i], PositionType(-5.0 + 0.25 * index[0], -3.0 + 0.5 * index[1]));
+  }
+}
+
+
+// Tests that the coarse-to-fine search finds the minimum of a smooth bowl, with fewer evaluations than the full search.
+GTEST_TEST(FullSearchOptimizer, CoarseToFineFindsMinimumOfBowl)
+{
+  for (const unsigned int numberOfRefinementLevels : { 1u, 2u, 3u, 5u })
+  {
+    for (const unsigned int numberOfBestCells : { 1u, 4u })
+    {
+      const auto costFunction = BowlCostFunction::New();
+      const auto optimizer = CreateOptimizer(*costFunction, numberOfRefinementLevels, numberOfBestCells);
+
+      optimizer->StartOptimization();
+      ExpectMinimumOfBowl(*optimizer);
+      EXPECT_EQ(optimizer->GetCurrentIteration(), costFunction->GetEvaluatedPositions().size());
+      EXPECT_LT(optimizer->GetCurrentIteration(), optimizer->GetNumberOfIterations());
+    }
+  }
+}
+
+
+// Tests that the coarse-to-fine search never evaluates a grid point twice, also when the neighbourhoods of the best
+// grid points overlap.
+GTEST_TEST(FullSearchOptimizer, CoarseToFineEvaluatesEachGridPointOnce)
+{
+  for (const unsigned int numberOfRefinementLevels : { 1u, 2u, 3u, 5u })
+  {
+    for (const unsigned int numberOfBestCells : { 1u, 4u, 20u })
+    {
+      const auto costFunction = BowlCostFunction::New();
+      const auto optimizer = CreateOptimizer(*costFunction, numberOfRefinementLevels, numberOfBestCells);
+      optimizer->StartOptimization();
+
+      const std::vector<PositionType> & positions = costFunction->GetEvaluatedPositions();
+      const std::set<PositionType>      uniquePositions(positions.begin(), positions.end());
+      EXPECT_EQ(uniquePositions.size(), positions.size());
+    }
+  }
+}
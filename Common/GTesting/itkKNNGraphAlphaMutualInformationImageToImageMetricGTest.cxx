@@ -0,0 +1,104 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+// First include the header file to be tested:
+#include "KNNGraphAlphaMutualInformation/itkKNNGraphAlphaMutualInformationImageToImageMetric.h"
+
+#include "elxGTestUtilities.h"
+#include "itkAdvancedBSplineDeformableTransform.h"
+#include "itkImageFullSampler.h"
+
+#include <itkBSplineInterpolateImageFunction.h>
+#include <itkImage.h>
+
+#include <gtest/gtest.h>
+
+namespace
+{
+constexpr unsigned int ImageDimension = 2;
+
+using ImageType = itk::Image<float, ImageDimension>;
+using MetricType = itk::KNNGraphAlphaMutualInformationImageToImageMetric<ImageType, ImageType>;
+using TransformType = itk::AdvancedBSplineDeformableTransform<double, ImageDimension, 3>;
+using SamplerType = itk::ImageFullSampler<ImageType>;
+using InterpolatorType = itk::BSplineInterpolateImageFunction<ImageType, double, double>;
+
+
+// The value and derivative of the metric, from GetValueAndDerivative, and the value from GetValue.
+struct Evaluation
+{
+  MetricType::MeasureType    value = 0.0;
+  MetricType::MeasureType    valueOnly = 0.0;
+  MetricType::DerivativeType derivative;
+};
+
+
+// Evaluates the kNN metric on two smooth 32x32 images, single-threaded if the number of work units is zero.
+Evaluation
+EvaluateMetric(const itk::ThreadIdType numberOfWorkUnits)
+{
+  const ImageType::SizeType imageSize{ { 32, 32 } };
+  const ImageType::Pointer  fixedImage = elastix::GTestUtilities::CreateSmoothImage<ImageType>(imageSize, 0.0);
+  const ImageType::Pointer  movingImage = elastix::GTestUtilities::CreateSmoothImage<ImageType>(imageSize, 1.5);
+
+  const auto transform = elastix::GTestUtilities::CreateBSplineTransform<TransformType>(-6.0, 6.0, 10);
+  const TransformType::ParametersType parameters =
+    elastix::GTestUtilities::GeneratePseudoRandomParameters(transform->GetNumberOfParameters(), -2.0, 2.0);
+  transform->SetParameters(parameters);
+
+  const auto metric = MetricType::New();
+  metric->SetFixedImage(fixedImage);
+  metric->SetMovingImage(movingImage);
+  metric->SetFixedImageRegion(fixedImage->GetBufferedRegion());
+  metric->SetTransform(transform.GetPointer());
+  metric->SetInterpolator(InterpolatorType::New());
+  metric->SetImageSampler(SamplerType::New());
+  metric->SetANNkDTree(50, "ANN_KD_SL_MIDPT");
+  metric->SetANNStandardTreeSearch(10, 0.0);
+  metric->SetUseMultiThread(numberOfWorkUnits > 0);
+  if (numberOfWorkUnits > 0)
+  {
+    metric->SetNumberOfWorkUnits(numberOfWorkUnits);
+  }
+  metric->Initialize();
+
+  Evaluation evaluation;
+  metric->GetValueAndDerivative(parameters, evaluation.value, evaluation.derivative);
+  evaluation.valueOnly = metric->GetValue(parameters);
+  return evaluation;
+}
+
+} // namespace
+
+
+// Tests that the threaded tree generation and neighbour search give exactly the same result as the serial ones.
+GTEST_TEST(KNNGraphAlphaMutualInformationImageToImageMetric, ThreadedEqualsSerial)
+{
+  const Evaluation expected = EvaluateMetric(0);
+  EXPECT_NE(expected.value, 0.0);
+
+  // Every query point writes only its own neighbours, and the trees do not depend on the order in which they are
+  // generated, so the number of work units should not matter.
+  for (const itk::ThreadIdType numberOfWorkUnits : { 1u, 2u, 3u, 8u })
+  {
+    const Evaluation actual = EvaluateMetric(numberOfWorkUnits);
+    EXPECT_EQ(actual.value, expected.value);
+    EXPECT_EQ(actual.valueOnly, expected.valueOnly);
+    EXPECT_EQ(actual.derivative, expected.derivative);
+  }
+}
@@ -0,0 +1,238 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+// First include the header file to be tested:
+#include "PCAMetric/itkPCAMetric_F_multithreaded.h"
+
+#include <itkImage.h>
+#include <itkMersenneTwisterRandomVariateGenerator.h>
+
+#include <vnl/algo/vnl_symmetric_eigensystem.h>
+#include <vnl/vnl_diag_matrix.h>
+
+#include <cmath>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace
+{
+using ImageType = itk::Image<float, 3>;
+
+// Gives access to the eigensolvers of the PCA metric, which are protected.
+class EigenSolverPCAMetric : public itk::PCAMetric<ImageType, ImageType>
+{
+public:
+  using Self = EigenSolverPCAMetric;
+  using Pointer = itk::SmartPointer<Self>;
+  itkNewMacro(Self);
+
+  using PCAMetric::ComputeEigenDecomposition;
+  using PCAMetric::ComputeWarmStartedEigenDecomposition;
+};
+
+using RealType = EigenSolverPCAMetric::RealType;
+using MatrixType = EigenSolverPCAMetric::MatrixType;
+using VectorType = vnl_vector<RealType>;
+
+constexpr unsigned int NumberOfImages = 20;
+constexpr unsigned int NumEigenValues = 3;
+
+
+// The eigenpairs that are used by the metric, in descending order of the eigenvalues.
+struct EigenPairs
+{
+  RealType   sumEigenValues = 0.0;
+  VectorType eigenValues;
+  MatrixType eigenVectors;
+};
+
+
+// Creates a symmetric matrix with the specified eigenvalues and random eigenvectors.
+MatrixType
+CreateSymmetricMatrix(const std::vector<RealType> & eigenValues, const unsigned int seed)
+{
+  const auto randomGenerator = itk::Statistics::MersenneTwisterRandomVariateGenerator::New();
+  randomGenerator->SetSeed(seed);
+  MatrixType randomMatrix(NumberOfImages, NumberOfImages);
+  for (unsigned int i = 0; i < NumberOfImages; ++i)
+  {
+    for (unsigned int j = 0; j < NumberOfImages; ++j)
+    {
+      randomMatrix(i, j) = randomGenerator->GetUniformVariate(-1.0, 1.0);
+    }
+  }
+
+  // The eigenvectors of a random symmetric matrix form a random orthonormal basis.
+  const MatrixType                Q = vnl_symmetric_eigensystem<RealType>(randomMatrix + randomMatrix.transpose()).V;
+  const vnl_diag_matrix<RealType> D(VectorType(eigenValues.data(), NumberOfImages));
+  const MatrixType                K = Q * D * Q.transpose();
+  return (K + K.transpose()) * 0.5;
+}
+
+
+// Returns a matrix with three well separated largest eigenvalues.
+MatrixType
+CreateSeparatedMatrix(void)
+{
+  std::vector<RealType> eigenValues{ 10.0, 7.0, 5.0 };
+  for (unsigned int i = NumEigenValues; i < NumberOfImages; ++i)
+  {
+    eigenValues.push_back(1.0 - 0.04 * i);
+  }
+  return CreateSymmetricMatrix(eigenValues, 12345);
+}
+
+
+// Returns the eigenpairs that are computed by the full eigensolver, without warm start.
+EigenPairs
+ComputeColdEigenPairs(const MatrixType & K)
+{
+  EigenPairs result;
+  const auto metric = EigenSolverPCAMetric::New();
+  metric->SetNumEigenValues(NumEigenValues);
+  metric->SetUseWarmStartedEigenSolver(false);
+  metric->ComputeEigenDecomposition(K, result.sumEigenValues, result.eigenVectors);
+
+  const vnl_symmetric_eigensystem<RealType> eig(K);
+  result.eigenValues.set_size(NumEigenValues);
+  for (unsigned int i = 0; i < NumEigenValues; ++i)
+  {
+    result.eigenValues[i] = eig.get_eigenvalue(NumberOfImages - 1 - i);
+  }
+  return result;
+}
+
+
+// Checks that the warm-started eigenpairs are eigenpairs of K, with the eigenvalues of the cold solve.
+void
+ExpectEigenPairsOfMatrix(const MatrixType & K, const EigenPairs & actual, const EigenPairs & expected)
+{
+  const RealType tolerance = 1e-7;
+  EXPECT_NEAR(actual.sumEigenValues, expected.sumEigenValues, NumEigenValues * tolerance);
+  ASSERT_EQ(actual.eigenVectors.rows(), NumberOfImages);
+  ASSERT_EQ(actual.eigenVectors.cols(), NumEigenValues);
+  for (unsigned int i = 0; i < NumEigenValues; ++i)
+  {
+    const VectorType eigenVector = actual.eigenVectors.get_column(i);
+    EXPECT_NEAR(actual.eigenValues[i], expected.eigenValues[i], tolerance);
+    EXPECT_NEAR(eigenVector.two_norm(), 1.0, 1e-12);
+    EXPECT_LE((K * eigenVector - actual.eigenValues[i] * eigenVector).two_norm(), tolerance);
+  }
+}
+
+} // namespace
+
+
+// Tests that a warm start from the eigenvectors of a slightly different matrix gives the eigenpairs of the cold solve.
+GTEST_TEST(PCAMetric, WarmStartedEigenPairsEqualColdSolve)
+{
+  const MatrixType K0 = CreateSeparatedMatrix();
+
+  // A small symmetric perturbation, like the change of the correlation matrix between two iterations.
+  const auto randomGenerator = itk::Statistics::MersenneTwisterRandomVariateGenerator::New();
+  randomGenerator->SetSeed(54321);
+  MatrixType K1 = K0;
+  for (unsigned int i = 0; i < NumberOfImages; ++i)
+  {
+    for (unsigned int j = i; j < NumberOfImages; ++j)
+    {
+      K1(i, j) += randomGenerator->GetUniformVariate(-1e-3, 1e-3);
+      K1(j, i) = K1(i, j);
+    }
+  }
+
+  const auto metric = EigenSolverPCAMetric::New();
+  metric->SetNumEigenValues(NumEigenValues);
+  metric->SetUseWarmStartedEigenSolver(true);
+
+  // The first decomposition has nothing to start from, so it solves the full eigenproblem.
+  EigenPairs       seed;
+  const EigenPairs expectedSeed = ComputeColdEigenPairs(K0);
+  metric->ComputeEigenDecomposition(K0, seed.sumEigenValues, seed.eigenVectors);
+  EXPECT_EQ(seed.sumEigenValues, expectedSeed.sumEigenValues);
+  EXPECT_EQ(seed.eigenVectors, expectedSeed.eigenVectors);
+
+  EigenPairs actual;
+  actual.eigenValues.set_size(NumEigenValues);
+  actual.eigenVectors.set_size(NumberOfImages, NumEigenValues);
+  ASSERT_TRUE(metric->ComputeWarmStartedEigenDecomposition(K1, actual.eigenValues, actual.eigenVectors));
+  actual.sumEigenValues = actual.eigenValues.sum();
+
+  const EigenPairs expected = ComputeColdEigenPairs(K1);
+  ExpectEigenPairsOfMatrix(K1, actual, expected);
+
+  // The eigenvalues are well separated, so the eigenvectors equal those of the cold solve, up to their sign.
+  for (unsigned int i = 0; i < NumEigenValues; ++i)
+  {
+    const RealType cosine = dot_product(actual.eigenVectors.get_column(i), expected.eigenVectors.get_column(i));
+    EXPECT_NEAR(std::abs(cosine), 1.0, 1e-10);
+  }
+
+  // The next decomposition starts from the converged eigenvectors.
+  EigenPairs next;
+  metric->ComputeEigenDecomposition(K1, next.sumEigenValues, next.eigenVectors);
+  next.eigenValues = actual.eigenValues;
+  ExpectEigenPairsOfMatrix(K1, next, expected);
+}
+
+
+// Tests that a rejected warm start falls back on the cold solve, which then seeds the next warm start.
+GTEST_TEST(PCAMetric, RejectedWarmStartFallsBackOnColdSolve)
+{
+  // The third largest eigenvalue lies in a cluster, so the subspace iteration converges too slowly.
+  std::vector<RealType> eigenValues{ 10.0, 9.0 };
+  for (unsigned int i = 2; i < NumberOfImages; ++i)
+  {
+    eigenValues.push_back(1.0 - 1e-5 * i);
+  }
+  const MatrixType K = CreateSymmetricMatrix(eigenValues, 6789);
+
+  const auto metric = EigenSolverPCAMetric::New();
+  metric->SetNumEigenValues(NumEigenValues);
+  metric->SetUseWarmStartedEigenSolver(true);
+
+  // Seed the warm start with the eigenvectors of an unrelated matrix.
+  RealType   seedSum = 0.0;
+  MatrixType seedVectors;
+  metric->ComputeEigenDecomposition(CreateSeparatedMatrix(), seedSum, seedVectors);
+
+  VectorType warmEigenValues(NumEigenValues);
+  MatrixType warmEigenVectors(NumberOfImages, NumEigenValues);
+  EXPECT_FALSE(metric->ComputeWarmStartedEigenDecomposition(K, warmEigenValues, warmEigenVectors));
+
+  // The rejected warm start leaves nothing to start from, so the full eigenproblem is solved, like without warm start.
+  const EigenPairs expected = ComputeColdEigenPairs(K);
+  EigenPairs       actual;
+  metric->ComputeEigenDecomposition(K, actual.sumEigenValues, actual.eigenVectors);
+  EXPECT_EQ(actual.sumEigenValues, expected.sumEigenValues);
+  EXPECT_EQ(actual.eigenVectors, expected.eigenVectors);
+
+  // The fallback seeds the warm start with the eigenvectors of K, so that it is accepted for K itself.
+  ASSERT_TRUE(metric->ComputeWarmStartedEigenDecomposition(K, warmEigenValues, warmEigenVectors));
+  EigenPairs warm;
+  warm.sumEigenValues = warmEigenValues.sum();
+  warm.eigenValues = warmEigenValues;
+  warm.eigenVectors = warmEigenVectors;
+  ExpectEigenPairsOfMatrix(K, warm, expected);
+
+  // A matrix of another size is rejected as well.
+  MatrixType smallerMatrix(NumberOfImages - 1, NumberOfImages - 1);
+  smallerMatrix.set_identity();
+  EXPECT_FALSE(metric->ComputeWarmStartedEigenDecomposition(smallerMatrix, warmEigenValues, warmEigenVectors));
+}
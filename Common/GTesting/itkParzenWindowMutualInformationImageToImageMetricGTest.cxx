@@ -0,0 +1,174 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+// First include the header file to be tested:
+#include "AdvancedMattesMutualInformation/itkParzenWindowMutualInformationImageToImageMetric.h"
+
+#include "elxGTestUtilities.h"
+#include "itkAdvancedBSplineDeformableTransform.h"
+#include "itkExponentialLimiterFunction.h"
+#include "itkHardLimiterFunction.h"
+#include "itkImageFullSampler.h"
+
+#include <itkBSplineInterpolateImageFunction.h>
+#include <itkImage.h>
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace
+{
+constexpr unsigned int ImageDimension = 2;
+
+using ImageType = itk::Image<float, ImageDimension>;
+using TransformType = itk::AdvancedBSplineDeformableTransform<double, ImageDimension, 3>;
+using SamplerType = itk::ImageFullSampler<ImageType>;
+using InterpolatorType = itk::BSplineInterpolateImageFunction<ImageType, double, double>;
+
+
+// Gives access to the joint PDFs of the mutual information, which are protected.
+class JointPDFMetric : public itk::ParzenWindowMutualInformationImageToImageMetric<ImageType, ImageType>
+{
+public:
+  using Self = JointPDFMetric;
+  using Superclass = itk::ParzenWindowMutualInformationImageToImageMetric<ImageType, ImageType>;
+  using Pointer = itk::SmartPointer<Self>;
+  itkNewMacro(Self);
+
+  using Superclass::ComputePDFs;
+  using PDFValuesType = std::vector<PDFValueType>;
+
+  // Returns the bins of the joint PDF.
+  PDFValuesType
+  GetJointPDFValues(void) const
+  {
+    const PDFValueType * buffer = this->m_JointPDF->GetBufferPointer();
+    return PDFValuesType(buffer, buffer + this->m_JointPDF->GetBufferedRegion().GetNumberOfPixels());
+  }
+
+  // Returns the sum of all bins of the joint PDFs of the threads, which are added in the order of the threads.
+  // This is how the joint PDF was accumulated before the merge was restricted to the bins that are touched.
+  PDFValuesType
+  ComputeSumOfThreadJointPDFValues(void) const
+  {
+    PDFValuesType sum(this->m_JointPDF->GetBufferedRegion().GetNumberOfPixels(), 0.0);
+    for (itk::ThreadIdType i = 0; i < this->GetNumberOfWorkUnits(); ++i)
+    {
+      const PDFValueType * threadBuffer =
+        this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[i].st_JointPDF->GetBufferPointer();
+      for (std::size_t j = 0; j < sum.size(); ++j)
+      {
+        sum[j] += threadBuffer[j];
+      }
+    }
+    return sum;
+  }
+};
+
+constexpr itk::ThreadIdType NumberOfWorkUnits = 4;
+
+
+// Creates a multi-threaded mutual information metric with the specified number of histogram bins.
+JointPDFMetric::Pointer
+CreateMetric(const unsigned long numberOfHistogramBins, SamplerType & sampler)
+{
+  const ImageType::SizeType imageSize{ { 32, 32 } };
+  const auto                fixedImage = elastix::GTestUtilities::CreateSmoothImage<ImageType>(imageSize, 0.0);
+  const auto                movingImage = elastix::GTestUtilities::CreateSmoothImage<ImageType>(imageSize, 1.5);
+  const auto                transform = elastix::GTestUtilities::CreateBSplineTransform<TransformType>(-6.0, 6.0, 10);
+
+  const auto metric = JointPDFMetric::New();
+  metric->SetFixedImage(fixedImage);
+  metric->SetMovingImage(movingImage);
+  metric->SetFixedImageRegion(fixedImage->GetBufferedRegion());
+  metric->SetTransform(transform.GetPointer());
+  metric->SetInterpolator(InterpolatorType::New());
+  metric->SetImageSampler(&sampler);
+  metric->SetFixedImageLimiter(itk::HardLimiterFunction<JointPDFMetric::RealType, ImageDimension>::New());
+  metric->SetMovingImageLimiter(itk::ExponentialLimiterFunction<JointPDFMetric::RealType, ImageDimension>::New());
+  metric->SetNumberOfFixedHistogramBins(numberOfHistogramBins);
+  metric->SetNumberOfMovingHistogramBins(numberOfHistogramBins);
+  metric->SetUseMultiThread(true);
+  metric->SetNumberOfWorkUnits(NumberOfWorkUnits);
+  metric->Initialize();
+  return metric;
+}
+
+
+// Returns the sampled region of the second evaluation, which only covers a part of the histograms of the first one.
+ImageType::RegionType
+CreateSubRegion(void)
+{
+  return ImageType::RegionType(ImageType::IndexType{ { 2, 3 } }, ImageType::SizeType{ { 6, 5 } });
+}
+
+
+// Expects that the joint PDF equals the sum of the joint PDFs of the threads, and that it is not empty.
+void
+ExpectJointPDFEqualsSumOfThreadJointPDFs(const JointPDFMetric & metric)
+{
+  const JointPDFMetric::PDFValuesType jointPDFValues = metric.GetJointPDFValues();
+  EXPECT_EQ(jointPDFValues, metric.ComputeSumOfThreadJointPDFValues());
+  EXPECT_NE(jointPDFValues, JointPDFMetric::PDFValuesType(jointPDFValues.size(), 0.0));
+}
+
+
+// Computes the joint PDF twice, at different parameters and of different samples, and compares it with the previous
+// accumulation, and with the joint PDF of a metric that is evaluated once.
+void
+ExpectJointPDFEqualsPreviousAccumulation(const unsigned long numberOfHistogramBins)
+{
+  const auto                    sampler = SamplerType::New();
+  const JointPDFMetric::Pointer metric = CreateMetric(numberOfHistogramBins, *sampler);
+  const unsigned int            numberOfParameters = metric->GetNumberOfParameters();
+
+  metric->ComputePDFs(elastix::GTestUtilities::GeneratePseudoRandomParameters(numberOfParameters, -2.0, 2.0));
+  ExpectJointPDFEqualsSumOfThreadJointPDFs(*metric);
+
+  // The second evaluation touches fewer bins, so the bins of the first one must be reset.
+  const JointPDFMetric::ParametersType secondParameters =
+    elastix::GTestUtilities::GeneratePseudoRandomParameters(numberOfParameters, -1.0, 0.5);
+  sampler->SetInputImageRegion(CreateSubRegion());
+  metric->ComputePDFs(secondParameters);
+  ExpectJointPDFEqualsSumOfThreadJointPDFs(*metric);
+
+  const auto                    freshSampler = SamplerType::New();
+  const JointPDFMetric::Pointer freshMetric = CreateMetric(numberOfHistogramBins, *freshSampler);
+  freshSampler->SetInputImageRegion(CreateSubRegion());
+  freshMetric->ComputePDFs(secondParameters);
+  EXPECT_EQ(metric->GetJointPDFValues(), freshMetric->GetJointPDFValues());
+}
+
+} // namespace
+
+
+// Tests that the joint PDF that is merged single-threadedly equals the previous accumulation. With 4 work units,
+// 16x16 bins stay below the threshold of the threaded merge.
+GTEST_TEST(ParzenWindowMutualInformationImageToImageMetric, SingleThreadedMergeEqualsPreviousAccumulation)
+{
+  ExpectJointPDFEqualsPreviousAccumulation(16);
+}
+
+
+// Tests that the joint PDF that is merged multi-threadedly equals the previous accumulation. With 4 work units,
+// 128x128 bins reach the threshold of the threaded merge.
+GTEST_TEST(ParzenWindowMutualInformationImageToImageMetric, MultiThreadedMergeEqualsPreviousAccumulation)
+{
+  ExpectJointPDFEqualsPreviousAccumulation(128);
+}
@@ -0,0 +1,146 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+// First include the header file to be tested:
+#include "itkStackTransform.h"
+
+#include "elxGTestUtilities.h"
+#include "itkAdvancedBSplineDeformableTransform.h"
+#include "itkAdvancedTranslationTransform.h"
+
+#include <gtest/gtest.h>
+
+namespace
+{
+constexpr unsigned int Dimension = 3;
+constexpr unsigned int NumberOfSubTransforms = 4;
+
+using StackTransformType = itk::StackTransform<double, Dimension, Dimension>;
+using SubTransformType = StackTransformType::SubTransformType;
+using BSplineTransformType = itk::AdvancedBSplineDeformableTransform<double, Dimension - 1, 3>;
+using TranslationTransformType = itk::AdvancedTranslationTransform<double, Dimension - 1>;
+using ParametersType = StackTransformType::ParametersType;
+
+
+// Creates a B-spline transform, whose grid covers [0, 40]^2.
+BSplineTransformType::Pointer
+CreateBSplineTransform(void)
+{
+  return elastix::GTestUtilities::CreateBSplineTransform<BSplineTransformType>(-10.0, 10.0, 7);
+}
+
+
+// Creates a stack of copies of the sub transform, and sets random parameters.
+StackTransformType::Pointer
+CreateStackTransform(SubTransformType & subTransform, ParametersType & parameters)
+{
+  const auto stackTransform = StackTransformType::New();
+  stackTransform->SetNumberOfSubTransforms(NumberOfSubTransforms);
+  stackTransform->SetStackOrigin(-1.5);
+  stackTransform->SetStackSpacing(2.0);
+  stackTransform->SetAllSubTransforms(&subTransform);
+
+  parameters =
+    elastix::GTestUtilities::GeneratePseudoRandomParameters(stackTransform->GetNumberOfParameters(), -2.0, 2.0);
+  stackTransform->SetParameters(parameters);
+  return stackTransform;
+}
+
+
+// Expects that the stack transform maps points at the last dimension position of sub transform t like a copy of
+// the sub transform, with the parameters of sub transform t, does.
+void
+ExpectStackTransformEqualsSubTransforms(const StackTransformType & stackTransform,
+                                        SubTransformType &         subTransform,
+                                        const ParametersType &     parameters)
+{
+  const unsigned int numberOfSubTransformParameters = subTransform.GetNumberOfParameters();
+  ASSERT_EQ(parameters.GetSize(), NumberOfSubTransforms * numberOfSubTransformParameters);
+
+  for (unsigned int t = 0; t < NumberOfSubTransforms; ++t)
+  {
+    ParametersType subTransformParameters(numberOfSubTransformParameters);
+    for (unsigned int i = 0; i < numberOfSubTransformParameters; ++i)
+    {
+      subTransformParameters[i] = parameters[t * numberOfSubTransformParameters + i];
+    }
+    subTransform.SetParametersByValue(subTransformParameters);
+
+    for (double x = -5.0; x <= 45.0; x += 3.5)
+    {
+      for (double y = -5.0; y <= 45.0; y += 4.5)
+      {
+        StackTransformType::InputPointType ipp;
+        ipp[0] = x;
+        ipp[1] = y;
+        ipp[2] = stackTransform.GetStackOrigin() + t * stackTransform.GetStackSpacing();
+        SubTransformType::InputPointType ippr;
+        ippr[0] = x;
+        ippr[1] = y;
+
+        const StackTransformType::OutputPointType opp = stackTransform.TransformPoint(ipp);
+        const SubTransformType::OutputPointType   oppr = subTransform.TransformPoint(ippr);
+        EXPECT_EQ(opp[0], oppr[0]);
+        EXPECT_EQ(opp[1], oppr[1]);
+        EXPECT_EQ(opp[2], ipp[2]);
+      }
+    }
+  }
+}
+
+} // namespace
+
+
+// Tests that every sub transform of a B-spline stack uses its own part of the parameters of the stack.
+GTEST_TEST(StackTransform, BSplineStackEqualsSubTransforms)
+{
+  const BSplineTransformType::Pointer subTransform = CreateBSplineTransform();
+  ParametersType                      parameters;
+  const StackTransformType::Pointer   stackTransform = CreateStackTransform(*subTransform, parameters);
+
+  EXPECT_EQ(stackTransform->GetParameters(), parameters);
+  ExpectStackTransformEqualsSubTransforms(*stackTransform, *subTransform, parameters);
+}
+
+
+// Tests that every sub transform of a translation stack uses its own part of the parameters of the stack.
+GTEST_TEST(StackTransform, TranslationStackEqualsSubTransforms)
+{
+  const auto                        subTransform = TranslationTransformType::New();
+  ParametersType                    parameters;
+  const StackTransformType::Pointer stackTransform = CreateStackTransform(*subTransform, parameters);
+
+  EXPECT_EQ(stackTransform->GetParameters(), parameters);
+  ExpectStackTransformEqualsSubTransforms(*stackTransform, *subTransform, parameters);
+}
+
+
+// Tests that the stack transform keeps its own copy of the parameters that are set by value.
+GTEST_TEST(StackTransform, SetParametersByValueKeepsCopy)
+{
+  const BSplineTransformType::Pointer subTransform = CreateBSplineTransform();
+  ParametersType                      parameters;
+  const StackTransformType::Pointer   stackTransform = CreateStackTransform(*subTransform, parameters);
+
+  ParametersType temporaryParameters = parameters;
+  stackTransform->SetParametersByValue(temporaryParameters);
+  temporaryParameters.Fill(0.0);
+
+  EXPECT_EQ(stackTransform->GetParameters(), parameters);
+  ExpectStackTransformEqualsSubTransforms(*stackTransform, *subTransform, parameters);
+}
@@ -0,0 +1,170 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+// First include the header file to be tested:
+#include "SplineKernelTransform/itkThinPlateSplineKernelTransform2.h"
+
+#include <itkMersenneTwisterRandomVariateGenerator.h>
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace
+{
+constexpr unsigned int Dimension = 2;
+
+using TransformType = itk::ThinPlateSplineKernelTransform2<double, Dimension>;
+using PointSetType = TransformType::PointSetType;
+using PointType = TransformType::InputPointType;
+
+
+// A thin plate spline that solves either the decoupled L matrix, one system for all dimensions, or the full L matrix,
+// like the kernels with a non-diagonal G do.
+template <bool VDecoupled>
+class SolveTransform : public TransformType
+{
+public:
+  using Self = SolveTransform;
+  using Pointer = itk::SmartPointer<Self>;
+  itkNewMacro(Self);
+
+  using TransformType::m_LMatrixInverse;
+
+protected:
+  SolveTransform() { this->m_FastComputationPossible = VDecoupled; }
+};
+
+
+// Creates a thin plate spline with the specified number of random landmarks in [0, 100]^2.
+template <typename TTransform = TransformType>
+typename TTransform::Pointer
+CreateTransform(const unsigned int numberOfLandmarks, const std::string & matrixInversionMethod = "SVD")
+{
+  const auto randomGenerator = itk::Statistics::MersenneTwisterRandomVariateGenerator::New();
+  randomGenerator->SetSeed(12345);
+
+  const auto sourceLandmarks = PointSetType::New();
+  const auto targetLandmarks = PointSetType::New();
+  for (unsigned int i = 0; i < numberOfLandmarks; ++i)
+  {
+    PointType source;
+    PointType target;
+    for (unsigned int dim = 0; dim < Dimension; ++dim)
+    {
+      source[dim] = randomGenerator->GetUniformVariate(0.0, 100.0);
+    }
+    for (unsigned int dim = 0; dim < Dimension; ++dim)
+    {
+      const double noise = randomGenerator->GetUniformVariate(-0.5, 0.5);
+      target[dim] = source[dim] + 2.0 * std::sin(source[1 - dim] / 15.0) + noise;
+    }
+    sourceLandmarks->SetPoint(i, source);
+    targetLandmarks->SetPoint(i, target);
+  }
+
+  const auto transform = TTransform::New();
+  transform->SetMatrixInversionMethod(matrixInversionMethod);
+  transform->SetSourceLandmarks(sourceLandmarks);
+  transform->SetTargetLandmarks(targetLandmarks);
+  return transform;
+}
+
+
+// Returns points on a grid around the landmarks, from close by to far away.
+std::vector<PointType>
+CreateTestPoints(void)
+{
+  std::vector<PointType> points;
+  for (double x = -1000.0; x <= 1100.0; x += 37.5)
+  {
+    for (double y = -1000.0; y <= 1100.0; y += 37.5)
+    {
+      PointType point;
+      point[0] = x;
+      point[1] = y;
+      points.push_back(point);
+    }
+  }
+  return points;
+}
+
+} // namespace
+
+
+// Tests that the far-field approximation stays within its tolerance of the exact kernel sum.
+GTEST_TEST(ThinPlateSplineKernelTransform2, FarFieldApproximationIsWithinTolerance)
+{
+  // More landmarks than the minimum for which the landmarks are clustered (4 clusters of 64 landmarks).
+  const TransformType::Pointer transform = CreateTransform(400);
+  const std::vector<PointType> points = CreateTestPoints();
+
+  std::vector<PointType> exactPoints;
+  for (const PointType & point : points)
+  {
+    exactPoints.push_back(transform->TransformPoint(point));
+  }
+
+  for (const double tolerance : { 1e-1, 1e-3 })
+  {
+    transform->SetFarFieldTolerance(tolerance);
+    double maximumError = 0.0;
+    for (std::size_t i = 0; i < points.size(); ++i)
+    {
+      const PointType approximatePoint = transform->TransformPoint(points[i]);
+      maximumError = std::max(maximumError, approximatePoint.EuclideanDistanceTo(exactPoints[i]));
+    }
+    EXPECT_LE(maximumError, tolerance);
+  }
+
+  // Switching the approximation off again gives the exact kernel sum, up to the order of summation.
+  transform->SetFarFieldTolerance(0.0);
+  for (std::size_t i = 0; i < points.size(); ++i)
+  {
+    EXPECT_LE(transform->TransformPoint(points[i]).EuclideanDistanceTo(exactPoints[i]), 1e-8);
+  }
+}
+
+
+// Tests that solving the decoupled L matrix, one system for all dimensions, gives the solution of the full L matrix.
+GTEST_TEST(ThinPlateSplineKernelTransform2, DecoupledSolveEqualsFullSolve)
+{
+  const std::vector<PointType> points = CreateTestPoints();
+
+  for (const std::string matrixInversionMethod : { "SVD", "QR" })
+  {
+    const auto decoupledTransform = CreateTransform<SolveTransform<true>>(100, matrixInversionMethod);
+    const auto fullTransform = CreateTransform<SolveTransform<false>>(100, matrixInversionMethod);
+
+    // The inverse of the decoupled L matrix is expanded to the block structure of the full inverse.
+    const auto & decoupledInverse = decoupledTransform->m_LMatrixInverse;
+    const auto & fullInverse = fullTransform->m_LMatrixInverse;
+    ASSERT_EQ(decoupledInverse.rows(), fullInverse.rows());
+    ASSERT_EQ(decoupledInverse.cols(), fullInverse.cols());
+    EXPECT_LE((decoupledInverse - fullInverse).absolute_value_max(), 1e-8 * fullInverse.absolute_value_max());
+
+    for (const PointType & point : points)
+    {
+      EXPECT_LE(decoupledTransform->TransformPoint(point).EuclideanDistanceTo(fullTransform->TransformPoint(point)),
+                1e-6);
+    }
+  }
+}
@@ -0,0 +1,136 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+// First include the header file to be tested:
+#include "BendingEnergyPenalty/itkTransformBendingEnergyPenaltyTerm.h"
+
+#include "elxGTestUtilities.h"
+#include "itkAdvancedBSplineDeformableTransform.h"
+#include "itkImageFullSampler.h"
+
+#include <itkBSplineInterpolateImageFunction.h>
+#include <itkImage.h>
+
+#include <cmath>
+
+#include <gtest/gtest.h>
+
+namespace
+{
+constexpr unsigned int ImageDimension = 2;
+
+using ImageType = itk::Image<float, ImageDimension>;
+using MetricType = itk::TransformBendingEnergyPenaltyTerm<ImageType, double>;
+using TransformType = itk::AdvancedBSplineDeformableTransform<double, ImageDimension, 3>;
+using SamplerType = itk::ImageFullSampler<ImageType>;
+using InterpolatorType = itk::BSplineInterpolateImageFunction<ImageType, double, double>;
+
+
+// Creates a B-spline transform with random parameters, whose valid region covers a 64x64 image.
+// The knots lie on the pixel boundaries, so that every pixel lies within one polynomial piece.
+TransformType::Pointer
+CreateTransform(TransformType::ParametersType & parameters)
+{
+  const auto transform = elastix::GTestUtilities::CreateBSplineTransform<TransformType>(-16.5, 8.0, 13);
+  parameters = elastix::GTestUtilities::GeneratePseudoRandomParameters(transform->GetNumberOfParameters(), -2.0, 2.0);
+  transform->SetParameters(parameters);
+  return transform;
+}
+
+
+// Creates a bending energy penalty term, which samples every pixel of a 64x64 image.
+MetricType::Pointer
+CreateMetric(const bool useAnalyticBendingEnergy, TransformType::ParametersType & parameters)
+{
+  const auto image = ImageType::New();
+  image->SetRegions(ImageType::SizeType{ { 64, 64 } });
+  image->Allocate(true);
+
+  const TransformType::Pointer transform = CreateTransform(parameters);
+
+  const auto metric = MetricType::New();
+  metric->SetFixedImage(image);
+  metric->SetMovingImage(image);
+  metric->SetFixedImageRegion(image->GetBufferedRegion());
+  metric->SetTransform(transform.GetPointer());
+  metric->SetInterpolator(InterpolatorType::New());
+  metric->SetImageSampler(SamplerType::New());
+  metric->SetUseAnalyticBendingEnergy(useAnalyticBendingEnergy);
+  metric->Initialize();
+  return metric;
+}
+
+} // namespace
+
+
+// Tests that the analytic bending energy is close to the bending energy sampled at every pixel.
+GTEST_TEST(TransformBendingEnergyPenaltyTerm, AnalyticEnergyEqualsDenselySampledEnergy)
+{
+  TransformType::ParametersType parameters;
+  const MetricType::Pointer     sampledMetric = CreateMetric(false, parameters);
+  const MetricType::Pointer     analyticMetric = CreateMetric(true, parameters);
+
+  MetricType::MeasureType    sampledValue = 0.0;
+  MetricType::DerivativeType sampledDerivative;
+  sampledMetric->GetValueAndDerivative(parameters, sampledValue, sampledDerivative);
+
+  MetricType::MeasureType    analyticValue = 0.0;
+  MetricType::DerivativeType analyticDerivative;
+  analyticMetric->GetValueAndDerivative(parameters, analyticValue, analyticDerivative);
+
+  // The sampled energy is the midpoint rule of the integral that is computed analytically.
+  const double tolerance = 1e-2;
+  EXPECT_GT(sampledValue, 0.0);
+  EXPECT_NEAR(analyticValue, sampledValue, tolerance * sampledValue);
+  EXPECT_NEAR(analyticMetric->GetValue(parameters), analyticValue, 1e-12 * analyticValue);
+
+  ASSERT_EQ(analyticDerivative.GetSize(), sampledDerivative.GetSize());
+  const double derivativeTolerance = tolerance * sampledDerivative.inf_norm();
+  for (unsigned int i = 0; i < sampledDerivative.GetSize(); ++i)
+  {
+    EXPECT_NEAR(analyticDerivative[i], sampledDerivative[i], derivativeTolerance);
+  }
+}
+
+
+// Tests the analytic derivative against central finite differences of the analytic energy.
+GTEST_TEST(TransformBendingEnergyPenaltyTerm, AnalyticDerivativeEqualsFiniteDifferences)
+{
+  TransformType::ParametersType parameters;
+  const MetricType::Pointer     metric = CreateMetric(true, parameters);
+
+  MetricType::MeasureType    value = 0.0;
+  MetricType::DerivativeType derivative;
+  metric->GetValueAndDerivative(parameters, value, derivative);
+  ASSERT_EQ(derivative.GetSize(), parameters.GetSize());
+
+  // The energy is quadratic in the parameters, so central differences are exact up to round-off.
+  const double                  delta = 0.5;
+  const double                  tolerance = 1e-8 * derivative.inf_norm();
+  TransformType::ParametersType perturbedParameters = parameters;
+  for (unsigned int i = 0; i < parameters.GetSize(); ++i)
+  {
+    perturbedParameters[i] = parameters[i] + delta;
+    const double valuePlus = metric->GetValue(perturbedParameters);
+    perturbedParameters[i] = parameters[i] - delta;
+    const double valueMin = metric->GetValue(perturbedParameters);
+    perturbedParameters[i] = parameters[i];
+
+    EXPECT_NEAR(derivative[i], (valuePlus - valueMin) / (2.0 * delta), tolerance);
+  }
+}
@@ -0,0 +1,418 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+// First include the header file to be tested:
+#include "RigidityPenalty/itkTransformRigidityPenaltyTerm.h"
+
+#include "elxGTestUtilities.h"
+#include "itkAdvancedBSplineDeformableTransform.h"
+
+#include <itkBSplineInterpolateImageFunction.h>
+#include <itkImage.h>
+#include <itkImageRegionIterator.h>
+#include <itkMersenneTwisterRandomVariateGenerator.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace
+{
+constexpr unsigned int ImageDimension = 2;
+
+using ImageType = itk::Image<float, ImageDimension>;
+using MetricType = itk::TransformRigidityPenaltyTerm<ImageType, double>;
+using TransformType = itk::AdvancedBSplineDeformableTransform<double, ImageDimension, 3>;
+using RigidityImageType = MetricType::RigidityImageType;
+using InterpolatorType = itk::BSplineInterpolateImageFunction<ImageType, double, double>;
+
+// A non-square B-spline grid, with anisotropic spacing.
+constexpr unsigned int GridSizeX = 8;
+constexpr unsigned int GridSizeY = 9;
+constexpr double       GridSpacingX = 5.0;
+constexpr double       GridSpacingY = 7.0;
+
+// The weights of the linearity, orthonormality and properness conditions.
+constexpr double LinearityWeight = 0.3;
+constexpr double OrthonormalityWeight = 2.0;
+constexpr double PropernessWeight = 0.7;
+
+
+// The results of the rigidity penalty term.
+struct RigidityPenalty
+{
+  double                     value = 0.0;
+  double                     linearityValue = 0.0;
+  double                     orthonormalityValue = 0.0;
+  double                     propernessValue = 0.0;
+  double                     linearityGradientMagnitude = 0.0;
+  double                     orthonormalityGradientMagnitude = 0.0;
+  double                     propernessGradientMagnitude = 0.0;
+  MetricType::DerivativeType derivative;
+};
+
+
+// Samples an image on the grid, with the zero flux Neumann boundary condition of the previous implementation.
+class GridImage
+{
+public:
+  explicit GridImage(const double * data)
+    : m_Data(data)
+  {}
+
+  double
+  operator()(const int x, const int y) const
+  {
+    const int cx = std::min(std::max(x, 0), static_cast<int>(GridSizeX) - 1);
+    const int cy = std::min(std::max(y, 0), static_cast<int>(GridSizeY) - 1);
+    return m_Data[cx + GridSizeX * cy];
+  }
+
+private:
+  const double * m_Data;
+};
+
+
+// Applies 1D operators in x and then in y, like the NeighborhoodOperatorImageFilters of the previous implementation.
+std::vector<double>
+FilterSeparable(const double * image, const double (&operatorX)[3], const double (&operatorY)[3])
+{
+  std::vector<double> filteredX(GridSizeX * GridSizeY);
+  const GridImage     in(image);
+  for (int y = 0; y < static_cast<int>(GridSizeY); ++y)
+  {
+    for (int x = 0; x < static_cast<int>(GridSizeX); ++x)
+    {
+      double sum = 0.0;
+      for (int k = 0; k < 3; ++k)
+      {
+        sum += operatorX[k] * in(x + k - 1, y);
+      }
+      filteredX[x + GridSizeX * y] = sum;
+    }
+  }
+
+  std::vector<double> filtered(GridSizeX * GridSizeY);
+  const GridImage     inX(filteredX.data());
+  for (int y = 0; y < static_cast<int>(GridSizeY); ++y)
+  {
+    for (int x = 0; x < static_cast<int>(GridSizeX); ++x)
+    {
+      double sum = 0.0;
+      for (int k = 0; k < 3; ++k)
+      {
+        sum += operatorY[k] * inX(x, y + k - 1);
+      }
+      filtered[x + GridSizeX * y] = sum;
+    }
+  }
+  return filtered;
+}
+
+
+// Returns the inner product of a 3x3 operator with the neighbourhood of (x,y) of the product of two images.
+double
+InnerProduct(const double (&op)[9], const GridImage & part, const GridImage & rigidity, const int x, const int y)
+{
+  double sum = 0.0;
+  for (int k = 0; k < 9; ++k)
+  {
+    const int nx = x + k % 3 - 1;
+    const int ny = y + k / 3 - 1;
+    sum += op[k] * part(nx, ny) * rigidity(nx, ny);
+  }
+  return sum;
+}
+
+
+// Computes the rigidity penalty term in 2D as the previous, filter based, implementation did.
+RigidityPenalty
+ComputeReferencePenalty(const TransformType::ParametersType & parameters, const std::vector<double> & rigidity)
+{
+  const unsigned int N = GridSizeX * GridSizeY;
+  const double       sx = GridSpacingX;
+  const double       sy = GridSpacingY;
+  const double       b3[3] = { 1.0 / 6.0, 4.0 / 6.0, 1.0 / 6.0 };
+
+  /** The 1D operators of Create1DOperator() for FA, FB, FD, FE and FG. */
+  const double dx[3] = { -0.5 / sx, 0.0, 0.5 / sx };
+  const double dy[3] = { -0.5 / sy, 0.0, 0.5 / sy };
+  const double dxx[3] = { 0.5 / (sx * sx), -1.0 / (sx * sx), 0.5 / (sx * sx) };
+  const double dyy[3] = { 0.5 / (sy * sy), -1.0 / (sy * sy), 0.5 / (sy * sy) };
+  const double dxy[3] = { -0.5 / (sx * sy), 0.0, 0.5 / (sx * sy) };
+
+  /** The 3x3 operators of CreateNDOperator() for FA, FB, FD, FE and FG, before scaling by the spacing. */
+  const double ndA[9] = { 1.0 / 12.0, 0.0, -1.0 / 12.0, 1.0 / 3.0, 0.0, -1.0 / 3.0, 1.0 / 12.0, 0.0, -1.0 / 12.0 };
+  const double ndB[9] = { 1.0 / 12.0, 1.0 / 3.0, 1.0 / 12.0, 0.0, 0.0, 0.0, -1.0 / 12.0, -1.0 / 3.0, -1.0 / 12.0 };
+  const double ndD[9] = { 1.0 / 12.0, -1.0 / 6.0, 1.0 / 12.0, 1.0 / 3.0, -2.0 / 3.0,
+                          1.0 / 3.0,  1.0 / 12.0, -1.0 / 6.0, 1.0 / 12.0 };
+  const double ndE[9] = { 1.0 / 12.0, 1.0 / 3.0,  1.0 / 12.0, -1.0 / 6.0, -2.0 / 3.0,
+                          -1.0 / 6.0, 1.0 / 12.0, 1.0 / 3.0,  1.0 / 12.0 };
+  const double ndG[9] = { 0.25, 0.0, -0.25, 0.0, 0.0, 0.0, -0.25, 0.0, 0.25 };
+
+  /** Filter the coefficient images. */
+  std::vector<double> FA[ImageDimension], FB[ImageDimension], FD[ImageDimension], FE[ImageDimension],
+    FG[ImageDimension];
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    const double * coefficients = parameters.data_block() + i * N;
+    FA[i] = FilterSeparable(coefficients, dx, b3);
+    FB[i] = FilterSeparable(coefficients, b3, dy);
+    FD[i] = FilterSeparable(coefficients, dxx, b3);
+    FE[i] = FilterSeparable(coefficients, b3, dyy);
+    FG[i] = FilterSeparable(coefficients, dxy, dxy);
+  }
+
+  double rigiditySum = 0.0;
+  for (const double c : rigidity)
+  {
+    rigiditySum += c;
+  }
+
+  /** Compute the condition values and the subparts of the derivative. */
+  RigidityPenalty     result;
+  std::vector<double> OCparts[ImageDimension][ImageDimension];
+  std::vector<double> PCparts[ImageDimension][ImageDimension];
+  std::vector<double> LCparts[ImageDimension][3];
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    for (unsigned int j = 0; j < ImageDimension; ++j)
+    {
+      OCparts[i][j].resize(N);
+      PCparts[i][j].resize(N);
+    }
+    for (unsigned int j = 0; j < 3; ++j)
+    {
+      LCparts[i][j].resize(N);
+    }
+  }
+  for (unsigned int n = 0; n < N; ++n)
+  {
+    const double c = rigidity[n];
+    const double a1 = 1.0 + FA[0][n];
+    const double a2 = FA[1][n];
+    const double b1 = FB[0][n];
+    const double b2 = 1.0 + FB[1][n];
+
+    const double oc1 = a1 * a1 + a2 * a2 - 1.0;
+    const double oc2 = b1 * b1 + b2 * b2 - 1.0;
+    const double oc3 = a1 * b1 + a2 * b2;
+    result.orthonormalityValue += c * (oc1 * oc1 + oc2 * oc2 + oc3 * oc3);
+    OCparts[0][0][n] = 2.0 * (2.0 * a1 * a1 * a1 + 2.0 * a2 * a2 * a1 - 2.0 * a1 + b1 * b1 * a1 + a2 * b2 * b1);
+    OCparts[0][1][n] = 2.0 * (b1 * a1 * a1 + a2 * b2 * a1 + 2.0 * b1 * b1 * b1 + 2.0 * b1 * b2 * b2 - 2.0 * b1);
+    OCparts[1][0][n] = 2.0 * (2.0 * a2 * a2 * a2 + 2.0 * a2 * a1 * a1 - 2.0 * a2 + a2 * b2 * b2 + b1 * a1 * b2);
+    OCparts[1][1][n] = 2.0 * (a2 * a2 * b2 + b1 * a1 * a2 + 2.0 * b2 * b2 * b2 + 2.0 * b1 * b1 * b2 - 2.0 * b2);
+
+    const double pc = a1 * b2 - a2 * b1 - 1.0;
+    result.propernessValue += c * pc * pc;
+    PCparts[0][0][n] = 2.0 * (b2 * b2 * a1 - a2 * b2 * b1 - b2);
+    PCparts[0][1][n] = 2.0 * (a2 + a2 * a2 * b1 - a2 * b2 * a1);
+    PCparts[1][0][n] = 2.0 * (b1 * b1 * a2 - b1 * a1 * b2 + b1);
+    PCparts[1][1][n] = 2.0 * (-a1 + a1 * a1 * b2 - b1 * a1 * a2);
+
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      result.linearityValue += c * (FD[i][n] * FD[i][n] + FE[i][n] * FE[i][n] + FG[i][n] * FG[i][n]);
+      LCparts[i][0][n] = 2.0 * FD[i][n];
+      LCparts[i][1][n] = 2.0 * FE[i][n];
+      LCparts[i][2][n] = 2.0 * FG[i][n];
+    }
+  }
+  result.linearityValue /= rigiditySum;
+  result.orthonormalityValue /= rigiditySum;
+  result.propernessValue /= rigiditySum;
+  result.value = LinearityWeight * result.linearityValue + OrthonormalityWeight * result.orthonormalityValue +
+                 PropernessWeight * result.propernessValue;
+
+  /** Filter the subparts and add them to the derivative. */
+  const GridImage rigidityImage(rigidity.data());
+  result.derivative.SetSize(ImageDimension * N);
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    const GridImage oc0(OCparts[i][0].data()), oc1(OCparts[i][1].data());
+    const GridImage pc0(PCparts[i][0].data()), pc1(PCparts[i][1].data());
+    const GridImage lc0(LCparts[i][0].data()), lc1(LCparts[i][1].data()), lc2(LCparts[i][2].data());
+    for (int y = 0; y < static_cast<int>(GridSizeY); ++y)
+    {
+      for (int x = 0; x < static_cast<int>(GridSizeX); ++x)
+      {
+        const double tmpOC = OrthonormalityWeight * (InnerProduct(ndA, oc0, rigidityImage, x, y) / sx +
+                                                     InnerProduct(ndB, oc1, rigidityImage, x, y) / sy);
+        const double tmpPC = PropernessWeight * (InnerProduct(ndA, pc0, rigidityImage, x, y) / sx +
+                                                 InnerProduct(ndB, pc1, rigidityImage, x, y) / sy);
+        const double tmpLC = LinearityWeight * (InnerProduct(ndD, lc0, rigidityImage, x, y) / (sx * sx) +
+                                                InnerProduct(ndE, lc1, rigidityImage, x, y) / (sy * sy) +
+                                                InnerProduct(ndG, lc2, rigidityImage, x, y) / (sx * sy));
+
+        result.linearityGradientMagnitude += tmpLC * tmpLC / (rigiditySum * rigiditySum);
+        result.orthonormalityGradientMagnitude += tmpOC * tmpOC / (rigiditySum * rigiditySum);
+        result.propernessGradientMagnitude += tmpPC * tmpPC / (rigiditySum * rigiditySum);
+        result.derivative[i * N + x + GridSizeX * y] = (tmpLC + tmpOC + tmpPC) / rigiditySum;
+      }
+    }
+  }
+  result.linearityGradientMagnitude = std::sqrt(result.linearityGradientMagnitude);
+  result.orthonormalityGradientMagnitude = std::sqrt(result.orthonormalityGradientMagnitude);
+  result.propernessGradientMagnitude = std::sqrt(result.propernessGradientMagnitude);
+  return result;
+}
+
+
+// Creates a B-spline transform with random parameters.
+TransformType::Pointer
+CreateTransform(TransformType::ParametersType & parameters)
+{
+  TransformType::OriginType  gridOrigin;
+  TransformType::SpacingType gridSpacing;
+  gridOrigin[0] = -10.0;
+  gridOrigin[1] = -12.0;
+  gridSpacing[0] = GridSpacingX;
+  gridSpacing[1] = GridSpacingY;
+
+  const auto transform = elastix::GTestUtilities::CreateBSplineTransform<TransformType>(
+    gridOrigin, gridSpacing, TransformType::RegionType::SizeType{ { GridSizeX, GridSizeY } });
+  parameters = elastix::GTestUtilities::GeneratePseudoRandomParameters(transform->GetNumberOfParameters(), -1.0, 1.0);
+  transform->SetParameters(parameters);
+  return transform;
+}
+
+
+// Creates a fixed rigidity image on the B-spline grid, so that it is copied to the rigidity coefficients as is.
+RigidityImageType::Pointer
+CreateRigidityImage(const TransformType & transform, std::vector<double> & rigidity)
+{
+  const auto image = RigidityImageType::New();
+  image->SetRegions(transform.GetGridRegion());
+  image->SetOrigin(transform.GetGridOrigin());
+  image->SetSpacing(transform.GetGridSpacing());
+  image->SetDirection(transform.GetGridDirection());
+  image->Allocate();
+
+  const auto randomGenerator = itk::Statistics::MersenneTwisterRandomVariateGenerator::New();
+  randomGenerator->SetSeed(54321);
+  rigidity.clear();
+  for (itk::ImageRegionIterator<RigidityImageType> it(image, image->GetBufferedRegion()); !it.IsAtEnd(); ++it)
+  {
+    it.Set(randomGenerator->GetUniformVariate(0.0, 1.0));
+    rigidity.push_back(it.Get());
+  }
+  return image;
+}
+
+
+// Evaluates the rigidity penalty term, single-threaded or with the specified number of work units.
+RigidityPenalty
+EvaluatePenalty(const bool                      useMultiThread,
+                TransformType::ParametersType & parameters,
+                std::vector<double> &           rigidity)
+{
+  const auto image = ImageType::New();
+  image->SetRegions(ImageType::SizeType{ { 32, 32 } });
+  image->Allocate(true);
+
+  const TransformType::Pointer transform = CreateTransform(parameters);
+
+  const auto metric = MetricType::New();
+  metric->SetFixedImage(image);
+  metric->SetMovingImage(image);
+  metric->SetFixedImageRegion(image->GetBufferedRegion());
+  metric->SetTransform(transform.GetPointer());
+  metric->SetInterpolator(InterpolatorType::New());
+  metric->SetFixedRigidityImage(CreateRigidityImage(*transform, rigidity));
+  metric->SetUseFixedRigidityImage(true);
+  metric->SetUseMovingRigidityImage(false);
+  metric->SetDilateRigidityImages(false);
+  metric->SetLinearityConditionWeight(LinearityWeight);
+  metric->SetOrthonormalityConditionWeight(OrthonormalityWeight);
+  metric->SetPropernessConditionWeight(PropernessWeight);
+  metric->SetUseMultiThread(useMultiThread);
+  metric->SetNumberOfWorkUnits(3);
+  metric->Initialize();
+
+  RigidityPenalty result;
+  metric->GetValueAndDerivative(parameters, result.value, result.derivative);
+  result.linearityValue = metric->GetLinearityConditionValue();
+  result.orthonormalityValue = metric->GetOrthonormalityConditionValue();
+  result.propernessValue = metric->GetPropernessConditionValue();
+  result.linearityGradientMagnitude = metric->GetLinearityConditionGradientMagnitude();
+  result.orthonormalityGradientMagnitude = metric->GetOrthonormalityConditionGradientMagnitude();
+  result.propernessGradientMagnitude = metric->GetPropernessConditionGradientMagnitude();
+
+  // GetValue() shares the computation of the value with GetValueAndDerivative().
+  EXPECT_DOUBLE_EQ(metric->GetValue(parameters), result.value);
+  return result;
+}
+
+} // namespace
+
+
+// Tests that the value and derivative on the grid equal those of the previous, filter based, implementation.
+GTEST_TEST(TransformRigidityPenaltyTerm, ValueAndDerivativeOnGridEqualPreviousImplementation)
+{
+  TransformType::ParametersType parameters;
+  std::vector<double>           rigidity;
+  const RigidityPenalty         actual = EvaluatePenalty(false, parameters, rigidity);
+  const RigidityPenalty         expected = ComputeReferencePenalty(parameters, rigidity);
+
+  // The stencils combine the separable operators, so the results differ by round-off only.
+  const double tolerance = 1e-10;
+  EXPECT_GT(expected.value, 0.0);
+  EXPECT_NEAR(actual.value, expected.value, tolerance * expected.value);
+  EXPECT_NEAR(actual.linearityValue, expected.linearityValue, tolerance * expected.linearityValue);
+  EXPECT_NEAR(actual.orthonormalityValue, expected.orthonormalityValue, tolerance * expected.orthonormalityValue);
+  EXPECT_NEAR(actual.propernessValue, expected.propernessValue, tolerance * expected.propernessValue);
+  EXPECT_NEAR(actual.linearityGradientMagnitude,
+              expected.linearityGradientMagnitude,
+              tolerance * expected.linearityGradientMagnitude);
+  EXPECT_NEAR(actual.orthonormalityGradientMagnitude,
+              expected.orthonormalityGradientMagnitude,
+              tolerance * expected.orthonormalityGradientMagnitude);
+  EXPECT_NEAR(actual.propernessGradientMagnitude,
+              expected.propernessGradientMagnitude,
+              tolerance * expected.propernessGradientMagnitude);
+
+  ASSERT_EQ(actual.derivative.GetSize(), expected.derivative.GetSize());
+  const double derivativeTolerance = tolerance * expected.derivative.inf_norm();
+  for (unsigned int i = 0; i < expected.derivative.GetSize(); ++i)
+  {
+    EXPECT_NEAR(actual.derivative[i], expected.derivative[i], derivativeTolerance);
+  }
+}
+
+
+// Tests that distributing the grid lines over the work units of the threader does not change the result.
+GTEST_TEST(TransformRigidityPenaltyTerm, MultiThreadedEqualsSingleThreaded)
+{
+  TransformType::ParametersType parameters;
+  std::vector<double>           rigidity;
+  const RigidityPenalty         expected = EvaluatePenalty(false, parameters, rigidity);
+  const RigidityPenalty         actual = EvaluatePenalty(true, parameters, rigidity);
+
+  // The sums per grid line are added in a fixed order, so the results should be identical.
+  EXPECT_EQ(actual.value, expected.value);
+  EXPECT_EQ(actual.linearityGradientMagnitude, expected.linearityGradientMagnitude);
+  EXPECT_EQ(actual.orthonormalityGradientMagnitude, expected.orthonormalityGradientMagnitude);
+  EXPECT_EQ(actual.propernessGradientMagnitude, expected.propernessGradientMagnitude);
+  ASSERT_EQ(actual.derivative.GetSize(), expected.derivative.GetSize());
+  for (unsigned int i = 0; i < expected.derivative.GetSize(); ++i)
+  {
+    EXPECT_EQ(actual.derivative[i], expected.derivative[i]);
+  }
+}
@@ -262,6 +262,36 @@ public:
                                            DerivativeType &                imageJacobian,
                                            NonZeroJacobianIndicesType &    nonZeroJacobianIndices) const override;
 
+  /** Support for precomputed interpolation weights, see the base class. */
+  unsigned int
+  GetNumberOfPrecomputedWeights(void) const override
+  {
+    return SpaceDimension * (VSplineOrder + 1);
+  }
+
+  bool
+  PrecomputeWeights(const InputPointType & ipp, IndexType & supportIndex, double * weights1D) const override;
+
+  void
+  TransformPointUsingPrecomputedWeights(const InputPointType & ipp,
+                                        const IndexType &      supportIndex,
+                                        const double *         weights1D,
+                                        OutputPointType &      opp) const override;
+
+  void
+  GetJacobianUsingPrecomputedWeights(const IndexType &            supportIndex,
+                                     const double *               weights1D,
+                                     JacobianType &               jacobian,
+                                     NonZeroJacobianIndicesType & nonZeroJacobianIndices) const override;
+
+  void
+  EvaluateJacobianWithImageGradientProductUsingPrecomputedWeights(
+    const IndexType &               supportIndex,
+    const double *                  weights1D,
+    const MovingImageGradientType & movingImageGradient,
+    DerivativeType &                imageJacobian,
+    NonZeroJacobianIndicesType &    nonZeroJacobianIndices) const override;
+
   /** Compute the spatial Jacobian of the transformation. */
   void
   GetSpatialJacobian(const InputPointType & ipp, SpatialJacobianType & sj) const override;
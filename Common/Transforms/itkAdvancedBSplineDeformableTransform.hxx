@@ -502,6 +502,185 @@ AdvancedBSplineDeformableTransform<TScalarType, NDimensions, VSplineOrder>::Eval
 } // end EvaluateJacobianWithImageGradientProduct()
 
 
+/**
+ * ********************* PrecomputeWeights ****************************
+ */
+
+template <class TScalarType, unsigned int NDimensions, unsigned int VSplineOrder>
+bool
+AdvancedBSplineDeformableTransform<TScalarType, NDimensions, VSplineOrder>::PrecomputeWeights(
+  const InputPointType & ipp,
+  IndexType &            supportIndex,
+  double *               weights1D) const
+{
+  /** Convert the physical point to a continuous index. */
+  ContinuousIndexType cindex;
+  this->TransformPointToContinuousGridIndex(ipp, cindex);
+
+  /** Points outside the valid region are handled by the regular functions. */
+  if (!this->InsideValidRegion(cindex))
+  {
+    return false;
+  }
+
+  /** Compute the support start index and the 1D weights. */
+  this->m_WeightsFunction->ComputeStartIndex(cindex, supportIndex);
+  this->m_WeightsFunction->Evaluate1DWeights(cindex, supportIndex, weights1D);
+  return true;
+
+} // end PrecomputeWeights()
+
+
+/**
+ * ********************* TransformPointUsingPrecomputedWeights ****************************
+ */
+
+template <class TScalarType, unsigned int NDimensions, unsigned int VSplineOrder>
+void
+AdvancedBSplineDeformableTransform<TScalarType, NDimensions, VSplineOrder>::TransformPointUsingPrecomputedWeights(
+  const InputPointType & ipp,
+  const IndexType &      supportIndex,
+  const double *         weights1D,
+  OutputPointType &      opp) const
+{
+  /** Check if the coefficient image has been set. */
+  opp = ipp;
+  if (!this->m_CoefficientImages[0])
+  {
+    itkWarningMacro(<< "B-spline coefficients have not been set");
+    return;
+  }
+
+  /** Compute the weights from the precomputed 1D weights, on the stack. */
+  const unsigned long             numberOfWeights = WeightsFunctionType::NumberOfWeights;
+  typename WeightsType::ValueType weightsArray[numberOfWeights];
+  WeightsType                     weights(weightsArray, numberOfWeights, false);
+  this->m_WeightsFunction->EvaluateFrom1DWeights(weights1D, weights);
+
+  /** Setup support region. */
+  RegionType supportRegion;
+  supportRegion.SetSize(this->m_SupportSize);
+  supportRegion.SetIndex(supportIndex);
+
+  /** Create iterators over the coefficient images. */
+  typedef ImageScanlineConstIterator<ImageType> IteratorType;
+  IteratorType                                  iterator[SpaceDimension];
+  for (unsigned int j = 0; j < SpaceDimension; j++)
+  {
+    iterator[j] = IteratorType(this->m_CoefficientImages[j], supportRegion);
+  }
+
+  /** Loop over the support region and correlate the coefficients with the weights. */
+  OutputVectorType displacement(NumericTraits<ScalarType>::ZeroValue());
+  unsigned long    counter = 0;
+  while (!iterator[0].IsAtEnd())
+  {
+    while (!iterator[0].IsAtEndOfLine())
+    {
+      for (unsigned int j = 0; j < SpaceDimension; j++)
+      {
+        displacement[j] += static_cast<ScalarType>(weights[counter] * iterator[j].Value());
+        ++iterator[j];
+      }
+      ++counter;
+    }
+
+    for (unsigned int j = 0; j < SpaceDimension; j++)
+    {
+      iterator[j].NextLine();
+    }
+  }
+
+  /** The output point is the start point + displacement. */
+  opp += displacement;
+
+} // end TransformPointUsingPrecomputedWeights()
+
+
+/**
+ * ********************* GetJacobianUsingPrecomputedWeights ****************************
+ */
+
+template <class TScalarType, unsigned int NDimensions, unsigned int VSplineOrder>
+void
+AdvancedBSplineDeformableTransform<TScalarType, NDimensions, VSplineOrder>::GetJacobianUsingPrecomputedWeights(
+  const IndexType &            supportIndex,
+  const double *               weights1D,
+  JacobianType &               jacobian,
+  NonZeroJacobianIndicesType & nonZeroJacobianIndices) const
+{
+  /** Initialize, like in GetJacobian(). */
+  const NumberOfParametersType nnzji = this->GetNumberOfNonZeroJacobianIndices();
+  if ((jacobian.cols() != nnzji) || (jacobian.rows() != SpaceDimension))
+  {
+    jacobian.SetSize(SpaceDimension, nnzji);
+    jacobian.Fill(0.0);
+  }
+
+  /** Compute the weights from the precomputed 1D weights, on the stack. */
+  const unsigned long             numberOfWeights = WeightsFunctionType::NumberOfWeights;
+  typename WeightsType::ValueType weightsArray[numberOfWeights];
+  WeightsType                     weights(weightsArray, numberOfWeights, false);
+  this->m_WeightsFunction->EvaluateFrom1DWeights(weights1D, weights);
+
+  /** Put at the right positions. */
+  ParametersValueType * jacobianPointer = jacobian.data_block();
+  for (unsigned int d = 0; d < SpaceDimension; ++d)
+  {
+    unsigned long offset = d * SpaceDimension * numberOfWeights + d * numberOfWeights;
+    std::copy(weightsArray, weightsArray + numberOfWeights, jacobianPointer + offset);
+  }
+
+  /** Compute the nonzero Jacobian indices. */
+  RegionType supportRegion;
+  supportRegion.SetSize(this->m_SupportSize);
+  supportRegion.SetIndex(supportIndex);
+  this->ComputeNonZeroJacobianIndices(nonZeroJacobianIndices, supportRegion);
+
+} // end GetJacobianUsingPrecomputedWeights()
+
+
+/**
+ * ********************* EvaluateJacobianWithImageGradientProductUsingPrecomputedWeights ****************************
+ */
+
+template <class TScalarType, unsigned int NDimensions, unsigned int VSplineOrder>
+void
+AdvancedBSplineDeformableTransform<TScalarType, NDimensions, VSplineOrder>::
+  EvaluateJacobianWithImageGradientProductUsingPrecomputedWeights(
+    const IndexType &               supportIndex,
+    const double *                  weights1D,
+    const MovingImageGradientType & movingImageGradient,
+    DerivativeType &                imageJacobian,
+    NonZeroJacobianIndicesType &    nonZeroJacobianIndices) const
+{
+  /** Compute the weights from the precomputed 1D weights, on the stack. */
+  const unsigned long             numberOfWeights = WeightsFunctionType::NumberOfWeights;
+  typename WeightsType::ValueType weightsArray[numberOfWeights];
+  WeightsType                     weights(weightsArray, numberOfWeights, false);
+  this->m_WeightsFunction->EvaluateFrom1DWeights(weights1D, weights);
+
+  /** Compute the inner product. */
+  NumberOfParametersType counter = 0;
+  for (unsigned int d = 0; d < SpaceDimension; ++d)
+  {
+    const MovingImageGradientValueType mig = movingImageGradient[d];
+    for (unsigned long i = 0; i < numberOfWeights; ++i)
+    {
+      imageJacobian[counter] = weightsArray[i] * mig;
+      ++counter;
+    }
+  }
+
+  /** Compute the nonzero Jacobian indices. */
+  RegionType supportRegion;
+  supportRegion.SetSize(this->m_SupportSize);
+  supportRegion.SetIndex(supportIndex);
+  this->ComputeNonZeroJacobianIndices(nonZeroJacobianIndices, supportRegion);
+
+} // end EvaluateJacobianWithImageGradientProductUsingPrecomputedWeights()
+
+
 /**
  * ********************* GetSpatialJacobian ****************************
  */
@@ -297,6 +297,61 @@ public:
    */
   typedef ContinuousIndex<ScalarType, SpaceDimension> ContinuousIndexType;
 
+  /** Support for precomputed interpolation weights.
+   * For a fixed set of points (for example the samples of a full or grid sampler)
+   * the support start index and the SpaceDimension x (SplineOrder + 1) one-dimensional
+   * B-spline weights can be computed once by PrecomputeWeights() and reused by the
+   * *UsingPrecomputedWeights() functions, as long as the grid does not change.
+   * GetNumberOfPrecomputedWeights() returns the number of one-dimensional weights
+   * per point, or 0 if the transform does not support precomputed weights.
+   */
+  virtual unsigned int
+  GetNumberOfPrecomputedWeights(void) const
+  {
+    return 0;
+  }
+
+  /** Compute the support start index and the one-dimensional weights of a point.
+   * Returns false if the support region of the point is not inside the valid region,
+   * in which case the regular functions should be used for this point.
+   */
+  virtual bool
+  PrecomputeWeights(const InputPointType &, IndexType &, double *) const
+  {
+    itkExceptionMacro(<< "Precomputed weights are not supported by this transform.");
+  }
+
+  /** Equivalent to TransformPoint(), using precomputed weights. */
+  virtual void
+  TransformPointUsingPrecomputedWeights(const InputPointType &,
+                                        const IndexType &,
+                                        const double *,
+                                        OutputPointType &) const
+  {
+    itkExceptionMacro(<< "Precomputed weights are not supported by this transform.");
+  }
+
+  /** Equivalent to GetJacobian(), using precomputed weights. */
+  virtual void
+  GetJacobianUsingPrecomputedWeights(const IndexType &,
+                                     const double *,
+                                     JacobianType &,
+                                     NonZeroJacobianIndicesType &) const
+  {
+    itkExceptionMacro(<< "Precomputed weights are not supported by this transform.");
+  }
+
+  /** Equivalent to EvaluateJacobianWithImageGradientProduct(), using precomputed weights. */
+  virtual void
+  EvaluateJacobianWithImageGradientProductUsingPrecomputedWeights(const IndexType &,
+                                                                  const double *,
+                                                                  const MovingImageGradientType &,
+                                                                  DerivativeType &,
+                                                                  NonZeroJacobianIndicesType &) const
+  {
+    itkExceptionMacro(<< "Precomputed weights are not supported by this transform.");
+  }
+
 protected:
   /** Print contents of an AdvancedBSplineDeformableTransformBase. */
   void
@@ -20,6 +20,8 @@
 
 #include "itkAdvancedCombinationTransform.h"
 
+#include <algorithm>
+
 namespace itk
 {
 
@@ -1485,6 +1487,62 @@ AdvancedCombinationTransform<TScalarType, NDimensions>::TransformPoint(const Inp
 } // end TransformPoint()
 
 
+/**
+ * ****************** TransformPoints ****************************
+ */
+
+template <typename TScalarType, unsigned int NDimensions>
+void
+AdvancedCombinationTransform<TScalarType, NDimensions>::TransformPoints(const InputPointType * inputPoints,
+                                                                        OutputPointType *      outputPoints,
+                                                                        SizeValueType          numberOfPoints) const
+{
+  if (this->m_CurrentTransform.IsNull())
+  {
+    this->NoCurrentTransformSet();
+  }
+
+  if (this->m_InitialTransform.IsNull())
+  {
+    this->m_CurrentTransform->TransformPoints(inputPoints, outputPoints, numberOfPoints);
+    return;
+  }
+
+  /** The intermediate results of the initial transform are stored per block on the stack. */
+  const SizeValueType blockSize = 64;
+  OutputPointType     initialPoints[blockSize];
+
+  if (this->m_UseAddition)
+  {
+    /** Add the displacements of both transforms. */
+    this->m_CurrentTransform->TransformPoints(inputPoints, outputPoints, numberOfPoints);
+    for (SizeValueType blockBegin = 0; blockBegin < numberOfPoints; blockBegin += blockSize)
+    {
+      const SizeValueType n = std::min(blockSize, numberOfPoints - blockBegin);
+      this->m_InitialTransform->TransformPoints(inputPoints + blockBegin, initialPoints, n);
+      for (SizeValueType k = 0; k < n; ++k)
+      {
+        for (unsigned int i = 0; i < SpaceDimension; ++i)
+        {
+          outputPoints[blockBegin + k][i] += (initialPoints[k][i] - inputPoints[blockBegin + k][i]);
+        }
+      }
+    }
+  }
+  else
+  {
+    /** Apply the current transform to the output of the initial transform. */
+    for (SizeValueType blockBegin = 0; blockBegin < numberOfPoints; blockBegin += blockSize)
+    {
+      const SizeValueType n = std::min(blockSize, numberOfPoints - blockBegin);
+      this->m_InitialTransform->TransformPoints(inputPoints + blockBegin, initialPoints, n);
+      this->m_CurrentTransform->TransformPoints(initialPoints, outputPoints + blockBegin, n);
+    }
+  }
+
+} // end TransformPoints()
+
+
 /**
  * ****************** GetJacobian ****************************
  */
@@ -1521,6 +1579,54 @@ AdvancedCombinationTransform<TScalarType, NDimensions>::EvaluateJacobianWithImag
 } // end EvaluateJacobianWithImageGradientProduct()
 
 
+/**
+ * ****************** EvaluateJacobianWithImageGradientProducts ****************************
+ */
+
+template <typename TScalarType, unsigned int NDimensions>
+void
+AdvancedCombinationTransform<TScalarType, NDimensions>::EvaluateJacobianWithImageGradientProducts(
+  const InputPointType *          ipps,
+  const MovingImageGradientType * movingImageGradients,
+  DerivativeType *                imageJacobians,
+  NonZeroJacobianIndicesType *    nonZeroJacobianIndices,
+  SizeValueType                   numberOfPoints) const
+{
+  if (this->m_CurrentTransform.IsNull())
+  {
+    this->NoCurrentTransformSet();
+  }
+
+  if (this->m_InitialTransform.IsNull())
+  {
+    this->m_CurrentTransform->EvaluateJacobianWithImageGradientProducts(
+      ipps, movingImageGradients, imageJacobians, nonZeroJacobianIndices, numberOfPoints);
+  }
+  else if (this->m_UseAddition)
+  {
+    Superclass::EvaluateJacobianWithImageGradientProducts(
+      ipps, movingImageGradients, imageJacobians, nonZeroJacobianIndices, numberOfPoints);
+  }
+  else
+  {
+    /** Evaluate the current transform at the output of the initial transform. */
+    const SizeValueType blockSize = 64;
+    OutputPointType     initialPoints[blockSize];
+    for (SizeValueType blockBegin = 0; blockBegin < numberOfPoints; blockBegin += blockSize)
+    {
+      const SizeValueType n = std::min(blockSize, numberOfPoints - blockBegin);
+      this->m_InitialTransform->TransformPoints(ipps + blockBegin, initialPoints, n);
+      this->m_CurrentTransform->EvaluateJacobianWithImageGradientProducts(initialPoints,
+                                                                         movingImageGradients + blockBegin,
+                                                                         imageJacobians + blockBegin,
+                                                                         nonZeroJacobianIndices + blockBegin,
+                                                                         n);
+    }
+  }
+
+} // end EvaluateJacobianWithImageGradientProducts()
+
+
 /**
  * ****************** GetSpatialJacobian ****************************
  */
@@ -222,6 +222,25 @@ public:
   virtual void
   GetSpatialJacobian(const InputPointType & ipp, SpatialJacobianType & sj) const = 0;
 
+  /** Batched versions of TransformPoint() and EvaluateJacobianWithImageGradientProduct().
+   * They process numberOfPoints points at once and store the results in the
+   * output arrays, which should have at least numberOfPoints elements.
+   * The results are identical to calling the single-point functions for
+   * every point. The default implementations do exactly that. Subclasses
+   * that can look up their coefficients once per batch override them.
+   */
+  virtual void
+  TransformPoints(const InputPointType * inputPoints,
+                  OutputPointType *      outputPoints,
+                  SizeValueType          numberOfPoints) const;
+
+  virtual void
+  EvaluateJacobianWithImageGradientProducts(const InputPointType *          ipps,
+                                            const MovingImageGradientType * movingImageGradients,
+                                            DerivativeType *                imageJacobians,
+                                            NonZeroJacobianIndicesType *    nonZeroJacobianIndices,
+                                            SizeValueType                   numberOfPoints) const;
+
   /** Override some pure virtual ITK4 functions. */
   void
   ComputeJacobianWithRespectToParameters(const InputPointType & itkNotUsed(p),
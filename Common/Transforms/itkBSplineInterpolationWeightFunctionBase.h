@@ -112,6 +112,21 @@ public:
   virtual void
   Evaluate(const ContinuousIndexType & cindex, const IndexType & startIndex, WeightsType & weights) const;
 
+  /** Evaluate the one-dimensional weights at specified ContinousIndex position.
+   * The SpaceDimension x (SplineOrder + 1) weights are stored row by row in the
+   * user specified buffer, which is assumed to be large enough.
+   * Together with EvaluateFrom1DWeights() this allows the weights of a fixed set
+   * of points to be precomputed with a small memory footprint.
+   */
+  void
+  Evaluate1DWeights(const ContinuousIndexType & cindex, const IndexType & startIndex, double * weights1D) const;
+
+  /** Compute the weights from one-dimensional weights computed by Evaluate1DWeights().
+   * This function assume that the weights has a correct size.
+   */
+  void
+  EvaluateFrom1DWeights(const double * weights1D, WeightsType & weights) const;
+
   /** Compute the start index of the support region. */
   void
   ComputeStartIndex(const ContinuousIndexType & index, IndexType & startIndex) const;
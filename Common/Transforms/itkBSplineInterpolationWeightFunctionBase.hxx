@@ -199,6 +199,58 @@ BSplineInterpolationWeightFunctionBase<TCoordRep, VSpaceDimension, VSplineOrder>
 } // end Evaluate()
 
 
+/**
+ * ******************* Evaluate1DWeights *******************
+ */
+
+template <class TCoordRep, unsigned int VSpaceDimension, unsigned int VSplineOrder>
+void
+BSplineInterpolationWeightFunctionBase<TCoordRep, VSpaceDimension, VSplineOrder>::Evaluate1DWeights(
+  const ContinuousIndexType & cindex,
+  const IndexType &           startIndex,
+  double *                    weights1D) const
+{
+  /** Compute the 1D weights. */
+  OneDWeightsType oneDWeights;
+  this->Compute1DWeights(cindex, startIndex, oneDWeights);
+
+  /** Copy them row by row. */
+  for (unsigned int j = 0; j < SpaceDimension; j++)
+  {
+    for (unsigned int k = 0; k < SplineOrder + 1; k++)
+    {
+      weights1D[j * (SplineOrder + 1) + k] = oneDWeights[j][k];
+    }
+  }
+
+} // end Evaluate1DWeights()
+
+
+/**
+ * ******************* EvaluateFrom1DWeights *******************
+ */
+
+template <class TCoordRep, unsigned int VSpaceDimension, unsigned int VSplineOrder>
+void
+BSplineInterpolationWeightFunctionBase<TCoordRep, VSpaceDimension, VSplineOrder>::EvaluateFrom1DWeights(
+  const double * weights1D,
+  WeightsType &  weights) const
+{
+  /** Compute the vector of weights, like in Evaluate(). */
+  for (unsigned int k = 0; k < this->m_NumberOfWeights; k++)
+  {
+    double                tmp1 = 1.0;
+    const unsigned long * tmp2 = this->m_OffsetToIndexTable[k];
+    for (unsigned int j = 0; j < SpaceDimension; j++)
+    {
+      tmp1 *= weights1D[j * (SplineOrder + 1) + tmp2[j]];
+    }
+    weights[k] = tmp1;
+  }
+
+} // end EvaluateFrom1DWeights()
+
+
 } // end namespace itk
 
 #endif
@@ -126,6 +126,13 @@ public:
   void
   GetSpatialJacobian(const InputPointType & ipp, SpatialJacobianType & sj) const override;
 
+  /** Precomputed weights are not supported, because the support region may wrap around. */
+  unsigned int
+  GetNumberOfPrecomputedWeights(void) const override
+  {
+    return 0;
+  }
+
 protected:
   CyclicBSplineDeformableTransform();
   ~CyclicBSplineDeformableTransform() override;
@@ -130,6 +130,14 @@ public:
   OutputPointType
   TransformPoint(const InputPointType & point) const override;
 
+  /** Transform a batch of points. The coefficient buffers and the offset
+   * table are looked up once, instead of once per point.
+   */
+  void
+  TransformPoints(const InputPointType * inputPoints,
+                  OutputPointType *      outputPoints,
+                  SizeValueType          numberOfPoints) const override;
+
   /** Compute the Jacobian of the transformation. */
   void
   GetJacobian(const InputPointType &       ipp,
@@ -145,6 +153,40 @@ public:
                                            DerivativeType &                imageJacobian,
                                            NonZeroJacobianIndicesType &    nonZeroJacobianIndices) const override;
 
+  /** Batched version of EvaluateJacobianWithImageGradientProduct(), without a virtual call per point. */
+  void
+  EvaluateJacobianWithImageGradientProducts(const InputPointType *          ipps,
+                                            const MovingImageGradientType * movingImageGradients,
+                                            DerivativeType *                imageJacobians,
+                                            NonZeroJacobianIndicesType *    nonZeroJacobianIndices,
+                                            SizeValueType                   numberOfPoints) const override;
+
+  /** Support for precomputed interpolation weights, see the base class.
+   * The one-dimensional weights are directly consumed by the recursive implementation.
+   */
+  bool
+  PrecomputeWeights(const InputPointType & ipp, IndexType & supportIndex, double * weights1D) const override;
+
+  void
+  TransformPointUsingPrecomputedWeights(const InputPointType & ipp,
+                                        const IndexType &      supportIndex,
+                                        const double *         weights1D,
+                                        OutputPointType &      opp) const override;
+
+  void
+  GetJacobianUsingPrecomputedWeights(const IndexType &            supportIndex,
+                                     const double *               weights1D,
+                                     JacobianType &               jacobian,
+                                     NonZeroJacobianIndicesType & nonZeroJacobianIndices) const override;
+
+  void
+  EvaluateJacobianWithImageGradientProductUsingPrecomputedWeights(
+    const IndexType &               supportIndex,
+    const double *                  weights1D,
+    const MovingImageGradientType & movingImageGradient,
+    DerivativeType &                imageJacobian,
+    NonZeroJacobianIndicesType &    nonZeroJacobianIndices) const override;
+
   /** Compute the spatial Jacobian of the transformation. */
   void
   GetSpatialJacobian(const InputPointType & ipp, SpatialJacobianType & sj) const override;
@@ -192,6 +234,15 @@ protected:
 
   typename RecursiveBSplineWeightFunctionType::Pointer m_RecursiveBSplineWeightFunction;
 
+  /** Transform a point, given the offset table and the buffers of the coefficient images.
+   * Shared by TransformPoint() and TransformPoints().
+   */
+  void
+  TransformPointUsingCoefficientBuffers(const InputPointType &  point,
+                                        const OffsetValueType * bsplineOffsetTable,
+                                        ScalarType * const *    coefficientBuffers,
+                                        OutputPointType &       outputPoint) const;
+
   /** Compute the nonzero Jacobian indices. */
   void
   ComputeNonZeroJacobianIndices(NonZeroJacobianIndicesType & nonZeroJacobianIndices,
@@ -20,7 +20,7 @@
 
 #include "itkRecursiveBSplineTransform.h"
 
-#include "itkRecursiveBSplineTransformImplementation.h"
+#include "itkRecursiveBSplineTransformImplementationSIMD.h"
 
 
 namespace itk
@@ -49,44 +49,100 @@ template <typename TScalar, unsigned int NDimensions, unsigned int VSplineOrder>
 typename RecursiveBSplineTransform<TScalar, NDimensions, VSplineOrder>::OutputPointType
 RecursiveBSplineTransform<TScalar, NDimensions, VSplineOrder>::TransformPoint(const InputPointType & point) const
 {
-  /** Define some constants. */
-  const unsigned int numberOfWeights = RecursiveBSplineWeightFunctionType::NumberOfWeights;
+  /** Check if the coefficient image has been set. */
+  if (!this->m_CoefficientImages[0])
+  {
+    itkWarningMacro(<< "B-spline coefficients have not been set");
+    return point;
+  }
+
+  ScalarType * coefficientBuffers[SpaceDimension];
+  for (unsigned int j = 0; j < SpaceDimension; ++j)
+  {
+    coefficientBuffers[j] = this->m_CoefficientImages[j]->GetBufferPointer();
+  }
 
-  /** Initialize output point. */
   OutputPointType outputPoint;
+  this->TransformPointUsingCoefficientBuffers(
+    point, this->m_CoefficientImages[0]->GetOffsetTable(), coefficientBuffers, outputPoint);
+  return outputPoint;
 
-  /** Allocate weights on the stack: */
-  typename WeightsType::ValueType weightsArray1D[numberOfWeights];
-  WeightsType                     weights1D(weightsArray1D, numberOfWeights, false);
+} // end TransformPoint()
+
+
+/**
+ * ********************* TransformPoints ****************************
+ */
 
+template <class TScalar, unsigned int NDimensions, unsigned int VSplineOrder>
+void
+RecursiveBSplineTransform<TScalar, NDimensions, VSplineOrder>::TransformPoints(
+  const InputPointType * inputPoints,
+  OutputPointType *      outputPoints,
+  SizeValueType          numberOfPoints) const
+{
   /** Check if the coefficient image has been set. */
   if (!this->m_CoefficientImages[0])
   {
     itkWarningMacro(<< "B-spline coefficients have not been set");
-    outputPoint = point;
-    return outputPoint;
+    for (SizeValueType i = 0; i < numberOfPoints; ++i)
+    {
+      outputPoints[i] = inputPoints[i];
+    }
+    return;
+  }
+
+  /** Get the offset table and the coefficient buffers, which are the same for all points. */
+  const OffsetValueType * bsplineOffsetTable = this->m_CoefficientImages[0]->GetOffsetTable();
+  ScalarType *            coefficientBuffers[SpaceDimension];
+  for (unsigned int j = 0; j < SpaceDimension; ++j)
+  {
+    coefficientBuffers[j] = this->m_CoefficientImages[j]->GetBufferPointer();
+  }
+
+  for (SizeValueType i = 0; i < numberOfPoints; ++i)
+  {
+    this->TransformPointUsingCoefficientBuffers(
+      inputPoints[i], bsplineOffsetTable, coefficientBuffers, outputPoints[i]);
   }
 
+} // end TransformPoints()
+
+
+/**
+ * ********************* TransformPointUsingCoefficientBuffers ****************************
+ */
+
+template <class TScalar, unsigned int NDimensions, unsigned int VSplineOrder>
+void
+RecursiveBSplineTransform<TScalar, NDimensions, VSplineOrder>::TransformPointUsingCoefficientBuffers(
+  const InputPointType &  point,
+  const OffsetValueType * bsplineOffsetTable,
+  ScalarType * const *    coefficientBuffers,
+  OutputPointType &       outputPoint) const
+{
   /** Convert to continuous index. */
   ContinuousIndexType cindex;
   this->TransformPointToContinuousGridIndex(point, cindex);
 
   // NOTE: if the support region does not lie totally within the grid
   // we assume zero displacement and return the input point
-  bool inside = this->InsideValidRegion(cindex);
-  if (!inside)
+  if (!this->InsideValidRegion(cindex))
   {
     outputPoint = point;
-    return outputPoint;
+    return;
   }
 
+  /** Allocate weights on the stack. */
+  const unsigned int              numberOfWeights = RecursiveBSplineWeightFunctionType::NumberOfWeights;
+  typename WeightsType::ValueType weightsArray1D[numberOfWeights];
+  WeightsType                     weights1D(weightsArray1D, numberOfWeights, false);
+
   // Compute interpolation weighs and store them in weights1D
   IndexType supportIndex;
   this->m_RecursiveBSplineWeightFunction->Evaluate(cindex, weights1D, supportIndex);
 
-  /** Initialize (helper) variables. */
-  const OffsetValueType * bsplineOffsetTable = this->m_CoefficientImages[0]->GetOffsetTable();
-  OffsetValueType         totalOffsetToSupportIndex = 0;
+  OffsetValueType totalOffsetToSupportIndex = 0;
   for (unsigned int j = 0; j < SpaceDimension; ++j)
   {
     totalOffsetToSupportIndex += supportIndex[j] * bsplineOffsetTable[j];
@@ -95,12 +151,12 @@ RecursiveBSplineTransform<TScalar, NDimensions, VSplineOrder>::TransformPoint(co
   ScalarType * mu[SpaceDimension];
   for (unsigned int j = 0; j < SpaceDimension; ++j)
   {
-    mu[j] = this->m_CoefficientImages[j]->GetBufferPointer() + totalOffsetToSupportIndex;
+    mu[j] = coefficientBuffers[j] + totalOffsetToSupportIndex;
   }
 
-  /** Call the recursive TransformPoint function. */
+  /** Call the recursive TransformPoint function, or its SIMD counterpart. */
   ScalarType displacement[SpaceDimension];
-  RecursiveBSplineTransformImplementation<SpaceDimension, SpaceDimension, SplineOrder, TScalar>::TransformPoint(
+  RecursiveBSplineTransformImplementationSIMD<SpaceDimension, SpaceDimension, SplineOrder, TScalar>::TransformPoint(
     displacement, mu, bsplineOffsetTable, weightsArray1D);
 
   // The output point is the start point + displacement.
@@ -109,8 +165,7 @@ RecursiveBSplineTransform<TScalar, NDimensions, VSplineOrder>::TransformPoint(co
     outputPoint[j] = displacement[j] + point[j];
   }
 
-  return outputPoint;
-} // end TransformPoint()
+} // end TransformPointUsingCoefficientBuffers()
 
 
 /**
@@ -166,7 +221,7 @@ RecursiveBSplineTransform<TScalar, NDimensions, VSplineOrder>::GetJacobian(
    * The pointer has changed after this function call.
    */
   ParametersValueType * jacobianPointer = jacobian.data_block();
-  RecursiveBSplineTransformImplementation<SpaceDimension, SpaceDimension, SplineOrder, TScalar>::GetJacobian(
+  RecursiveBSplineTransformImplementationSIMD<SpaceDimension, SpaceDimension, SplineOrder, TScalar>::GetJacobian(
     jacobianPointer, weightsArray1D, 1.0);
 
   /** Compute the nonzero Jacobian indices.
@@ -232,7 +287,7 @@ RecursiveBSplineTransform<TScalar, NDimensions, VSplineOrder>::EvaluateJacobianW
     migArray[j] = movingImageGradient[j];
   }
   ParametersValueType * imageJacobianPointer = imageJacobian.data_block();
-  RecursiveBSplineTransformImplementation<SpaceDimension, SpaceDimension, SplineOrder, TScalar>::
+  RecursiveBSplineTransformImplementationSIMD<SpaceDimension, SpaceDimension, SplineOrder, TScalar>::
     EvaluateJacobianWithImageGradientProduct(imageJacobianPointer, migArray, weightsArray1D, 1.0);
 
   /** Setup support region needed for the nonZeroJacobianIndices. */
@@ -248,6 +303,174 @@ RecursiveBSplineTransform<TScalar, NDimensions, VSplineOrder>::EvaluateJacobianW
 } // end EvaluateJacobianWithImageGradientProduct()
 
 
+/**
+ * ********************* EvaluateJacobianWithImageGradientProducts ****************************
+ */
+
+template <class TScalar, unsigned int NDimensions, unsigned int VSplineOrder>
+void
+RecursiveBSplineTransform<TScalar, NDimensions, VSplineOrder>::EvaluateJacobianWithImageGradientProducts(
+  const InputPointType *          ipps,
+  const MovingImageGradientType * movingImageGradients,
+  DerivativeType *                imageJacobians,
+  NonZeroJacobianIndicesType *    nonZeroJacobianIndices,
+  SizeValueType                   numberOfPoints) const
+{
+  /** The qualified call avoids the virtual function call per point. */
+  for (SizeValueType i = 0; i < numberOfPoints; ++i)
+  {
+    this->Self::EvaluateJacobianWithImageGradientProduct(
+      ipps[i], movingImageGradients[i], imageJacobians[i], nonZeroJacobianIndices[i]);
+  }
+
+} // end EvaluateJacobianWithImageGradientProducts()
+
+
+/**
+ * ********************* PrecomputeWeights ****************************
+ */
+
+template <class TScalar, unsigned int NDimensions, unsigned int VSplineOrder>
+bool
+RecursiveBSplineTransform<TScalar, NDimensions, VSplineOrder>::PrecomputeWeights(
+  const InputPointType & ipp,
+  IndexType &            supportIndex,
+  double *               weights1D) const
+{
+  /** Convert the physical point to a continuous index. */
+  ContinuousIndexType cindex;
+  this->TransformPointToContinuousGridIndex(ipp, cindex);
+
+  /** Points outside the valid region are handled by the regular functions. */
+  if (!this->InsideValidRegion(cindex))
+  {
+    return false;
+  }
+
+  /** Compute the 1D weights with the same weight function as GetJacobian(). */
+  const unsigned int numberOfWeights = RecursiveBSplineWeightFunctionType::NumberOfWeights;
+  WeightsType        weights(weights1D, numberOfWeights, false);
+  this->m_RecursiveBSplineWeightFunction->Evaluate(cindex, weights, supportIndex);
+  return true;
+
+} // end PrecomputeWeights()
+
+
+/**
+ * ********************* TransformPointUsingPrecomputedWeights ****************************
+ */
+
+template <class TScalar, unsigned int NDimensions, unsigned int VSplineOrder>
+void
+RecursiveBSplineTransform<TScalar, NDimensions, VSplineOrder>::TransformPointUsingPrecomputedWeights(
+  const InputPointType & ipp,
+  const IndexType &      supportIndex,
+  const double *         weights1D,
+  OutputPointType &      opp) const
+{
+  /** Check if the coefficient image has been set. */
+  if (!this->m_CoefficientImages[0])
+  {
+    itkWarningMacro(<< "B-spline coefficients have not been set");
+    opp = ipp;
+    return;
+  }
+
+  /** Initialize (helper) variables. */
+  const OffsetValueType * bsplineOffsetTable = this->m_CoefficientImages[0]->GetOffsetTable();
+  OffsetValueType         totalOffsetToSupportIndex = 0;
+  for (unsigned int j = 0; j < SpaceDimension; ++j)
+  {
+    totalOffsetToSupportIndex += supportIndex[j] * bsplineOffsetTable[j];
+  }
+
+  ScalarType * mu[SpaceDimension];
+  for (unsigned int j = 0; j < SpaceDimension; ++j)
+  {
+    mu[j] = this->m_CoefficientImages[j]->GetBufferPointer() + totalOffsetToSupportIndex;
+  }
+
+  /** Call the recursive TransformPoint function, or its SIMD counterpart. */
+  ScalarType displacement[SpaceDimension];
+  RecursiveBSplineTransformImplementationSIMD<SpaceDimension, SpaceDimension, SplineOrder, TScalar>::TransformPoint(
+    displacement, mu, bsplineOffsetTable, weights1D);
+
+  // The output point is the start point + displacement.
+  for (unsigned int j = 0; j < SpaceDimension; ++j)
+  {
+    opp[j] = displacement[j] + ipp[j];
+  }
+
+} // end TransformPointUsingPrecomputedWeights()
+
+
+/**
+ * ********************* GetJacobianUsingPrecomputedWeights ****************************
+ */
+
+template <class TScalar, unsigned int NDimensions, unsigned int VSplineOrder>
+void
+RecursiveBSplineTransform<TScalar, NDimensions, VSplineOrder>::GetJacobianUsingPrecomputedWeights(
+  const IndexType &            supportIndex,
+  const double *               weights1D,
+  JacobianType &               jacobian,
+  NonZeroJacobianIndicesType & nonZeroJacobianIndices) const
+{
+  /** Initialize. */
+  const NumberOfParametersType nnzji = this->GetNumberOfNonZeroJacobianIndices();
+  if ((jacobian.cols() != nnzji) || (jacobian.rows() != SpaceDimension))
+  {
+    jacobian.SetSize(SpaceDimension, nnzji);
+    jacobian.Fill(0.0);
+  }
+
+  /** Recursively compute the first numberOfIndices entries of the Jacobian. */
+  ParametersValueType * jacobianPointer = jacobian.data_block();
+  RecursiveBSplineTransformImplementationSIMD<SpaceDimension, SpaceDimension, SplineOrder, TScalar>::GetJacobian(
+    jacobianPointer, weights1D, 1.0);
+
+  /** Compute the nonzero Jacobian indices. */
+  RegionType supportRegion;
+  supportRegion.SetSize(this->m_SupportSize);
+  supportRegion.SetIndex(supportIndex);
+  this->ComputeNonZeroJacobianIndices(nonZeroJacobianIndices, supportRegion);
+
+} // end GetJacobianUsingPrecomputedWeights()
+
+
+/**
+ * ********************* EvaluateJacobianWithImageGradientProductUsingPrecomputedWeights ****************************
+ */
+
+template <class TScalar, unsigned int NDimensions, unsigned int VSplineOrder>
+void
+RecursiveBSplineTransform<TScalar, NDimensions, VSplineOrder>::
+  EvaluateJacobianWithImageGradientProductUsingPrecomputedWeights(
+    const IndexType &               supportIndex,
+    const double *                  weights1D,
+    const MovingImageGradientType & movingImageGradient,
+    DerivativeType &                imageJacobian,
+    NonZeroJacobianIndicesType &    nonZeroJacobianIndices) const
+{
+  /** Recursively compute the inner product of the Jacobian and the moving image gradient. */
+  double migArray[SpaceDimension]; // InternalFloatType
+  for (unsigned int j = 0; j < SpaceDimension; ++j)
+  {
+    migArray[j] = movingImageGradient[j];
+  }
+  ParametersValueType * imageJacobianPointer = imageJacobian.data_block();
+  RecursiveBSplineTransformImplementationSIMD<SpaceDimension, SpaceDimension, SplineOrder, TScalar>::
+    EvaluateJacobianWithImageGradientProduct(imageJacobianPointer, migArray, weights1D, 1.0);
+
+  /** Compute the nonzero Jacobian indices. */
+  RegionType supportRegion;
+  supportRegion.SetSize(this->m_SupportSize);
+  supportRegion.SetIndex(supportIndex);
+  this->ComputeNonZeroJacobianIndices(nonZeroJacobianIndices, supportRegion);
+
+} // end EvaluateJacobianWithImageGradientProductUsingPrecomputedWeights()
+
+
 /**
  * ********************* GetSpatialJacobian ****************************
  */
@@ -0,0 +1,473 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkRecursiveBSplineTransformImplementationSIMD_h
+#define itkRecursiveBSplineTransformImplementationSIMD_h
+
+#include "itkRecursiveBSplineTransformImplementation.h"
+
+/** Explicit SIMD kernels are compiled for x86-64 with GCC, Clang and MSVC.
+ * With GCC and Clang the kernels are compiled with a target attribute, so that
+ * the rest of elastix does not need to be compiled with -mavx2 or -mavx512f.
+ */
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#  define ELX_BSPLINE_SIMD_KERNELS
+#  define ELX_BSPLINE_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#  define ELX_BSPLINE_TARGET_AVX512 __attribute__((target("avx512f")))
+#  include <immintrin.h>
+#elif defined(_MSC_VER) && defined(_M_X64)
+#  define ELX_BSPLINE_SIMD_KERNELS
+#  define ELX_BSPLINE_TARGET_AVX2
+#  define ELX_BSPLINE_TARGET_AVX512
+#  include <immintrin.h>
+#  include <intrin.h>
+#endif
+
+namespace itk
+{
+
+/** \class RecursiveBSplineSIMDDispatch
+ *
+ * \brief Selects at run time which instruction set is used by the SIMD
+ * kernels of the recursive B-spline transform.
+ *
+ * By default the widest instruction set that is supported by the CPU and
+ * the operating system is used. SetInstructionSet() can be used to select
+ * a narrower one, e.g. to compare the performance, but it should not be
+ * called while transforms are being evaluated.
+ *
+ * \ingroup ITKTransform
+ */
+
+class RecursiveBSplineSIMDDispatch
+{
+public:
+  /** The instruction sets for which kernels are available. */
+  typedef enum
+  {
+    Scalar = 0,
+    AVX2 = 1,
+    AVX512 = 2
+  } InstructionSetType;
+
+  /** Get the widest instruction set supported by this machine. */
+  static InstructionSetType
+  GetSupportedInstructionSet(void)
+  {
+    static const InstructionSetType supported = DetectInstructionSet();
+    return supported;
+  }
+
+
+  /** Get the instruction set that is currently used by the kernels. */
+  static InstructionSetType
+  GetInstructionSet(void)
+  {
+    return static_cast<InstructionSetType>(SelectedInstructionSet());
+  }
+
+
+  /** Select the instruction set. It is clamped to the supported instruction set. */
+  static void
+  SetInstructionSet(InstructionSetType instructionSet)
+  {
+    const InstructionSetType supported = GetSupportedInstructionSet();
+    SelectedInstructionSet() = instructionSet < supported ? instructionSet : supported;
+  }
+
+
+  /** Get a human readable name of an instruction set. */
+  static const char *
+  GetInstructionSetName(InstructionSetType instructionSet)
+  {
+    switch (instructionSet)
+    {
+      case AVX512:
+        return "AVX-512";
+      case AVX2:
+        return "AVX2";
+      default:
+        return "scalar";
+    }
+  }
+
+
+private:
+  /** The selected instruction set, shared by all translation units. */
+  static int &
+  SelectedInstructionSet(void)
+  {
+    static int selected = GetSupportedInstructionSet();
+    return selected;
+  }
+
+
+  /** Query the CPU and the operating system. */
+  static InstructionSetType
+  DetectInstructionSet(void)
+  {
+#if defined(ELX_BSPLINE_SIMD_KERNELS) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+    {
+      return Scalar;
+    }
+
+    /** Check that the OS saves the YMM and ZMM registers. */
+    __cpuidex(info, 1, 0);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool fma = (info[2] & (1 << 12)) != 0;
+    if (!osxsave)
+    {
+      return Scalar;
+    }
+    const unsigned long long xcr0 = _xgetbv(0);
+    const bool               ymm = (xcr0 & 0x6) == 0x6;
+    const bool               zmm = (xcr0 & 0xe6) == 0xe6;
+
+    __cpuidex(info, 7, 0);
+    const bool avx2 = (info[1] & (1 << 5)) != 0;
+    const bool avx512f = (info[1] & (1 << 16)) != 0;
+    if (zmm && avx512f)
+    {
+      return AVX512;
+    }
+    if (ymm && avx2 && fma)
+    {
+      return AVX2;
+    }
+    return Scalar;
+#elif defined(ELX_BSPLINE_SIMD_KERNELS)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+    {
+      return AVX512;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+    {
+      return AVX2;
+    }
+    return Scalar;
+#else
+    return Scalar;
+#endif
+  }
+};
+
+
+/** \class RecursiveBSplineTransformImplementationSIMD
+ *
+ * \brief The RecursiveBSplineTransformImplementation with explicit SIMD
+ * kernels for the most common case.
+ *
+ * In general this class is identical to RecursiveBSplineTransformImplementation.
+ * For 3D cubic B-splines with double coefficients, which is the default in
+ * elastix, TransformPoint(), GetJacobian() and EvaluateJacobianWithImageGradientProduct()
+ * are replaced by AVX2 or AVX-512 kernels, selected at run time by the
+ * RecursiveBSplineSIMDDispatch. The four coefficients of the support region
+ * along the x-axis are contiguous in memory, which maps naturally onto
+ * the four double lanes of an AVX2 register. Since the summation order differs
+ * from the recursive implementation, the results may differ in the last digits.
+ *
+ * \ingroup ITKTransform
+ */
+
+template <unsigned int OutputDimension, unsigned int SpaceDimension, unsigned int SplineOrder, class TScalar>
+class RecursiveBSplineTransformImplementationSIMD
+  : public RecursiveBSplineTransformImplementation<OutputDimension, SpaceDimension, SplineOrder, TScalar>
+{};
+
+
+/** \class RecursiveBSplineTransformImplementationSIMD
+ *
+ * \brief Specialization for 3D cubic B-splines with double coefficients.
+ */
+
+template <>
+class RecursiveBSplineTransformImplementationSIMD<3, 3, 3, double>
+  : public RecursiveBSplineTransformImplementation<3, 3, 3, double>
+{
+public:
+  typedef RecursiveBSplineTransformImplementation<3, 3, 3, double> Superclass;
+  typedef Superclass::ScalarType                                   ScalarType;
+  typedef Superclass::InternalFloatType                            InternalFloatType;
+  typedef Superclass::OutputPointType                              OutputPointType;
+  typedef Superclass::CoefficientPointerVectorType                 CoefficientPointerVectorType;
+
+  /** The number of coefficients per dimension, and in the support region. */
+  itkStaticConstMacro(Width, unsigned int, 4);
+  itkStaticConstMacro(NumberOfIndices, unsigned int, 64);
+
+  /** TransformPoint, see the superclass. */
+  static inline void
+  TransformPoint(OutputPointType                    opp,
+                 const CoefficientPointerVectorType mu,
+                 const OffsetValueType *            gridOffsetTable,
+                 const double *                     weights1D)
+  {
+#ifdef ELX_BSPLINE_SIMD_KERNELS
+    switch (RecursiveBSplineSIMDDispatch::GetInstructionSet())
+    {
+      case RecursiveBSplineSIMDDispatch::AVX512:
+        TransformPointAVX512(opp, mu, gridOffsetTable, weights1D);
+        return;
+      case RecursiveBSplineSIMDDispatch::AVX2:
+        TransformPointAVX2(opp, mu, gridOffsetTable, weights1D);
+        return;
+      default:
+        break;
+    }
+#endif
+    Superclass::TransformPoint(opp, mu, gridOffsetTable, weights1D);
+  } // end TransformPoint()
+
+
+  /** GetJacobian, see the superclass. */
+  static inline void
+  GetJacobian(ScalarType *& jacobians, const double * weights1D, double value)
+  {
+#ifdef ELX_BSPLINE_SIMD_KERNELS
+    switch (RecursiveBSplineSIMDDispatch::GetInstructionSet())
+    {
+      case RecursiveBSplineSIMDDispatch::AVX512:
+        GetJacobianAVX512(jacobians, weights1D, value);
+        return;
+      case RecursiveBSplineSIMDDispatch::AVX2:
+        GetJacobianAVX2(jacobians, weights1D, value);
+        return;
+      default:
+        break;
+    }
+#endif
+    Superclass::GetJacobian(jacobians, weights1D, value);
+  } // end GetJacobian()
+
+
+  /** EvaluateJacobianWithImageGradientProduct, see the superclass. */
+  static inline void
+  EvaluateJacobianWithImageGradientProduct(ScalarType *&             imageJacobian,
+                                           const InternalFloatType * movingImageGradient,
+                                           const double *            weights1D,
+                                           double                    value)
+  {
+#ifdef ELX_BSPLINE_SIMD_KERNELS
+    switch (RecursiveBSplineSIMDDispatch::GetInstructionSet())
+    {
+      case RecursiveBSplineSIMDDispatch::AVX512:
+        EvaluateJacobianWithImageGradientProductAVX512(imageJacobian, movingImageGradient, weights1D, value);
+        return;
+      case RecursiveBSplineSIMDDispatch::AVX2:
+        EvaluateJacobianWithImageGradientProductAVX2(imageJacobian, movingImageGradient, weights1D, value);
+        return;
+      default:
+        break;
+    }
+#endif
+    Superclass::EvaluateJacobianWithImageGradientProduct(imageJacobian, movingImageGradient, weights1D, value);
+  } // end EvaluateJacobianWithImageGradientProduct()
+
+
+#ifdef ELX_BSPLINE_SIMD_KERNELS
+private:
+  /** Sum the four lanes of an AVX2 register. */
+  ELX_BSPLINE_TARGET_AVX2 static inline double
+  HorizontalSumAVX2(const __m256d v)
+  {
+    const __m128d sum2 = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(sum2, _mm_unpackhi_pd(sum2, sum2)));
+  }
+
+
+  /** TransformPoint for AVX2. The weights are stored as [x0..x3, y0..y3, z0..z3].
+   * For every z and y the four coefficients along x are loaded at once. They are
+   * accumulated with the y and z weights, and finally reduced with the x weights.
+   */
+  ELX_BSPLINE_TARGET_AVX2 static inline void
+  TransformPointAVX2(OutputPointType                    opp,
+                     const CoefficientPointerVectorType mu,
+                     const OffsetValueType *            gridOffsetTable,
+                     const double *                     weights1D)
+  {
+    const __m256d         wx = _mm256_loadu_pd(weights1D);
+    const OffsetValueType offsetY = gridOffsetTable[1];
+    const OffsetValueType offsetZ = gridOffsetTable[2];
+
+    for (unsigned int j = 0; j < 3; ++j)
+    {
+      __m256d        sumZ = _mm256_setzero_pd();
+      const double * muZ = mu[j];
+      for (unsigned int z = 0; z < Width; ++z, muZ += offsetZ)
+      {
+        const double * muY = muZ;
+        __m256d        sumY = _mm256_setzero_pd();
+        for (unsigned int y = 0; y < Width; ++y, muY += offsetY)
+        {
+          sumY = _mm256_fmadd_pd(_mm256_set1_pd(weights1D[Width + y]), _mm256_loadu_pd(muY), sumY);
+        }
+        sumZ = _mm256_fmadd_pd(_mm256_set1_pd(weights1D[2 * Width + z]), sumY, sumZ);
+      }
+      opp[j] = HorizontalSumAVX2(_mm256_mul_pd(sumZ, wx));
+    }
+  } // end TransformPointAVX2()
+
+
+  /** TransformPoint for AVX-512. Two rows of four coefficients are processed at once. */
+  ELX_BSPLINE_TARGET_AVX512 static inline void
+  TransformPointAVX512(OutputPointType                    opp,
+                       const CoefficientPointerVectorType mu,
+                       const OffsetValueType *            gridOffsetTable,
+                       const double *                     weights1D)
+  {
+    const __m512d         wx = _mm512_broadcast_f64x4(_mm256_loadu_pd(weights1D));
+    const OffsetValueType offsetY = gridOffsetTable[1];
+    const OffsetValueType offsetZ = gridOffsetTable[2];
+
+    /** The y weights of rows {0,1} and {2,3}, each repeated over four lanes. */
+    const __m512d wy01 = _mm512_insertf64x4(_mm512_set1_pd(weights1D[Width]), _mm256_set1_pd(weights1D[Width + 1]), 1);
+    const __m512d wy23 =
+      _mm512_insertf64x4(_mm512_set1_pd(weights1D[Width + 2]), _mm256_set1_pd(weights1D[Width + 3]), 1);
+
+    for (unsigned int j = 0; j < 3; ++j)
+    {
+      __m512d        sumZ = _mm512_setzero_pd();
+      const double * muZ = mu[j];
+      for (unsigned int z = 0; z < Width; ++z, muZ += offsetZ)
+      {
+        const __m512d rows01 =
+          _mm512_insertf64x4(_mm512_castpd256_pd512(_mm256_loadu_pd(muZ)), _mm256_loadu_pd(muZ + offsetY), 1);
+        const __m512d rows23 = _mm512_insertf64x4(
+          _mm512_castpd256_pd512(_mm256_loadu_pd(muZ + 2 * offsetY)), _mm256_loadu_pd(muZ + 3 * offsetY), 1);
+        const __m512d sumY = _mm512_fmadd_pd(wy23, rows23, _mm512_mul_pd(wy01, rows01));
+        sumZ = _mm512_fmadd_pd(_mm512_set1_pd(weights1D[2 * Width + z]), sumY, sumZ);
+      }
+      opp[j] = _mm512_reduce_add_pd(_mm512_mul_pd(sumZ, wx));
+    }
+  } // end TransformPointAVX512()
+
+
+  /** GetJacobian for AVX2. The Jacobian has three rows of 3 * 64 elements,
+   * and the weights of output dimension j are stored at row j, column j * 64.
+   */
+  ELX_BSPLINE_TARGET_AVX2 static inline void
+  GetJacobianAVX2(ScalarType *& jacobians, const double * weights1D, double value)
+  {
+    const __m256d      wx = _mm256_loadu_pd(weights1D);
+    const unsigned int rowStride = NumberOfIndices * (3 + 1);
+    ScalarType *       jac = jacobians;
+    for (unsigned int z = 0; z < Width; ++z)
+    {
+      const double wz = value * weights1D[2 * Width + z];
+      for (unsigned int y = 0; y < Width; ++y, jac += Width)
+      {
+        const __m256d w = _mm256_mul_pd(_mm256_set1_pd(wz * weights1D[Width + y]), wx);
+        _mm256_storeu_pd(jac, w);
+        _mm256_storeu_pd(jac + rowStride, w);
+        _mm256_storeu_pd(jac + 2 * rowStride, w);
+      }
+    }
+    jacobians += NumberOfIndices;
+  } // end GetJacobianAVX2()
+
+
+  /** GetJacobian for AVX-512. Two rows of four weights are stored at once. */
+  ELX_BSPLINE_TARGET_AVX512 static inline void
+  GetJacobianAVX512(ScalarType *& jacobians, const double * weights1D, double value)
+  {
+    const __m512d      wx = _mm512_broadcast_f64x4(_mm256_loadu_pd(weights1D));
+    const unsigned int rowStride = NumberOfIndices * (3 + 1);
+    ScalarType *       jac = jacobians;
+    for (unsigned int z = 0; z < Width; ++z)
+    {
+      const double wz = value * weights1D[2 * Width + z];
+      for (unsigned int y = 0; y < Width; y += 2, jac += 2 * Width)
+      {
+        const __m512d wy = _mm512_insertf64x4(
+          _mm512_set1_pd(wz * weights1D[Width + y]), _mm256_set1_pd(wz * weights1D[Width + y + 1]), 1);
+        const __m512d w = _mm512_mul_pd(wy, wx);
+        _mm512_storeu_pd(jac, w);
+        _mm512_storeu_pd(jac + rowStride, w);
+        _mm512_storeu_pd(jac + 2 * rowStride, w);
+      }
+    }
+    jacobians += NumberOfIndices;
+  } // end GetJacobianAVX512()
+
+
+  /** EvaluateJacobianWithImageGradientProduct for AVX2. The result has three
+   * blocks of 64 elements, one for each output dimension.
+   */
+  ELX_BSPLINE_TARGET_AVX2 static inline void
+  EvaluateJacobianWithImageGradientProductAVX2(ScalarType *&             imageJacobian,
+                                               const InternalFloatType * movingImageGradient,
+                                               const double *            weights1D,
+                                               double                    value)
+  {
+    const __m256d wx = _mm256_loadu_pd(weights1D);
+    const __m256d g0 = _mm256_set1_pd(movingImageGradient[0]);
+    const __m256d g1 = _mm256_set1_pd(movingImageGradient[1]);
+    const __m256d g2 = _mm256_set1_pd(movingImageGradient[2]);
+    ScalarType *  imjac = imageJacobian;
+    for (unsigned int z = 0; z < Width; ++z)
+    {
+      const double wz = value * weights1D[2 * Width + z];
+      for (unsigned int y = 0; y < Width; ++y, imjac += Width)
+      {
+        const __m256d w = _mm256_mul_pd(_mm256_set1_pd(wz * weights1D[Width + y]), wx);
+        _mm256_storeu_pd(imjac, _mm256_mul_pd(w, g0));
+        _mm256_storeu_pd(imjac + NumberOfIndices, _mm256_mul_pd(w, g1));
+        _mm256_storeu_pd(imjac + 2 * NumberOfIndices, _mm256_mul_pd(w, g2));
+      }
+    }
+    imageJacobian += NumberOfIndices;
+  } // end EvaluateJacobianWithImageGradientProductAVX2()
+
+
+  /** EvaluateJacobianWithImageGradientProduct for AVX-512. */
+  ELX_BSPLINE_TARGET_AVX512 static inline void
+  EvaluateJacobianWithImageGradientProductAVX512(ScalarType *&             imageJacobian,
+                                                 const InternalFloatType * movingImageGradient,
+                                                 const double *            weights1D,
+                                                 double                    value)
+  {
+    const __m512d wx = _mm512_broadcast_f64x4(_mm256_loadu_pd(weights1D));
+    const __m512d g0 = _mm512_set1_pd(movingImageGradient[0]);
+    const __m512d g1 = _mm512_set1_pd(movingImageGradient[1]);
+    const __m512d g2 = _mm512_set1_pd(movingImageGradient[2]);
+    ScalarType *  imjac = imageJacobian;
+    for (unsigned int z = 0; z < Width; ++z)
+    {
+      const double wz = value * weights1D[2 * Width + z];
+      for (unsigned int y = 0; y < Width; y += 2, imjac += 2 * Width)
+      {
+        const __m512d wy = _mm512_insertf64x4(
+          _mm512_set1_pd(wz * weights1D[Width + y]), _mm256_set1_pd(wz * weights1D[Width + y + 1]), 1);
+        const __m512d w = _mm512_mul_pd(wy, wx);
+        _mm512_storeu_pd(imjac, _mm512_mul_pd(w, g0));
+        _mm512_storeu_pd(imjac + NumberOfIndices, _mm512_mul_pd(w, g1));
+        _mm512_storeu_pd(imjac + 2 * NumberOfIndices, _mm512_mul_pd(w, g2));
+      }
+    }
+    imageJacobian += NumberOfIndices;
+  } // end EvaluateJacobianWithImageGradientProductAVX512()
+
+#endif // ELX_BSPLINE_SIMD_KERNELS
+};
+
+} // end namespace itk
+
+#endif /* itkRecursiveBSplineTransformImplementationSIMD_h */
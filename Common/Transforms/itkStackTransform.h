@@ -31,6 +31,12 @@ namespace itk
  * one for every last dimension index. This transform selects the right
  * transform based on the last dimension index of the input point.
  *
+ * The parameters of all sub transforms are stored in one contiguous vector:
+ * SetParameters() hands every sub transform a view on its part of the vector
+ * passed in, instead of a copy. As for the B-spline transform, the memory is
+ * managed by the caller. Use SetParametersByValue to let the transform keep
+ * its own copy of the parameters.
+ *
  * \ingroup Transforms
  *
  */
@@ -136,6 +142,10 @@ public:
   void
   SetParameters(const ParametersType & param) override;
 
+  /** Set the parameters, and keep a copy of them. */
+  void
+  SetParametersByValue(const ParametersType & param) override;
+
   /** Get the parameters. Concatenates the parameters of the
    * sub transforms. */
   const ParametersType &
@@ -182,6 +192,7 @@ public:
       this->m_NumberOfSubTransforms = num;
       this->m_SubTransformContainer.clear();
       this->m_SubTransformContainer.resize(num);
+      this->m_SubTransformParameters.clear();
       this->Modified();
     }
   }
@@ -298,6 +309,10 @@ private:
   unsigned int              m_NumberOfSubTransforms;
   SubTransformContainerType m_SubTransformContainer;
 
+  // Views on the contiguous parameters, one for every sub transform, and the buffer used by SetParametersByValue
+  std::vector<ParametersType> m_SubTransformParameters;
+  ParametersType              m_InternalParametersBuffer;
+
   // Stack spacing and origin of last dimension
   TScalarType m_StackSpacing, m_StackOrigin;
 };
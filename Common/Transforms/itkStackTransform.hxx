@@ -19,6 +19,7 @@
 #define _itkStackTransform_hxx
 
 #include "itkStackTransform.h"
+#include <algorithm>
 
 namespace itk
 {
@@ -52,24 +53,36 @@ StackTransform<TScalarType, NInputDimensions, NOutputDimensions>::SetParameters(
                          "per subtransform.");
   }
 
-  // Set separate subtransform parameters
+  // Set separate subtransform parameters, as views on the contiguous parameters. The views must
+  // outlive the sub transforms' use of them, so the container is only resized here.
   const NumberOfParametersType numSubTransformParameters = this->m_SubTransformContainer[0]->GetNumberOfParameters();
+  ParametersValueType *        data = const_cast<ParametersValueType *>(param.data_block());
+  this->m_SubTransformParameters.resize(this->m_NumberOfSubTransforms);
   for (unsigned int t = 0; t < this->m_NumberOfSubTransforms; ++t)
   {
-    // MS, \todo: the new itk::TransformParameters only have constructors taking 1 argument
-    // ParametersType subparams ( ParametersArrayType( &( param.data_block()[ t * numSubTransformParameters ] ),
-    // numSubTransformParameters, false ) ); ParametersType subparams ( &( param.data_block()[ t *
-    // numSubTransformParameters ] ), numSubTransformParameters, false );
-    // NTA, split the parameter by number of subparameters
-    const Array<double> subarray(&(param.data_block()[t * numSubTransformParameters]), numSubTransformParameters);
-    ParametersType      subparams(subarray);
-    this->m_SubTransformContainer[t]->SetParametersByValue(subparams);
+    this->m_SubTransformParameters[t].SetData(data + t * numSubTransformParameters, numSubTransformParameters, false);
+    this->m_SubTransformContainer[t]->SetParameters(this->m_SubTransformParameters[t]);
   }
 
   this->Modified();
 } // end SetParameters()
 
 
+/**
+ * ************************ SetParametersByValue ***********************
+ */
+
+template <class TScalarType, unsigned int NInputDimensions, unsigned int NOutputDimensions>
+void
+StackTransform<TScalarType, NInputDimensions, NOutputDimensions>::SetParametersByValue(const ParametersType & param)
+{
+  // Keep a copy of the parameters, and let the sub transforms refer to it
+  this->m_InternalParametersBuffer = param;
+  this->SetParameters(this->m_InternalParametersBuffer);
+
+} // end SetParametersByValue()
+
+
 /**
  * ************************ GetParameters ***********************
  */
@@ -81,14 +94,12 @@ StackTransform<TScalarType, NInputDimensions, NOutputDimensions>::GetParameters(
   this->m_Parameters.SetSize(this->GetNumberOfParameters());
 
   // Fill params with parameters of subtransforms
-  unsigned int i = 0;
+  const NumberOfParametersType numSubTransformParameters = this->m_SubTransformContainer[0]->GetNumberOfParameters();
   for (unsigned int t = 0; t < this->m_NumberOfSubTransforms; ++t)
   {
     const ParametersType & subparams = this->m_SubTransformContainer[t]->GetParameters();
-    for (unsigned int p = 0; p < this->m_SubTransformContainer[0]->GetNumberOfParameters(); ++p, ++i)
-    {
-      this->m_Parameters[i] = subparams[p];
-    }
+    std::copy_n(
+      subparams.begin(), numSubTransformParameters, this->m_Parameters.begin() + t * numSubTransformParameters);
   }
 
   return this->m_Parameters;
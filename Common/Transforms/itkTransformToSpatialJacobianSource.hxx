@@ -317,7 +317,6 @@ TransformToSpatialJacobianSource<TOutputImage, TTransformPrecisionType>::Generat
   outputPtr->SetSpacing(m_OutputSpacing);
   outputPtr->SetOrigin(m_OutputOrigin);
   outputPtr->SetDirection(m_OutputDirection);
-  outputPtr->Allocate();
 
 } // end GenerateOutputInformation()
 
@@ -25,6 +25,7 @@
 #include "itkImageRandomCoordinateSampler.h"
 #include "itkImageFullSampler.h"
 #include "itkPlatformMultiThreader.h"
+#include "itkPoolMultiThreader.h"
 
 namespace itk
 {
@@ -123,6 +124,13 @@ public:
     this->m_Threader->SetNumberOfWorkUnits(numberOfThreads);
   }
 
+  /** Select the use of the persistent thread pool, instead of spawning new threads
+   * for every launch. Typically set equal to the UseThreadPool setting of the metric.
+   */
+  virtual void
+  SetUseThreadPool(bool _arg);
+  itkGetConstMacro(UseThreadPool, bool);
+
 
   virtual void
   BeforeThreadedCompute(const ParametersType & mu);
@@ -135,7 +143,7 @@ protected:
   ~ComputeDisplacementDistribution() override;
 
   /** Typedefs for multi-threading. */
-  typedef itk::PlatformMultiThreader ThreaderType;
+  typedef itk::MultiThreaderBase     ThreaderType;
   typedef ThreaderType::WorkUnitInfo ThreadInfoType;
 
   typename FixedImageType::ConstPointer   m_FixedImage;
@@ -217,6 +225,7 @@ protected:
 
   SizeValueType               m_NumberOfPixelsCounted;
   bool                        m_UseMultiThread;
+  bool                        m_UseThreadPool;
   ImageSampleContainerPointer m_SampleContainer;
 
 private:
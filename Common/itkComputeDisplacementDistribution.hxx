@@ -51,7 +51,8 @@ ComputeDisplacementDistribution<TFixedImage, TTransform>::ComputeDisplacementDis
 
   /** Threading related variables. */
   this->m_UseMultiThread = true;
-  this->m_Threader = ThreaderType::New();
+  this->m_UseThreadPool = false;
+  this->m_Threader = PlatformMultiThreader::New();
 
   /** Initialize the m_ThreaderParameters. */
   this->m_ThreaderParameters.st_Self = this;
@@ -74,6 +75,37 @@ ComputeDisplacementDistribution<TFixedImage, TTransform>::~ComputeDisplacementDi
 } // end Destructor
 
 
+/**
+ * ************************* SetUseThreadPool ************************
+ */
+
+template <class TFixedImage, class TTransform>
+void
+ComputeDisplacementDistribution<TFixedImage, TTransform>::SetUseThreadPool(bool _arg)
+{
+  if (this->m_UseThreadPool == _arg)
+  {
+    return;
+  }
+
+  /** Swap the threader, keeping the number of work units. */
+  const ThreadIdType numberOfThreads = this->m_Threader->GetNumberOfWorkUnits();
+  if (_arg)
+  {
+    this->m_Threader = PoolMultiThreader::New();
+  }
+  else
+  {
+    this->m_Threader = PlatformMultiThreader::New();
+  }
+  this->m_Threader->SetNumberOfWorkUnits(numberOfThreads);
+
+  this->m_UseThreadPool = _arg;
+  this->Modified();
+
+} // end SetUseThreadPool()
+
+
 /**
  * ************************* InitializeThreadingParameters ************************
  */
@@ -22,6 +22,12 @@
 #include "itkImageRandomSamplerBase.h"
 #include "itkImageRandomCoordinateSampler.h"
 #include "itkScaledSingleValuedNonLinearOptimizer.h"
+#include "itkPlatformMultiThreader.h"
+#include "itkPoolMultiThreader.h"
+
+#include "vnl/vnl_diag_matrix.h"
+#include "vnl/vnl_sparse_matrix.h"
+#include <vector>
 
 namespace itk
 {
@@ -31,6 +37,14 @@ namespace itk
  * More specifically this class computes the Jacobian terms related to the automatic
  * parameter estimation for the adaptive stochastic gradient descent optimizer.
  * Details can be found in the paper.
+ *
+ * The computation is multi-threaded. The covariance matrix is accumulated over chunks
+ * of consecutive samples. The Jacobians of a chunk are first computed once, split over
+ * the samples, into a buffer that is shared by all work units. Then each work unit owns
+ * a contiguous block of rows (parameters), and accumulates the contributions of the
+ * buffered Jacobians to these rows only, in sample order. The result is therefore
+ * independent of the number of work units. The maxima over the samples are computed
+ * per work unit and reduced afterwards.
  */
 
 template <class TFixedImage, class TTransform>
@@ -104,9 +118,27 @@ public:
   virtual void
   Compute(double & TrC, double & TrCC, double & maxJJ, double & maxJCJ);
 
+  /** Set the number of threads. */
+  void
+  SetNumberOfWorkUnits(ThreadIdType numberOfThreads)
+  {
+    this->m_Threader->SetNumberOfWorkUnits(numberOfThreads);
+  }
+
+  /** Select the use of the persistent thread pool, instead of spawning new threads
+   * for every launch. Typically set equal to the UseThreadPool setting of the metric.
+   */
+  virtual void
+  SetUseThreadPool(bool _arg);
+  itkGetConstMacro(UseThreadPool, bool);
+
 protected:
   ComputeJacobianTerms();
-  ~ComputeJacobianTerms() override = default;
+  ~ComputeJacobianTerms() override;
+
+  /** Typedefs for multi-threading. */
+  typedef itk::MultiThreaderBase     ThreaderType;
+  typedef ThreaderType::WorkUnitInfo ThreadInfoType;
 
   typename FixedImageType::ConstPointer m_FixedImage;
   FixedImageRegionType                  m_FixedImageRegion;
@@ -115,9 +147,10 @@ protected:
   ScalesType                            m_Scales;
   bool                                  m_UseScales;
 
-  unsigned int  m_MaxBandCovSize;
-  unsigned int  m_NumberOfBandStructureSamples;
-  SizeValueType m_NumberOfJacobianMeasurements;
+  unsigned int          m_MaxBandCovSize;
+  unsigned int          m_NumberOfBandStructureSamples;
+  SizeValueType         m_NumberOfJacobianMeasurements;
+  ThreaderType::Pointer m_Threader;
 
   typedef typename FixedImageType::IndexType   FixedImageIndexType;
   typedef typename FixedImageType::PointType   FixedImagePointType;
@@ -146,6 +179,87 @@ protected:
   virtual void
   SampleFixedImageForJacobianTerms(ImageSampleContainerPointer & sampleContainer);
 
+  /** Typedefs for the covariance matrix. */
+  typedef double                                 CovarianceValueType;
+  typedef itk::Array2D<CovarianceValueType>      CovarianceMatrixType;
+  typedef vnl_sparse_matrix<CovarianceValueType> SparseCovarianceMatrixType;
+  typedef vnl_diag_matrix<CovarianceValueType>   DiagCovarianceMatrixType;
+
+  /** Guess the band structure of the covariance matrix, and initialize m_BandCov. */
+  virtual void
+  DetermineBandStructure(void);
+
+  /** Launch a multi-threaded computation. */
+  void
+  LaunchComputeThreaderCallback(ThreadFunctionType callback) const;
+
+  /** Jacobians threader callback function. */
+  static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+  ComputeJacobiansThreaderCallback(void * arg);
+
+  /** Covariance threader callback function. */
+  static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+  ComputeCovarianceThreaderCallback(void * arg);
+
+  /** Maxima threader callback function. */
+  static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+  ComputeMaximaThreaderCallback(void * arg);
+
+  /** Compute the buffered Jacobians of the samples of one work unit. */
+  virtual void
+  ThreadedComputeJacobians(ThreadIdType threadID);
+
+  /** Accumulate the buffered Jacobians in the covariance matrix rows of one work unit. */
+  virtual void
+  ThreadedComputeCovariance(ThreadIdType threadID);
+
+  /** Compute maxJJ and maxJCJ over the samples of one work unit. */
+  virtual void
+  ThreadedComputeMaxima(ThreadIdType threadID);
+
+  /** Initialize some multi-threading related parameters. */
+  virtual void
+  InitializeThreadingParameters(void);
+
+  /** To give the threads access to all member variables and functions. */
+  struct MultiThreaderParameterType
+  {
+    Self * st_Self;
+  };
+  mutable MultiThreaderParameterType m_ThreaderParameters;
+
+  struct ComputePerThreadStruct
+  {
+    /**  Used for accumulating variables. */
+    double st_MaxJJ;
+    double st_MaxJCJ;
+  };
+  itkPadStruct(ITK_CACHE_LINE_ALIGNMENT, ComputePerThreadStruct, PaddedComputePerThreadStruct);
+  itkAlignedTypedef(ITK_CACHE_LINE_ALIGNMENT, PaddedComputePerThreadStruct, AlignedComputePerThreadStruct);
+  mutable AlignedComputePerThreadStruct * m_ComputePerThreadVariables;
+  mutable ThreadIdType                    m_ComputePerThreadVariablesSize;
+
+  bool                        m_UseThreadPool;
+  ImageSampleContainerPointer m_SampleContainer;
+
+  /** The upper triangle of the covariance matrix. During the accumulation the dominant
+   * bands are stored in m_BandCov and the other elements in m_Cov; afterwards the bands
+   * are copied into m_Cov.
+   */
+  SparseCovarianceMatrixType m_Cov;
+  DiagCovarianceMatrixType   m_DiagCov;
+  CovarianceMatrixType       m_BandCov;
+  std::vector<unsigned int>  m_BandCovMap;
+  std::vector<unsigned int>  m_BandCovMap2;
+
+  /** The Jacobians J_j and their nonzero indices of the samples
+   * [m_JacobianBufferBegin, m_JacobianBufferBegin + m_JacobianBufferSize).
+   */
+  std::vector<JacobianType>               m_JacobianBuffer;
+  std::vector<NonZeroJacobianIndicesType> m_NonZeroJacobianIndicesBuffer;
+  SizeValueType                           m_JacobianBufferBegin;
+  SizeValueType                           m_JacobianBufferSize;
+
 private:
   ComputeJacobianTerms(const Self &) = delete;
   void
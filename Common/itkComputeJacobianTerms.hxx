@@ -22,8 +22,8 @@
 
 #include "vnl/vnl_math.h"
 #include "vnl/vnl_fastops.h"
-#include "vnl/vnl_diag_matrix.h"
-#include "vnl/vnl_sparse_matrix.h"
+#include <algorithm>
+#include <cmath>
 
 namespace itk
 {
@@ -43,10 +43,94 @@ ComputeJacobianTerms<TFixedImage, TTransform>::ComputeJacobianTerms()
   this->m_MaxBandCovSize = 0;
   this->m_NumberOfBandStructureSamples = 0;
   this->m_NumberOfJacobianMeasurements = 0;
+  this->m_SampleContainer = nullptr;
+  this->m_JacobianBufferBegin = 0;
+  this->m_JacobianBufferSize = 0;
+
+  /** Threading related variables. */
+  this->m_UseThreadPool = false;
+  this->m_Threader = PlatformMultiThreader::New();
+
+  /** Initialize the m_ThreaderParameters. */
+  this->m_ThreaderParameters.st_Self = this;
+
+  // Multi-threading structs
+  this->m_ComputePerThreadVariables = nullptr;
+  this->m_ComputePerThreadVariablesSize = 0;
 
 } // end Constructor
 
 
+/**
+ * ************************* Destructor ************************
+ */
+
+template <class TFixedImage, class TTransform>
+ComputeJacobianTerms<TFixedImage, TTransform>::~ComputeJacobianTerms()
+{
+  delete[] this->m_ComputePerThreadVariables;
+} // end Destructor
+
+
+/**
+ * ************************* SetUseThreadPool ************************
+ */
+
+template <class TFixedImage, class TTransform>
+void
+ComputeJacobianTerms<TFixedImage, TTransform>::SetUseThreadPool(bool _arg)
+{
+  if (this->m_UseThreadPool == _arg)
+  {
+    return;
+  }
+
+  /** Swap the threader, keeping the number of work units. */
+  const ThreadIdType numberOfThreads = this->m_Threader->GetNumberOfWorkUnits();
+  if (_arg)
+  {
+    this->m_Threader = PoolMultiThreader::New();
+  }
+  else
+  {
+    this->m_Threader = PlatformMultiThreader::New();
+  }
+  this->m_Threader->SetNumberOfWorkUnits(numberOfThreads);
+
+  this->m_UseThreadPool = _arg;
+  this->Modified();
+
+} // end SetUseThreadPool()
+
+
+/**
+ * ************************* InitializeThreadingParameters ************************
+ */
+
+template <class TFixedImage, class TTransform>
+void
+ComputeJacobianTerms<TFixedImage, TTransform>::InitializeThreadingParameters(void)
+{
+  const ThreadIdType numberOfThreads = this->m_Threader->GetNumberOfWorkUnits();
+
+  /** Only resize the array of structs when needed. */
+  if (this->m_ComputePerThreadVariablesSize != numberOfThreads)
+  {
+    delete[] this->m_ComputePerThreadVariables;
+    this->m_ComputePerThreadVariables = new AlignedComputePerThreadStruct[numberOfThreads];
+    this->m_ComputePerThreadVariablesSize = numberOfThreads;
+  }
+
+  /** Some initialization. */
+  for (ThreadIdType i = 0; i < numberOfThreads; ++i)
+  {
+    this->m_ComputePerThreadVariables[i].st_MaxJJ = NumericTraits<double>::Zero;
+    this->m_ComputePerThreadVariables[i].st_MaxJCJ = NumericTraits<double>::Zero;
+  }
+
+} // end InitializeThreadingParameters()
+
+
 /**
  * ************************* Compute ************************
  */
@@ -71,37 +155,155 @@ ComputeJacobianTerms<TFixedImage, TTransform>::Compute(double & TrC, double & Tr
    * Term 4: maxJCJ, see (54)
    */
 
-  typedef double                                 CovarianceValueType;
-  typedef itk::Array2D<CovarianceValueType>      CovarianceMatrixType;
-  typedef vnl_sparse_matrix<CovarianceValueType> SparseCovarianceMatrixType;
-  typedef SparseCovarianceMatrixType::row        SparseRowType;
-  typedef itk::Array<SizeValueType>              NonZeroJacobianIndicesExpandedType;
-  typedef vnl_diag_matrix<CovarianceValueType>   DiagCovarianceMatrixType;
-
   /** Initialize. */
   TrC = TrCC = maxJJ = maxJCJ = 0.0;
+  this->InitializeThreadingParameters();
 
   /** Get samples. */
-  ImageSampleContainerPointer sampleContainer; // default-constructed (null)
-  SampleFixedImageForJacobianTerms(sampleContainer);
-  const SizeValueType nrofsamples = sampleContainer->Size();
-  const double        n = static_cast<double>(nrofsamples);
+  this->SampleFixedImageForJacobianTerms(this->m_SampleContainer);
 
   /** Get the number of parameters. */
   const unsigned int P = static_cast<unsigned int>(this->m_Transform->GetNumberOfParameters());
 
-  /** Get transform and set current position. */
-  typename TransformType::Pointer transform = this->m_Transform;
-  const unsigned int              outdim = this->m_Transform->GetOutputSpaceDimension();
-
   /** Get scales vector */
   const ScalesType & scales = this->m_Scales;
 
-  /** Create iterator over the sample container. */
-  typename ImageSampleContainerType::ConstIterator iter;
-  typename ImageSampleContainerType::ConstIterator begin = sampleContainer->Begin();
-  typename ImageSampleContainerType::ConstIterator end = sampleContainer->End();
-  unsigned int                                     samplenr = 0;
+  /** Initialize covariance matrix. Sparse, diagonal, and band form. */
+  this->m_Cov.set_size(P, P);
+  this->m_DiagCov = DiagCovarianceMatrixType(P, 0.0);
+  this->DetermineBandStructure();
+  const unsigned int bandcovsize = static_cast<unsigned int>(this->m_BandCovMap2.size());
+
+  /**
+   *    TERM 1
+   *
+   * Loop over image and compute Jacobian.
+   * Compute C = 1/n \sum_i J_i^T J_i
+   * Possibly apply scaling afterwards.
+   *
+   * The samples are processed in chunks, which bounds the memory of the Jacobian buffer
+   * to about 6 MB for a 3D cubic B-spline. The chunk size does not depend on the number
+   * of work units, and hence neither does the result.
+   */
+  const SizeValueType numberOfSamples = this->m_SampleContainer->Size();
+  const SizeValueType numberOfSamplesPerChunk = 1024;
+  const unsigned int  outdim = this->m_Transform->GetOutputSpaceDimension();
+  const unsigned int  sizejacind = this->m_Transform->GetNumberOfNonZeroJacobianIndices();
+  const SizeValueType bufferSize = std::min(numberOfSamples, numberOfSamplesPerChunk);
+  JacobianType        jacobian(outdim, sizejacind);
+  jacobian.Fill(0.0);
+  this->m_JacobianBuffer.assign(bufferSize, jacobian);
+  this->m_NonZeroJacobianIndicesBuffer.assign(bufferSize, NonZeroJacobianIndicesType(sizejacind));
+  for (SizeValueType begin = 0; begin < numberOfSamples; begin += numberOfSamplesPerChunk)
+  {
+    this->m_JacobianBufferBegin = begin;
+    this->m_JacobianBufferSize = std::min(numberOfSamples - begin, numberOfSamplesPerChunk);
+    this->LaunchComputeThreaderCallback(this->ComputeJacobiansThreaderCallback);
+    this->LaunchComputeThreaderCallback(this->ComputeCovarianceThreaderCallback);
+  }
+  this->m_JacobianBuffer.clear();
+  this->m_NonZeroJacobianIndicesBuffer.clear();
+
+  /** Copy the bandmatrix into the sparse matrix and empty the bandcov matrix.
+   * \todo: perhaps work further with this bandmatrix instead.
+   */
+  SparseCovarianceMatrixType & cov = this->m_Cov;
+  for (unsigned int p = 0; p < P; ++p)
+  {
+    for (unsigned int b = 0; b < bandcovsize; ++b)
+    {
+      const double tempval = this->m_BandCov(p, b);
+      if (std::abs(tempval) > 1e-14)
+      {
+        const unsigned int q = p + this->m_BandCovMap2[b];
+        cov(p, q) = tempval;
+      }
+    }
+  }
+  this->m_BandCov.set_size(0, 0);
+
+  /** Apply scales. the use of m_Scales maybe something wrong. */
+  if (this->m_UseScales)
+  {
+    for (unsigned int p = 0; p < P; ++p)
+    {
+      cov.scale_row(p, 1.0 / this->m_Scales[p]);
+    }
+    /**  \todo: this might be faster with get_row instead of the iterator */
+    cov.reset();
+    bool notfinished = cov.next();
+    while (notfinished)
+    {
+      const int col = cov.getcolumn();
+      cov(cov.getrow(), col) /= scales[col];
+      notfinished = cov.next();
+    }
+  }
+
+  /** Compute TrC = trace(C), and diagcov. */
+  for (unsigned int p = 0; p < P; ++p)
+  {
+    if (!cov.empty_row(p))
+    {
+      // avoid creation of element if the row is empty
+      CovarianceValueType & covpp = cov(p, p);
+      TrC += covpp;
+      this->m_DiagCov[p] = covpp;
+    }
+  }
+
+  /**
+   *    TERM 2
+   *
+   * Compute TrCC = ||C||_F^2.
+   */
+  cov.reset();
+  bool notfinished2 = cov.next();
+  while (notfinished2)
+  {
+    TrCC += vnl_math::sqr(cov.value());
+    notfinished2 = cov.next();
+  }
+
+  /** Symmetry: multiply by 2 and subtract sumsqr(diagcov). */
+  TrCC *= 2.0;
+  TrCC -= this->m_DiagCov.diagonal().squared_magnitude();
+
+  /**
+   *    TERM 3 and 4
+   *
+   * Compute maxJJ and maxJCJ
+   * \li maxJJ = max_j [ ||J_j||_F^2 + 2\sqrt{2} || J_j J_j^T ||_F ]
+   * \li maxJCJ = max_j [ Tr( J_j C J_j^T ) + 2\sqrt{2} || J_j C J_j^T ||_F ]
+   */
+  this->LaunchComputeThreaderCallback(this->ComputeMaximaThreaderCallback);
+
+  /** Gather the maxima from all threads. */
+  const ThreadIdType numberOfThreads = this->m_Threader->GetNumberOfWorkUnits();
+  for (ThreadIdType i = 0; i < numberOfThreads; ++i)
+  {
+    maxJJ = std::max(maxJJ, this->m_ComputePerThreadVariables[i].st_MaxJJ);
+    maxJCJ = std::max(maxJCJ, this->m_ComputePerThreadVariables[i].st_MaxJCJ);
+  }
+
+  /** Release the memory. */
+  this->m_Cov.set_size(0, 0);
+  this->m_SampleContainer = nullptr;
+
+} // end Compute()
+
+
+/**
+ * ************************* DetermineBandStructure ************************
+ */
+
+template <class TFixedImage, class TTransform>
+void
+ComputeJacobianTerms<TFixedImage, TTransform>::DetermineBandStructure(void)
+{
+  const SizeValueType nrofsamples = this->m_SampleContainer->Size();
+  const unsigned int  P = static_cast<unsigned int>(this->m_Transform->GetNumberOfParameters());
+  const unsigned int  outdim = this->m_Transform->GetOutputSpaceDimension();
 
   /** Variables for nonzerojacobian indices and the Jacobian. */
   NumberOfParametersType sizejacind = this->m_Transform->GetNumberOfNonZeroJacobianIndices();
@@ -113,16 +315,6 @@ ComputeJacobianTerms<TFixedImage, TTransform>::Compute(double & TrC, double & Tr
   {
     jacind[1] = 0;
   }
-  NonZeroJacobianIndicesType prevjacind = jacind;
-
-  /** Initialize covariance matrix. Sparse, diagonal, and band form. */
-  SparseCovarianceMatrixType cov(P, P);
-  DiagCovarianceMatrixType   diagcov(P, 0.0);
-  CovarianceMatrixType       bandcov;
-
-  /** For temporary storage of J'J. */
-  CovarianceMatrixType jactjac(sizejacind, sizejacind);
-  jactjac.Fill(0.0);
 
   typedef std::vector<unsigned int>             DifHistType;
   typedef std::pair<unsigned int, unsigned int> FreqPairType;
@@ -159,7 +351,7 @@ ComputeJacobianTerms<TFixedImage, TTransform>::Compute(double & TrC, double & Tr
     onezero = 1 - onezero; // introduces semi-randomness
 
     /** Read fixed coordinates and get Jacobian J_j. */
-    const FixedImagePointType & point = sampleContainer->GetElement(samplenr).m_ImageCoordinates;
+    const FixedImagePointType & point = this->m_SampleContainer->GetElement(samplenr).m_ImageCoordinates;
     this->m_Transform->GetJacobian(point, jacj, jacind);
 
     /** Skip invalid Jacobians in the beginning, if any. */
@@ -198,9 +390,9 @@ ComputeJacobianTerms<TFixedImage, TTransform>::Compute(double & TrC, double & Tr
   const unsigned int bandcovsize = std::min(this->m_MaxBandCovSize, static_cast<unsigned int>(difHist2.size()));
 
   /** Maps parameterNrDifference (q-p) to colnr in bandcov. */
-  std::vector<unsigned int> bandcovMap(P, bandcovsize);
+  this->m_BandCovMap.assign(P, bandcovsize);
   /** Maps colnr in bandcov to parameterNrDifference (q-p). */
-  std::vector<unsigned int> bandcovMap2(bandcovsize, P);
+  this->m_BandCovMap2.assign(bandcovsize, P);
 
   /** Sort the difHist2 based on the frequencies. */
   std::sort(difHist2.begin(), difHist2.end());
@@ -210,35 +402,195 @@ ComputeJacobianTerms<TFixedImage, TTransform>::Compute(double & TrC, double & Tr
   for (unsigned int b = 0; b < bandcovsize; ++b)
   {
     --difHist2It;
-    bandcovMap[difHist2It->second] = b;
-    bandcovMap2[b] = difHist2It->second;
+    this->m_BandCovMap[difHist2It->second] = b;
+    this->m_BandCovMap2[b] = difHist2It->second;
   }
 
   /** Initialize band matrix. */
-  bandcov = CovarianceMatrixType(P, bandcovsize);
-  bandcov.Fill(0.0);
+  this->m_BandCov = CovarianceMatrixType(P, bandcovsize);
+  this->m_BandCov.Fill(0.0);
 
-  /**
-   *    TERM 1
-   *
-   * Loop over image and compute Jacobian.
-   * Compute C = 1/n \sum_i J_i^T J_i
-   * Possibly apply scaling afterwards.
-   */
-  jacind[0] = 0;
-  if (sizejacind > 1)
+} // end DetermineBandStructure()
+
+
+/**
+ * *********************** LaunchComputeThreaderCallback***************
+ */
+
+template <class TFixedImage, class TTransform>
+void
+ComputeJacobianTerms<TFixedImage, TTransform>::LaunchComputeThreaderCallback(ThreadFunctionType callback) const
+{
+  /** Setup threader. */
+  this->m_Threader->SetSingleMethod(callback,
+                                    const_cast<void *>(static_cast<const void *>(&this->m_ThreaderParameters)));
+
+  /** Launch. */
+  this->m_Threader->SingleMethodExecute();
+
+} // end LaunchComputeThreaderCallback()
+
+
+/**
+ * ************ ComputeJacobiansThreaderCallback ****************************
+ */
+
+template <class TFixedImage, class TTransform>
+ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+ComputeJacobianTerms<TFixedImage, TTransform>::ComputeJacobiansThreaderCallback(void * arg)
+{
+  /** Get the current thread id and user data. */
+  ThreadInfoType *             infoStruct = static_cast<ThreadInfoType *>(arg);
+  ThreadIdType                 threadID = infoStruct->WorkUnitID;
+  MultiThreaderParameterType * temp = static_cast<MultiThreaderParameterType *>(infoStruct->UserData);
+
+  /** Call the real implementation. */
+  temp->st_Self->ThreadedComputeJacobians(threadID);
+
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+
+} // end ComputeJacobiansThreaderCallback()
+
+
+/**
+ * ************ ComputeCovarianceThreaderCallback ****************************
+ */
+
+template <class TFixedImage, class TTransform>
+ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+ComputeJacobianTerms<TFixedImage, TTransform>::ComputeCovarianceThreaderCallback(void * arg)
+{
+  /** Get the current thread id and user data. */
+  ThreadInfoType *             infoStruct = static_cast<ThreadInfoType *>(arg);
+  ThreadIdType                 threadID = infoStruct->WorkUnitID;
+  MultiThreaderParameterType * temp = static_cast<MultiThreaderParameterType *>(infoStruct->UserData);
+
+  /** Call the real implementation. */
+  temp->st_Self->ThreadedComputeCovariance(threadID);
+
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+
+} // end ComputeCovarianceThreaderCallback()
+
+
+/**
+ * ************ ComputeMaximaThreaderCallback ****************************
+ */
+
+template <class TFixedImage, class TTransform>
+ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+ComputeJacobianTerms<TFixedImage, TTransform>::ComputeMaximaThreaderCallback(void * arg)
+{
+  /** Get the current thread id and user data. */
+  ThreadInfoType *             infoStruct = static_cast<ThreadInfoType *>(arg);
+  ThreadIdType                 threadID = infoStruct->WorkUnitID;
+  MultiThreaderParameterType * temp = static_cast<MultiThreaderParameterType *>(infoStruct->UserData);
+
+  /** Call the real implementation. */
+  temp->st_Self->ThreadedComputeMaxima(threadID);
+
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+
+} // end ComputeMaximaThreaderCallback()
+
+
+/**
+ * ************************* ThreadedComputeJacobians ************************
+ */
+
+template <class TFixedImage, class TTransform>
+void
+ComputeJacobianTerms<TFixedImage, TTransform>::ThreadedComputeJacobians(ThreadIdType threadId)
+{
+  /** Get the samples of the buffer for this thread. */
+  const ThreadIdType  numberOfThreads = this->m_Threader->GetNumberOfWorkUnits();
+  const SizeValueType bufferSize = this->m_JacobianBufferSize;
+  const SizeValueType pos_begin = bufferSize * threadId / numberOfThreads;
+  const SizeValueType pos_end = bufferSize * (threadId + 1) / numberOfThreads;
+
+  /** Read fixed coordinates and get Jacobian J_j. */
+  for (SizeValueType i = pos_begin; i < pos_end; ++i)
   {
-    jacind[1] = 0;
+    const FixedImagePointType & point =
+      this->m_SampleContainer->GetElement(this->m_JacobianBufferBegin + i).m_ImageCoordinates;
+    this->m_Transform->GetJacobian(point, this->m_JacobianBuffer[i], this->m_NonZeroJacobianIndicesBuffer[i]);
   }
-  for (iter = begin; iter != end; ++iter)
+
+} // end ThreadedComputeJacobians()
+
+
+/**
+ * ************************* ThreadedComputeCovariance ************************
+ */
+
+template <class TFixedImage, class TTransform>
+void
+ComputeJacobianTerms<TFixedImage, TTransform>::ThreadedComputeCovariance(ThreadIdType threadId)
+{
+  /** Each work unit owns the rows [p_begin, p_end) of the covariance matrix, and
+   * loops over all buffered Jacobians, in sample order. Only this work unit writes
+   * to these rows, so no locking or reduction is needed, and the result does not
+   * depend on the number of work units.
+   */
+  const unsigned int  P = static_cast<unsigned int>(this->m_Transform->GetNumberOfParameters());
+  const ThreadIdType  numberOfThreads = this->m_Threader->GetNumberOfWorkUnits();
+  const unsigned int  outdim = this->m_Transform->GetOutputSpaceDimension();
+  const double        n = static_cast<double>(this->m_SampleContainer->Size());
+  const unsigned int  bandcovsize = static_cast<unsigned int>(this->m_BandCovMap2.size());
+  const unsigned long p_begin = static_cast<unsigned long>(P) * threadId / numberOfThreads;
+  const unsigned long p_end = static_cast<unsigned long>(P) * (threadId + 1) / numberOfThreads;
+  if (p_begin == p_end)
   {
-    /** Print progress 0-50%.
-     *progressObserver->UpdateAndPrintProgress( samplenr );*/
-    ++samplenr;
+    return;
+  }
 
-    /** Read fixed coordinates and get Jacobian J_j. */
-    const FixedImagePointType & point = (*iter).Value().m_ImageCoordinates;
-    this->m_Transform->GetJacobian(point, jacj, jacind);
+  /** Variables for nonzerojacobian indices. */
+  NumberOfParametersType     sizejacind = this->m_Transform->GetNumberOfNonZeroJacobianIndices();
+  NonZeroJacobianIndicesType prevjacind(sizejacind);
+
+  /** For temporary storage of the owned rows of J'J, and their indices in prevjacind. */
+  CovarianceMatrixType jactjac(sizejacind, sizejacind);
+  jactjac.Fill(0.0);
+  std::vector<unsigned int> ownedRows;
+  ownedRows.reserve(sizejacind);
+
+  /** Add the upper triangle of the owned rows of jactjac / n to the covariance matrix. */
+  const auto updateCovariance = [&]() {
+    for (const unsigned int pi : ownedRows)
+    {
+      const unsigned int p = prevjacind[pi];
+      for (unsigned int qi = 0; qi < sizejacind; ++qi)
+      {
+        const unsigned int q = prevjacind[qi];
+        if (q >= p)
+        {
+          const double tempval = jactjac(pi, qi) / n;
+          if (std::abs(tempval) > 1e-14)
+          {
+            const unsigned int bandindex = this->m_BandCovMap[q - p];
+            if (bandindex < bandcovsize)
+            {
+              this->m_BandCov(p, bandindex) += tempval;
+            }
+            else
+            {
+              this->m_Cov(p, q) += tempval;
+            }
+          }
+        }
+      } // qi
+    }   // pi
+  };
+
+  /** Loop over the buffered samples; consecutive samples with the same nonzero
+   * Jacobian indices are first summed in jactjac.
+   */
+  bool first = true;
+  for (SizeValueType j = 0; j < this->m_JacobianBufferSize; ++j)
+  {
+    /** Get the buffered Jacobian J_j. */
+    const JacobianType &               jacj = this->m_JacobianBuffer[j];
+    const NonZeroJacobianIndicesType & jacind = this->m_NonZeroJacobianIndicesBuffer[j];
 
     /** Skip invalid Jacobians in the beginning, if any. */
     if (sizejacind > 1)
@@ -249,153 +601,101 @@ ComputeJacobianTerms<TFixedImage, TTransform>::Compute(double & TrC, double & Tr
       }
     }
 
-    if (jacind == prevjacind)
-    {
-      /** Update sum of J_j^T J_j. */
-      vnl_fastops::inc_X_by_AtA(jactjac, jacj);
-    }
-    else
+    if (first || jacind != prevjacind)
     {
-      /** The following should only be done after the first sample. */
-      if (iter != begin)
+      /** Update covariance matrix. */
+      if (!first)
       {
-        /** Update covariance matrix. */
-        for (unsigned int pi = 0; pi < sizejacind; ++pi)
-        {
-          const unsigned int p = prevjacind[pi];
-          for (unsigned int qi = 0; qi < sizejacind; ++qi)
-          {
-            const unsigned int q = prevjacind[qi];
-            if (q >= p)
-            {
-              const double tempval = jactjac(pi, qi) / n;
-              if (std::abs(tempval) > 1e-14)
-              {
-                const unsigned int bandindex = bandcovMap[q - p];
-                if (bandindex < bandcovsize)
-                {
-                  bandcov(p, bandindex) += tempval;
-                }
-                else
-                {
-                  cov(p, q) += tempval;
-                }
-              }
-            }
-          } // qi
-        }   // pi
-      }     // end if
-
-      /** Initialize jactjac by J_j^T J_j. */
-      vnl_fastops::AtA(jactjac, jacj);
+        updateCovariance();
+      }
+      first = false;
 
-      /** Remember nonzerojacobian indices. */
+      /** Remember nonzerojacobian indices, and the ones owned by this work unit. */
       prevjacind = jacind;
-    } // end else
-
-  } // end iter loop: end computation of covariance matrix
-
-  /** Update covariance matrix once again to include last jactjac updates
-   * \todo: a bit ugly that this loop is copied from above.
-   */
-  for (unsigned int pi = 0; pi < sizejacind; ++pi)
-  {
-    const unsigned int p = prevjacind[pi];
-    for (unsigned int qi = 0; qi < sizejacind; ++qi)
-    {
-      const unsigned int q = prevjacind[qi];
-      if (q >= p)
+      ownedRows.clear();
+      for (unsigned int pi = 0; pi < sizejacind; ++pi)
       {
-        const double tempval = jactjac(pi, qi) / n;
-        if (std::abs(tempval) > 1e-14)
+        if (jacind[pi] >= p_begin && jacind[pi] < p_end)
         {
-          const unsigned int bandindex = bandcovMap[q - p];
-          if (bandindex < bandcovsize)
-          {
-            bandcov(p, bandindex) += tempval;
-          }
-          else
-          {
-            cov(p, q) += tempval;
-          }
+          ownedRows.push_back(pi);
+          std::fill(jactjac[pi], jactjac[pi] + sizejacind, 0.0);
         }
       }
-    } // qi
-  }   // pi
+    }
 
-  /** Copy the bandmatrix into the sparse matrix and empty the bandcov matrix.
-   * \todo: perhaps work further with this bandmatrix instead.
-   */
-  for (unsigned int p = 0; p < P; ++p)
-  {
-    for (unsigned int b = 0; b < bandcovsize; ++b)
+    /** Update the owned rows of the sum of J_j^T J_j. */
+    for (const unsigned int pi : ownedRows)
     {
-      const double tempval = bandcov(p, b);
-      if (std::abs(tempval) > 1e-14)
+      const unsigned int p = jacind[pi];
+      for (unsigned int qi = 0; qi < sizejacind; ++qi)
       {
-        const unsigned int q = p + bandcovMap2[b];
-        cov(p, q) = tempval;
+        if (jacind[qi] >= p)
+        {
+          double sum = 0.0;
+          for (unsigned int d = 0; d < outdim; ++d)
+          {
+            sum += jacj[d][pi] * jacj[d][qi];
+          }
+          jactjac(pi, qi) += sum;
+        }
       }
     }
-  }
-  bandcov.set_size(0, 0);
 
-  /** Apply scales. the use of m_Scales maybe something wrong. */
-  if (this->m_UseScales)
-  {
-    for (unsigned int p = 0; p < P; ++p)
-    {
-      cov.scale_row(p, 1.0 / this->m_Scales[p]);
-    }
-    /**  \todo: this might be faster with get_row instead of the iterator */
-    cov.reset();
-    bool notfinished = cov.next();
-    while (notfinished)
-    {
-      const int col = cov.getcolumn();
-      cov(cov.getrow(), col) /= scales[col];
-      notfinished = cov.next();
-    }
-  }
+  } // end j loop: end computation of covariance matrix
 
-  /** Compute TrC = trace(C), and diagcov. */
-  for (unsigned int p = 0; p < P; ++p)
+  /** Update covariance matrix once again to include last jactjac updates. */
+  if (!first)
   {
-    if (!cov.empty_row(p))
-    {
-      // avoid creation of element if the row is empty
-      CovarianceValueType & covpp = cov(p, p);
-      TrC += covpp;
-      diagcov[p] = covpp;
-    }
+    updateCovariance();
   }
 
-  /**
-   *    TERM 2
-   *
-   * Compute TrCC = ||C||_F^2.
-   */
-  cov.reset();
-  bool notfinished2 = cov.next();
-  while (notfinished2)
+} // end ThreadedComputeCovariance()
+
+
+/**
+ * ************************* ThreadedComputeMaxima ************************
+ */
+
+template <class TFixedImage, class TTransform>
+void
+ComputeJacobianTerms<TFixedImage, TTransform>::ThreadedComputeMaxima(ThreadIdType threadId)
+{
+  typedef typename SparseCovarianceMatrixType::row SparseRowType;
+  typedef itk::Array<SizeValueType>                NonZeroJacobianIndicesExpandedType;
+
+  /** Get sample container size, number of threads, and output space dimension. */
+  const SizeValueType sampleContainerSize = this->m_SampleContainer->Size();
+  const ThreadIdType  numberOfThreads = this->m_Threader->GetNumberOfWorkUnits();
+  const unsigned int  outdim = this->m_Transform->GetOutputSpaceDimension();
+  const unsigned int  P = static_cast<unsigned int>(this->m_Transform->GetNumberOfParameters());
+
+  /** Get a handle to the scales vector and the covariance matrix. */
+  const ScalesType &               scales = this->m_Scales;
+  SparseCovarianceMatrixType &     cov = this->m_Cov;
+  const DiagCovarianceMatrixType & diagcov = this->m_DiagCov;
+
+  /** Get the samples for this thread. */
+  const unsigned long nrOfSamplesPerThreads = static_cast<unsigned long>(
+    std::ceil(static_cast<double>(sampleContainerSize) / static_cast<double>(numberOfThreads)));
+
+  unsigned long pos_begin = nrOfSamplesPerThreads * threadId;
+  unsigned long pos_end = nrOfSamplesPerThreads * (threadId + 1);
+  pos_begin = (pos_begin > sampleContainerSize) ? sampleContainerSize : pos_begin;
+  pos_end = (pos_end > sampleContainerSize) ? sampleContainerSize : pos_end;
+
+  /** Variables for nonzerojacobian indices and the Jacobian. */
+  NumberOfParametersType sizejacind = this->m_Transform->GetNumberOfNonZeroJacobianIndices();
+  JacobianType           jacj(outdim, sizejacind);
+  jacj.Fill(0.0);
+  NonZeroJacobianIndicesType jacind(sizejacind);
+  jacind[0] = 0;
+  if (sizejacind > 1)
   {
-    TrCC += vnl_math::sqr(cov.value());
-    notfinished2 = cov.next();
+    jacind[1] = 0;
   }
 
-  /** Symmetry: multiply by 2 and subtract sumsqr(diagcov). */
-  TrCC *= 2.0;
-  TrCC -= diagcov.diagonal().squared_magnitude();
-
-  /**
-   *    TERM 3 and 4
-   *
-   * Compute maxJJ and maxJCJ
-   * \li maxJJ = max_j [ ||J_j||_F^2 + 2\sqrt{2} || J_j J_j^T ||_F ]
-   * \li maxJCJ = max_j [ Tr( J_j C J_j^T ) + 2\sqrt{2} || J_j C J_j^T ||_F ]
-   */
-  maxJJ = 0.0;
-  maxJCJ = 0.0;
+  double       maxJJ = 0.0;
+  double       maxJCJ = 0.0;
   const double sqrt2 = std::sqrt(static_cast<double>(2.0));
 
   JacobianType                       jacjjacj(outdim, outdim);
@@ -406,11 +706,18 @@ ComputeJacobianTerms<TFixedImage, TTransform>::Compute(double & TrC, double & Tr
   JacobianType                       jacjcovjacj(outdim, outdim);
   NonZeroJacobianIndicesExpandedType jacindExpanded(P);
 
-  samplenr = 0;
-  for (iter = begin; iter != end; ++iter)
+  /** Create iterator over the sample container. */
+  typename ImageSampleContainerType::ConstIterator threader_fiter;
+  typename ImageSampleContainerType::ConstIterator threader_fbegin = this->m_SampleContainer->Begin();
+  typename ImageSampleContainerType::ConstIterator threader_fend = this->m_SampleContainer->Begin();
+
+  threader_fbegin += (int)pos_begin;
+  threader_fend += (int)pos_end;
+
+  for (threader_fiter = threader_fbegin; threader_fiter != threader_fend; ++threader_fiter)
   {
     /** Read fixed coordinates and get Jacobian. */
-    const FixedImagePointType & point = (*iter).Value().m_ImageCoordinates;
+    const FixedImagePointType & point = (*threader_fiter).Value().m_ImageCoordinates;
     this->m_Transform->GetJacobian(point, jacj, jacind);
 
     /** Apply scales, if necessary. */
@@ -454,6 +761,7 @@ ComputeJacobianTerms<TFixedImage, TTransform>::Compute(double & TrC, double & Tr
      * for this using:
      * J C J' = J (cov + cov' - diag(cov')) J'.
      * (NB: cov now still contains only the upper triangular part of C)
+     * The rows of cov are only read here, so all threads can share it.
      */
     for (unsigned int pi = 0; pi < sizejacind; ++pi)
     {
@@ -506,16 +814,13 @@ ComputeJacobianTerms<TFixedImage, TTransform>::Compute(double & TrC, double & Tr
     /** Max_j [JCJ_j]. */
     maxJCJ = std::max(maxJCJ, JCJ_j);
 
-    /** Show progress 50-100%. */
-    // progressObserver->UpdateAndPrintProgress( samplenr + nrofsamples );
-    ++samplenr;
-
   } // end loop over sample container
 
-  /** Finalize progress information. */
-  // progressObserver->PrintProgress( 1.0 );
+  /** Update the thread struct once. */
+  this->m_ComputePerThreadVariables[threadId].st_MaxJJ = maxJJ;
+  this->m_ComputePerThreadVariables[threadId].st_MaxJCJ = maxJCJ;
 
-} // end Compute()
+} // end ThreadedComputeMaxima()
 
 
 /**
@@ -143,6 +143,13 @@ public:
   MeasureType
   GetValue(const ParametersType & parameters) const override;
 
+  /** The histograms are members of this metric, so it may run next to other metrics. */
+  bool
+  CanBeEvaluatedConcurrently(void) const override
+  {
+    return true;
+  }
+
   /** Set/get whether to apply the technique introduced by Nicholas Tustison; default: false */
   itkGetConstMacro(UseJacobianPreconditioning, bool);
   itkSetMacro(UseJacobianPreconditioning, bool);
@@ -21,12 +21,13 @@
 #include "itkParzenWindowMutualInformationImageToImageMetric.h"
 
 #include "itkImageLinearConstIteratorWithIndex.h"
-#include "itkImageScanlineConstIterator.h"
 #include "vnl/vnl_math.h"
 #include "itkMatrix.h"
 #include "vnl/vnl_inverse.h"
 #include "vnl/vnl_det.h"
 
+#include <vector>
+
 #ifdef ELASTIX_USE_OPENMP
 #  include <omp.h>
 #endif
@@ -88,45 +89,39 @@ ParzenWindowMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::GetV
   this->ComputeMarginalPDF(this->m_JointPDF, this->m_FixedImageMarginalPDF, 0);
   this->ComputeMarginalPDF(this->m_JointPDF, this->m_MovingImageMarginalPDF, 1);
 
-  /** Compute the metric by double summation over histogram. */
-
-  /** Setup iterators */
-  typedef ImageLinearConstIteratorWithIndex<JointPDFType> JointPDFIteratorType;
-  typedef typename MarginalPDFType::const_iterator        MarginalPDFIteratorType;
-
-  JointPDFIteratorType jointPDFit(this->m_JointPDF, this->m_JointPDF->GetLargestPossibleRegion());
-  jointPDFit.SetDirection(0);
-  jointPDFit.GoToBegin();
-  MarginalPDFIteratorType       fixedPDFit = this->m_FixedImageMarginalPDF.begin();
-  const MarginalPDFIteratorType fixedPDFend = this->m_FixedImageMarginalPDF.end();
-  MarginalPDFIteratorType       movingPDFit = this->m_MovingImageMarginalPDF.begin();
-  const MarginalPDFIteratorType movingPDFend = this->m_MovingImageMarginalPDF.end();
+  /** Compute the metric by double summation over histogram.
+   * Rows and columns of the joint histogram with a zero marginal pdf
+   * do not contribute, and are skipped.
+   */
+  std::vector<unsigned int> movingBins;
+  this->ComputeNonZeroMarginalPDFBins(this->m_MovingImageMarginalPDF, movingBins);
+  const PDFValueType *  jointPDFBuffer = this->m_JointPDF->GetBufferPointer();
+  const OffsetValueType jointPDFRowStride = this->m_JointPDF->GetOffsetTable()[1];
 
   /** Loop over histogram. */
   double MI = 0.0;
-  while (fixedPDFit != fixedPDFend)
+  for (unsigned int f = 0; f < this->m_FixedImageMarginalPDF.GetSize(); ++f)
   {
-    const double fixedImagePDFValue = *fixedPDFit;
-    movingPDFit = this->m_MovingImageMarginalPDF.begin();
-    while (movingPDFit != movingPDFend)
+    const double fixedImagePDFValue = this->m_FixedImageMarginalPDF[f];
+    if (fixedImagePDFValue <= 1e-16)
+    {
+      continue;
+    }
+
+    const PDFValueType * jointPDFRow = jointPDFBuffer + f * jointPDFRowStride;
+    for (const unsigned int m : movingBins)
     {
-      const double movingImagePDFValue = *movingPDFit;
+      const double movingImagePDFValue = this->m_MovingImageMarginalPDF[m];
       const double fixPDFmovPDF = fixedImagePDFValue * movingImagePDFValue;
-      const double jointPDFValue = jointPDFit.Get();
+      const double jointPDFValue = jointPDFRow[m];
 
       /** Check for non-zero bin contribution. */
       if (jointPDFValue > 1e-16 && fixPDFmovPDF > 1e-16)
       {
         MI += jointPDFValue * std::log(jointPDFValue / fixPDFmovPDF);
       }
-      ++movingPDFit;
-      ++jointPDFit;
-    } // end while-loop over moving index
-
-    ++fixedPDFit;
-    jointPDFit.NextLine();
-
-  } // end while-loop over fixed index
+    } // end for-loop over moving index
+  }   // end for-loop over fixed index
 
   return static_cast<MeasureType>(-1.0 * MI);
 
@@ -166,65 +161,53 @@ ParzenWindowMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::GetV
   this->ComputeMarginalPDF(this->m_JointPDF, this->m_FixedImageMarginalPDF, 0);
   this->ComputeMarginalPDF(this->m_JointPDF, this->m_MovingImageMarginalPDF, 1);
 
-  /** Compute the metric and derivatives by double summation over histogram. */
-
-  /** Setup iterators .*/
-  typedef ImageLinearConstIteratorWithIndex<JointPDFType>            JointPDFIteratorType;
-  typedef ImageLinearConstIteratorWithIndex<JointPDFDerivativesType> JointPDFDerivativesIteratorType;
-  typedef typename MarginalPDFType::const_iterator                   MarginalPDFIteratorType;
-  typedef typename DerivativeType::iterator                          DerivativeIteratorType;
-
-  JointPDFIteratorType jointPDFit(this->m_JointPDF, this->m_JointPDF->GetLargestPossibleRegion());
-  jointPDFit.SetDirection(0);
-  jointPDFit.GoToBegin();
-  JointPDFDerivativesIteratorType jointPDFDerivativesit(this->m_JointPDFDerivatives,
-                                                        this->m_JointPDFDerivatives->GetLargestPossibleRegion());
-  jointPDFDerivativesit.SetDirection(0);
-  jointPDFDerivativesit.GoToBegin();
-  MarginalPDFIteratorType       fixedPDFit = this->m_FixedImageMarginalPDF.begin();
-  const MarginalPDFIteratorType fixedPDFend = this->m_FixedImageMarginalPDF.end();
-  MarginalPDFIteratorType       movingPDFit = this->m_MovingImageMarginalPDF.begin();
-  const MarginalPDFIteratorType movingPDFend = this->m_MovingImageMarginalPDF.end();
-  DerivativeIteratorType        derivit = derivative.begin();
-  const DerivativeIteratorType  derivbegin = derivative.begin();
-  const DerivativeIteratorType  derivend = derivative.end();
+  /** Compute the metric and derivatives by double summation over histogram.
+   * Rows and columns of the joint histogram with a zero marginal pdf
+   * do not contribute, and are skipped.
+   */
+  std::vector<unsigned int> movingBins;
+  this->ComputeNonZeroMarginalPDFBins(this->m_MovingImageMarginalPDF, movingBins);
+  const PDFValueType *           jointPDFBuffer = this->m_JointPDF->GetBufferPointer();
+  const OffsetValueType          jointPDFRowStride = this->m_JointPDF->GetOffsetTable()[1];
+  const PDFDerivativeValueType * jointPDFDerivativesBuffer = this->m_JointPDFDerivatives->GetBufferPointer();
+  const OffsetValueType          movingBinStride = this->m_JointPDFDerivatives->GetOffsetTable()[1];
+  const OffsetValueType          fixedBinStride = this->m_JointPDFDerivatives->GetOffsetTable()[2];
+  const unsigned int             numberOfParameters = derivative.GetSize();
 
   /** Loop over the joint histogram. */
   double MI = 0.0;
-  while (fixedPDFit != fixedPDFend)
+  for (unsigned int f = 0; f < this->m_FixedImageMarginalPDF.GetSize(); ++f)
   {
-    const double fixedImagePDFValue = *fixedPDFit;
-    movingPDFit = this->m_MovingImageMarginalPDF.begin();
-    while (movingPDFit != movingPDFend)
+    const double fixedImagePDFValue = this->m_FixedImageMarginalPDF[f];
+    if (fixedImagePDFValue <= 1e-16)
+    {
+      continue;
+    }
+
+    const PDFValueType * jointPDFRow = jointPDFBuffer + f * jointPDFRowStride;
+    for (const unsigned int m : movingBins)
     {
-      const double movingImagePDFValue = *movingPDFit;
+      const double movingImagePDFValue = this->m_MovingImageMarginalPDF[m];
       const double fixPDFmovPDF = fixedImagePDFValue * movingImagePDFValue;
-      const double jointPDFValue = jointPDFit.Get();
+      const double jointPDFValue = jointPDFRow[m];
 
       /** Check for non-zero bin contribution. */
       if (jointPDFValue > 1e-16 && fixPDFmovPDF > 1e-16)
       {
-        derivit = derivbegin;
         const double pRatio = std::log(jointPDFValue / fixPDFmovPDF);
         const double pRatioAlpha = this->m_Alpha * pRatio;
         MI += jointPDFValue * pRatio;
-        while (derivit != derivend)
-        {
-          /**  Ref: eq 23 of Thevenaz & Unser paper [3]. */
-          (*derivit) -= jointPDFDerivativesit.Get() * pRatioAlpha;
-          ++derivit;
-          ++jointPDFDerivativesit;
-        } // end while-loop over parameters
-      }   // end if-block to check non-zero bin contribution
 
-      ++movingPDFit;
-      ++jointPDFit;
-      jointPDFDerivativesit.NextLine();
-
-    } // end while-loop over moving index
-    ++fixedPDFit;
-    jointPDFit.NextLine();
-  } // end while-loop over fixed index
+        /**  Ref: eq 23 of Thevenaz & Unser paper [3]. */
+        const PDFDerivativeValueType * jointPDFDerivatives =
+          jointPDFDerivativesBuffer + f * fixedBinStride + m * movingBinStride;
+        for (unsigned int mu = 0; mu < numberOfParameters; ++mu)
+        {
+          derivative[mu] -= jointPDFDerivatives[mu] * pRatioAlpha;
+        }
+      } // end if-block to check non-zero bin contribution
+    }   // end for-loop over moving index
+  }     // end for-loop over fixed index
 
   value = static_cast<MeasureType>(-1.0 * MI);
 
@@ -318,7 +301,7 @@ ParzenWindowMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::Comp
     MovingImagePointType        mappedPoint;
 
     /** Transform point and check if it is inside the B-spline support region. */
-    bool sampleOk = this->TransformPoint(fixedPoint, mappedPoint);
+    bool sampleOk = this->TransformSamplePoint(fiter.Index(), fixedPoint, mappedPoint);
 
     /** Check if the point is inside the moving mask. */
     if (sampleOk)
@@ -344,7 +327,7 @@ ParzenWindowMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::Comp
       movingImageValue = this->GetMovingImageLimiter()->Evaluate(movingImageValue, movingImageDerivative);
 
       /** Get the transform Jacobian dT/dmu. */
-      this->EvaluateTransformJacobian(fixedPoint, jacobian, nzji);
+      this->EvaluateSampleTransformJacobian(fiter.Index(), fixedPoint, jacobian, nzji);
 
       /** Compute the inner product (dM/dx)^T (dT/dmu). */
       this->EvaluateTransformJacobianInnerProduct(jacobian, movingImageDerivative, imageJacobian);
@@ -430,6 +413,7 @@ ParzenWindowMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::Thre
   const NumberOfParametersType nnzji = this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices();
   NonZeroJacobianIndicesType   nzji = NonZeroJacobianIndicesType(nnzji);
   DerivativeType               imageJacobian(nzji.size());
+  TransformJacobianType        jacobian;
 
   /** Get a handle to the pre-allocated derivative for the current thread.
    * The initialization is performed at the beginning of each resolution in
@@ -451,95 +435,92 @@ ParzenWindowMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::Thre
   ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
   const unsigned long         sampleContainerSize = sampleContainer->Size();
 
-  /** Get the samples for this thread. */
-  const unsigned long nrOfSamplesPerThreads = static_cast<unsigned long>(
-    std::ceil(static_cast<double>(sampleContainerSize) / static_cast<double>(Self::GetNumberOfWorkUnits())));
-
-  unsigned long pos_begin = nrOfSamplesPerThreads * threadId;
-  unsigned long pos_end = nrOfSamplesPerThreads * (threadId + 1);
-  pos_begin = (pos_begin > sampleContainerSize) ? sampleContainerSize : pos_begin;
-  pos_end = (pos_end > sampleContainerSize) ? sampleContainerSize : pos_end;
-
-  /** Create iterator over the sample container. */
-  typename ImageSampleContainerType::ConstIterator fiter;
-  typename ImageSampleContainerType::ConstIterator fbegin = sampleContainer->Begin();
-  typename ImageSampleContainerType::ConstIterator fend = sampleContainer->Begin();
-  fbegin += (int)pos_begin;
-  fend += (int)pos_end;
-
-  /** Loop over sample container and compute contribution of each sample to pdfs. */
-  for (fiter = fbegin; fiter != fend; ++fiter)
+  /** Loop over the ranges of samples assigned to this thread. */
+  unsigned long pos_begin = 0;
+  unsigned long pos_end = 0;
+  bool          firstRange = true;
+  while (this->GetNextSampleRange(threadId, sampleContainerSize, firstRange, pos_begin, pos_end))
   {
-    /** Read fixed coordinates and create some variables. */
-    const FixedImagePointType & fixedPoint = (*fiter).Value().m_ImageCoordinates;
-    RealType                    movingImageValue;
-    MovingImageDerivativeType   movingImageDerivative;
-    MovingImagePointType        mappedPoint;
+    /** Create iterator over the sample container. */
+    typename ImageSampleContainerType::ConstIterator fiter;
+    typename ImageSampleContainerType::ConstIterator fbegin = sampleContainer->Begin();
+    typename ImageSampleContainerType::ConstIterator fend = sampleContainer->Begin();
+    fbegin += (int)pos_begin;
+    fend += (int)pos_end;
+
+    /** Loop over sample container and compute contribution of each sample to pdfs. */
+    for (fiter = fbegin; fiter != fend; ++fiter)
+    {
+      /** Read fixed coordinates and create some variables. */
+      const FixedImagePointType & fixedPoint = (*fiter).Value().m_ImageCoordinates;
+      RealType                    movingImageValue;
+      MovingImageDerivativeType   movingImageDerivative;
+      MovingImagePointType        mappedPoint;
 
-    /** Transform point and check if it is inside the B-spline support region. */
-    bool sampleOk = this->TransformPoint(fixedPoint, mappedPoint);
+      /** Transform point and check if it is inside the B-spline support region. */
+      bool sampleOk = this->TransformSamplePoint(fiter.Index(), fixedPoint, mappedPoint);
 
-    /** Check if the point is inside the moving mask. */
-    if (sampleOk)
-    {
-      sampleOk = this->IsInsideMovingMask(mappedPoint);
-    }
+      /** Check if the point is inside the moving mask. */
+      if (sampleOk)
+      {
+        sampleOk = this->IsInsideMovingMask(mappedPoint);
+      }
 
-    /** Compute the moving image value, its derivative, and check
-     * if the point is inside the moving image buffer.
-     */
-    if (sampleOk)
-    {
-      sampleOk = this->EvaluateMovingImageValueAndDerivative(mappedPoint, movingImageValue, &movingImageDerivative);
-    }
+      /** Compute the moving image value, its derivative, and check
+       * if the point is inside the moving image buffer.
+       */
+      if (sampleOk)
+      {
+        sampleOk = this->EvaluateMovingImageValueAndDerivative(mappedPoint, movingImageValue, &movingImageDerivative);
+      }
 
-    if (sampleOk)
-    {
-      /** Get the fixed image value. */
-      RealType fixedImageValue = static_cast<RealType>((*fiter).Value().m_ImageValue);
+      if (sampleOk)
+      {
+        /** Get the fixed image value. */
+        RealType fixedImageValue = static_cast<RealType>((*fiter).Value().m_ImageValue);
 
-      /** Make sure the values fall within the histogram range. */
-      fixedImageValue = this->GetFixedImageLimiter()->Evaluate(fixedImageValue);
-      movingImageValue = this->GetMovingImageLimiter()->Evaluate(movingImageValue, movingImageDerivative);
+        /** Make sure the values fall within the histogram range. */
+        fixedImageValue = this->GetFixedImageLimiter()->Evaluate(fixedImageValue);
+        movingImageValue = this->GetMovingImageLimiter()->Evaluate(movingImageValue, movingImageDerivative);
 
 #if 0
-      /** Get the TransformJacobian dT/dmu. */
-      this->EvaluateTransformJacobian( fixedPoint, jacobian, nzji );
+        /** Get the TransformJacobian dT/dmu. */
+        this->EvaluateTransformJacobian( fixedPoint, jacobian, nzji );
 
-      /** Compute the inner products (dM/dx)^T (dT/dmu). */
-      this->EvaluateTransformJacobianInnerProduct(
-        jacobian, movingImageDerivative, imageJacobian );
+        /** Compute the inner products (dM/dx)^T (dT/dmu). */
+        this->EvaluateTransformJacobianInnerProduct(
+          jacobian, movingImageDerivative, imageJacobian );
 #else
-      /** Compute the inner product of the transform Jacobian dT/dmu and the moving image gradient dM/dx. */
-      this->m_AdvancedTransform->EvaluateJacobianWithImageGradientProduct(
-        fixedPoint, movingImageDerivative, imageJacobian, nzji);
+        /** Compute the inner product of the transform Jacobian dT/dmu and the moving image gradient dM/dx. */
+        this->EvaluateSampleTransformJacobianWithImageGradientProduct(
+          fiter.Index(), fixedPoint, movingImageDerivative, jacobian, imageJacobian, nzji);
 #endif
 
-      /** If desired, apply the technique introduced by Tustison. */
-      TransformJacobianType jacobian;
-      if (this->GetUseJacobianPreconditioning())
-      {
-        this->EvaluateTransformJacobian(fixedPoint, jacobian, nzji);
-
-        this->ComputeJacobianPreconditioner(jacobian, nzji, jacobianPreconditioner, preconditioningDivisor);
-        DerivativeValueType * imjacit = imageJacobian.begin();
-        DerivativeValueType * jacprecit = jacobianPreconditioner.begin();
-        for (unsigned int i = 0; i < nzji.size(); ++i)
+        /** If desired, apply the technique introduced by Tustison. */
+        if (this->GetUseJacobianPreconditioning())
         {
-          while (imjacit != imageJacobian.end())
+          this->EvaluateSampleTransformJacobian(fiter.Index(), fixedPoint, jacobian, nzji);
+
+          this->ComputeJacobianPreconditioner(jacobian, nzji, jacobianPreconditioner, preconditioningDivisor);
+          DerivativeValueType * imjacit = imageJacobian.begin();
+          DerivativeValueType * jacprecit = jacobianPreconditioner.begin();
+          for (unsigned int i = 0; i < nzji.size(); ++i)
           {
-            (*imjacit) *= (*jacprecit);
-            ++imjacit;
-            ++jacprecit;
+            while (imjacit != imageJacobian.end())
+            {
+              (*imjacit) *= (*jacprecit);
+              ++imjacit;
+              ++jacprecit;
+            }
           }
         }
-      }
 
-      /** Compute this sample's contribution to the joint distributions. */
-      this->UpdateDerivativeLowMemory(fixedImageValue, movingImageValue, imageJacobian, nzji, derivative);
+        /** Compute this sample's contribution to the joint distributions. */
+        this->UpdateDerivativeLowMemory(fixedImageValue, movingImageValue, imageJacobian, nzji, derivative);
 
-    } // end sampleOk
-  }   // end loop over sample container
+      } // end sampleOk
+    } // end loop over sample container
+  } // end while loop over the sample ranges
 
   /** If desired, apply the technique introduced by Tustison. */
   if (this->GetUseJacobianPreconditioning())
@@ -607,9 +588,8 @@ ParzenWindowMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::Afte
     this->m_ThreaderMetricParameters.st_DerivativePointer = derivative.begin();
     this->m_ThreaderMetricParameters.st_NormalizationFactor = 1.0;
 
-    this->m_Threader->SetSingleMethod(this->AccumulateDerivativesThreaderCallback,
-                                      const_cast<void *>(static_cast<const void *>(&this->m_ThreaderMetricParameters)));
-    this->m_Threader->SingleMethodExecute();
+    this->LaunchThreaderCallback(this->AccumulateDerivativesThreaderCallback,
+                                 const_cast<void *>(static_cast<const void *>(&this->m_ThreaderMetricParameters)));
   }
 
 } // end AfterThreadedComputeDerivativeLowMemory()
@@ -647,14 +627,11 @@ ParzenWindowMutualInformationImageToImageMetric<TFixedImage,
                                                 TMovingImage>::LaunchComputeDerivativeLowMemoryThreaderCallback(void)
   const
 {
-  /** Setup threader. */
-  this->m_Threader->SetSingleMethod(
+  /** Setup threader and launch. */
+  this->LaunchThreaderCallback(
     this->ComputeDerivativeLowMemoryThreaderCallback,
     const_cast<void *>(static_cast<const void *>(&this->m_ParzenWindowMutualInformationThreaderParameters)));
 
-  /** Launch. */
-  this->m_Threader->SingleMethodExecute();
-
 } // end LaunchComputeDerivativeLowMemoryThreaderCallback()
 
 
@@ -667,65 +644,44 @@ void
 ParzenWindowMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::ComputeValueAndPRatioArray(
   double & MI) const
 {
-  /** Setup iterators. */
-  typedef ImageScanlineConstIterator<JointPDFType> JointPDFIteratorType;
-  typedef typename MarginalPDFType::const_iterator MarginalPDFIteratorType;
-
-  JointPDFIteratorType          jointPDFit(this->m_JointPDF, this->m_JointPDF->GetLargestPossibleRegion());
-  MarginalPDFIteratorType       fixedPDFit = this->m_FixedImageMarginalPDF.begin();
-  const MarginalPDFIteratorType fixedPDFend = this->m_FixedImageMarginalPDF.end();
-  MarginalPDFIteratorType       movingPDFit;
-  const MarginalPDFIteratorType movingPDFbegin = this->m_MovingImageMarginalPDF.begin();
-  const MarginalPDFIteratorType movingPDFend = this->m_MovingImageMarginalPDF.end();
+  /** Rows and columns of the joint histogram with a zero marginal pdf
+   * do not contribute, and are skipped.
+   */
+  std::vector<unsigned int> movingBins;
+  this->ComputeNonZeroMarginalPDFBins(this->m_MovingImageMarginalPDF, movingBins);
+  const PDFValueType *  jointPDFBuffer = this->m_JointPDF->GetBufferPointer();
+  const OffsetValueType jointPDFRowStride = this->m_JointPDF->GetOffsetTable()[1];
 
   /** Initialize */
   this->m_PRatioArray.Fill(itk::NumericTraits<PRatioType>::ZeroValue());
 
   /** Loop over the joint histogram. */
   PDFValueType sum = 0.0;
-  unsigned int fixedIndex = 0;
-  unsigned int movingIndex = 0;
-  while (fixedPDFit != fixedPDFend)
+  for (unsigned int fixedIndex = 0; fixedIndex < this->m_FixedImageMarginalPDF.GetSize(); ++fixedIndex)
   {
-    const double fixedPDFValue = *fixedPDFit;
-    double       logFixedPDFValue = 0.0;
-    if (fixedPDFValue > 1e-16)
+    const double fixedPDFValue = this->m_FixedImageMarginalPDF[fixedIndex];
+    if (fixedPDFValue <= 1e-16)
     {
-      logFixedPDFValue = std::log(fixedPDFValue);
+      continue;
     }
-    movingPDFit = movingPDFbegin;
-    movingIndex = 0;
+    const double logFixedPDFValue = std::log(fixedPDFValue);
 
-    while (movingPDFit != movingPDFend)
+    const PDFValueType * jointPDFRow = jointPDFBuffer + fixedIndex * jointPDFRowStride;
+    for (const unsigned int movingIndex : movingBins)
     {
-      const PDFValueType movingPDFValue = *movingPDFit;
-      const PDFValueType jointPDFValue = jointPDFit.Value();
+      const PDFValueType movingPDFValue = this->m_MovingImageMarginalPDF[movingIndex];
+      const PDFValueType jointPDFValue = jointPDFRow[movingIndex];
 
       /** Check for non-zero bin contribution. */
-      if (jointPDFValue > 1e-16 && movingPDFValue > 1e-16)
+      if (jointPDFValue > 1e-16)
       {
         const PDFValueType pRatio = std::log(jointPDFValue / movingPDFValue);
         this->m_PRatioArray[fixedIndex][movingIndex] = static_cast<PRatioType>(this->m_Alpha * pRatio);
-
-        if (fixedPDFValue > 1e-16)
-        {
-          sum += jointPDFValue * (pRatio - logFixedPDFValue);
-        }
+        sum += jointPDFValue * (pRatio - logFixedPDFValue);
       } // end if-block to check non-zero bin contribution
 
-      /** Update iterators. */
-      ++movingPDFit;
-      ++jointPDFit;
-      ++movingIndex;
-
-    } // end while-loop over moving index
-
-    /** Update iterators. */
-    ++fixedPDFit;
-    jointPDFit.NextLine();
-    ++fixedIndex;
-
-  } // end while-loop over fixed index
+    } // end for-loop over moving index
+  }   // end for-loop over fixed index
 
   // Assign
   MI = sum;
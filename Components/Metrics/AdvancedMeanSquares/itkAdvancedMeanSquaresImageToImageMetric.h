@@ -146,6 +146,13 @@ public:
                         MeasureType &                   value,
                         DerivativeType &                derivative) const override;
 
+  /** The transform and image sampler are only touched by BeforeThreadedGetValueAndDerivative(). */
+  bool
+  CanBeEvaluatedConcurrently(void) const override
+  {
+    return true;
+  }
+
   /** Experimental feature: compute SelfHessian */
   void
   GetSelfHessian(const TransformParametersType & parameters, HessianType & H) const override;
@@ -206,6 +213,7 @@ protected:
   typedef typename Superclass::CentralDifferenceGradientFilterType CentralDifferenceGradientFilterType;
   typedef typename Superclass::MovingImageDerivativeType           MovingImageDerivativeType;
   typedef typename Superclass::NonZeroJacobianIndicesType          NonZeroJacobianIndicesType;
+  typedef typename Superclass::TransformMovingImageGradientType    TransformMovingImageGradientType;
 
   /** Protected typedefs for SelfHessian */
   typedef SmoothingRecursiveGaussianImageFilter<FixedImageType, FixedImageType>         SmootherType;
@@ -217,14 +225,16 @@ protected:
   double m_NormalizationFactor;
 
   /** Compute a pixel's contribution to the measure and derivatives;
-   * Called by GetValueAndDerivative(). */
+   * Called by GetValueAndDerivative(). The derivative may be of single precision,
+   * see SetUseSinglePrecisionThreadDerivatives(). */
+  template <class TDerivative>
   void
   UpdateValueAndDerivativeTerms(const RealType                     fixedImageValue,
                                 const RealType                     movingImageValue,
                                 const DerivativeType &             imageJacobian,
                                 const NonZeroJacobianIndicesType & nzji,
                                 MeasureType &                      measure,
-                                DerivativeType &                   deriv) const;
+                                TDerivative &                      deriv) const;
 
   /** Compute a pixel's contribution to the SelfHessian;
    * Called by GetSelfHessian(). */
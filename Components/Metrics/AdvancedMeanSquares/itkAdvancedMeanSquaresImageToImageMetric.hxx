@@ -23,6 +23,9 @@
 #include "itkMersenneTwisterRandomVariateGenerator.h"
 #include "itkComputeImageExtremaFilter.h"
 
+#include <algorithm>
+#include <vector>
+
 #ifdef ELASTIX_USE_OPENMP
 #  include <omp.h>
 #endif
@@ -51,6 +54,9 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::AdvancedMeanSq
 
   this->m_SelfHessianNoiseRange = 1.0;
 
+  /** The threaded derivative computation supports single precision per-thread derivatives. */
+  this->m_SupportsSinglePrecisionThreadDerivatives = true;
+
 } // end Constructor
 
 
@@ -319,66 +325,67 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::ThreadedGetVal
   ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
   const unsigned long         sampleContainerSize = sampleContainer->Size();
 
-  /** Get the samples for this thread. */
-  const unsigned long nrOfSamplesPerThreads = static_cast<unsigned long>(
-    std::ceil(static_cast<double>(sampleContainerSize) / static_cast<double>(Self::GetNumberOfWorkUnits())));
-
-  unsigned long pos_begin = nrOfSamplesPerThreads * threadId;
-  unsigned long pos_end = nrOfSamplesPerThreads * (threadId + 1);
-  pos_begin = (pos_begin > sampleContainerSize) ? sampleContainerSize : pos_begin;
-  pos_end = (pos_end > sampleContainerSize) ? sampleContainerSize : pos_end;
-
-  /** Create iterator over the sample container. */
-  typename ImageSampleContainerType::ConstIterator threader_fiter;
-  typename ImageSampleContainerType::ConstIterator threader_fbegin = sampleContainer->Begin();
-  typename ImageSampleContainerType::ConstIterator threader_fend = sampleContainer->Begin();
-
-  threader_fbegin += (int)pos_begin;
-  threader_fend += (int)pos_end;
-
   /** Create variables to store intermediate results. circumvent false sharing */
   unsigned long numberOfPixelsCounted = 0;
   MeasureType   measure = NumericTraits<MeasureType>::Zero;
 
-  /** Loop over the fixed image to calculate the mean squares. */
-  for (threader_fiter = threader_fbegin; threader_fiter != threader_fend; ++threader_fiter)
+  /** The fixed and mapped points of a batch of samples. */
+  FixedImagePointType  fixedPoints[Superclass::SampleBatchSize];
+  MovingImagePointType mappedPoints[Superclass::SampleBatchSize];
+
+  /** Loop over the ranges of samples assigned to this thread. */
+  unsigned long pos_begin = 0;
+  unsigned long pos_end = 0;
+  bool          firstRange = true;
+  while (this->GetNextSampleRange(threadId, sampleContainerSize, firstRange, pos_begin, pos_end))
   {
-    /** Read fixed coordinates and initialize some variables. */
-    const FixedImagePointType & fixedPoint = (*threader_fiter).Value().m_ImageCoordinates;
-    RealType                    movingImageValue;
-    MovingImagePointType        mappedPoint;
+    /** Split the range into batches, of which all points are transformed at once. */
+    for (unsigned long batch_begin = pos_begin; batch_begin < pos_end; batch_begin += Superclass::SampleBatchSize)
+    {
+      const unsigned long batchSize =
+        std::min(pos_end - batch_begin, static_cast<unsigned long>(Superclass::SampleBatchSize));
 
-    /** Transform point and check if it is inside the B-spline support region. */
-    bool sampleOk = this->TransformPoint(fixedPoint, mappedPoint);
+      /** Transform the points and check if they are inside the B-spline support region. */
+      for (unsigned long i = 0; i < batchSize; ++i)
+      {
+        fixedPoints[i] = sampleContainer->ElementAt(batch_begin + i).m_ImageCoordinates;
+      }
+      this->TransformSamplePoints(batch_begin, fixedPoints, mappedPoints, batchSize);
 
-    /** Check if point is inside mask. */
-    if (sampleOk)
-    {
-      sampleOk = this->IsInsideMovingMask(mappedPoint); // thread-safe?
-    }
+      /** Loop over the samples of the batch to calculate the mean squares. */
+      for (unsigned long i = 0; i < batchSize; ++i)
+      {
+        const MovingImagePointType & mappedPoint = mappedPoints[i];
+        RealType                     movingImageValue;
 
-    /** Compute the moving image value M(T(x)) and check if
-     * the point is inside the moving image buffer.
-     */
-    if (sampleOk)
-    {
-      sampleOk = this->EvaluateMovingImageValueAndDerivative(mappedPoint, movingImageValue, nullptr);
-    }
+        /** Check if point is inside mask. */
+        bool sampleOk = this->IsInsideMovingMask(mappedPoint); // thread-safe?
 
-    if (sampleOk)
-    {
-      numberOfPixelsCounted++;
+        /** Compute the moving image value M(T(x)) and check if
+         * the point is inside the moving image buffer.
+         */
+        if (sampleOk)
+        {
+          sampleOk = this->EvaluateMovingImageValueAndDerivative(mappedPoint, movingImageValue, nullptr);
+        }
 
-      /** Get the fixed image value. */
-      const RealType & fixedImageValue = static_cast<RealType>((*threader_fiter).Value().m_ImageValue);
+        if (sampleOk)
+        {
+          numberOfPixelsCounted++;
 
-      /** The difference squared. */
-      const RealType diff = movingImageValue - fixedImageValue;
-      measure += diff * diff;
+          /** Get the fixed image value. */
+          const RealType & fixedImageValue =
+            static_cast<RealType>(sampleContainer->ElementAt(batch_begin + i).m_ImageValue);
 
-    } // end if sampleOk
+          /** The difference squared. */
+          const RealType diff = movingImageValue - fixedImageValue;
+          measure += diff * diff;
 
-  } // end for loop over the image sample container
+        } // end if sampleOk
+
+      } // end for loop over the samples of the batch
+    }   // end for loop over the batches
+  }     // end while loop over the sample ranges
 
   /** Only update these variables at the end to prevent unnecessary "false sharing". */
   this->m_GetValueAndDerivativePerThreadVariables[threadId].st_NumberOfPixelsCounted = numberOfPixelsCounted;
@@ -507,7 +514,7 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::GetValueAndDer
     MovingImageDerivativeType   movingImageDerivative;
 
     /** Transform point and check if it is inside the B-spline support region. */
-    bool sampleOk = this->TransformPoint(fixedPoint, mappedPoint);
+    bool sampleOk = this->TransformSamplePoint(fiter.Index(), fixedPoint, mappedPoint);
 
     /** Check if point is inside mask. */
     if (sampleOk)
@@ -539,8 +546,8 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::GetValueAndDer
         jacobian, movingImageDerivative, imageJacobian );
 #else
       /** Compute the inner product of the transform Jacobian and the moving image gradient. */
-      this->m_AdvancedTransform->EvaluateJacobianWithImageGradientProduct(
-        fixedPoint, movingImageDerivative, imageJacobian, nzji);
+      this->EvaluateSampleTransformJacobianWithImageGradientProduct(
+        fiter.Index(), fixedPoint, movingImageDerivative, jacobian, imageJacobian, nzji);
 #endif
 
       /** Compute this pixel's contribution to the measure and derivatives. */
@@ -617,10 +624,19 @@ template <class TFixedImage, class TMovingImage>
 void
 AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::ThreadedGetValueAndDerivative(ThreadIdType threadId)
 {
-  /** Initialize array that stores dM(x)/dmu, and the sparse Jacobian + indices. */
+  /** Get the per-thread arrays that store dM(x)/dmu and the sparse Jacobian indices, for a batch of samples.
+   * They are only (re)allocated when the number of nonzero Jacobian indices changes.
+   */
   const NumberOfParametersType nnzji = this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices();
-  NonZeroJacobianIndicesType   nzji = NonZeroJacobianIndicesType(nnzji);
-  DerivativeType               imageJacobian(nnzji);
+  std::vector<NonZeroJacobianIndicesType> & nzjis =
+    this->m_GetValueAndDerivativePerThreadVariables[threadId].st_BatchNonZeroJacobianIndices;
+  std::vector<DerivativeType> & imageJacobians =
+    this->m_GetValueAndDerivativePerThreadVariables[threadId].st_BatchImageJacobians;
+  if (imageJacobians.size() != Superclass::SampleBatchSize || imageJacobians[0].GetSize() != nnzji)
+  {
+    nzjis.assign(Superclass::SampleBatchSize, NonZeroJacobianIndicesType(nnzji));
+    imageJacobians.assign(Superclass::SampleBatchSize, DerivativeType(nnzji));
+  }
 
   /** Get a handle to the pre-allocated derivative for the current thread.
    * The initialization is performed at the beginning of each resolution in
@@ -628,84 +644,109 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::ThreadedGetVal
    * AfterThreadedGetValueAndDerivative() and the accumulate functions.
    */
   DerivativeType & derivative = this->m_GetValueAndDerivativePerThreadVariables[threadId].st_Derivative;
+  typename Superclass::SinglePrecisionDerivativeType & singlePrecisionDerivative =
+    this->m_GetValueAndDerivativePerThreadVariables[threadId].st_SinglePrecisionDerivative;
+  const bool useSinglePrecisionDerivative = this->GetUseSinglePrecisionThreadDerivativesInternal();
 
   /** Get a handle to the sample container. */
   ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
   const unsigned long         sampleContainerSize = sampleContainer->Size();
 
-  /** Get the samples for this thread. */
-  const unsigned long nrOfSamplesPerThreads = static_cast<unsigned long>(
-    std::ceil(static_cast<double>(sampleContainerSize) / static_cast<double>(Self::GetNumberOfWorkUnits())));
-
-  unsigned long pos_begin = nrOfSamplesPerThreads * threadId;
-  unsigned long pos_end = nrOfSamplesPerThreads * (threadId + 1);
-  pos_begin = (pos_begin > sampleContainerSize) ? sampleContainerSize : pos_begin;
-  pos_end = (pos_end > sampleContainerSize) ? sampleContainerSize : pos_end;
-
-  /** Create iterator over the sample container. */
-  typename ImageSampleContainerType::ConstIterator threader_fiter;
-  typename ImageSampleContainerType::ConstIterator threader_fbegin = sampleContainer->Begin();
-  typename ImageSampleContainerType::ConstIterator threader_fend = sampleContainer->Begin();
-
-  threader_fbegin += (int)pos_begin;
-  threader_fend += (int)pos_end;
-
   /** Create variables to store intermediate results. circumvent false sharing */
   unsigned long numberOfPixelsCounted = 0;
   MeasureType   measure = NumericTraits<MeasureType>::Zero;
 
-  /** Loop over the fixed image to calculate the mean squares. */
-  for (threader_fiter = threader_fbegin; threader_fiter != threader_fend; ++threader_fiter)
+  /** The points, image values and image derivatives of a batch of samples.
+   * The valid samples of a batch are stored contiguously at the start of the arrays.
+   */
+  FixedImagePointType              fixedPoints[Superclass::SampleBatchSize];
+  MovingImagePointType             mappedPoints[Superclass::SampleBatchSize];
+  FixedImagePointType              validFixedPoints[Superclass::SampleBatchSize];
+  SizeValueType                    validSampleIndices[Superclass::SampleBatchSize];
+  RealType                         fixedImageValues[Superclass::SampleBatchSize];
+  RealType                         movingImageValues[Superclass::SampleBatchSize];
+  TransformMovingImageGradientType movingImageDerivatives[Superclass::SampleBatchSize];
+  TransformJacobianType            jacobian;
+
+  /** Loop over the ranges of samples assigned to this thread. */
+  unsigned long pos_begin = 0;
+  unsigned long pos_end = 0;
+  bool          firstRange = true;
+  while (this->GetNextSampleRange(threadId, sampleContainerSize, firstRange, pos_begin, pos_end))
   {
-    /** Read fixed coordinates and initialize some variables. */
-    const FixedImagePointType & fixedPoint = (*threader_fiter).Value().m_ImageCoordinates;
-    RealType                    movingImageValue;
-    MovingImagePointType        mappedPoint;
-    MovingImageDerivativeType   movingImageDerivative;
-
-    /** Transform point and check if it is inside the B-spline support region. */
-    bool sampleOk = this->TransformPoint(fixedPoint, mappedPoint);
-
-    /** Check if point is inside mask. */
-    if (sampleOk)
-    {
-      sampleOk = this->IsInsideMovingMask(mappedPoint); // thread-safe?
-    }
-
-    /** Compute the moving image value M(T(x)) and derivative dM/dx and check if
-     * the point is inside the moving image buffer.
-     */
-    if (sampleOk)
+    /** Split the range into batches, of which all points are transformed at once. */
+    for (unsigned long batch_begin = pos_begin; batch_begin < pos_end; batch_begin += Superclass::SampleBatchSize)
     {
-      sampleOk = this->EvaluateMovingImageValueAndDerivative(mappedPoint, movingImageValue, &movingImageDerivative);
-    }
-
-    if (sampleOk)
-    {
-      numberOfPixelsCounted++;
-
-      /** Get the fixed image value. */
-      const RealType & fixedImageValue = static_cast<RealType>((*threader_fiter).Value().m_ImageValue);
-
-#if 0
-      /** Get the TransformJacobian dT/dmu. */
-      this->EvaluateTransformJacobian( fixedPoint, jacobian, nzji );
-
-      /** Compute the inner products (dM/dx)^T (dT/dmu). */
-      this->EvaluateTransformJacobianInnerProduct(
-        jacobian, movingImageDerivative, imageJacobian );
-#else
-      /** Compute the inner product of the transform Jacobian dT/dmu and the moving image gradient dM/dx. */
-      this->m_AdvancedTransform->EvaluateJacobianWithImageGradientProduct(
-        fixedPoint, movingImageDerivative, imageJacobian, nzji);
-#endif
+      const unsigned long batchSize =
+        std::min(pos_end - batch_begin, static_cast<unsigned long>(Superclass::SampleBatchSize));
 
-      /** Compute this pixel's contribution to the measure and derivatives. */
-      this->UpdateValueAndDerivativeTerms(fixedImageValue, movingImageValue, imageJacobian, nzji, measure, derivative);
+      /** Transform the points and check if they are inside the B-spline support region. */
+      for (unsigned long i = 0; i < batchSize; ++i)
+      {
+        fixedPoints[i] = sampleContainer->ElementAt(batch_begin + i).m_ImageCoordinates;
+      }
+      this->TransformSamplePoints(batch_begin, fixedPoints, mappedPoints, batchSize);
 
-    } // end if sampleOk
+      /** Collect the valid samples of the batch. */
+      unsigned long numberOfValidSamples = 0;
+      for (unsigned long i = 0; i < batchSize; ++i)
+      {
+        const MovingImagePointType & mappedPoint = mappedPoints[i];
+        RealType                     movingImageValue;
+        MovingImageDerivativeType    movingImageDerivative;
+
+        /** Check if point is inside mask. */
+        bool sampleOk = this->IsInsideMovingMask(mappedPoint); // thread-safe?
+
+        /** Compute the moving image value M(T(x)) and derivative dM/dx and check if
+         * the point is inside the moving image buffer.
+         */
+        if (sampleOk)
+        {
+          sampleOk = this->EvaluateMovingImageValueAndDerivative(mappedPoint, movingImageValue, &movingImageDerivative);
+        }
+
+        if (sampleOk)
+        {
+          validFixedPoints[numberOfValidSamples] = fixedPoints[i];
+          validSampleIndices[numberOfValidSamples] = batch_begin + i;
+          fixedImageValues[numberOfValidSamples] =
+            static_cast<RealType>(sampleContainer->ElementAt(batch_begin + i).m_ImageValue);
+          movingImageValues[numberOfValidSamples] = movingImageValue;
+          movingImageDerivatives[numberOfValidSamples] = movingImageDerivative;
+          ++numberOfValidSamples;
+        }
+      } // end for loop over the samples of the batch
+
+      /** Compute the inner products of the transform Jacobian dT/dmu and the
+       * moving image gradient dM/dx of all valid samples of the batch.
+       */
+      this->EvaluateSampleTransformJacobiansWithImageGradientProducts(validSampleIndices,
+                                                                      validFixedPoints,
+                                                                      movingImageDerivatives,
+                                                                      jacobian,
+                                                                      imageJacobians.data(),
+                                                                      nzjis.data(),
+                                                                      numberOfValidSamples);
+
+      /** Compute the contributions of the valid samples to the measure and derivatives. */
+      for (unsigned long i = 0; i < numberOfValidSamples; ++i)
+      {
+        if (useSinglePrecisionDerivative)
+        {
+          this->UpdateValueAndDerivativeTerms(
+            fixedImageValues[i], movingImageValues[i], imageJacobians[i], nzjis[i], measure, singlePrecisionDerivative);
+        }
+        else
+        {
+          this->UpdateValueAndDerivativeTerms(
+            fixedImageValues[i], movingImageValues[i], imageJacobians[i], nzjis[i], measure, derivative);
+        }
+      }
+      numberOfPixelsCounted += numberOfValidSamples;
 
-  } // end for loop over the image sample container
+    } // end for loop over the batches
+  }   // end while loop over the sample ranges
 
   /** Only update these variables at the end to prevent unnecessary "false sharing". */
   this->m_GetValueAndDerivativePerThreadVariables[threadId].st_NumberOfPixelsCounted = numberOfPixelsCounted;
@@ -755,44 +796,12 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::AfterThreadedG
   }
   value *= normal_sum;
 
-  /** Accumulate derivatives. */
-  // compute single-threadedly
-  if (!this->m_UseMultiThread && false) // force multi-threaded
-  {
-    derivative = this->m_GetValueAndDerivativePerThreadVariables[0].st_Derivative * normal_sum;
-    for (ThreadIdType i = 1; i < numberOfThreads; i++)
-    {
-      derivative += this->m_GetValueAndDerivativePerThreadVariables[i].st_Derivative * normal_sum;
-    }
-  }
-  // compute multi-threadedly with itk threads
-  else if (true) // force ITK threads !this->m_UseOpenMP )
-  {
-    this->m_ThreaderMetricParameters.st_DerivativePointer = derivative.begin();
-    this->m_ThreaderMetricParameters.st_NormalizationFactor = 1.0 / normal_sum;
-
-    this->m_Threader->SetSingleMethod(this->AccumulateDerivativesThreaderCallback,
-                                      const_cast<void *>(static_cast<const void *>(&this->m_ThreaderMetricParameters)));
-    this->m_Threader->SingleMethodExecute();
-  }
-#ifdef ELASTIX_USE_OPENMP
-  // compute multi-threadedly with openmp
-  else
-  {
-    const int spaceDimension = static_cast<int>(this->GetNumberOfParameters());
+  /** Accumulate derivatives multi-threadedly. */
+  this->m_ThreaderMetricParameters.st_DerivativePointer = derivative.begin();
+  this->m_ThreaderMetricParameters.st_NormalizationFactor = 1.0 / normal_sum;
 
-#  pragma omp parallel for
-    for (int j = 0; j < spaceDimension; ++j)
-    {
-      DerivativeValueType tmp = NumericTraits<DerivativeValueType>::Zero;
-      for (ThreadIdType i = 0; i < numberOfThreads; ++i)
-      {
-        tmp += this->m_GetValueAndDerivativePerThreadVariables[i].st_Derivative[j];
-      }
-      derivative[j] = tmp * normal_sum;
-    }
-  }
-#endif
+  this->LaunchThreaderCallback(this->AccumulateDerivativesThreaderCallback,
+                               const_cast<void *>(static_cast<const void *>(&this->m_ThreaderMetricParameters)));
 
 } // end AfterThreadedGetValueAndDerivative()
 
@@ -802,6 +811,7 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::AfterThreadedG
  */
 
 template <class TFixedImage, class TMovingImage>
+template <class TDerivative>
 void
 AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::UpdateValueAndDerivativeTerms(
   const RealType                     fixedImageValue,
@@ -809,7 +819,7 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::UpdateValueAnd
   const DerivativeType &             imageJacobian,
   const NonZeroJacobianIndicesType & nzji,
   MeasureType &                      measure,
-  DerivativeType &                   deriv) const
+  TDerivative &                      deriv) const
 {
   /** The difference squared. */
   const RealType diff = movingImageValue - fixedImageValue;
@@ -822,7 +832,7 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::UpdateValueAnd
   {
     /** Loop over all Jacobians. */
     typename DerivativeType::const_iterator imjacit = imageJacobian.begin();
-    typename DerivativeType::iterator       derivit = deriv.begin();
+    typename TDerivative::iterator          derivit = deriv.begin();
     for (unsigned int mu = 0; mu < this->GetNumberOfParameters(); ++mu)
     {
       (*derivit) += diff_2 * (*imjacit);
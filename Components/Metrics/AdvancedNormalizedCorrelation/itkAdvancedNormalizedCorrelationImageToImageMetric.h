@@ -172,6 +172,13 @@ public:
                         MeasureType &                   value,
                         DerivativeType &                derivative) const override;
 
+  /** This metric only writes its own threading variables during GetValueAndDerivative(). */
+  bool
+  CanBeEvaluatedConcurrently(void) const override
+  {
+    return true;
+  }
+
   /** Set/Get SubtractMean boolean. If true, the sample mean is subtracted
    * from the sample values in the cross-correlation formula and
    * typically results in narrower valleys in the cost function.
@@ -201,6 +208,7 @@ protected:
   typedef typename Superclass::CentralDifferenceGradientFilterType CentralDifferenceGradientFilterType;
   typedef typename Superclass::MovingImageDerivativeType           MovingImageDerivativeType;
   typedef typename Superclass::NonZeroJacobianIndicesType          NonZeroJacobianIndicesType;
+  typedef typename Superclass::TransformMovingImageGradientType    TransformMovingImageGradientType;
 
   /** Compute a pixel's contribution to the derivative terms;
    * Called by GetValueAndDerivative().
@@ -267,6 +275,10 @@ private:
     DerivativeType st_DerivativeF;
     DerivativeType st_DerivativeM;
     DerivativeType st_Differential;
+
+    /** Scratch space for the image Jacobians of a batch of samples, reused over the iterations. */
+    std::vector<DerivativeType>             st_BatchImageJacobians;
+    std::vector<NonZeroJacobianIndicesType> st_BatchNonZeroJacobianIndices;
   };
   itkPadStruct(ITK_CACHE_LINE_ALIGNMENT,
                CorrelationGetValueAndDerivativePerThreadStruct,
@@ -230,7 +230,7 @@ AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>::GetV
     MovingImagePointType        mappedPoint;
 
     /** Transform point and check if it is inside the B-spline support region. */
-    bool sampleOk = this->TransformPoint(fixedPoint, mappedPoint);
+    bool sampleOk = this->TransformSamplePoint(fiter.Index(), fixedPoint, mappedPoint);
 
     /** Check if point is inside mask. */
     if (sampleOk)
@@ -389,7 +389,7 @@ AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>::GetV
     MovingImageDerivativeType   movingImageDerivative;
 
     /** Transform point and check if it is inside the B-spline support region. */
-    bool sampleOk = this->TransformPoint(fixedPoint, mappedPoint);
+    bool sampleOk = this->TransformSamplePoint(fiter.Index(), fixedPoint, mappedPoint);
 
     /** Check if point is inside mask. */
     if (sampleOk)
@@ -413,7 +413,7 @@ AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>::GetV
       const RealType & fixedImageValue = static_cast<RealType>((*fiter).Value().m_ImageValue);
 
       /** Get the TransformJacobian dT/dmu. */
-      this->EvaluateTransformJacobian(fixedPoint, jacobian, nzji);
+      this->EvaluateSampleTransformJacobian(fiter.Index(), fixedPoint, jacobian, nzji);
 
       /** Compute the innerproducts (dM/dx)^T (dT/dmu) and (dMask/dx)^T (dT/dmu). */
       this->EvaluateTransformJacobianInnerProduct(jacobian, movingImageDerivative, imageJacobian);
@@ -524,10 +524,20 @@ void
 AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>::ThreadedGetValueAndDerivative(
   ThreadIdType threadId)
 {
-  /** Initialize array that stores dM(x)/dmu, and the sparse Jacobian + indices. */
+  /** Get the per-thread arrays that store dM(x)/dmu and the sparse Jacobian indices, for a batch of samples.
+   * They are only (re)allocated when the number of nonzero Jacobian indices changes.
+   */
   const NumberOfParametersType nnzji = this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices();
-  NonZeroJacobianIndicesType   nzji = NonZeroJacobianIndicesType(nnzji);
-  DerivativeType               imageJacobian(nzji.size());
+  std::vector<NonZeroJacobianIndicesType> & nzjis =
+    this->m_CorrelationGetValueAndDerivativePerThreadVariables[threadId].st_BatchNonZeroJacobianIndices;
+  std::vector<DerivativeType> & imageJacobians =
+    this->m_CorrelationGetValueAndDerivativePerThreadVariables[threadId].st_BatchImageJacobians;
+  if (imageJacobians.size() != Superclass::SampleBatchSize || imageJacobians[0].GetSize() != nnzji)
+  {
+    nzjis.assign(Superclass::SampleBatchSize, NonZeroJacobianIndicesType(nnzji));
+    imageJacobians.assign(Superclass::SampleBatchSize, DerivativeType(nnzji));
+  }
+  TransformJacobianType jacobian;
 
   /** Get handles to the pre-allocated derivatives for the current thread.
    * The initialization is performed at the beginning of each resolution in
@@ -542,23 +552,6 @@ AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>::Thre
   ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
   const unsigned long         sampleContainerSize = sampleContainer->Size();
 
-  /** Get the samples for this thread. */
-  const unsigned long nrOfSamplesPerThreads = static_cast<unsigned long>(
-    std::ceil(static_cast<double>(sampleContainerSize) / static_cast<double>(Self::GetNumberOfWorkUnits())));
-
-  unsigned long pos_begin = nrOfSamplesPerThreads * threadId;
-  unsigned long pos_end = nrOfSamplesPerThreads * (threadId + 1);
-  pos_begin = (pos_begin > sampleContainerSize) ? sampleContainerSize : pos_begin;
-  pos_end = (pos_end > sampleContainerSize) ? sampleContainerSize : pos_end;
-
-  /** Create iterator over the sample container. */
-  typename ImageSampleContainerType::ConstIterator threader_fiter;
-  typename ImageSampleContainerType::ConstIterator threader_fbegin = sampleContainer->Begin();
-  typename ImageSampleContainerType::ConstIterator threader_fend = sampleContainer->Begin();
-
-  threader_fbegin += (int)pos_begin;
-  threader_fend += (int)pos_end;
-
   /** Create variables to store intermediate results. */
   AccumulateType sff = NumericTraits<AccumulateType>::Zero;
   AccumulateType smm = NumericTraits<AccumulateType>::Zero;
@@ -567,66 +560,99 @@ AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>::Thre
   AccumulateType sm = NumericTraits<AccumulateType>::Zero;
   unsigned long  numberOfPixelsCounted = 0;
 
-  /** Loop over the fixed image to calculate the mean squares. */
-  for (threader_fiter = threader_fbegin; threader_fiter != threader_fend; ++threader_fiter)
+  /** The points, image values and image derivatives of a batch of samples.
+   * The valid samples of a batch are stored contiguously at the start of the arrays.
+   */
+  FixedImagePointType              fixedPoints[Superclass::SampleBatchSize];
+  MovingImagePointType             mappedPoints[Superclass::SampleBatchSize];
+  FixedImagePointType              validFixedPoints[Superclass::SampleBatchSize];
+  SizeValueType                    validSampleIndices[Superclass::SampleBatchSize];
+  RealType                         fixedImageValues[Superclass::SampleBatchSize];
+  RealType                         movingImageValues[Superclass::SampleBatchSize];
+  TransformMovingImageGradientType movingImageDerivatives[Superclass::SampleBatchSize];
+
+  /** Loop over the ranges of samples assigned to this thread. */
+  unsigned long pos_begin = 0;
+  unsigned long pos_end = 0;
+  bool          firstRange = true;
+  while (this->GetNextSampleRange(threadId, sampleContainerSize, firstRange, pos_begin, pos_end))
   {
-    /** Read fixed coordinates and initialize some variables. */
-    const FixedImagePointType & fixedPoint = (*threader_fiter).Value().m_ImageCoordinates;
-    RealType                    movingImageValue;
-    MovingImagePointType        mappedPoint;
-    MovingImageDerivativeType   movingImageDerivative;
-
-    /** Transform point and check if it is inside the B-spline support region. */
-    bool sampleOk = this->TransformPoint(fixedPoint, mappedPoint);
-
-    /** Check if point is inside mask. */
-    if (sampleOk)
-    {
-      sampleOk = this->IsInsideMovingMask(mappedPoint);
-    }
-
-    /** Compute the moving image value M(T(x)) and derivative dM/dx and check if
-     * the point is inside the moving image buffer.
-     */
-    if (sampleOk)
+    /** Split the range into batches, of which all points are transformed at once. */
+    for (unsigned long batch_begin = pos_begin; batch_begin < pos_end; batch_begin += Superclass::SampleBatchSize)
     {
-      sampleOk = this->EvaluateMovingImageValueAndDerivative(mappedPoint, movingImageValue, &movingImageDerivative);
-    }
-
-    if (sampleOk)
-    {
-      numberOfPixelsCounted++;
-
-      /** Get the fixed image value. */
-      const RealType & fixedImageValue = static_cast<RealType>((*threader_fiter).Value().m_ImageValue);
-
-#if 0
-      /** Get the TransformJacobian dT/dmu. */
-      this->EvaluateTransformJacobian( fixedPoint, jacobian, nzji );
-
-      /** Compute the inner products (dM/dx)^T (dT/dmu). */
-      this->EvaluateTransformJacobianInnerProduct(
-        jacobian, movingImageDerivative, imageJacobian );
-#else
-      /** Compute the inner product of the transform Jacobian dT/dmu and the moving image gradient dM/dx. */
-      this->m_AdvancedTransform->EvaluateJacobianWithImageGradientProduct(
-        fixedPoint, movingImageDerivative, imageJacobian, nzji);
-#endif
-
-      /** Update some sums needed to calculate the value of NC. */
-      sff += fixedImageValue * fixedImageValue;
-      smm += movingImageValue * movingImageValue;
-      sfm += fixedImageValue * movingImageValue;
-      sf += fixedImageValue;  // Only needed when m_SubtractMean == true
-      sm += movingImageValue; // Only needed when m_SubtractMean == true
+      const unsigned long batchSize =
+        std::min(pos_end - batch_begin, static_cast<unsigned long>(Superclass::SampleBatchSize));
 
-      /** Compute this voxel's contribution to the derivative terms. */
-      this->UpdateDerivativeTerms(
-        fixedImageValue, movingImageValue, imageJacobian, nzji, derivativeF, derivativeM, differential);
+      /** Transform the points and check if they are inside the B-spline support region. */
+      for (unsigned long i = 0; i < batchSize; ++i)
+      {
+        fixedPoints[i] = sampleContainer->ElementAt(batch_begin + i).m_ImageCoordinates;
+      }
+      this->TransformSamplePoints(batch_begin, fixedPoints, mappedPoints, batchSize);
 
-    } // end if sampleOk
+      /** Collect the valid samples of the batch. */
+      unsigned long numberOfValidSamples = 0;
+      for (unsigned long i = 0; i < batchSize; ++i)
+      {
+        const MovingImagePointType & mappedPoint = mappedPoints[i];
+        RealType                     movingImageValue;
+        MovingImageDerivativeType    movingImageDerivative;
+
+        /** Check if point is inside mask. */
+        bool sampleOk = this->IsInsideMovingMask(mappedPoint);
+
+        /** Compute the moving image value M(T(x)) and derivative dM/dx and check if
+         * the point is inside the moving image buffer.
+         */
+        if (sampleOk)
+        {
+          sampleOk = this->EvaluateMovingImageValueAndDerivative(mappedPoint, movingImageValue, &movingImageDerivative);
+        }
+
+        if (sampleOk)
+        {
+          validFixedPoints[numberOfValidSamples] = fixedPoints[i];
+          validSampleIndices[numberOfValidSamples] = batch_begin + i;
+          fixedImageValues[numberOfValidSamples] =
+            static_cast<RealType>(sampleContainer->ElementAt(batch_begin + i).m_ImageValue);
+          movingImageValues[numberOfValidSamples] = movingImageValue;
+          movingImageDerivatives[numberOfValidSamples] = movingImageDerivative;
+          ++numberOfValidSamples;
+        }
+      } // end for loop over the samples of the batch
+
+      /** Compute the inner products of the transform Jacobian dT/dmu and the
+       * moving image gradient dM/dx of all valid samples of the batch.
+       */
+      this->EvaluateSampleTransformJacobiansWithImageGradientProducts(validSampleIndices,
+                                                                      validFixedPoints,
+                                                                      movingImageDerivatives,
+                                                                      jacobian,
+                                                                      imageJacobians.data(),
+                                                                      nzjis.data(),
+                                                                      numberOfValidSamples);
+
+      /** Compute the contributions of the valid samples. */
+      for (unsigned long i = 0; i < numberOfValidSamples; ++i)
+      {
+        const RealType fixedImageValue = fixedImageValues[i];
+        const RealType movingImageValue = movingImageValues[i];
+
+        /** Update some sums needed to calculate the value of NC. */
+        sff += fixedImageValue * fixedImageValue;
+        smm += movingImageValue * movingImageValue;
+        sfm += fixedImageValue * movingImageValue;
+        sf += fixedImageValue;  // Only needed when m_SubtractMean == true
+        sm += movingImageValue; // Only needed when m_SubtractMean == true
+
+        /** Compute this voxel's contribution to the derivative terms. */
+        this->UpdateDerivativeTerms(
+          fixedImageValue, movingImageValue, imageJacobians[i], nzjis[i], derivativeF, derivativeM, differential);
+      }
+      numberOfPixelsCounted += numberOfValidSamples;
 
-  } // end for loop over the image sample container
+    } // end for loop over the batches
+  }   // end while loop over the sample ranges
 
   /** Only update these variables at the end to prevent unnecessary "false sharing". */
   this->m_CorrelationGetValueAndDerivativePerThreadVariables[threadId].st_NumberOfPixelsCounted = numberOfPixelsCounted;
@@ -759,8 +785,7 @@ AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>::Afte
     temp->st_InvertedDenominator = 1.0 / denom;
     temp->st_DerivativePointer = derivative.begin();
 
-    this->m_Threader->SetSingleMethod(AccumulateDerivativesThreaderCallback, temp);
-    this->m_Threader->SingleMethodExecute();
+    this->LaunchThreaderCallback(AccumulateDerivativesThreaderCallback, temp);
 
     delete temp;
   }
@@ -39,6 +39,12 @@ namespace elastix
  * The parameters used in this class are:
  * \parameter Metric: Select this metric as follows:\n
  *    <tt>(Metric "TransformBendingEnergyPenalty")</tt>
+ * \parameter UseAnalyticBendingEnergy: compute the bending energy of a B-spline transform
+ *    exactly on the control point grid, instead of by sampling the fixed image. The energy is
+ *    integrated over the fixed image region, ignoring masks and initial transforms. The cost
+ *    is proportional to the number of control points. Can be given for each resolution.\n
+ *    example: <tt>(UseAnalyticBendingEnergy "true" "true" "false")</tt>\n
+ *    Default is "false".
  *
  * \ingroup Metrics
  *
@@ -133,6 +139,7 @@ public:
   /**
    * Do some things before each resolution:
    * \li Set options for SelfHessian
+   * \li Set the option to compute the bending energy analytically
    */
   void
   BeforeEachResolution(void) override;
@@ -59,6 +59,12 @@ TransformBendingEnergyPenalty<TElastix>::BeforeEachResolution(void)
     numberOfSamplesForSelfHessian, "NumberOfSamplesForSelfHessian", this->GetComponentLabel(), level, 0);
   this->SetNumberOfSamplesForSelfHessian(numberOfSamplesForSelfHessian);
 
+  /** Compute the bending energy of a B-spline transform on the control point grid, or not. */
+  bool useAnalyticBendingEnergy = false;
+  this->GetConfiguration()->ReadParameter(
+    useAnalyticBendingEnergy, "UseAnalyticBendingEnergy", this->GetComponentLabel(), level, 0);
+  this->SetUseAnalyticBendingEnergy(useAnalyticBendingEnergy);
+
 } // end BeforeEachResolution()
 
 
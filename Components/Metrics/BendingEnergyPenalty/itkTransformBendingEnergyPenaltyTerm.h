@@ -21,6 +21,8 @@
 #include "itkTransformPenaltyTerm.h"
 #include "itkImageGridSampler.h"
 
+#include <vector>
+
 namespace itk
 {
 
@@ -34,6 +36,16 @@ namespace itk
  * [1]. For rigid and affine transformation this energy is always
  * zero.
  *
+ * For B-spline transforms the bending energy can optionally be computed
+ * analytically, see SetUseAnalyticBendingEnergy(). The integral of the
+ * squared second order derivatives over the fixed image domain is then
+ * a quadratic form in the B-spline coefficients. Since the B-spline basis
+ * is separable, this quadratic form is a sum of tensor products of banded
+ * one-dimensional Gram matrices of the basis function derivatives. These
+ * are precomputed once per grid, after which the value and derivative are
+ * exact and cost a number of operations proportional to the number of
+ * control points, independent of the number of image samples.
+ *
  *
  * [1]: D. Rueckert, L. I. Sonoda, C. Hayes, D. L. G. Hill,
  *      M. O. Leach, and D. J. Hawkes, "Nonrigid registration
@@ -142,6 +154,15 @@ public:
                         MeasureType &          value,
                         DerivativeType &       derivative) const override;
 
+  /** The sampled and the analytic computation only set the transform parameters when
+   * UseMetricSingleThreaded is on, so the penalty may run next to other metrics.
+   */
+  bool
+  CanBeEvaluatedConcurrently(void) const override
+  {
+    return true;
+  }
+
   /** Get value and derivatives for each thread. */
   inline void
   ThreadedGetValueAndDerivative(ThreadIdType threadID) override;
@@ -158,6 +179,19 @@ public:
   itkSetMacro(NumberOfSamplesForSelfHessian, unsigned int);
   itkGetConstMacro(NumberOfSamplesForSelfHessian, unsigned int);
 
+  /** Compute the bending energy of B-spline transforms analytically on the
+   * control point grid, instead of by sampling the fixed image. The energy
+   * is then integrated exactly over the part of the fixed image region that
+   * lies inside the valid region of the B-spline grid, and normalized by its
+   * volume, such that the value matches the sampled mean. Image masks and
+   * initial transforms are not taken into account, and the grid direction
+   * is assumed to be orthonormal. Other transforms use the sampled
+   * computation. Default: false.
+   */
+  itkSetMacro(UseAnalyticBendingEnergy, bool);
+  itkGetConstMacro(UseAnalyticBendingEnergy, bool);
+  itkBooleanMacro(UseAnalyticBendingEnergy);
+
 protected:
   /** Typedefs for indices and points. */
   typedef typename Superclass::FixedImageIndexType            FixedImageIndexType;
@@ -171,6 +205,21 @@ protected:
   /** Typedefs for SelfHessian */
   typedef ImageGridSampler<FixedImageType> SelfHessianSamplerType;
 
+  /** Typedefs for the analytic bending energy. */
+  typedef typename Superclass::BSplineBaseTransformType  BSplineBaseTransformType;
+  typedef typename Superclass::BSplineGridParametersType BSplineGridParametersType;
+  typedef typename BSplineBaseTransformType::SizeType    GridSizeType;
+  typedef std::vector<double>                            GramMatrixType;
+
+  /** Compute the analytic bending energy and, if requested, its derivative.
+   * Returns false if the transform is not a B-spline, in which case
+   * the sampled computation should be used.
+   */
+  bool
+  ComputeAnalyticValueAndDerivative(const ParametersType & parameters,
+                                    MeasureType &          value,
+                                    DerivativeType *       derivative) const;
+
   /** The constructor. */
   TransformBendingEnergyPenaltyTerm();
 
@@ -184,7 +233,33 @@ private:
   void
   operator=(const Self &) = delete;
 
+  /** Compute the banded Gram matrices of the B-spline basis functions and their
+   * first and second order derivatives, integrated over [lower, upper] in
+   * continuous grid index coordinates.
+   */
+  template <unsigned int VSplineOrder>
+  void
+  ComputeGramMatrices(const double lower[], const double upper[], const GridSizeType & gridSize) const;
+
+  /** Multiply a coefficient image by the tensor product of the Gram matrices
+   * of the given derivative orders, storing the result in output.
+   */
+  void
+  ApplyGramMatrices(const double *        input,
+                    const unsigned int    derivativeOrders[],
+                    std::vector<double> & output,
+                    std::vector<double> & buffer) const;
+
   unsigned int m_NumberOfSamplesForSelfHessian;
+  bool         m_UseAnalyticBendingEnergy;
+
+  /** The precomputed Gram matrices and the geometry they belong to. */
+  mutable BSplineGridParametersType m_GramGridParameters;
+  mutable FixedImageRegionType      m_GramFixedImageRegion;
+  mutable unsigned int              m_GramSplineOrder;
+  mutable GridSizeType              m_GramGridSize;
+  mutable double                    m_GramNormalization;
+  mutable GramMatrixType            m_GramMatrices[FixedImageDimension][3];
 };
 
 } // end namespace itk
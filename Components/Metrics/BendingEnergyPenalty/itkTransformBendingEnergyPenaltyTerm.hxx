@@ -19,6 +19,11 @@
 #define itkTransformBendingEnergyPenaltyTerm_hxx
 
 #include "itkTransformBendingEnergyPenaltyTerm.h"
+#include "itkBSplineKernelFunction2.h"
+#include "itkBSplineDerivativeKernelFunction2.h"
+#include "itkBSplineSecondOrderDerivativeKernelFunction2.h"
+#include <algorithm>
+#include <limits>
 
 #ifdef ELASTIX_USE_OPENMP
 #  include <omp.h>
@@ -40,6 +45,9 @@ TransformBendingEnergyPenaltyTerm<TFixedImage, TScalarType>::TransformBendingEne
   this->SetUseImageSampler(true);
 
   this->m_NumberOfSamplesForSelfHessian = 100000;
+  this->m_UseAnalyticBendingEnergy = false;
+  this->m_GramSplineOrder = 0;
+  this->m_GramNormalization = 0.0;
 
 } // end Constructor
 
@@ -52,6 +60,16 @@ template <class TFixedImage, class TScalarType>
 typename TransformBendingEnergyPenaltyTerm<TFixedImage, TScalarType>::MeasureType
 TransformBendingEnergyPenaltyTerm<TFixedImage, TScalarType>::GetValue(const ParametersType & parameters) const
 {
+  /** Compute the bending energy on the B-spline grid, if requested. */
+  if (this->m_UseAnalyticBendingEnergy)
+  {
+    MeasureType value = NumericTraits<MeasureType>::Zero;
+    if (this->ComputeAnalyticValueAndDerivative(parameters, value, nullptr))
+    {
+      return value;
+    }
+  }
+
   /** Initialize some variables. */
   this->m_NumberOfPixelsCounted = 0;
   RealType           measure = NumericTraits<RealType>::Zero;
@@ -354,6 +372,12 @@ TransformBendingEnergyPenaltyTerm<TFixedImage, TScalarType>::GetValueAndDerivati
                                                                                    MeasureType &          value,
                                                                                    DerivativeType & derivative) const
 {
+  /** Compute the bending energy on the B-spline grid, if requested. */
+  if (this->m_UseAnalyticBendingEnergy && this->ComputeAnalyticValueAndDerivative(parameters, value, &derivative))
+  {
+    return;
+  }
+
   /** Option for now to still use the single threaded code. */
   if (!this->m_UseMultiThread)
   {
@@ -617,9 +641,8 @@ TransformBendingEnergyPenaltyTerm<TFixedImage, TScalarType>::AfterThreadedGetVal
     this->m_ThreaderMetricParameters.st_NormalizationFactor =
       static_cast<DerivativeValueType>(this->m_NumberOfPixelsCounted);
 
-    this->m_Threader->SetSingleMethod(this->AccumulateDerivativesThreaderCallback,
-                                      const_cast<void *>(static_cast<const void *>(&this->m_ThreaderMetricParameters)));
-    this->m_Threader->SingleMethodExecute();
+    this->LaunchThreaderCallback(this->AccumulateDerivativesThreaderCallback,
+                                 const_cast<void *>(static_cast<const void *>(&this->m_ThreaderMetricParameters)));
   }
 #ifdef ELASTIX_USE_OPENMP
   // compute multi-threadedly with openmp
@@ -815,6 +838,333 @@ TransformBendingEnergyPenaltyTerm<TFixedImage, TScalarType>::GetSelfHessian(cons
 } // end GetSelfHessian()
 
 
+/**
+ * ******************* ComputeAnalyticValueAndDerivative *******************
+ */
+
+template <class TFixedImage, class TScalarType>
+bool
+TransformBendingEnergyPenaltyTerm<TFixedImage, TScalarType>::ComputeAnalyticValueAndDerivative(
+  const ParametersType & parameters,
+  MeasureType &          value,
+  DerivativeType *       derivative) const
+{
+  /** Find the B-spline transform, possibly as the current transform of a combination transform. */
+  const BSplineBaseTransformType * bsplineTransform =
+    dynamic_cast<const BSplineBaseTransformType *>(this->m_AdvancedTransform.GetPointer());
+  const CombinationTransformType * combinationTransform =
+    dynamic_cast<const CombinationTransformType *>(this->m_AdvancedTransform.GetPointer());
+  if (bsplineTransform == nullptr && combinationTransform != nullptr)
+  {
+    bsplineTransform = dynamic_cast<const BSplineBaseTransformType *>(combinationTransform->GetCurrentTransform());
+  }
+
+  /** Determine the spline order. */
+  unsigned int splineOrder = 0;
+  if (dynamic_cast<const BSplineOrder1TransformType *>(bsplineTransform) != nullptr)
+  {
+    splineOrder = 1;
+  }
+  else if (dynamic_cast<const BSplineOrder2TransformType *>(bsplineTransform) != nullptr)
+  {
+    splineOrder = 2;
+  }
+  else if (dynamic_cast<const BSplineOrder3TransformType *>(bsplineTransform) != nullptr)
+  {
+    splineOrder = 3;
+  }
+
+  /** Quit if the parameters are not just the B-spline coefficients. */
+  const GridSizeType  gridSize = bsplineTransform ? bsplineTransform->GetGridRegion().GetSize() : GridSizeType();
+  const SizeValueType numberOfGridPoints = bsplineTransform ? bsplineTransform->GetGridRegion().GetNumberOfPixels() : 0;
+  if (splineOrder == 0 || parameters.GetSize() != FixedImageDimension * numberOfGridPoints)
+  {
+    return false;
+  }
+
+  /** Like the sampled computation, leave the transform at the parameters that are evaluated.
+   * Otherwise BeforeThreadedGetValueAndDerivative() has already done so, see the combination metric.
+   */
+  if (this->m_UseMetricSingleThreaded)
+  {
+    this->SetTransformParameters(parameters);
+  }
+
+  /** Initialize the value and derivative. */
+  value = NumericTraits<MeasureType>::Zero;
+  if (derivative != nullptr)
+  {
+    *derivative = DerivativeType(this->GetNumberOfParameters());
+    derivative->Fill(NumericTraits<DerivativeValueType>::ZeroValue());
+  }
+
+  /** The second order derivatives of a linear B-spline vanish almost everywhere. */
+  if (splineOrder < 2)
+  {
+    return true;
+  }
+
+  /** Recompute the Gram matrices if the grid or the fixed image region changed. */
+  const FixedImageRegionType & fixedImageRegion = this->GetFixedImageRegion();
+  if (splineOrder != this->m_GramSplineOrder || fixedImageRegion != this->m_GramFixedImageRegion ||
+      bsplineTransform->GetFixedParameters() != this->m_GramGridParameters)
+  {
+    /** Compute the matrix mapping physical points to continuous grid indices. */
+    typedef typename BSplineBaseTransformType::DirectionType GridDirectionType;
+    GridDirectionType                                        scaledDirection = bsplineTransform->GetGridDirection();
+    for (unsigned int i = 0; i < FixedImageDimension; ++i)
+    {
+      for (unsigned int j = 0; j < FixedImageDimension; ++j)
+      {
+        scaledDirection[i][j] *= bsplineTransform->GetGridSpacing()[j];
+      }
+    }
+    const vnl_matrix_fixed<double, FixedImageDimension, FixedImageDimension> pointToIndex =
+      scaledDirection.GetInverse();
+
+    /** Compute the bounding box of the fixed image region in grid index coordinates,
+     * relative to the first coefficient.
+     */
+    double lower[FixedImageDimension];
+    double upper[FixedImageDimension];
+    std::fill_n(lower, FixedImageDimension, std::numeric_limits<double>::max());
+    std::fill_n(upper, FixedImageDimension, -std::numeric_limits<double>::max());
+    for (unsigned int corner = 0; corner < (1u << FixedImageDimension); ++corner)
+    {
+      ContinuousIndex<double, FixedImageDimension> fixedIndex;
+      for (unsigned int d = 0; d < FixedImageDimension; ++d)
+      {
+        fixedIndex[d] = static_cast<double>(fixedImageRegion.GetIndex()[d]) - 0.5;
+        if ((corner >> d) & 1u)
+        {
+          fixedIndex[d] += static_cast<double>(fixedImageRegion.GetSize()[d]);
+        }
+      }
+      FixedImagePointType point;
+      this->GetFixedImage()->TransformContinuousIndexToPhysicalPoint(fixedIndex, point);
+
+      for (unsigned int i = 0; i < FixedImageDimension; ++i)
+      {
+        double gridIndex = -static_cast<double>(bsplineTransform->GetGridRegion().GetIndex()[i]);
+        for (unsigned int j = 0; j < FixedImageDimension; ++j)
+        {
+          gridIndex += pointToIndex[i][j] * (point[j] - bsplineTransform->GetGridOrigin()[j]);
+        }
+        lower[i] = std::min(lower[i], gridIndex);
+        upper[i] = std::max(upper[i], gridIndex);
+      }
+    }
+
+    /** Restrict the box to the valid region of the grid, like the sampled computation does. */
+    double volume = 1.0;
+    for (unsigned int d = 0; d < FixedImageDimension; ++d)
+    {
+      const double border = 0.5 * (static_cast<double>(splineOrder) - 1.0);
+      lower[d] = std::max(lower[d], border);
+      upper[d] = std::min(upper[d], static_cast<double>(gridSize[d]) - 1.0 - border);
+      if (upper[d] <= lower[d])
+      {
+        itkExceptionMacro(<< "The fixed image region does not overlap the valid region of the B-spline grid.");
+      }
+      volume *= upper[d] - lower[d];
+    }
+
+    /** Precompute the Gram matrices. */
+    if (splineOrder == 2)
+    {
+      this->template ComputeGramMatrices<2>(lower, upper, gridSize);
+    }
+    else
+    {
+      this->template ComputeGramMatrices<3>(lower, upper, gridSize);
+    }
+
+    /** Store what the Gram matrices were computed for. */
+    this->m_GramSplineOrder = splineOrder;
+    this->m_GramFixedImageRegion = fixedImageRegion;
+    this->m_GramGridParameters = bsplineTransform->GetFixedParameters();
+    this->m_GramGridSize = gridSize;
+    this->m_GramNormalization = 1.0 / volume;
+  }
+
+  /** The integral of the squared second order derivative in direction (i,j) is, for each
+   * coefficient image c, given by c^T ( G_0 \otimes ... \otimes G_{D-1} ) c, where G_d is the
+   * Gram matrix of the derivative of order [d==i]+[d==j] in dimension d. The mixed derivatives
+   * appear twice in the Frobenius norm of the Hessian.
+   */
+  const double *      coefficients = parameters.data_block();
+  std::vector<double> product(numberOfGridPoints);
+  std::vector<double> buffer(numberOfGridPoints);
+  for (unsigned int i = 0; i < FixedImageDimension; ++i)
+  {
+    for (unsigned int j = i; j < FixedImageDimension; ++j)
+    {
+      unsigned int derivativeOrders[FixedImageDimension];
+      std::fill_n(derivativeOrders, FixedImageDimension, 0u);
+      ++derivativeOrders[i];
+      ++derivativeOrders[j];
+
+      const double spacingProduct = bsplineTransform->GetGridSpacing()[i] * bsplineTransform->GetGridSpacing()[j];
+      const double weight = (i == j ? 1.0 : 2.0) * this->m_GramNormalization / vnl_math::sqr(spacingProduct);
+
+      for (unsigned int k = 0; k < FixedImageDimension; ++k)
+      {
+        const double * coefficientImage = coefficients + k * numberOfGridPoints;
+        this->ApplyGramMatrices(coefficientImage, derivativeOrders, product, buffer);
+
+        double energy = 0.0;
+        for (SizeValueType n = 0; n < numberOfGridPoints; ++n)
+        {
+          energy += coefficientImage[n] * product[n];
+        }
+        value += static_cast<MeasureType>(weight * energy);
+
+        if (derivative != nullptr)
+        {
+          DerivativeValueType * derivativeImage = derivative->data_block() + k * numberOfGridPoints;
+          for (SizeValueType n = 0; n < numberOfGridPoints; ++n)
+          {
+            derivativeImage[n] += static_cast<DerivativeValueType>(2.0 * weight * product[n]);
+          }
+        }
+      }
+    }
+  }
+
+  return true;
+
+} // end ComputeAnalyticValueAndDerivative()
+
+
+/**
+ * ******************* ComputeGramMatrices *******************
+ */
+
+template <class TFixedImage, class TScalarType>
+template <unsigned int VSplineOrder>
+void
+TransformBendingEnergyPenaltyTerm<TFixedImage, TScalarType>::ComputeGramMatrices(const double         lower[],
+                                                                                 const double         upper[],
+                                                                                 const GridSizeType & gridSize) const
+{
+  typedef BSplineKernelFunction2<VSplineOrder>                      KernelType;
+  typedef BSplineDerivativeKernelFunction2<VSplineOrder>            DerivativeKernelType;
+  typedef BSplineSecondOrderDerivativeKernelFunction2<VSplineOrder> SecondOrderDerivativeKernelType;
+
+  typename KernelType::Pointer                      kernel = KernelType::New();
+  typename DerivativeKernelType::Pointer            derivativeKernel = DerivativeKernelType::New();
+  typename SecondOrderDerivativeKernelType::Pointer secondOrderDerivativeKernel =
+    SecondOrderDerivativeKernelType::New();
+
+  /** The four point Gauss-Legendre rule is exact for polynomials up to degree 7,
+   * so for the products of the polynomial pieces of the basis functions.
+   */
+  const double nodes[4] = { -0.8611363115940526, -0.3399810435848563, 0.3399810435848563, 0.8611363115940526 };
+  const double weights[4] = { 0.3478548451374538, 0.6521451548625461, 0.6521451548625461, 0.3478548451374538 };
+
+  const long   order = static_cast<long>(VSplineOrder);
+  const long   bandWidth = 2 * order + 1;
+  const double support = 0.5 * static_cast<double>(VSplineOrder + 1);
+  for (unsigned int d = 0; d < FixedImageDimension; ++d)
+  {
+    const long length = static_cast<long>(gridSize[d]);
+    for (unsigned int n = 0; n < 3; ++n)
+    {
+      this->m_GramMatrices[d][n].assign(length * bandWidth, 0.0);
+    }
+
+    for (long c = 0; c < length; ++c)
+    {
+      for (long o = std::max(-order, -c); o <= std::min(order, length - 1 - c); ++o)
+      {
+        /** Integrate over the overlap of both supports, in pieces between
+         * multiples of one half, where the basis functions have their knots.
+         */
+        const double begin = std::max(lower[d], static_cast<double>(std::max(c, c + o)) - support);
+        const double end = std::min(upper[d], static_cast<double>(std::min(c, c + o)) + support);
+        double       gram[3] = { 0.0, 0.0, 0.0 };
+        for (double x0 = begin; x0 < end;)
+        {
+          const double x1 = std::min(end, 0.5 * std::floor(2.0 * x0) + 0.5);
+          const double center = 0.5 * (x0 + x1);
+          const double halfWidth = 0.5 * (x1 - x0);
+          for (unsigned int q = 0; q < 4; ++q)
+          {
+            const double u = center + halfWidth * nodes[q];
+            const double w = halfWidth * weights[q];
+            const double a = u - static_cast<double>(c);
+            const double b = a - static_cast<double>(o);
+            gram[0] += w * kernel->Evaluate(a) * kernel->Evaluate(b);
+            gram[1] += w * derivativeKernel->Evaluate(a) * derivativeKernel->Evaluate(b);
+            gram[2] += w * secondOrderDerivativeKernel->Evaluate(a) * secondOrderDerivativeKernel->Evaluate(b);
+          }
+          x0 = x1;
+        }
+
+        for (unsigned int n = 0; n < 3; ++n)
+        {
+          this->m_GramMatrices[d][n][c * bandWidth + o + order] = gram[n];
+        }
+      }
+    }
+  }
+
+} // end ComputeGramMatrices()
+
+
+/**
+ * ******************* ApplyGramMatrices *******************
+ */
+
+template <class TFixedImage, class TScalarType>
+void
+TransformBendingEnergyPenaltyTerm<TFixedImage, TScalarType>::ApplyGramMatrices(const double *        input,
+                                                                               const unsigned int    derivativeOrders[],
+                                                                               std::vector<double> & output,
+                                                                               std::vector<double> & buffer) const
+{
+  /** Apply the banded matrices one dimension at a time, alternating between
+   * the two buffers such that the last dimension ends up in the output.
+   */
+  const long     order = static_cast<long>(this->m_GramSplineOrder);
+  const long     bandWidth = 2 * order + 1;
+  const double * source = input;
+  long           stride = 1;
+  for (unsigned int d = 0; d < FixedImageDimension; ++d)
+  {
+    const GramMatrixType & gram = this->m_GramMatrices[d][derivativeOrders[d]];
+    const long             length = static_cast<long>(this->m_GramGridSize[d]);
+    const long             numberOfLines = static_cast<long>(output.size()) / (length * stride);
+    double *               target = ((FixedImageDimension - 1 - d) % 2 == 0) ? output.data() : buffer.data();
+
+    for (long line = 0; line < numberOfLines; ++line)
+    {
+      for (long c = 0; c < length; ++c)
+      {
+        const double * row = &gram[c * bandWidth + order];
+        const long     first = std::max(-order, -c);
+        const long     last = std::min(order, length - 1 - c);
+        for (long i = 0; i < stride; ++i)
+        {
+          const long     index = (line * length + c) * stride + i;
+          const double * center = source + index;
+          double         sum = 0.0;
+          for (long o = first; o <= last; ++o)
+          {
+            sum += row[o] * center[o * stride];
+          }
+          target[index] = sum;
+        }
+      }
+    }
+
+    source = target;
+    stride *= length;
+  }
+
+} // end ApplyGramMatrices()
+
+
 } // end namespace itk
 
 #endif // #ifndef itkTransformBendingEnergyPenaltyTerm_hxx
@@ -90,6 +90,13 @@ public:
                         MeasureType &                   Value,
                         DerivativeType &                Derivative) const override;
 
+  /** Only GetValue() sets the transform parameters itself. */
+  bool
+  CanBeEvaluatedConcurrently(void) const override
+  {
+    return true;
+  }
+
 protected:
   CorrespondingPointsEuclideanDistancePointMetric();
   ~CorrespondingPointsEuclideanDistancePointMetric() override = default;
@@ -32,6 +32,7 @@
 #include "kd_split.h"					// kd-tree splitting rules
 #include "kd_util.h"					// kd-tree utilities
 #include <ANN/ANNperf.h>				// performance evaluation
+#include <mutex>						// std::mutex
 
 //----------------------------------------------------------------------
 //	Global data
@@ -48,6 +49,7 @@
 //----------------------------------------------------------------------
 static int				IDX_TRIVIAL[] = {0};	// trivial point index
 ANNkd_leaf				*KD_TRIVIAL = NULL;		// trivial leaf node
+static std::mutex		KD_TRIVIAL_MUTEX;		// guards (de)allocation of KD_TRIVIAL
 
 //----------------------------------------------------------------------
 //	Printing the kd-tree 
@@ -220,6 +222,7 @@ ANNkd_tree::~ANNkd_tree()				// tree destructor
 //----------------------------------------------------------------------
 void annClose()				// close use of ANN
 {
+	std::lock_guard<std::mutex> lock(KD_TRIVIAL_MUTEX);
 	if (KD_TRIVIAL != NULL) {
 		delete KD_TRIVIAL;
 		KD_TRIVIAL = NULL;
@@ -266,6 +269,7 @@ void ANNkd_tree::SkeletonTree(			// construct skeleton tree
 	}
 
 	bnd_box_lo = bnd_box_hi = NULL;		// bounding box is nonexistent
+	std::lock_guard<std::mutex> lock(KD_TRIVIAL_MUTEX);	// trees may be built concurrently
 	if (KD_TRIVIAL == NULL)				// no trivial leaf node yet?
 		KD_TRIVIAL = new ANNkd_leaf(0, IDX_TRIVIAL);	// allocate it
 }
@@ -22,6 +22,7 @@ namespace itk
 {
 
 unsigned int ANNBinaryTreeCreator::m_NumberOfANNBinaryTrees = 0;
+std::mutex   ANNBinaryTreeCreator::m_ReferenceCountMutex;
 
 /**
  * ************************ CreateANNkDTree *************************
@@ -103,6 +104,7 @@ ANNBinaryTreeCreator::DeleteANNBruteForceTree(ANNBruteForceTreeType *& tree)
 void
 ANNBinaryTreeCreator::IncreaseReferenceCount(void)
 {
+  const std::lock_guard<std::mutex> lock(m_ReferenceCountMutex);
   m_NumberOfANNBinaryTrees++;
 } // end IncreaseReferenceCount
 
@@ -114,6 +116,8 @@ ANNBinaryTreeCreator::IncreaseReferenceCount(void)
 void
 ANNBinaryTreeCreator::DecreaseReferenceCount(void)
 {
+  /** annClose() is called while holding the lock, so that no tree can be created in the meantime. */
+  const std::lock_guard<std::mutex> lock(m_ReferenceCountMutex);
   m_NumberOfANNBinaryTrees--;
   if (m_NumberOfANNBinaryTrees == 0)
   {
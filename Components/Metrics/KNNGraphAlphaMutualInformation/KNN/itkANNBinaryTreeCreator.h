@@ -22,6 +22,7 @@
 #include "itkObject.h"
 #include "itkObjectFactory.h"
 #include "ANN/ANN.h"
+#include <mutex>
 
 namespace itk
 {
@@ -64,6 +65,8 @@ public:
    * of any sort exist, we can call annClose(). This little
    * function is cause of going through the trouble of creating
    * this class with static creating functions.
+   * The reference count is guarded by a mutex, so that trees may be
+   * created and deleted from multiple threads.
    */
 
   /** Static function to create an ANN kDTree. */
@@ -110,6 +113,7 @@ private:
 
   /** Member variables. */
   static unsigned int m_NumberOfANNBinaryTrees;
+  static std::mutex   m_ReferenceCountMutex;
 };
 
 } // end namespace itk
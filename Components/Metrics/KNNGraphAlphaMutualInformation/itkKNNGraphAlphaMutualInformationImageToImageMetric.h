@@ -311,6 +311,23 @@ private:
                                                    TransformJacobianIndicesContainerType & jacobiansIndices,
                                                    SpatialDerivativeContainerType &        spatialDerivatives) const;
 
+  /** Connect the list samples to the three trees, generate the trees, and connect
+   * them to the searchers. The trees are generated concurrently when multi-threading.
+   */
+  void
+  GenerateTrees(const ListSamplePointer & listSampleFixed,
+                const ListSamplePointer & listSampleMoving,
+                const ListSamplePointer & listSampleJoint) const;
+
+  /** Search the k nearest neighbours of all samples in listSample, in one batch.
+   * The query points are distributed over the work units when multi-threading.
+   */
+  void
+  SearchAllNeighbours(BinaryKNNTreeSearchType *        searcher,
+                      const ListSampleType *           listSample,
+                      std::vector<IndexArrayType> &    indices,
+                      std::vector<DistanceArrayType> & distances) const;
+
   /** This function calculates the spatial derivative of the
    * featureNr feature image at the point mappedPoint.
    * \todo move this to base class.
@@ -325,22 +325,7 @@ KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::Get
    * and connect them to the searchers.
    */
 
-  /** Generate the tree for the fixed image samples. */
-  this->m_BinaryKNNTreeFixed->SetSample(listSampleFixed);
-  this->m_BinaryKNNTreeFixed->GenerateTree();
-
-  /** Generate the tree for the moving image samples. */
-  this->m_BinaryKNNTreeMoving->SetSample(listSampleMoving);
-  this->m_BinaryKNNTreeMoving->GenerateTree();
-
-  /** Generate the tree for the joint image samples. */
-  this->m_BinaryKNNTreeJoint->SetSample(listSampleJoint);
-  this->m_BinaryKNNTreeJoint->GenerateTree();
-
-  /** Initialize tree searchers. */
-  this->m_BinaryKNNTreeSearcherFixed->SetBinaryTree(this->m_BinaryKNNTreeFixed);
-  this->m_BinaryKNNTreeSearcherMoving->SetBinaryTree(this->m_BinaryKNNTreeMoving);
-  this->m_BinaryKNNTreeSearcherJoint->SetBinaryTree(this->m_BinaryKNNTreeJoint);
+  this->GenerateTrees(listSampleFixed, listSampleMoving, listSampleJoint);
 
   /**
    * *************** Estimate the \alpha MI ******************
@@ -377,9 +362,8 @@ KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::Get
 
   /** Temporary variables. */
   typedef typename NumericTraits<MeasureType>::AccumulateType AccumulateType;
-  MeasurementVectorType                                       z_F, z_M, z_J;
-  IndexArrayType                                              indices_F, indices_M, indices_J;
-  DistanceArrayType                                           distances_F, distances_M, distances_J;
+  std::vector<IndexArrayType>                                 allIndices_F, allIndices_M, allIndices_J;
+  std::vector<DistanceArrayType>                              allDistances_F, allDistances_M, allDistances_J;
 
   MeasureType    H, G;
   AccumulateType sumG = NumericTraits<AccumulateType>::Zero;
@@ -393,18 +377,18 @@ KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::Get
   unsigned int k = this->m_BinaryKNNTreeSearcherFixed->GetKNearestNeighbors();
   double       twoGamma = jointSize * (1.0 - this->m_Alpha);
 
+  /** Search for the K nearest neighbours of all query points, i.e. all samples. */
+  this->SearchAllNeighbours(this->m_BinaryKNNTreeSearcherFixed, listSampleFixed, allIndices_F, allDistances_F);
+  this->SearchAllNeighbours(this->m_BinaryKNNTreeSearcherMoving, listSampleMoving, allIndices_M, allDistances_M);
+  this->SearchAllNeighbours(this->m_BinaryKNNTreeSearcherJoint, listSampleJoint, allIndices_J, allDistances_J);
+
   /** Loop over all query points, i.e. all samples. */
   for (unsigned long i = 0; i < this->m_NumberOfPixelsCounted; i++)
   {
-    /** Get the i-th query point. */
-    listSampleFixed->GetMeasurementVector(i, z_F);
-    listSampleMoving->GetMeasurementVector(i, z_M);
-    listSampleJoint->GetMeasurementVector(i, z_J);
-
-    /** Search for the K nearest neighbours of the current query point. */
-    this->m_BinaryKNNTreeSearcherFixed->Search(z_F, indices_F, distances_F);
-    this->m_BinaryKNNTreeSearcherMoving->Search(z_M, indices_M, distances_M);
-    this->m_BinaryKNNTreeSearcherJoint->Search(z_J, indices_J, distances_J);
+    /** Get the distances to the K nearest neighbours of the i-th query point. */
+    const DistanceArrayType & distances_F = allDistances_F[i];
+    const DistanceArrayType & distances_M = allDistances_M[i];
+    const DistanceArrayType & distances_J = allDistances_J[i];
 
     /** Add the distances between the points to get the total graph length.
      * The outcommented implementation calculates: sum J/sqrt(F*M)
@@ -549,22 +533,7 @@ KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::Get
    * and connect them to the searchers.
    */
 
-  /** Generate the tree for the fixed image samples. */
-  this->m_BinaryKNNTreeFixed->SetSample(listSampleFixed);
-  this->m_BinaryKNNTreeFixed->GenerateTree();
-
-  /** Generate the tree for the moving image samples. */
-  this->m_BinaryKNNTreeMoving->SetSample(listSampleMoving);
-  this->m_BinaryKNNTreeMoving->GenerateTree();
-
-  /** Generate the tree for the joint image samples. */
-  this->m_BinaryKNNTreeJoint->SetSample(listSampleJoint);
-  this->m_BinaryKNNTreeJoint->GenerateTree();
-
-  /** Initialize tree searchers. */
-  this->m_BinaryKNNTreeSearcherFixed->SetBinaryTree(this->m_BinaryKNNTreeFixed);
-  this->m_BinaryKNNTreeSearcherMoving->SetBinaryTree(this->m_BinaryKNNTreeMoving);
-  this->m_BinaryKNNTreeSearcherJoint->SetBinaryTree(this->m_BinaryKNNTreeJoint);
+  this->GenerateTrees(listSampleFixed, listSampleMoving, listSampleJoint);
 
   /**
    * *************** Estimate the \alpha MI and its derivatives ******************
@@ -601,9 +570,9 @@ KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::Get
 
   /** Temporary variables. */
   typedef typename NumericTraits<MeasureType>::AccumulateType AccumulateType;
-  MeasurementVectorType                                       z_F, z_M, z_J, z_M_ip, z_J_ip, diff_M, diff_J;
-  IndexArrayType                                              indices_F, indices_M, indices_J;
-  DistanceArrayType                                           distances_F, distances_M, distances_J;
+  MeasurementVectorType                                       z_M, z_M_ip, z_J_ip, diff_M, diff_J;
+  std::vector<IndexArrayType>                                 allIndices_F, allIndices_M, allIndices_J;
+  std::vector<DistanceArrayType>                              allDistances_F, allDistances_M, allDistances_J;
   MeasureType                                                 distance_F, distance_M, distance_J;
 
   MeasureType    H, G, Gpow;
@@ -623,18 +592,23 @@ KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::Get
   unsigned int k = this->m_BinaryKNNTreeSearcherFixed->GetKNearestNeighbors();
   double       twoGamma = jointSize * (1.0 - this->m_Alpha);
 
+  /** Search for the k nearest neighbours of all query points, i.e. all samples. */
+  this->SearchAllNeighbours(this->m_BinaryKNNTreeSearcherFixed, listSampleFixed, allIndices_F, allDistances_F);
+  this->SearchAllNeighbours(this->m_BinaryKNNTreeSearcherMoving, listSampleMoving, allIndices_M, allDistances_M);
+  this->SearchAllNeighbours(this->m_BinaryKNNTreeSearcherJoint, listSampleJoint, allIndices_J, allDistances_J);
+
   /** Loop over all query points, i.e. all samples. */
   for (unsigned long i = 0; i < this->m_NumberOfPixelsCounted; i++)
   {
     /** Get the i-th query point. */
-    listSampleFixed->GetMeasurementVector(i, z_F);
     listSampleMoving->GetMeasurementVector(i, z_M);
-    listSampleJoint->GetMeasurementVector(i, z_J);
 
-    /** Search for the k nearest neighbours of the current query point. */
-    this->m_BinaryKNNTreeSearcherFixed->Search(z_F, indices_F, distances_F);
-    this->m_BinaryKNNTreeSearcherMoving->Search(z_M, indices_M, distances_M);
-    this->m_BinaryKNNTreeSearcherJoint->Search(z_J, indices_J, distances_J);
+    /** Get the k nearest neighbours of the current query point. */
+    const IndexArrayType &    indices_M = allIndices_M[i];
+    const IndexArrayType &    indices_J = allIndices_J[i];
+    const DistanceArrayType & distances_F = allDistances_F[i];
+    const DistanceArrayType & distances_M = allDistances_M[i];
+    const DistanceArrayType & distances_J = allDistances_J[i];
 
     /** Variables to compute the measure and its derivative. */
     AccumulateType Gamma_F = NumericTraits<AccumulateType>::Zero;
@@ -724,6 +698,87 @@ KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::Get
 } // end GetValueAndDerivative()
 
 
+/**
+ * ************************ GenerateTrees *************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::GenerateTrees(
+  const ListSamplePointer & listSampleFixed,
+  const ListSamplePointer & listSampleMoving,
+  const ListSamplePointer & listSampleJoint) const
+{
+  /** Connect the samples to the trees for the fixed, moving and joint image samples. */
+  this->m_BinaryKNNTreeFixed->SetSample(listSampleFixed);
+  this->m_BinaryKNNTreeMoving->SetSample(listSampleMoving);
+  this->m_BinaryKNNTreeJoint->SetSample(listSampleJoint);
+
+  /** Generate the trees. They are independent, so they can be generated concurrently. */
+  BinaryKNNTreeType * trees[3] = { this->m_BinaryKNNTreeFixed.GetPointer(),
+                                   this->m_BinaryKNNTreeMoving.GetPointer(),
+                                   this->m_BinaryKNNTreeJoint.GetPointer() };
+  if (this->m_UseMultiThread)
+  {
+    this->m_Threader->ParallelizeArray(
+      0, 3, [&trees](SizeValueType t) { trees[t]->GenerateTree(); }, nullptr);
+  }
+  else
+  {
+    for (unsigned int t = 0; t < 3; ++t)
+    {
+      trees[t]->GenerateTree();
+    }
+  }
+
+  /** Initialize tree searchers. */
+  this->m_BinaryKNNTreeSearcherFixed->SetBinaryTree(this->m_BinaryKNNTreeFixed);
+  this->m_BinaryKNNTreeSearcherMoving->SetBinaryTree(this->m_BinaryKNNTreeMoving);
+  this->m_BinaryKNNTreeSearcherJoint->SetBinaryTree(this->m_BinaryKNNTreeJoint);
+
+} // end GenerateTrees()
+
+
+/**
+ * ************************ SearchAllNeighbours *************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::SearchAllNeighbours(
+  BinaryKNNTreeSearchType *        searcher,
+  const ListSampleType *           listSample,
+  std::vector<IndexArrayType> &    indices,
+  std::vector<DistanceArrayType> & distances) const
+{
+  const unsigned long numberOfQueryPoints = this->m_NumberOfPixelsCounted;
+  indices.resize(numberOfQueryPoints);
+  distances.resize(numberOfQueryPoints);
+
+  /** The ANN searchers keep their search state per thread, so the query points can be
+   * searched concurrently. Each query point writes only its own results.
+   */
+  const auto searchQueryPoint = [searcher, listSample, &indices, &distances](SizeValueType i) {
+    MeasurementVectorType z;
+    listSample->GetMeasurementVector(i, z);
+    searcher->Search(z, indices[i], distances[i]);
+  };
+
+  if (this->m_UseMultiThread)
+  {
+    this->m_Threader->ParallelizeArray(0, numberOfQueryPoints, searchQueryPoint, nullptr);
+  }
+  else
+  {
+    for (unsigned long i = 0; i < numberOfQueryPoints; ++i)
+    {
+      searchQueryPoint(i);
+    }
+  }
+
+} // end SearchAllNeighbours()
+
+
 /**
  * ************************ ComputeListSampleValuesAndDerivativePlusJacobian *************************
  */
@@ -142,6 +142,13 @@ public:
                         MeasureType &          Value,
                         DerivativeType &       Derivative) const override;
 
+  /** Like the mutual information, this metric only fills its own histograms. */
+  bool
+  CanBeEvaluatedConcurrently(void) const override
+  {
+    return true;
+  }
+
 protected:
   /** The constructor. */
   ParzenWindowNormalizedMutualInformationImageToImageMetric() = default;
@@ -53,7 +53,12 @@ namespace elastix
  *    each parameter. This should be used when registration is performed directly on the moving
  *    image, without using a fixed image. Possible values are "true" or "false".
  * \parameter NumEigenValues: number of eigenvalues used in the metric: sum(e) - e, where sum(e)
- *  is the sum of all eigenvalues and e is the sum of the first highest NumEigenValues eigenvalues.
+ *  is the sum of all eigenvalues and e is the sum of the first highest NumEigenValues eigenvalues. \n
+ * \parameter UseWarmStartedEigenSolver: compute the NumEigenValues highest eigenvalues with a subspace
+ *    iteration that starts from the eigenvectors of the previous iteration, instead of solving the full
+ *    eigenproblem in every iteration. Can be useful for a large number of images in the last dimension.
+ *    Can be specified for each resolution. Possible values are "true" or "false". Default: "false". \n
+ *    example: <tt>(UseWarmStartedEigenSolver "true")</tt>
  *
  * \ingroup RegistrationMetrics
  * \ingroup Metrics
@@ -57,6 +57,12 @@ PCAMetric<TElastix>::BeforeEachResolution(void)
   this->GetConfiguration()->ReadParameter(NumEigenValues, "NumEigenValues", this->GetComponentLabel(), level, 0);
   this->SetNumEigenValues(NumEigenValues);
 
+  /** Get and set if the eigensolver is warm-started from the previous iteration. */
+  bool useWarmStartedEigenSolver = false;
+  this->GetConfiguration()->ReadParameter(
+    useWarmStartedEigenSolver, "UseWarmStartedEigenSolver", this->GetComponentLabel(), level, 0);
+  this->SetUseWarmStartedEigenSolver(useWarmStartedEigenSolver);
+
   /** Get and set if we want to subtract the mean from the derivative. */
   bool subtractMean = false;
   this->GetConfiguration()->ReadParameter(subtractMean, "SubtractMean", this->GetComponentLabel(), 0, 0);
@@ -52,6 +52,12 @@ public:
   itkSetMacro(TransformIsStackTransform, bool);
   itkSetMacro(NumEigenValues, unsigned int);
 
+  /** Warm-start a partial eigensolver for the NumEigenValues largest eigenvalues from the eigenvectors
+   * of the previous iteration, instead of solving the full eigenproblem every iteration. Default: false.
+   */
+  itkSetMacro(UseWarmStartedEigenSolver, bool);
+  itkGetConstMacro(UseWarmStartedEigenSolver, bool);
+
   /** Typedefs from the superclass. */
   typedef typename Superclass::CoordinateRepresentationType    CoordinateRepresentationType;
   typedef typename Superclass::MovingImageType                 MovingImageType;
@@ -219,6 +225,25 @@ protected:
   void
   InitializeThreadingParameters(void) const override;
 
+  /** Compute the covariance matrix C = Atmm * Atmm^T / (N - 1) of the mean subtracted samples Atmm (G x N).
+   * The rows of C are distributed over the work units of the metric's threader, and the samples are
+   * traversed in blocks. The sums are scalar, in sample order.
+   */
+  void
+  ComputeCovarianceMatrix(const MatrixType & Atmm, MatrixType & C) const;
+
+  /** Compute the sum of the NumEigenValues largest eigenvalues of K, and the corresponding
+   * eigenvectors as the columns of eigenVectorMatrix, in descending order.
+   */
+  void
+  ComputeEigenDecomposition(const MatrixType & K, RealType & sumEigenValuesUsed, MatrixType & eigenVectorMatrix) const;
+
+  /** Subspace iteration on K, started from m_EigenVectors. Returns false if it did not converge. */
+  bool
+  ComputeWarmStartedEigenDecomposition(const MatrixType &     K,
+                                       vnl_vector<RealType> & eigenValues,
+                                       MatrixType &           eigenVectorMatrix) const;
+
 private:
   PCAMetric(const Self &) = delete;
   void
@@ -239,6 +264,10 @@ private:
   /** Integer to indicate how many eigenvalues you want to use in the metric */
   unsigned int m_NumEigenValues;
 
+  /** Eigenvectors of the previous iteration, the start of the warm-started eigensolver. */
+  bool               m_UseWarmStartedEigenSolver;
+  mutable MatrixType m_EigenVectors;
+
   /** Matrices, needed for derivative calculation */
   mutable std::vector<unsigned int> m_PixelStartIndex;
   mutable MatrixType                m_Atmm;
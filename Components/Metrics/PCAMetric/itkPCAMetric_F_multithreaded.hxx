@@ -26,6 +26,7 @@
 #include "vnl/algo/vnl_svd.h"
 #include "vnl/vnl_trace.h"
 #include "vnl/algo/vnl_symmetric_eigensystem.h"
+#include <algorithm>
 #include <numeric>
 #include <fstream>
 
@@ -44,6 +45,7 @@ PCAMetric<TFixedImage, TMovingImage>::PCAMetric()
   : m_SubtractMean(false)
   , m_TransformIsStackTransform(false)
   , m_NumEigenValues(6)
+  , m_UseWarmStartedEigenSolver(false)
 {
   this->SetUseImageSampler(true);
   this->SetUseFixedImageLimiter(false);
@@ -89,6 +91,9 @@ PCAMetric<TFixedImage, TMovingImage>::Initialize(void)
     std::cerr << "ERROR: Number of eigenvalues is larger than number of images. Maximum number of eigenvalues equals: "
               << this->m_G << std::endl;
   }
+
+  /** Start the eigensolver from scratch. */
+  this->m_EigenVectors.clear();
 } // end Initializes
 
 
@@ -290,20 +295,18 @@ PCAMetric<TFixedImage, TMovingImage>::GetValue(const TransformParametersType & p
   }
   mean /= RealType(this->m_NumberOfPixelsCounted);
 
-  MatrixType Amm(this->m_NumberOfPixelsCounted, this->m_G);
-  Amm.fill(NumericTraits<RealType>::Zero);
-
+  MatrixType Atmm(this->m_G, this->m_NumberOfPixelsCounted);
   for (unsigned int i = 0; i < this->m_NumberOfPixelsCounted; i++)
   {
     for (unsigned int j = 0; j < this->m_G; j++)
     {
-      Amm(i, j) = A(i, j) - mean(j);
+      Atmm(j, i) = A(i, j) - mean(j);
     }
   }
 
   /** Compute covariance matrix C */
-  MatrixType C(Amm.transpose() * Amm);
-  C /= static_cast<RealType>(RealType(this->m_NumberOfPixelsCounted) - 1.0);
+  MatrixType C;
+  this->ComputeCovarianceMatrix(Atmm, C);
 
   vnl_diag_matrix<RealType> S(this->m_G);
   S.fill(NumericTraits<RealType>::Zero);
@@ -315,14 +318,10 @@ PCAMetric<TFixedImage, TMovingImage>::GetValue(const TransformParametersType & p
   /** Compute correlation matrix K */
   MatrixType K(S * C * S);
 
-  /** Compute first eigenvalue and eigenvector of K */
-  vnl_symmetric_eigensystem<RealType> eig(K);
-
-  RealType sumEigenValuesUsed = itk::NumericTraits<RealType>::Zero;
-  for (unsigned int i = 1; i < this->m_NumEigenValues + 1; i++)
-  {
-    sumEigenValuesUsed += eig.get_eigenvalue(this->m_G - i);
-  }
+  /** Compute the largest eigenvalues of K */
+  RealType   sumEigenValuesUsed = itk::NumericTraits<RealType>::Zero;
+  MatrixType eigenVectorMatrix;
+  this->ComputeEigenDecomposition(K, sumEigenValuesUsed, eigenVectorMatrix);
 
   measure = this->m_G - sumEigenValuesUsed;
 
@@ -475,21 +474,19 @@ PCAMetric<TFixedImage, TMovingImage>::GetValueAndDerivativeSingleThreaded(const
   }
   mean /= RealType(this->m_NumberOfPixelsCounted);
 
-  /** Calculate standard deviation from columns */
-  MatrixType Amm(this->m_NumberOfPixelsCounted, this->m_G);
-  Amm.fill(NumericTraits<RealType>::Zero);
+  /** Subtract the mean from the columns */
+  MatrixType Atmm(this->m_G, this->m_NumberOfPixelsCounted);
   for (unsigned int i = 0; i < this->m_NumberOfPixelsCounted; i++)
   {
     for (unsigned int j = 0; j < this->m_G; j++)
     {
-      Amm(i, j) = A(i, j) - mean(j);
+      Atmm(j, i) = A(i, j) - mean(j);
     }
   }
 
   /** Compute covariance matrix C */
-  MatrixType Atmm = Amm.transpose();
-  MatrixType C(Atmm * Amm);
-  C /= static_cast<RealType>(RealType(this->m_NumberOfPixelsCounted) - 1.0);
+  MatrixType C;
+  this->ComputeCovarianceMatrix(Atmm, C);
 
   vnl_diag_matrix<RealType> S(this->m_G);
   S.fill(NumericTraits<RealType>::Zero);
@@ -500,20 +497,10 @@ PCAMetric<TFixedImage, TMovingImage>::GetValueAndDerivativeSingleThreaded(const
 
   MatrixType K(S * C * S);
 
-  /** Compute first eigenvalue and eigenvector of K */
-  vnl_symmetric_eigensystem<RealType> eig(K);
-
-  RealType sumEigenValuesUsed = itk::NumericTraits<RealType>::Zero;
-  for (unsigned int i = 1; i < this->m_NumEigenValues + 1; i++)
-  {
-    sumEigenValuesUsed += eig.get_eigenvalue(this->m_G - i);
-  }
-
-  MatrixType eigenVectorMatrix(this->m_G, this->m_NumEigenValues);
-  for (unsigned int i = 1; i < this->m_NumEigenValues + 1; i++)
-  {
-    eigenVectorMatrix.set_column(i - 1, (eig.get_eigenvector(this->m_G - i)).normalize());
-  }
+  /** Compute the largest eigenvalues and their eigenvectors of K */
+  RealType   sumEigenValuesUsed = itk::NumericTraits<RealType>::Zero;
+  MatrixType eigenVectorMatrix;
+  this->ComputeEigenDecomposition(K, sumEigenValuesUsed, eigenVectorMatrix);
 
   MatrixType eigenVectorMatrixTranspose(eigenVectorMatrix.transpose());
 
@@ -850,21 +837,19 @@ PCAMetric<TFixedImage, TMovingImage>::AfterThreadedGetSamples(MeasureType & valu
   }
   mean /= RealType(this->m_NumberOfPixelsCounted);
 
-  /** Calculate standard deviation from columns */
-  MatrixType Amm(this->m_NumberOfPixelsCounted, this->m_G);
-  Amm.fill(NumericTraits<RealType>::Zero);
+  /** Subtract the mean from the columns */
+  this->m_Atmm.set_size(this->m_G, this->m_NumberOfPixelsCounted);
   for (unsigned int i = 0; i < this->m_NumberOfPixelsCounted; i++)
   {
     for (unsigned int j = 0; j < this->m_G; j++)
     {
-      Amm(i, j) = A(i, j) - mean(j);
+      this->m_Atmm(j, i) = A(i, j) - mean(j);
     }
   }
 
   /** Compute covariancematrix C */
-  this->m_Atmm = Amm.transpose();
-  MatrixType C(this->m_Atmm * Amm);
-  C /= static_cast<RealType>(RealType(this->m_NumberOfPixelsCounted) - 1.0);
+  MatrixType C;
+  this->ComputeCovarianceMatrix(this->m_Atmm, C);
 
   vnl_diag_matrix<RealType> S(this->m_G);
   S.fill(NumericTraits<RealType>::Zero);
@@ -875,16 +860,10 @@ PCAMetric<TFixedImage, TMovingImage>::AfterThreadedGetSamples(MeasureType & valu
 
   MatrixType K(S * C * S);
 
-  /** Compute first eigenvalue and eigenvector of K */
-  vnl_symmetric_eigensystem<RealType> eig(K);
-
+  /** Compute the largest eigenvalues and their eigenvectors of K */
   RealType   sumEigenValuesUsed = itk::NumericTraits<RealType>::Zero;
-  MatrixType eigenVectorMatrix(this->m_G, this->m_NumEigenValues);
-  for (unsigned int i = 1; i < this->m_NumEigenValues + 1; i++)
-  {
-    sumEigenValuesUsed += eig.get_eigenvalue(this->m_G - i);
-    eigenVectorMatrix.set_column(i - 1, (eig.get_eigenvector(this->m_G - i)).normalize());
-  }
+  MatrixType eigenVectorMatrix;
+  this->ComputeEigenDecomposition(K, sumEigenValuesUsed, eigenVectorMatrix);
 
   value = this->m_G - sumEigenValuesUsed;
 
@@ -1152,6 +1131,224 @@ PCAMetric<TFixedImage, TMovingImage>::LaunchComputeDerivativeThreaderCallback(vo
 } // end LaunchComputeDerivativeThreaderCallback()
 
 
+/**
+ * ******************* ComputeCovarianceMatrix *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+PCAMetric<TFixedImage, TMovingImage>::ComputeCovarianceMatrix(const MatrixType & Atmm, MatrixType & C) const
+{
+  const unsigned int G = Atmm.rows();
+  const unsigned int N = Atmm.cols();
+  const RealType     normalization = static_cast<RealType>(RealType(N) - 1.0);
+  C.set_size(G, G);
+
+  /** Row i of C holds the inner products of row i of Atmm with rows j >= i. Four rows j
+   * are accumulated at once, over blocks of samples that fit in the cache, so that every
+   * element of row i is loaded once for four products, and the four sums do not wait for
+   * each other. Each sum is accumulated in sample order: without -ffast-math the compiler
+   * does not reorder, and hence does not vectorize, these sums. This keeps C independent
+   * of the instruction set.
+   */
+  const auto computeRow = [&Atmm, &C, G, N, normalization](SizeValueType i) {
+    const unsigned int    blockSize = 2048;
+    const RealType *      rowI = Atmm[i];
+    std::vector<RealType> sums(G - i, NumericTraits<RealType>::Zero);
+    for (unsigned int start = 0; start < N; start += blockSize)
+    {
+      const unsigned int end = std::min(start + blockSize, N);
+      unsigned int       j = i;
+      for (; j + 4 <= G; j += 4)
+      {
+        const RealType * row0 = Atmm[j];
+        const RealType * row1 = Atmm[j + 1];
+        const RealType * row2 = Atmm[j + 2];
+        const RealType * row3 = Atmm[j + 3];
+        RealType         sum0 = NumericTraits<RealType>::Zero;
+        RealType         sum1 = NumericTraits<RealType>::Zero;
+        RealType         sum2 = NumericTraits<RealType>::Zero;
+        RealType         sum3 = NumericTraits<RealType>::Zero;
+        for (unsigned int n = start; n < end; ++n)
+        {
+          const RealType a = rowI[n];
+          sum0 += a * row0[n];
+          sum1 += a * row1[n];
+          sum2 += a * row2[n];
+          sum3 += a * row3[n];
+        }
+        sums[j - i] += sum0;
+        sums[j + 1 - i] += sum1;
+        sums[j + 2 - i] += sum2;
+        sums[j + 3 - i] += sum3;
+      }
+      for (; j < G; ++j)
+      {
+        const RealType * rowJ = Atmm[j];
+        RealType         sum = NumericTraits<RealType>::Zero;
+        for (unsigned int n = start; n < end; ++n)
+        {
+          sum += rowI[n] * rowJ[n];
+        }
+        sums[j - i] += sum;
+      }
+    }
+
+    /** Each work unit writes row i of the upper triangle and column i of the lower triangle. */
+    for (unsigned int j = i; j < G; ++j)
+    {
+      C(i, j) = sums[j - i] / normalization;
+      C(j, i) = C(i, j);
+    }
+  };
+
+  if (this->m_UseMultiThread)
+  {
+    this->m_Threader->ParallelizeArray(0, G, computeRow, nullptr);
+  }
+  else
+  {
+    for (unsigned int i = 0; i < G; ++i)
+    {
+      computeRow(i);
+    }
+  }
+
+} // end ComputeCovarianceMatrix()
+
+
+/**
+ * ******************* ComputeEigenDecomposition *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+PCAMetric<TFixedImage, TMovingImage>::ComputeEigenDecomposition(const MatrixType & K,
+                                                                RealType &         sumEigenValuesUsed,
+                                                                MatrixType &       eigenVectorMatrix) const
+{
+  const unsigned int   G = K.rows();
+  vnl_vector<RealType> eigenValues(this->m_NumEigenValues);
+  eigenVectorMatrix.set_size(G, this->m_NumEigenValues);
+
+  const bool warmStarted =
+    this->m_UseWarmStartedEigenSolver && this->ComputeWarmStartedEigenDecomposition(K, eigenValues, eigenVectorMatrix);
+  if (!warmStarted)
+  {
+    /** Compute all eigenvalues and eigenvectors of K */
+    vnl_symmetric_eigensystem<RealType> eig(K);
+    for (unsigned int i = 1; i < this->m_NumEigenValues + 1; i++)
+    {
+      eigenValues[i - 1] = eig.get_eigenvalue(G - i);
+      eigenVectorMatrix.set_column(i - 1, (eig.get_eigenvector(G - i)).normalize());
+    }
+
+    /** Keep the leading eigenvectors, plus a few guard vectors, to start from in the next iteration. */
+    if (this->m_UseWarmStartedEigenSolver)
+    {
+      const unsigned int p = std::min(G, this->m_NumEigenValues + 4);
+      this->m_EigenVectors.set_size(G, p);
+      for (unsigned int c = 0; c < p; ++c)
+      {
+        this->m_EigenVectors.set_column(c, eig.get_eigenvector(G - p + c));
+      }
+    }
+  }
+
+  sumEigenValuesUsed = NumericTraits<RealType>::Zero;
+  for (unsigned int i = 0; i < this->m_NumEigenValues; i++)
+  {
+    sumEigenValuesUsed += eigenValues[i];
+  }
+
+} // end ComputeEigenDecomposition()
+
+
+/**
+ * ******************* ComputeWarmStartedEigenDecomposition *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+bool
+PCAMetric<TFixedImage, TMovingImage>::ComputeWarmStartedEigenDecomposition(
+  const MatrixType &     K,
+  vnl_vector<RealType> & eigenValues,
+  MatrixType &           eigenVectorMatrix) const
+{
+  const unsigned int G = K.rows();
+  const unsigned int k = this->m_NumEigenValues;
+  MatrixType &       X = this->m_EigenVectors;
+  if (X.rows() != G || X.cols() < k)
+  {
+    return false;
+  }
+  const unsigned int p = X.cols();
+
+  /** Between two iterations the correlation matrix changes only slightly, so the previous
+   * subspace is close to the invariant subspace of K, and a few steps suffice.
+   */
+  const unsigned int maximumNumberOfIterations = 50;
+  for (unsigned int iteration = 0; iteration < maximumNumberOfIterations; ++iteration)
+  {
+    /** Rayleigh-Ritz: solve the eigenproblem projected on the subspace spanned by X. */
+    const MatrixType KX = K * X;
+    MatrixType       H = X.transpose() * KX;
+    H = (H + H.transpose()) * 0.5;
+    vnl_symmetric_eigensystem<RealType> eig(H);
+    const MatrixType                    ritzVectors = X * eig.V;
+    const MatrixType                    KRitzVectors = KX * eig.V;
+
+    /** Check the residuals of the k largest Ritz pairs, the largest being the last. */
+    const RealType tolerance = 1e-8 * std::max(std::abs(eig.get_eigenvalue(p - 1)), RealType(1.0));
+    bool           converged = true;
+    for (unsigned int i = 1; i < k + 1 && converged; i++)
+    {
+      const vnl_vector<RealType> residual =
+        KRitzVectors.get_column(p - i) - eig.get_eigenvalue(p - i) * ritzVectors.get_column(p - i);
+      converged = residual.two_norm() <= tolerance;
+    }
+
+    if (converged)
+    {
+      for (unsigned int i = 1; i < k + 1; i++)
+      {
+        eigenValues[i - 1] = eig.get_eigenvalue(p - i);
+        eigenVectorMatrix.set_column(i - 1, ritzVectors.get_column(p - i).normalize());
+      }
+      X = ritzVectors;
+      return true;
+    }
+
+    /** Subspace iteration: orthonormalize K X with modified Gram-Schmidt, starting with the
+     * largest Ritz vector. If the subspace degenerates, fall back on the full eigensolver.
+     */
+    X = KRitzVectors;
+    RealType largestNorm = NumericTraits<RealType>::Zero;
+    for (unsigned int c = p; c-- > 0;)
+    {
+      vnl_vector<RealType> column = X.get_column(c);
+      for (unsigned int b = c + 1; b < p; ++b)
+      {
+        const vnl_vector<RealType> previous = X.get_column(b);
+        column -= dot_product(previous, column) * previous;
+      }
+      const RealType norm = column.two_norm();
+      largestNorm = std::max(largestNorm, norm);
+      if (!(norm > 1e-12 * largestNorm))
+      {
+        X.clear();
+        return false;
+      }
+      X.set_column(c, column / norm);
+    }
+  }
+
+  X.clear();
+  return false;
+
+} // end ComputeWarmStartedEigenDecomposition()
+
+
 } // end namespace itk
 
 #endif // itkPCAMetric_F_multithreaded_hxx
@@ -52,6 +52,12 @@ namespace itk
  * The RigidityPenaltyTermValueImageFilter at each pixel location is computed by
  * convolution with some separable 1D kernels.
  *
+ * The separable kernels are combined into 3x3 (2D) or 3x3x3 (3D) stencils, which
+ * are created once per B-spline grid spacing. The value and the derivative are then
+ * computed in two passes over the lines of the B-spline coefficient grid, without
+ * allocating intermediate images. The lines are distributed over the work units
+ * of the metric's threader when UseMultiThread is set.
+ *
  * The rigid penalty term penalizes deviations from a rigid
  * transformation at regions specified by the so-called rigidity images.
  *
@@ -319,9 +325,57 @@ private:
   void
   CreateNDOperator(NeighborhoodType & F, const std::string & whichF, const CoefficientImageSpacingType & spacing) const;
 
-  /** Private function used for the filtering. It performs 1D separable filtering. */
-  CoefficientImagePointer
-  FilterSeparable(const CoefficientImageType *, const std::vector<NeighborhoodType> & Operators) const;
+  /** The number of elements of the 3x3 (2D) or 3x3x3 (3D) stencils. */
+  itkStaticConstMacro(StencilSize, unsigned int, ImageDimension == 2 ? 9 : 27);
+
+  /** The number of operators: A, B (and C) for the orthonormality and properness
+   * conditions, and D, E, G (and F, H, I) for the linearity condition.
+   */
+  itkStaticConstMacro(NumberOfOperators, unsigned int, 4 * ImageDimension - 3);
+
+  /** The grid information that is shared by the passes over the grid lines. */
+  struct GridDataType
+  {
+    const ScalarType *        Coefficients[ImageDimension];
+    const RigidityPixelType * RigidityCoefficients;
+    SizeValueType             GridSize[ImageDimension];
+    SizeValueType             NumberOfPoints;
+    ScalarType                RigidityCoefficientSum;
+    MeasureType *             LineSums;
+    ScalarType *              Parts;
+    ScalarType *              OCparts[ImageDimension][ImageDimension];
+    ScalarType *              PCparts[ImageDimension][ImageDimension];
+    ScalarType *              LCparts[ImageDimension][3 * ImageDimension - 3];
+    DerivativeValueType *     Derivative;
+  };
+
+  /** Private function used for the filtering. It creates the stencils of the separable
+   * filters, as the outer product of the 1D operators, and of the ND operators.
+   */
+  void
+  CreateStencils(const CoefficientImageSpacingType & spacing) const;
+
+  /** Private function that computes the value and, if requested, the derivative. */
+  void
+  ComputeValueAndDerivativeOnGrid(DerivativeType * derivative) const;
+
+  /** Private function that computes the conditions and the subparts along one grid line. */
+  void
+  ComputeConditionsOnLine(const GridDataType & data, const SizeValueType line) const;
+
+  /** Private function that filters the subparts along one grid line, to compute the derivative. */
+  void
+  ComputeDerivativeOnLine(const GridDataType & data, const SizeValueType line) const;
+
+  /** Private functions that compute the buffer offsets of the neighbours of the grid points. */
+  void
+  ComputeLineOffsets(const GridDataType & data, const SizeValueType line, SizeValueType lineOffsets[]) const;
+
+  void
+  ComputeNeighbours(const GridDataType & data,
+                    const SizeValueType  lineOffsets[],
+                    const SizeValueType  x0,
+                    SizeValueType        neighbours[]) const;
 
   /** Member variables. */
   BSplineTransformPointer m_BSplineTransform;
@@ -357,6 +411,13 @@ private:
   RigidityImagePointer             m_MovingRigidityImageDilated;
   bool                             m_UseFixedRigidityImage;
   bool                             m_UseMovingRigidityImage;
+
+  /** Stencil variables and buffers that are reused between the iterations. */
+  mutable CoefficientImageSpacingType m_StencilSpacing;
+  mutable std::vector<ScalarType>     m_FilterStencils;
+  mutable std::vector<ScalarType>     m_DerivativeStencils;
+  mutable std::vector<ScalarType>     m_Parts;
+  mutable std::vector<MeasureType>    m_LineSums;
 };
 
 } // end namespace itk
@@ -483,357 +483,8 @@ TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::GetValue(const Parameter
     itkExceptionMacro(<< "ERROR: This filter is only implemented for dimension 2 and 3.");
   }
 
-  /** Get a handle to the B-spline coefficient images. */
-  std::vector<CoefficientImagePointer> inputImages(ImageDimension);
-  for (unsigned int i = 0; i < ImageDimension; i++)
-  {
-    inputImages[i] = this->m_BSplineTransform->GetCoefficientImages()[i];
-  }
-
-  /** Get the B-spline coefficient image spacing. */
-  CoefficientImageSpacingType spacing = inputImages[0]->GetSpacing();
-
-  /** TASK 0:
-   * Compute the rigidityCoefficientSum and check on it.
-   *
-   ************************************************************************* */
-
-  /** Create iterator over the rigidity coeficient image. */
-  CoefficientImageIteratorType it_RCI(this->m_RigidityCoefficientImage,
-                                      this->m_RigidityCoefficientImage->GetLargestPossibleRegion());
-  it_RCI.GoToBegin();
-  ScalarType rigidityCoefficientSum = NumericTraits<ScalarType>::Zero;
-
-  /** Add the rigidity coefficients together. */
-  while (!it_RCI.IsAtEnd())
-  {
-    rigidityCoefficientSum += it_RCI.Get();
-    ++it_RCI;
-  }
-
-  /** Check for early termination. */
-  if (rigidityCoefficientSum < 1e-14)
-  {
-    this->m_RigidityPenaltyTermValue = NumericTraits<MeasureType>::Zero;
-    return this->m_RigidityPenaltyTermValue;
-  }
-
-  /** TASK 1:
-   * Prepare for the calculation of the rigidity penalty term.
-   *
-   ************************************************************************* */
-
-  /** Create 1D neighbourhood operators. */
-  std::vector<NeighborhoodType> Operators_A(ImageDimension), Operators_B(ImageDimension), Operators_C(ImageDimension),
-    Operators_D(ImageDimension), Operators_E(ImageDimension), Operators_F(ImageDimension), Operators_G(ImageDimension),
-    Operators_H(ImageDimension), Operators_I(ImageDimension);
-
-  /** Create B-spline coefficient images that are filtered once. */
-  std::vector<CoefficientImagePointer> ui_FA(ImageDimension), ui_FB(ImageDimension), ui_FC(ImageDimension),
-    ui_FD(ImageDimension), ui_FE(ImageDimension), ui_FF(ImageDimension), ui_FG(ImageDimension), ui_FH(ImageDimension),
-    ui_FI(ImageDimension);
-
-  /** For all dimensions ... */
-  for (unsigned int i = 0; i < ImageDimension; i++)
-  {
-    /** ... create the filtered images ... */
-    ui_FA[i] = CoefficientImageType::New();
-    ui_FB[i] = CoefficientImageType::New();
-    ui_FD[i] = CoefficientImageType::New();
-    ui_FE[i] = CoefficientImageType::New();
-    ui_FG[i] = CoefficientImageType::New();
-    if (ImageDimension == 3)
-    {
-      ui_FC[i] = CoefficientImageType::New();
-      ui_FF[i] = CoefficientImageType::New();
-      ui_FH[i] = CoefficientImageType::New();
-      ui_FI[i] = CoefficientImageType::New();
-    }
-    /** ... and the apropiate operators.
-     * The operators C, D and E from the paper are here created
-     * by Create1DOperator D, E and G, because of the 3D case and history.
-     */
-    this->Create1DOperator(Operators_A[i], "FA_xi", i + 1, spacing);
-    this->Create1DOperator(Operators_B[i], "FB_xi", i + 1, spacing);
-    this->Create1DOperator(Operators_D[i], "FD_xi", i + 1, spacing);
-    this->Create1DOperator(Operators_E[i], "FE_xi", i + 1, spacing);
-    this->Create1DOperator(Operators_G[i], "FG_xi", i + 1, spacing);
-    if (ImageDimension == 3)
-    {
-      this->Create1DOperator(Operators_C[i], "FC_xi", i + 1, spacing);
-      this->Create1DOperator(Operators_F[i], "FF_xi", i + 1, spacing);
-      this->Create1DOperator(Operators_H[i], "FH_xi", i + 1, spacing);
-      this->Create1DOperator(Operators_I[i], "FI_xi", i + 1, spacing);
-    }
-  } // end for loop
-
-  /** TASK 2:
-   * Filter the B-spline coefficient images.
-   *
-   ************************************************************************* */
-
-  /** Filter the inputImages. */
-  for (unsigned int i = 0; i < ImageDimension; i++)
-  {
-    ui_FA[i] = this->FilterSeparable(inputImages[i], Operators_A);
-    ui_FB[i] = this->FilterSeparable(inputImages[i], Operators_B);
-    ui_FD[i] = this->FilterSeparable(inputImages[i], Operators_D);
-    ui_FE[i] = this->FilterSeparable(inputImages[i], Operators_E);
-    ui_FG[i] = this->FilterSeparable(inputImages[i], Operators_G);
-    if (ImageDimension == 3)
-    {
-      ui_FC[i] = this->FilterSeparable(inputImages[i], Operators_C);
-      ui_FF[i] = this->FilterSeparable(inputImages[i], Operators_F);
-      ui_FH[i] = this->FilterSeparable(inputImages[i], Operators_H);
-      ui_FI[i] = this->FilterSeparable(inputImages[i], Operators_I);
-    }
-  }
-
-  /** TASK 3:
-   * Create iterators.
-   *
-   ************************************************************************* */
-
-  /** Create iterators over ui_F?. */
-  std::vector<CoefficientImageIteratorType> itA(ImageDimension), itB(ImageDimension), itC(ImageDimension),
-    itD(ImageDimension), itE(ImageDimension), itF(ImageDimension), itG(ImageDimension), itH(ImageDimension),
-    itI(ImageDimension);
-
-  /** Create iterators. */
-  for (unsigned int i = 0; i < ImageDimension; i++)
-  {
-    /** Create iterators. */
-    itA[i] = CoefficientImageIteratorType(ui_FA[i], ui_FA[i]->GetLargestPossibleRegion());
-    itB[i] = CoefficientImageIteratorType(ui_FB[i], ui_FB[i]->GetLargestPossibleRegion());
-    itD[i] = CoefficientImageIteratorType(ui_FD[i], ui_FD[i]->GetLargestPossibleRegion());
-    itE[i] = CoefficientImageIteratorType(ui_FE[i], ui_FE[i]->GetLargestPossibleRegion());
-    itG[i] = CoefficientImageIteratorType(ui_FG[i], ui_FG[i]->GetLargestPossibleRegion());
-    if (ImageDimension == 3)
-    {
-      itC[i] = CoefficientImageIteratorType(ui_FC[i], ui_FC[i]->GetLargestPossibleRegion());
-      itF[i] = CoefficientImageIteratorType(ui_FF[i], ui_FF[i]->GetLargestPossibleRegion());
-      itH[i] = CoefficientImageIteratorType(ui_FH[i], ui_FH[i]->GetLargestPossibleRegion());
-      itI[i] = CoefficientImageIteratorType(ui_FI[i], ui_FI[i]->GetLargestPossibleRegion());
-    }
-    /** Reset iterators. */
-    itA[i].GoToBegin();
-    itB[i].GoToBegin();
-    itD[i].GoToBegin();
-    itE[i].GoToBegin();
-    itG[i].GoToBegin();
-    if (ImageDimension == 3)
-    {
-      itC[i].GoToBegin();
-      itF[i].GoToBegin();
-      itH[i].GoToBegin();
-      itI[i].GoToBegin();
-    }
-  }
-
-  /** TASK 4A:
-   * Do the actual calculation of the rigidity penalty term value.
-   * Calculate the orthonormality term.
-   *
-   ************************************************************************* */
-
-  /** Reset all iterators. */
-  it_RCI.GoToBegin();
-
-  if (this->m_CalculateOrthonormalityCondition)
-  {
-    ScalarType mu1_A, mu2_A, mu3_A, mu1_B, mu2_B, mu3_B, mu1_C, mu2_C, mu3_C;
-    while (!itA[0].IsAtEnd())
-    {
-      /** Copy values: this way we avoid calling Get() so many times.
-       * It also improves code readability.
-       */
-      mu1_A = itA[0].Get();
-      mu2_A = itA[1].Get();
-      mu1_B = itB[0].Get();
-      mu2_B = itB[1].Get();
-      if (ImageDimension == 3)
-      {
-        mu3_A = itA[2].Get();
-        mu3_B = itB[2].Get();
-        mu1_C = itC[0].Get();
-        mu2_C = itC[1].Get();
-        mu3_C = itC[2].Get();
-      }
-
-      if (ImageDimension == 2)
-      {
-        this->m_OrthonormalityConditionValue +=
-          it_RCI.Get() * (std::pow(+(1.0 + mu1_A) * (1.0 + mu1_A) + mu2_A * mu2_A - 1.0, 2.0) +
-                          std::pow(+mu1_B * mu1_B + (1.0 + mu2_B) * (1.0 + mu2_B) - 1.0, 2.0) +
-                          std::pow(+(1.0 + mu1_A) * mu1_B + mu2_A * (1.0 + mu2_B), 2.0));
-      }
-      else if (ImageDimension == 3)
-      {
-        this->m_OrthonormalityConditionValue +=
-          it_RCI.Get() * (std::pow(+(1.0 + mu1_A) * (1.0 + mu1_A) + mu2_A * mu2_A + mu3_A * mu3_A - 1.0, 2.0) +
-                          std::pow(+(1.0 + mu1_A) * mu1_B + mu2_A * (1.0 + mu2_B) + mu3_A * mu3_B, 2.0) +
-                          std::pow(+(1.0 + mu1_A) * mu1_C + mu2_A * mu2_C + mu3_A * (1.0 + mu3_C), 2.0) +
-                          std::pow(+mu1_B * mu1_B + (1.0 + mu2_B) * (1.0 + mu2_B) + mu3_B * mu3_B - 1.0, 2.0) +
-                          std::pow(+mu1_B * mu1_C + (1.0 + mu2_B) * mu2_C + mu3_B * (1.0 + mu3_C), 2.0) +
-                          std::pow(+mu1_C * mu1_C + mu2_C * mu2_C + (1.0 + mu3_C) * (1.0 + mu3_C) - 1.0, 2.0));
-      }
-
-      /** Increase all iterators. */
-      for (unsigned int i = 0; i < ImageDimension; i++)
-      {
-        ++itA[i];
-        ++itB[i];
-        if (ImageDimension == 3)
-        {
-          ++itC[i];
-        }
-      }
-      ++it_RCI;
-    } // end while
-  }   // end if do orthonormality
-
-  /** TASK 4B:
-   * Do the actual calculation of the rigidity penalty term value.
-   * Calculate the properness term.
-   *
-   ************************************************************************* */
-
-  /** Reset all iterators. */
-  for (unsigned int i = 0; i < ImageDimension; i++)
-  {
-    itA[i].GoToBegin();
-    itB[i].GoToBegin();
-    if (ImageDimension == 3)
-    {
-      itC[i].GoToBegin();
-    }
-  }
-  it_RCI.GoToBegin();
-
-  if (this->m_CalculatePropernessCondition)
-  {
-    ScalarType mu1_A, mu2_A, mu3_A, mu1_B, mu2_B, mu3_B, mu1_C, mu2_C, mu3_C;
-    while (!itA[0].IsAtEnd())
-    {
-      /** Copy values: this way we avoid calling Get() so many times.
-       * It also improves code readability.
-       */
-      mu1_A = itA[0].Get();
-      mu2_A = itA[1].Get();
-      mu1_B = itB[0].Get();
-      mu2_B = itB[1].Get();
-      if (ImageDimension == 3)
-      {
-        mu3_A = itA[2].Get();
-        mu3_B = itB[2].Get();
-        mu1_C = itC[0].Get();
-        mu2_C = itC[1].Get();
-        mu3_C = itC[2].Get();
-      }
-
-      if (ImageDimension == 2)
-      {
-        this->m_PropernessConditionValue +=
-          it_RCI.Get() * (std::pow(+(1.0 + mu1_A) * (1.0 + mu2_B) - mu2_A * mu1_B - 1.0, 2.0));
-      }
-      else if (ImageDimension == 3)
-      {
-        this->m_PropernessConditionValue +=
-          it_RCI.Get() * (std::pow(-mu1_C * (1.0 + mu2_B) * mu3_A + mu1_B * mu2_C * mu3_A + mu1_C * mu2_A * mu3_B -
-                                     (1.0 + mu1_A) * mu2_C * mu3_B - mu1_B * mu2_A * (1.0 + mu3_C) +
-                                     (1.0 + mu1_A) * (1.0 + mu2_B) * (1.0 + mu3_C) - 1.0,
-                                   2.0));
-      }
-
-      /** Increase all iterators. */
-      for (unsigned int i = 0; i < ImageDimension; i++)
-      {
-        ++itA[i];
-        ++itB[i];
-        if (ImageDimension == 3)
-        {
-          ++itC[i];
-        }
-      }
-      ++it_RCI;
-
-    } // end while
-  }   // end if do properness
-
-  /** TASK 4C:
-   * Do the actual calculation of the rigidity penalty term value.
-   * Calculate the linearity term.
-   *
-   ************************************************************************* */
-
-  /** Reset all iterators. */
-  it_RCI.GoToBegin();
-
-  if (this->m_CalculateLinearityCondition)
-  {
-    while (!itD[0].IsAtEnd())
-    {
-      /** Linearity condition part. */
-      for (unsigned int i = 0; i < ImageDimension; i++)
-      {
-        this->m_LinearityConditionValue +=
-          it_RCI.Get() * (+itD[i].Get() * itD[i].Get() + itE[i].Get() * itE[i].Get() + itG[i].Get() * itG[i].Get());
-        if (ImageDimension == 3)
-        {
-          this->m_LinearityConditionValue +=
-            it_RCI.Get() * (+itF[i].Get() * itF[i].Get() + itH[i].Get() * itH[i].Get() + itI[i].Get() * itI[i].Get());
-        }
-      } // end loop over i
-
-      /** Increase all iterators. */
-      for (unsigned int i = 0; i < ImageDimension; i++)
-      {
-        ++itD[i];
-        ++itE[i];
-        ++itG[i];
-        if (ImageDimension == 3)
-        {
-          ++itF[i];
-          ++itH[i];
-          ++itI[i];
-        }
-      }
-      ++it_RCI;
-
-    } // end while
-  }   // end if do properness
-
-  /** TASK 5:
-   * Do the actual calculation of the rigidity penalty term value.
-   *
-   ************************************************************************* */
-
-  /** Calculate the rigidity penalty term value. */
-  if (this->m_CalculateLinearityCondition)
-  {
-    this->m_LinearityConditionValue /= rigidityCoefficientSum;
-  }
-  if (this->m_CalculateOrthonormalityCondition)
-  {
-    this->m_OrthonormalityConditionValue /= rigidityCoefficientSum;
-  }
-  if (this->m_CalculatePropernessCondition)
-  {
-    this->m_PropernessConditionValue /= rigidityCoefficientSum;
-  }
-
-  if (this->m_UseLinearityCondition)
-  {
-    this->m_RigidityPenaltyTermValue += this->m_LinearityConditionWeight * this->m_LinearityConditionValue;
-  }
-  if (this->m_UseOrthonormalityCondition)
-  {
-    this->m_RigidityPenaltyTermValue += this->m_OrthonormalityConditionWeight * this->m_OrthonormalityConditionValue;
-  }
-  if (this->m_UsePropernessCondition)
-  {
-    this->m_RigidityPenaltyTermValue += this->m_PropernessConditionWeight * this->m_PropernessConditionValue;
-  }
+  /** Compute the rigidity penalty term value. */
+  this->ComputeValueAndDerivativeOnGrid(nullptr);
 
   /** Return the rigidity penalty term value. */
   return this->m_RigidityPenaltyTermValue;
@@ -926,32 +577,54 @@ TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::GetValueAndDerivative(co
     itkExceptionMacro(<< "ERROR: This filter is only implemented for dimension 2 and 3.");
   }
 
+  /** Compute the rigidity penalty term value and derivative. */
+  this->ComputeValueAndDerivativeOnGrid(&derivative);
+  value = this->m_RigidityPenaltyTermValue;
+
+} // end GetValueAndDerivative()
+
+
+/**
+ * ********************* ComputeValueAndDerivativeOnGrid ****************
+ */
+
+template <class TFixedImage, class TScalarType>
+void
+TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::ComputeValueAndDerivativeOnGrid(
+  DerivativeType * derivative) const
+{
   /** Get a handle to the B-spline coefficient images. */
-  std::vector<CoefficientImagePointer> inputImages(ImageDimension);
-  for (unsigned int i = 0; i < ImageDimension; i++)
+  const CoefficientImagePointer * coefficientImages = this->m_BSplineTransform->GetCoefficientImages();
+
+  /** Create the stencils, when the B-spline coefficient image spacing has changed. */
+  const CoefficientImageSpacingType spacing = coefficientImages[0]->GetSpacing();
+  if (this->m_FilterStencils.empty() || spacing != this->m_StencilSpacing)
   {
-    inputImages[i] = this->m_BSplineTransform->GetCoefficientImages()[i];
+    this->CreateStencils(spacing);
   }
 
-  /** Get the B-spline coefficient image spacing. */
-  CoefficientImageSpacingType spacing = inputImages[0]->GetSpacing();
+  /** Collect the grid information that is needed by the passes over the grid lines. */
+  GridDataType data;
+  data.NumberOfPoints = 1;
+  for (unsigned int i = 0; i < ImageDimension; i++)
+  {
+    data.Coefficients[i] = coefficientImages[i]->GetBufferPointer();
+    data.GridSize[i] = coefficientImages[0]->GetBufferedRegion().GetSize()[i];
+    data.NumberOfPoints *= data.GridSize[i];
+  }
+  data.RigidityCoefficients = this->m_RigidityCoefficientImage->GetBufferPointer();
+  const SizeValueType numberOfLines = data.NumberOfPoints / data.GridSize[0];
 
   /** TASK 0:
    * Compute the rigidityCoefficientSum and check on it.
    *
    ************************************************************************* */
 
-  /** Create iterator over the rigidity coeficient image. */
-  CoefficientImageIteratorType it_RCI(this->m_RigidityCoefficientImage,
-                                      this->m_RigidityCoefficientImage->GetLargestPossibleRegion());
-  it_RCI.GoToBegin();
-  ScalarType rigidityCoefficientSum = NumericTraits<ScalarType>::Zero;
-
   /** Add the rigidity coefficients together. */
-  while (!it_RCI.IsAtEnd())
+  ScalarType rigidityCoefficientSum = NumericTraits<ScalarType>::Zero;
+  for (SizeValueType point = 0; point < data.NumberOfPoints; ++point)
   {
-    rigidityCoefficientSum += it_RCI.Get();
-    ++it_RCI;
+    rigidityCoefficientSum += data.RigidityCoefficients[point];
   }
 
   /** Check for early termination. */
@@ -960,381 +633,384 @@ TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::GetValueAndDerivative(co
     this->m_RigidityPenaltyTermValue = NumericTraits<MeasureType>::Zero;
     return;
   }
+  data.RigidityCoefficientSum = rigidityCoefficientSum;
 
   /** TASK 1:
-   * Prepare for the calculation of the rigidity penalty term.
+   * Filter the B-spline coefficients and calculate the condition values and,
+   * for the derivative, the subparts. The buffers are reused between calls.
    *
    ************************************************************************* */
 
-  /** Create 1D neighbourhood operators. */
-  std::vector<NeighborhoodType> Operators_A(ImageDimension), Operators_B(ImageDimension), Operators_C(ImageDimension),
-    Operators_D(ImageDimension), Operators_E(ImageDimension), Operators_F(ImageDimension), Operators_G(ImageDimension),
-    Operators_H(ImageDimension), Operators_I(ImageDimension);
-
-  /** Create B-spline coefficient images that are filtered once. */
-  std::vector<CoefficientImagePointer> ui_FA(ImageDimension), ui_FB(ImageDimension), ui_FC(ImageDimension),
-    ui_FD(ImageDimension), ui_FE(ImageDimension), ui_FF(ImageDimension), ui_FG(ImageDimension), ui_FH(ImageDimension),
-    ui_FI(ImageDimension);
-
-  /** For all dimensions ... */
-  for (unsigned int i = 0; i < ImageDimension; i++)
+  const unsigned int NofLParts = 3 * ImageDimension - 3;
+  this->m_LineSums.resize(3 * numberOfLines);
+  data.LineSums = this->m_LineSums.data();
+  data.Parts = nullptr;
+  data.Derivative = nullptr;
+  if (derivative != nullptr)
   {
-    /** ... create the filtered images ... */
-    ui_FA[i] = CoefficientImageType::New();
-    ui_FB[i] = CoefficientImageType::New();
-    ui_FD[i] = CoefficientImageType::New();
-    ui_FE[i] = CoefficientImageType::New();
-    ui_FG[i] = CoefficientImageType::New();
-    if (ImageDimension == 3)
+    this->m_Parts.resize((2 * ImageDimension + NofLParts) * ImageDimension * data.NumberOfPoints);
+    data.Parts = this->m_Parts.data();
+    data.Derivative = derivative->data_block();
+
+    /** Each subpart occupies a grid sized block of the parts buffer. */
+    ScalarType * part = data.Parts;
+    for (unsigned int i = 0; i < ImageDimension; i++)
     {
-      ui_FC[i] = CoefficientImageType::New();
-      ui_FF[i] = CoefficientImageType::New();
-      ui_FH[i] = CoefficientImageType::New();
-      ui_FI[i] = CoefficientImageType::New();
+      for (unsigned int j = 0; j < ImageDimension; j++)
+      {
+        data.OCparts[i][j] = part;
+        part += data.NumberOfPoints;
+        data.PCparts[i][j] = part;
+        part += data.NumberOfPoints;
+      }
+      for (unsigned int j = 0; j < NofLParts; j++)
+      {
+        data.LCparts[i][j] = part;
+        part += data.NumberOfPoints;
+      }
     }
-    /** ... and the apropiate operators.
-     * The operators C, D and E from the paper are here created
-     * by Create1DOperator D, E and G, because of the 3D case and history.
-     */
-    this->Create1DOperator(Operators_A[i], "FA_xi", i + 1, spacing);
-    this->Create1DOperator(Operators_B[i], "FB_xi", i + 1, spacing);
-    this->Create1DOperator(Operators_D[i], "FD_xi", i + 1, spacing);
-    this->Create1DOperator(Operators_E[i], "FE_xi", i + 1, spacing);
-    this->Create1DOperator(Operators_G[i], "FG_xi", i + 1, spacing);
-    if (ImageDimension == 3)
+  }
+
+  /** Process the grid lines, possibly multi-threaded. */
+  const auto computeConditions = [this, &data](SizeValueType line) { this->ComputeConditionsOnLine(data, line); };
+  if (this->m_UseMultiThread)
+  {
+    this->m_Threader->ParallelizeArray(0, numberOfLines, computeConditions, nullptr);
+  }
+  else
+  {
+    for (SizeValueType line = 0; line < numberOfLines; ++line)
     {
-      this->Create1DOperator(Operators_C[i], "FC_xi", i + 1, spacing);
-      this->Create1DOperator(Operators_F[i], "FF_xi", i + 1, spacing);
-      this->Create1DOperator(Operators_H[i], "FH_xi", i + 1, spacing);
-      this->Create1DOperator(Operators_I[i], "FI_xi", i + 1, spacing);
+      computeConditions(line);
     }
-  } // end for loop
+  }
+
+  /** Add the values of the lines together, in a fixed order. */
+  for (SizeValueType line = 0; line < numberOfLines; ++line)
+  {
+    this->m_OrthonormalityConditionValue += this->m_LineSums[3 * line];
+    this->m_PropernessConditionValue += this->m_LineSums[3 * line + 1];
+    this->m_LinearityConditionValue += this->m_LineSums[3 * line + 2];
+  }
 
   /** TASK 2:
-   * Filter the B-spline coefficient images.
+   * Do the actual calculation of the rigidity penalty term value.
    *
    ************************************************************************* */
 
-  /** Filter the inputImages. */
-  for (unsigned int i = 0; i < ImageDimension; i++)
+  /** Calculate the rigidity penalty term value. */
+  if (this->m_CalculateLinearityCondition)
   {
-    ui_FA[i] = this->FilterSeparable(inputImages[i], Operators_A);
-    ui_FB[i] = this->FilterSeparable(inputImages[i], Operators_B);
-    ui_FD[i] = this->FilterSeparable(inputImages[i], Operators_D);
-    ui_FE[i] = this->FilterSeparable(inputImages[i], Operators_E);
-    ui_FG[i] = this->FilterSeparable(inputImages[i], Operators_G);
-    if (ImageDimension == 3)
-    {
-      ui_FC[i] = this->FilterSeparable(inputImages[i], Operators_C);
-      ui_FF[i] = this->FilterSeparable(inputImages[i], Operators_F);
-      ui_FH[i] = this->FilterSeparable(inputImages[i], Operators_H);
-      ui_FI[i] = this->FilterSeparable(inputImages[i], Operators_I);
-    }
+    this->m_LinearityConditionValue /= rigidityCoefficientSum;
+  }
+  if (this->m_CalculateOrthonormalityCondition)
+  {
+    this->m_OrthonormalityConditionValue /= rigidityCoefficientSum;
+  }
+  if (this->m_CalculatePropernessCondition)
+  {
+    this->m_PropernessConditionValue /= rigidityCoefficientSum;
+  }
+
+  if (this->m_UseLinearityCondition)
+  {
+    this->m_RigidityPenaltyTermValue += this->m_LinearityConditionWeight * this->m_LinearityConditionValue;
+  }
+  if (this->m_UseOrthonormalityCondition)
+  {
+    this->m_RigidityPenaltyTermValue += this->m_OrthonormalityConditionWeight * this->m_OrthonormalityConditionValue;
+  }
+  if (this->m_UsePropernessCondition)
+  {
+    this->m_RigidityPenaltyTermValue += this->m_PropernessConditionWeight * this->m_PropernessConditionValue;
+  }
+
+  if (derivative == nullptr)
+  {
+    return;
   }
 
   /** TASK 3:
-   * Create subparts and iterators.
+   * Filter the subparts and add it all to create the final derivative.
    *
    ************************************************************************* */
 
-  /** Create iterators over ui_F?. */
-  std::vector<CoefficientImageIteratorType> itA(ImageDimension), itB(ImageDimension), itC(ImageDimension),
-    itD(ImageDimension), itE(ImageDimension), itF(ImageDimension), itG(ImageDimension), itH(ImageDimension),
-    itI(ImageDimension);
-
-  /** Create iterators. */
-  for (unsigned int i = 0; i < ImageDimension; i++)
+  /** Process the grid lines, possibly multi-threaded. */
+  const auto computeDerivative = [this, &data](SizeValueType line) { this->ComputeDerivativeOnLine(data, line); };
+  if (this->m_UseMultiThread)
   {
-    /** Create iterators. */
-    itA[i] = CoefficientImageIteratorType(ui_FA[i], ui_FA[i]->GetLargestPossibleRegion());
-    itB[i] = CoefficientImageIteratorType(ui_FB[i], ui_FB[i]->GetLargestPossibleRegion());
-    itD[i] = CoefficientImageIteratorType(ui_FD[i], ui_FD[i]->GetLargestPossibleRegion());
-    itE[i] = CoefficientImageIteratorType(ui_FE[i], ui_FE[i]->GetLargestPossibleRegion());
-    itG[i] = CoefficientImageIteratorType(ui_FG[i], ui_FG[i]->GetLargestPossibleRegion());
-    if (ImageDimension == 3)
-    {
-      itC[i] = CoefficientImageIteratorType(ui_FC[i], ui_FC[i]->GetLargestPossibleRegion());
-      itF[i] = CoefficientImageIteratorType(ui_FF[i], ui_FF[i]->GetLargestPossibleRegion());
-      itH[i] = CoefficientImageIteratorType(ui_FH[i], ui_FH[i]->GetLargestPossibleRegion());
-      itI[i] = CoefficientImageIteratorType(ui_FI[i], ui_FI[i]->GetLargestPossibleRegion());
-    }
-    /** Reset iterators. */
-    itA[i].GoToBegin();
-    itB[i].GoToBegin();
-    itD[i].GoToBegin();
-    itE[i].GoToBegin();
-    itG[i].GoToBegin();
-    if (ImageDimension == 3)
+    this->m_Threader->ParallelizeArray(0, numberOfLines, computeDerivative, nullptr);
+  }
+  else
+  {
+    for (SizeValueType line = 0; line < numberOfLines; ++line)
     {
-      itC[i].GoToBegin();
-      itF[i].GoToBegin();
-      itH[i].GoToBegin();
-      itI[i].GoToBegin();
+      computeDerivative(line);
     }
   }
 
-  /** Create orthonormality and properness parts. */
-  std::vector<std::vector<CoefficientImagePointer>> OCparts(ImageDimension);
-  std::vector<std::vector<CoefficientImagePointer>> PCparts(ImageDimension);
-  for (unsigned int i = 0; i < ImageDimension; i++)
+  /** Set the gradient magnitudes of the several terms. */
+  MeasureType gradMagLC = NumericTraits<MeasureType>::Zero;
+  MeasureType gradMagOC = NumericTraits<MeasureType>::Zero;
+  MeasureType gradMagPC = NumericTraits<MeasureType>::Zero;
+  for (SizeValueType line = 0; line < numberOfLines; ++line)
   {
-    OCparts[i].resize(ImageDimension);
-    PCparts[i].resize(ImageDimension);
-    for (unsigned int j = 0; j < ImageDimension; j++)
-    {
-      OCparts[i][j] = CoefficientImageType::New();
-      OCparts[i][j]->SetRegions(inputImages[0]->GetLargestPossibleRegion());
-      OCparts[i][j]->Allocate();
-      PCparts[i][j] = CoefficientImageType::New();
-      PCparts[i][j]->SetRegions(inputImages[0]->GetLargestPossibleRegion());
-      PCparts[i][j]->Allocate();
-    }
+    gradMagOC += this->m_LineSums[3 * line];
+    gradMagPC += this->m_LineSums[3 * line + 1];
+    gradMagLC += this->m_LineSums[3 * line + 2];
   }
+  this->m_LinearityConditionGradientMagnitude = std::sqrt(gradMagLC);
+  this->m_OrthonormalityConditionGradientMagnitude = std::sqrt(gradMagOC);
+  this->m_PropernessConditionGradientMagnitude = std::sqrt(gradMagPC);
 
-  /** Create linearity parts. */
-  unsigned int                                      NofLParts = 3 * ImageDimension - 3;
-  std::vector<std::vector<CoefficientImagePointer>> LCparts(ImageDimension);
-  for (unsigned int i = 0; i < ImageDimension; i++)
+} // end ComputeValueAndDerivativeOnGrid()
+
+
+/**
+ * ********************* ComputeConditionsOnLine ****************
+ */
+
+template <class TFixedImage, class TScalarType>
+void
+TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::ComputeConditionsOnLine(const GridDataType & data,
+                                                                                const SizeValueType  line) const
+{
+  /** Only filter with the operators that are needed. The operators A, B and C
+   * are used by the orthonormality and properness conditions, the others by
+   * the linearity condition.
+   */
+  unsigned int firstOperator = 0;
+  unsigned int lastOperator = NumberOfOperators;
+  if (!this->m_CalculateOrthonormalityCondition && !this->m_CalculatePropernessCondition)
   {
-    LCparts[i].resize(NofLParts);
-    for (unsigned int j = 0; j < NofLParts; j++)
-    {
-      LCparts[i][j] = CoefficientImageType::New();
-      LCparts[i][j]->SetRegions(inputImages[0]->GetLargestPossibleRegion());
-      LCparts[i][j]->Allocate();
-    }
+    firstOperator = ImageDimension;
   }
+  if (!this->m_CalculateLinearityCondition)
+  {
+    lastOperator = ImageDimension;
+  }
+  const ScalarType * filterStencils = this->m_FilterStencils.data();
 
-  /** Create iterators over all parts. */
-  std::vector<std::vector<CoefficientImageIteratorType>> itOCp(ImageDimension);
-  std::vector<std::vector<CoefficientImageIteratorType>> itPCp(ImageDimension);
-  std::vector<std::vector<CoefficientImageIteratorType>> itLCp(ImageDimension);
-  for (unsigned int i = 0; i < ImageDimension; i++)
+  SizeValueType lineOffsets[StencilSize / 3];
+  SizeValueType neighbours[StencilSize];
+  ScalarType    coefficients[ImageDimension][StencilSize];
+  ScalarType    filtered[NumberOfOperators][ImageDimension];
+  MeasureType   lineValueOC = NumericTraits<MeasureType>::Zero;
+  MeasureType   lineValuePC = NumericTraits<MeasureType>::Zero;
+  MeasureType   lineValueLC = NumericTraits<MeasureType>::Zero;
+  ScalarType    mu1_A = 0.0, mu2_A = 0.0, mu3_A = 0.0, mu1_B = 0.0, mu2_B = 0.0, mu3_B = 0.0;
+  ScalarType    mu1_C = 0.0, mu2_C = 0.0, mu3_C = 0.0;
+
+  this->ComputeLineOffsets(data, line, lineOffsets);
+  for (SizeValueType x0 = 0; x0 < data.GridSize[0]; ++x0)
   {
-    itOCp[i].resize(ImageDimension);
-    itPCp[i].resize(ImageDimension);
-    itLCp[i].resize(NofLParts);
-    for (unsigned int j = 0; j < ImageDimension; j++)
+    const SizeValueType point = line * data.GridSize[0] + x0;
+    const ScalarType    rc = data.RigidityCoefficients[point];
+
+    /** Get the B-spline coefficients in the neighbourhood of this point. */
+    this->ComputeNeighbours(data, lineOffsets, x0, neighbours);
+    for (unsigned int i = 0; i < ImageDimension; i++)
     {
-      itOCp[i][j] = CoefficientImageIteratorType(OCparts[i][j], OCparts[i][j]->GetLargestPossibleRegion());
-      itOCp[i][j].GoToBegin();
-      itPCp[i][j] = CoefficientImageIteratorType(PCparts[i][j], PCparts[i][j]->GetLargestPossibleRegion());
-      itPCp[i][j].GoToBegin();
+      for (unsigned int k = 0; k < StencilSize; ++k)
+      {
+        coefficients[i][k] = data.Coefficients[i][neighbours[k]];
+      }
     }
-    for (unsigned int j = 0; j < NofLParts; j++)
+
+    /** Filter them with the stencils, which is equivalent to the separable filtering. */
+    for (unsigned int op = firstOperator; op < lastOperator; ++op)
     {
-      itLCp[i][j] = CoefficientImageIteratorType(LCparts[i][j], LCparts[i][j]->GetLargestPossibleRegion());
-      itLCp[i][j].GoToBegin();
+      const ScalarType * stencil = filterStencils + op * StencilSize;
+      for (unsigned int i = 0; i < ImageDimension; i++)
+      {
+        ScalarType sum = NumericTraits<ScalarType>::Zero;
+        for (unsigned int k = 0; k < StencilSize; ++k)
+        {
+          sum += stencil[k] * coefficients[i][k];
+        }
+        filtered[op][i] = sum;
+      }
     }
-  }
 
-  /** TASK 4A:
-   * Do the calculation of the orthonormality subparts.
-   *
-   ************************************************************************* */
+    /** Copy values: this improves code readability. */
+    if (firstOperator == 0)
+    {
+      mu1_A = filtered[0][0];
+      mu2_A = filtered[0][1];
+      mu1_B = filtered[1][0];
+      mu2_B = filtered[1][1];
+      if (ImageDimension == 3)
+      {
+        mu3_A = filtered[0][2];
+        mu3_B = filtered[1][2];
+        mu1_C = filtered[2][0];
+        mu2_C = filtered[2][1];
+        mu3_C = filtered[2][2];
+      }
+    }
+
+    /** Calculate the value of the orthonormality condition. */
+    if (this->m_CalculateOrthonormalityCondition)
+    {
+      if (ImageDimension == 2)
+      {
+        lineValueOC += rc * (std::pow(+(1.0 + mu1_A) * (1.0 + mu1_A) + mu2_A * mu2_A - 1.0, 2.0) +
+                             std::pow(+mu1_B * mu1_B + (1.0 + mu2_B) * (1.0 + mu2_B) - 1.0, 2.0) +
+                             std::pow(+(1.0 + mu1_A) * mu1_B + mu2_A * (1.0 + mu2_B), 2.0));
+      }
+      else if (ImageDimension == 3)
+      {
+        lineValueOC += rc * (std::pow(+(1.0 + mu1_A) * (1.0 + mu1_A) + mu2_A * mu2_A + mu3_A * mu3_A - 1.0, 2.0) +
+                             std::pow(+(1.0 + mu1_A) * mu1_B + mu2_A * (1.0 + mu2_B) + mu3_A * mu3_B, 2.0) +
+                             std::pow(+(1.0 + mu1_A) * mu1_C + mu2_A * mu2_C + mu3_A * (1.0 + mu3_C), 2.0) +
+                             std::pow(+mu1_B * mu1_B + (1.0 + mu2_B) * (1.0 + mu2_B) + mu3_B * mu3_B - 1.0, 2.0) +
+                             std::pow(+mu1_B * mu1_C + (1.0 + mu2_B) * mu2_C + mu3_B * (1.0 + mu3_C), 2.0) +
+                             std::pow(+mu1_C * mu1_C + mu2_C * mu2_C + (1.0 + mu3_C) * (1.0 + mu3_C) - 1.0, 2.0));
+      }
+    }
+
+    /** Calculate the value of the properness condition. */
+    if (this->m_CalculatePropernessCondition)
+    {
+      if (ImageDimension == 2)
+      {
+        lineValuePC += rc * (std::pow(+(1.0 + mu1_A) * (1.0 + mu2_B) - mu2_A * mu1_B - 1.0, 2.0));
+      }
+      else if (ImageDimension == 3)
+      {
+        lineValuePC += rc * (std::pow(-mu1_C * (1.0 + mu2_B) * mu3_A + mu1_B * mu2_C * mu3_A + mu1_C * mu2_A * mu3_B -
+                                        (1.0 + mu1_A) * mu2_C * mu3_B - mu1_B * mu2_A * (1.0 + mu3_C) +
+                                        (1.0 + mu1_A) * (1.0 + mu2_B) * (1.0 + mu3_C) - 1.0,
+                                      2.0));
+      }
+    }
+
+    /** Calculate the value of the linearity condition. The operators D, E, G
+     * (and for 3D F, H, I) follow the operators A, B (and C).
+     */
+    if (this->m_CalculateLinearityCondition)
+    {
+      for (unsigned int i = 0; i < ImageDimension; i++)
+      {
+        for (unsigned int op = ImageDimension; op < NumberOfOperators; ++op)
+        {
+          lineValueLC += rc * filtered[op][i] * filtered[op][i];
+        }
+      }
+    }
 
-  /** Reset all iterators. */
-  it_RCI.GoToBegin();
+    /** The rest is only needed for the derivative. */
+    if (data.Parts == nullptr)
+    {
+      continue;
+    }
 
-  if (this->m_CalculateOrthonormalityCondition)
-  {
-    ScalarType mu1_A, mu2_A, mu3_A, mu1_B, mu2_B, mu3_B, mu1_C, mu2_C, mu3_C;
-    ScalarType valueOC;
-    while (!itOCp[0][0].IsAtEnd())
+    /** Calculate the subparts of the derivative of the orthonormality condition.
+     * They are multiplied by the rigidity coefficient, which is needed when filtering them.
+     */
+    if (this->m_CalculateOrthonormalityCondition)
     {
-      /** Copy values: this way we avoid calling Get() so many times.
-       * It also improves code readability.
-       */
-      mu1_A = itA[0].Get();
-      mu2_A = itA[1].Get();
-      mu1_B = itB[0].Get();
-      mu2_B = itB[1].Get();
-      if (ImageDimension == 3)
-      {
-        mu3_A = itA[2].Get();
-        mu3_B = itB[2].Get();
-        mu1_C = itC[0].Get();
-        mu2_C = itC[1].Get();
-        mu3_C = itC[2].Get();
-      }
+      ScalarType valueOC;
       if (ImageDimension == 2)
       {
-        /** Calculate the value of the orthonormality condition. */
-        this->m_OrthonormalityConditionValue +=
-          it_RCI.Get() * (std::pow(+(1.0 + mu1_A) * (1.0 + mu1_A) + mu2_A * mu2_A - 1.0, 2.0) +
-                          std::pow(+mu1_B * mu1_B + (1.0 + mu2_B) * (1.0 + mu2_B) - 1.0, 2.0) +
-                          std::pow(+(1.0 + mu1_A) * mu1_B + mu2_A * (1.0 + mu2_B), 2.0));
-        /** Calculate the derivative of the orthonormality condition. */
         /** mu1, part 1 */
         valueOC = +2.0 * (1.0 + mu1_A) * (1.0 + mu1_A) * (1.0 + mu1_A) + 2.0 * mu2_A * mu2_A * (1.0 + mu1_A) -
                   2.0 * (1.0 + mu1_A) + mu1_B * mu1_B * (1.0 + mu1_A) + mu2_A * (1.0 + mu2_B) * mu1_B;
-        itOCp[0][0].Set(2.0 * valueOC);
+        data.OCparts[0][0][point] = 2.0 * rc * valueOC;
         /** mu1, part2*/
         valueOC = +mu1_B * (1.0 + mu1_A) * (1.0 + mu1_A) + mu2_A * (1.0 + mu2_B) * (1.0 + mu1_A) +
                   2.0 * mu1_B * mu1_B * mu1_B + 2.0 * mu1_B * (1.0 + mu2_B) * (1.0 + mu2_B) - 2.0 * mu1_B;
-        itOCp[0][1].Set(2.0 * valueOC);
+        data.OCparts[0][1][point] = 2.0 * rc * valueOC;
         /** mu2, part 1 */
         valueOC = +2.0 * mu2_A * mu2_A * mu2_A + 2.0 * mu2_A * (1.0 + mu1_A) * (1.0 + mu1_A) - 2.0 * mu2_A +
                   mu2_A * (1.0 + mu2_B) * (1.0 + mu2_B) + mu1_B * (1.0 + mu1_A) * (1.0 + mu2_B);
-        itOCp[1][0].Set(2.0 * valueOC);
+        data.OCparts[1][0][point] = 2.0 * rc * valueOC;
         /** mu2, part2*/
         valueOC = +mu2_A * mu2_A * (1.0 + mu2_B) + mu1_B * (1.0 + mu1_A) * mu2_A +
                   2.0 * (1.0 + mu2_B) * (1.0 + mu2_B) * (1.0 + mu2_B) + 2.0 * mu1_B * mu1_B * (1.0 + mu2_B) -
                   2.0 * (1.0 + mu2_B);
-        itOCp[1][1].Set(2.0 * valueOC);
+        data.OCparts[1][1][point] = 2.0 * rc * valueOC;
       } // end if dim == 2
       else if (ImageDimension == 3)
       {
-        /** Calculate the value of the orthonormality condition. */
-        this->m_OrthonormalityConditionValue +=
-          it_RCI.Get() * (std::pow(+(1.0 + mu1_A) * (1.0 + mu1_A) + mu2_A * mu2_A + mu3_A * mu3_A - 1.0, 2.0) +
-                          std::pow(+(1.0 + mu1_A) * mu1_B + mu2_A * (1.0 + mu2_B) + mu3_A * mu3_B, 2.0) +
-                          std::pow(+(1.0 + mu1_A) * mu1_C + mu2_A * mu2_C + mu3_A * (1.0 + mu3_C), 2.0) +
-                          std::pow(+mu1_B * mu1_B + (1.0 + mu2_B) * (1.0 + mu2_B) + mu3_B * mu3_B - 1.0, 2.0) +
-                          std::pow(+mu1_B * mu1_C + (1.0 + mu2_B) * mu2_C + mu3_B * (1.0 + mu3_C), 2.0) +
-                          std::pow(+mu1_C * mu1_C + mu2_C * mu2_C + (1.0 + mu3_C) * (1.0 + mu3_C) - 1.0, 2.0));
-        /** Calculate the derivative of the orthonormality condition. */
         /** mu1, part 1 */
         valueOC = +2.0 * (1.0 + mu1_A) * (1.0 + mu1_A) * (1.0 + mu1_A) + 2.0 * mu2_A * mu2_A * (1.0 + mu1_A) +
                   2.0 * (1.0 + mu1_A) * mu3_A * mu3_A - 2.0 * (1.0 + mu1_A) + mu1_B * mu1_B * (1.0 + mu1_A) +
                   mu2_A * (1.0 + mu2_B) * mu1_B + mu1_B * mu3_A * mu3_B + (1.0 + mu1_A) * mu1_C * mu1_C +
                   mu1_C * mu2_A * mu2_C + mu1_C * mu3_A * (1.0 + mu3_C);
-        itOCp[0][0].Set(2.0 * valueOC);
+        data.OCparts[0][0][point] = 2.0 * rc * valueOC;
         /** mu1, part2 */
         valueOC = +(1.0 + mu1_A) * (1.0 + mu1_A) * mu1_B + (1.0 + mu1_A) * mu2_A * mu3_B +
                   (1.0 + mu1_A) * mu3_A * mu3_B + mu1_B * mu1_B * mu1_B + mu1_B * (1.0 + mu2_B) * (1.0 + mu2_B) +
                   mu1_B * mu3_B * mu3_B - mu1_B + mu1_B * mu1_C * mu1_C + mu1_C * (1.0 + mu2_B) * mu2_C +
                   mu1_C * mu3_B * (1.0 + mu3_C);
-        itOCp[0][1].Set(2.0 * valueOC);
+        data.OCparts[0][1][point] = 2.0 * rc * valueOC;
         /** mu1, part3 */
         valueOC = +(1.0 + mu1_A) * (1.0 + mu1_A) * mu1_C + (1.0 + mu1_A) * mu2_A * mu2_C +
                   (1.0 + mu1_A) * mu3_A * (1.0 + mu3_C) + mu1_B * mu1_B * mu1_C + mu1_B * (1.0 + mu2_B) * mu2_C +
                   mu1_B * mu3_B * (1.0 + mu3_C) + 2.0 * mu1_C * mu1_C * mu1_C + 2.0 * mu1_C * mu2_C * mu2_C +
                   2.0 * mu1_C * (1.0 + mu3_C) * (1.0 + mu3_C) - 2.0 * mu1_C;
-        itOCp[0][2].Set(2.0 * valueOC);
+        data.OCparts[0][2][point] = 2.0 * rc * valueOC;
         /** mu2, part 1 */
         valueOC = +2.0 * mu2_A * mu2_A * mu2_A + 2.0 * mu2_A * (1.0 + mu1_A) * (1.0 + mu1_A) - 2.0 * mu2_A +
                   2.0 * mu2_A * mu3_A * mu3_A + mu2_A * (1.0 + mu2_B) * (1.0 + mu2_B) +
                   mu1_B * (1.0 + mu1_A) * (1.0 + mu2_B) + (1.0 + mu2_B) * mu3_A * mu3_B + mu2_A * mu2_C * mu2_C +
                   (1.0 + mu1_A) * mu1_C * mu2_C + mu2_C * mu3_A * (1.0 + mu3_C);
-        itOCp[1][0].Set(2.0 * valueOC);
+        data.OCparts[1][0][point] = 2.0 * rc * valueOC;
         /** mu2, part2 */
         valueOC = +mu2_A * mu2_A * (1.0 + mu2_B) + mu1_B * (1.0 + mu1_A) * mu2_A + mu2_A * mu3_A * mu3_B +
                   2.0 * (1.0 + mu2_B) * (1.0 + mu2_B) * (1.0 + mu2_B) + 2.0 * mu1_B * mu1_B * (1.0 + mu2_B) -
                   2.0 * (1.0 + mu2_B) + 2.0 * (1.0 + mu2_B) * mu3_B * mu3_B + (1.0 + mu2_B) * mu2_C * mu2_C +
                   mu1_B * mu1_C * mu2_C + mu2_C * mu3_B * (1.0 + mu3_C);
-        itOCp[1][1].Set(2.0 * valueOC);
+        data.OCparts[1][1][point] = 2.0 * rc * valueOC;
         /** mu2, part 3 */
         valueOC = +mu2_A * mu2_A * mu2_C + (1.0 + mu1_A) * mu1_C * mu2_A + mu2_A * mu3_A * (1.0 + mu3_C) +
                   (1.0 + mu2_B) * (1.0 + mu2_B) * mu2_C + mu1_B * mu1_C * mu2_B +
                   (1.0 + mu2_B) * mu3_B * (1.0 + mu3_C) + 2.0 * mu2_C * mu2_C * mu2_C + 2.0 * mu1_C * mu1_C * mu2_C +
                   2.0 * mu2_C * (1.0 + mu3_C) * (1.0 + mu3_C) - 2.0 * mu2_C;
-        itOCp[1][2].Set(2.0 * valueOC);
+        data.OCparts[1][2][point] = 2.0 * rc * valueOC;
         /** mu3, part 1 */
         valueOC = +2.0 * mu3_A * mu3_A * mu3_A + 2.0 * mu3_A * (1.0 + mu1_A) * (1.0 + mu1_A) - 2.0 * mu3_A +
                   2.0 * mu2_A * mu2_A * mu3_A + mu3_A * mu3_B * mu3_B + mu1_B * (1.0 + mu1_A) * mu3_B +
                   (1.0 + mu2_B) * mu2_A * mu3_B + mu3_A * (1.0 + mu3_C) * (1.0 + mu3_C) +
                   (1.0 + mu1_A) * mu1_C * (1.0 + mu3_C) + mu2_C * mu2_A * (1.0 + mu3_C);
-        itOCp[2][0].Set(2.0 * valueOC);
+        data.OCparts[2][0][point] = 2.0 * rc * valueOC;
         /** mu3, part2 */
         valueOC = +mu3_A * mu3_A * mu3_B + mu1_B * (1.0 + mu1_A) * mu3_A + mu2_A * mu3_A * (1.0 + mu2_B) +
                   2.0 * mu3_B * mu3_B * mu3_B + 2.0 * mu1_B * mu1_B * mu3_B - 2.0 * mu3_B +
                   2.0 * (1.0 + mu2_B) * (1.0 + mu2_B) * mu3_B + mu3_B * (1.0 + mu3_C) * (1.0 + mu3_C) +
                   mu1_B * mu1_C * (1.0 + mu3_C) + mu2_C * (1.0 + mu2_B) * (1.0 + mu3_C);
-        itOCp[2][1].Set(2.0 * valueOC);
+        data.OCparts[2][1][point] = 2.0 * rc * valueOC;
         /** mu3, part 3 */
         valueOC = +mu3_A * mu3_A * (1.0 + mu3_C) + (1.0 + mu1_A) * mu1_C * mu3_A + mu2_A * mu3_A * mu2_C +
                   mu3_B * mu3_B * (1.0 + mu3_C) + mu1_B * mu1_C * mu3_B + (1.0 + mu2_B) * mu3_B * mu2_C +
                   2.0 * (1.0 + mu3_C) * (1.0 + mu3_C) * (1.0 + mu3_C) + 2.0 * mu1_C * mu1_C * (1.0 + mu3_C) +
                   2.0 * mu2_C * mu2_C * (1.0 + mu3_C) - 2.0 * (1.0 + mu3_C);
-        itOCp[2][2].Set(2.0 * valueOC);
+        data.OCparts[2][2][point] = 2.0 * rc * valueOC;
       } // end if dim == 3
-
-      /** Increase all iterators. */
-      for (unsigned int i = 0; i < ImageDimension; i++)
-      {
-        ++itA[i];
-        ++itB[i];
-        if (ImageDimension == 3)
-        {
-          ++itC[i];
-        }
-        for (unsigned int j = 0; j < ImageDimension; j++)
-        {
-          ++itOCp[i][j];
-        }
-      }
-      ++it_RCI;
-
-    } // end while
-  }   // end if do orthonormality
-
-  /** TASK 4B:
-   * Do the calculation of the properness parts.
-   *
-   ************************************************************************* */
-
-  /** Reset all iterators. */
-  for (unsigned int i = 0; i < ImageDimension; i++)
-  {
-    itA[i].GoToBegin();
-    itB[i].GoToBegin();
-    if (ImageDimension == 3)
-    {
-      itC[i].GoToBegin();
     }
-  }
-  it_RCI.GoToBegin();
 
-  if (this->m_CalculatePropernessCondition)
-  {
-    ScalarType mu1_A, mu2_A, mu3_A, mu1_B, mu2_B, mu3_B, mu1_C, mu2_C, mu3_C;
-    ScalarType valuePC;
-    while (!itPCp[0][0].IsAtEnd())
+    /** Calculate the subparts of the derivative of the properness condition. */
+    if (this->m_CalculatePropernessCondition)
     {
-      /** Copy values: this way we avoid calling Get() so many times.
-       * It also improves code readability.
-       */
-      mu1_A = itA[0].Get();
-      mu2_A = itA[1].Get();
-      mu1_B = itB[0].Get();
-      mu2_B = itB[1].Get();
-      if (ImageDimension == 3)
-      {
-        mu3_A = itA[2].Get();
-        mu3_B = itB[2].Get();
-        mu1_C = itC[0].Get();
-        mu2_C = itC[1].Get();
-        mu3_C = itC[2].Get();
-      }
+      ScalarType valuePC;
       if (ImageDimension == 2)
       {
-        /** Calculate the value of the properness condition. */
-        this->m_PropernessConditionValue +=
-          it_RCI.Get() * (std::pow(+(1.0 + mu1_A) * (1.0 + mu2_B) - mu2_A * mu1_B - 1.0, 2.0));
-        /** Calculate the derivative of the properness condition. */
         /** mu1, part 1 */
         valuePC = +(1.0 + mu2_B) * (1.0 + mu2_B) * (1.0 + mu1_A) - mu2_A * (1.0 + mu2_B) * mu1_B - (1.0 + mu2_B);
-        itPCp[0][0].Set(2.0 * valuePC);
+        data.PCparts[0][0][point] = 2.0 * rc * valuePC;
         /** mu1, part 2 */
         valuePC = +mu2_A + mu2_A * mu2_A * mu1_B - mu2_A * (1.0 + mu2_B) * (1.0 + mu1_A);
-        itPCp[0][1].Set(2.0 * valuePC);
+        data.PCparts[0][1][point] = 2.0 * rc * valuePC;
         /** mu2, part 1 */
         valuePC = +mu1_B * mu1_B * mu2_A - mu1_B * (1.0 + mu1_A) * (1.0 + mu2_B) + mu1_B;
-        itPCp[1][0].Set(2.0 * valuePC);
+        data.PCparts[1][0][point] = 2.0 * rc * valuePC;
         /** mu2, part 2 */
         valuePC = -(1.0 + mu1_A) + (1.0 + mu1_A) * (1.0 + mu1_A) * (1.0 + mu2_B) - mu1_B * (1.0 + mu1_A) * mu2_A;
-        itPCp[1][1].Set(2.0 * valuePC);
+        data.PCparts[1][1][point] = 2.0 * rc * valuePC;
       } // end if dim == 2
       else if (ImageDimension == 3)
       {
-        /** Calculate the value of the properness condition. */
-        this->m_PropernessConditionValue +=
-          it_RCI.Get() * (std::pow(-mu1_C * (1.0 + mu2_B) * mu3_A + mu1_B * mu2_C * mu3_A + mu1_C * mu2_A * mu3_B -
-                                     (1.0 + mu1_A) * mu2_C * mu3_B - mu1_B * mu2_A * (1.0 + mu3_C) +
-                                     (1.0 + mu1_A) * (1.0 + mu2_B) * (1.0 + mu3_C) - 1.0,
-                                   2.0));
-        /** Calculate the derivative of the properness condition. */
         /** mu1, part 1 */
         valuePC = +(1.0 + mu1_A) * mu2_C * mu2_C * mu3_B * mu3_B +
                   (1.0 + mu1_A) * (1.0 + mu2_B) * (1.0 + mu2_B) * (1.0 + mu3_C) * (1.0 + mu3_C) +
@@ -1345,7 +1021,7 @@ TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::GetValueAndDerivative(co
                   mu1_B * mu2_A * mu2_C * mu3_B * (1.0 + mu3_C) -
                   2.0 * (1.0 + mu1_A) * (1.0 + mu2_B) * mu2_C * mu3_B * (1.0 + mu3_C) + mu2_C * mu3_B -
                   mu1_B * mu2_A * (1.0 + mu2_B) * (1.0 + mu3_C) * (1.0 + mu3_C) - (1.0 + mu2_B) * (1.0 + mu3_C);
-        itPCp[0][0].Set(2.0 * valuePC);
+        data.PCparts[0][0][point] = 2.0 * rc * valuePC;
         /** mu1, part 2 */
         valuePC = +mu1_B * mu2_C * mu2_C * mu3_A * mu3_A + mu1_B * mu2_A * mu2_A * (1.0 + mu3_C) * (1.0 + mu3_C) -
                   mu1_C * (1.0 + mu2_B) * mu2_C * mu3_A * mu3_A +
@@ -1355,7 +1031,7 @@ TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::GetValueAndDerivative(co
                   mu1_C * mu2_A * mu2_A * mu3_B * (1.0 + mu3_C) +
                   (1.0 + mu1_A) * mu2_A * mu2_C * mu3_B * (1.0 + mu3_C) -
                   (1.0 + mu1_A) * mu2_A * (1.0 + mu2_B) * (1.0 + mu3_C) * (1.0 + mu3_C) + mu2_A * (1.0 + mu3_C);
-        itPCp[0][1].Set(2.0 * valuePC);
+        data.PCparts[0][1][point] = 2.0 * rc * valuePC;
         /** mu1, part 3 */
         valuePC = +mu1_C * (1.0 + mu2_B) * (1.0 + mu2_B) * mu3_A * mu3_A + mu1_C * mu2_A * mu2_A * mu3_B * mu3_B -
                   mu1_B * (1.0 + mu2_B) * mu2_C * mu3_A * mu3_A - 2.0 * mu1_C * mu2_A * (1.0 + mu2_B) * mu3_A * mu3_B +
@@ -1365,7 +1041,7 @@ TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::GetValueAndDerivative(co
                   mu1_B * mu2_A * mu2_C * mu3_A * mu3_B - (1.0 + mu1_A) * mu2_A * mu2_C * mu3_B * mu3_B -
                   mu1_B * mu2_A * mu2_A * mu3_B * (1.0 + mu3_C) +
                   (1.0 + mu1_A) * mu2_A * (1.0 + mu2_B) * mu3_B * (1.0 + mu3_C) - mu2_A * mu3_B;
-        itPCp[0][2].Set(2.0 * valuePC);
+        data.PCparts[0][2][point] = 2.0 * rc * valuePC;
         /** mu2, part 1 */
         valuePC = +mu1_C * mu1_C * mu2_A * mu3_B * mu3_B + mu1_B * mu1_B * mu2_A * (1.0 + mu3_C) * (1.0 + mu3_C) -
                   mu1_C * mu1_C * (1.0 + mu2_B) * mu3_A * mu3_B +
@@ -1375,7 +1051,7 @@ TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::GetValueAndDerivative(co
                   (1.0 + mu1_A) * mu1_C * (1.0 + mu2_B) * mu3_B * (1.0 + mu3_C) - mu1_C * mu3_B +
                   (1.0 + mu1_A) * mu1_B * mu2_C * mu3_B * (1.0 + mu3_C) -
                   (1.0 + mu1_A) * mu1_B * (1.0 + mu2_B) * (1.0 + mu3_C) * (1.0 + mu3_C) + mu1_B * (1.0 + mu3_C);
-        itPCp[1][0].Set(2.0 * valuePC);
+        data.PCparts[1][0][point] = 2.0 * rc * valuePC;
         /** mu2, part 2 */
         valuePC = +mu1_C * mu1_C * (1.0 + mu2_B) * mu3_A * mu3_A +
                   (1.0 + mu1_A) * (1.0 + mu1_A) * (1.0 + mu2_B) * (1.0 + mu3_C) * (1.0 + mu3_C) -
@@ -1386,7 +1062,7 @@ TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::GetValueAndDerivative(co
                   (1.0 + mu1_A) * mu1_C * mu2_A * mu3_B * (1.0 + mu3_C) -
                   (1.0 + mu1_A) * (1.0 + mu1_A) * mu2_C * mu3_B * (1.0 + mu3_C) -
                   (1.0 + mu1_A) * mu1_B * mu2_A * (1.0 + mu3_C) * (1.0 + mu3_C) - (1.0 + mu1_A) * (1.0 + mu3_C);
-        itPCp[1][1].Set(2.0 * valuePC);
+        data.PCparts[1][1][point] = 2.0 * rc * valuePC;
         /** mu2, part 3 */
         valuePC = +mu1_B * mu1_B * mu2_C * mu3_A * mu3_A + (1.0 + mu1_A) * (1.0 + mu1_A) * mu2_C * mu3_B * mu3_B -
                   mu1_B * mu1_C * (1.0 + mu2_B) * mu3_A * mu3_A +
@@ -1396,7 +1072,7 @@ TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::GetValueAndDerivative(co
                   (1.0 + mu1_A) * mu1_C * mu2_A * mu3_B * mu3_B +
                   (1.0 + mu1_A) * mu1_B * mu2_A * mu3_B * (1.0 + mu3_C) -
                   (1.0 + mu1_A) * (1.0 + mu1_A) * (1.0 + mu2_B) * mu3_B * (1.0 + mu3_C) + (1.0 + mu1_A) * mu3_B;
-        itPCp[1][2].Set(2.0 * valuePC);
+        data.PCparts[1][2][point] = 2.0 * rc * valuePC;
         /** mu3, part 1 */
         valuePC = +mu1_C * mu1_C * (1.0 + mu2_B) * (1.0 + mu2_B) * mu3_A + mu1_B * mu1_B * mu2_C * mu2_C * mu3_A -
                   2.0 * mu1_B * mu1_C * (1.0 + mu2_B) * mu2_C * mu3_A - mu1_C * mu1_C * mu2_A * (1.0 + mu2_B) * mu3_B +
@@ -1406,7 +1082,7 @@ TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::GetValueAndDerivative(co
                   mu1_B * mu1_C * mu2_A * mu2_C * mu3_B - (1.0 + mu1_A) * mu1_B * mu2_C * mu2_C * mu3_B -
                   mu1_B * mu1_B * mu2_A * mu2_C * (1.0 + mu3_C) +
                   (1.0 + mu1_A) * mu1_B * (1.0 + mu2_B) * mu2_C * (1.0 + mu3_C) + mu1_B * mu2_C;
-        itPCp[2][0].Set(2.0 * valuePC);
+        data.PCparts[2][0][point] = 2.0 * rc * valuePC;
         /** mu3, part 2 */
         valuePC = +mu1_C * mu1_C * mu2_A * mu2_A * mu3_B + (1.0 + mu1_A) * (1.0 + mu1_A) * mu2_C * mu2_C * mu3_B -
                   mu1_C * mu1_C * mu2_A * (1.0 + mu2_B) * mu3_A +
@@ -1416,7 +1092,7 @@ TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::GetValueAndDerivative(co
                   (1.0 + mu1_A) * mu1_C * mu2_A * (1.0 + mu2_B) * (1.0 + mu3_C) - mu1_C * mu2_A +
                   (1.0 + mu1_A) * mu1_B * mu2_A * mu2_C * (1.0 + mu3_C) -
                   (1.0 + mu1_A) * (1.0 + mu1_A) * (1.0 + mu2_B) * mu2_C * (1.0 + mu3_C) + (1.0 + mu1_A) * mu2_C;
-        itPCp[2][1].Set(2.0 * valuePC);
+        data.PCparts[2][1][point] = 2.0 * rc * valuePC;
         /** mu3, part 3 */
         valuePC = +mu1_B * mu1_B * mu2_A * mu2_A * (1.0 + mu3_C) +
                   (1.0 + mu1_A) * (1.0 + mu1_A) * (1.0 + mu2_B) * (1.0 + mu2_B) * (1.0 + mu3_C) +
@@ -1428,445 +1104,105 @@ TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::GetValueAndDerivative(co
                   (1.0 + mu1_A) * (1.0 + mu1_A) * (1.0 + mu2_B) * mu2_C * mu3_B -
                   2.0 * (1.0 + mu1_A) * mu1_B * mu2_A * (1.0 + mu2_B) * (1.0 + mu3_C) + mu1_B * mu2_A -
                   (1.0 + mu1_A) * (1.0 + mu2_B);
-        itPCp[2][2].Set(2.0 * valuePC);
+        data.PCparts[2][2][point] = 2.0 * rc * valuePC;
       } // end if dim == 3
+    }
 
-      /** Increase all iterators. */
-      for (unsigned int i = 0; i < ImageDimension; i++)
-      {
-        ++itA[i];
-        ++itB[i];
-        if (ImageDimension == 3)
-        {
-          ++itC[i];
-        }
-        for (unsigned int j = 0; j < ImageDimension; j++)
-        {
-          ++itPCp[i][j];
-        }
-      }
-      ++it_RCI;
-
-    } // end while
-  }   // end if do properness
-
-  /** TASK 4C:
-   * Do the calculation of the linearity parts.
-   *
-   ************************************************************************* */
-
-  /** Reset all iterators. */
-  it_RCI.GoToBegin();
-
-  if (this->m_CalculateLinearityCondition)
-  {
-    while (!itLCp[0][0].IsAtEnd())
+    /** Calculate the subparts of the derivative of the linearity condition. */
+    if (this->m_CalculateLinearityCondition)
     {
-      /** Linearity condition part. */
       for (unsigned int i = 0; i < ImageDimension; i++)
       {
-        /** Calculate the value of the linearity condition. */
-        this->m_LinearityConditionValue +=
-          it_RCI.Get() * (+itD[i].Get() * itD[i].Get() + itE[i].Get() * itE[i].Get() + itG[i].Get() * itG[i].Get());
-        if (ImageDimension == 3)
+        for (unsigned int j = 0; j < 3 * ImageDimension - 3; j++)
         {
-          this->m_LinearityConditionValue +=
-            it_RCI.Get() * (+itF[i].Get() * itF[i].Get() + itH[i].Get() * itH[i].Get() + itI[i].Get() * itI[i].Get());
-        }
-      } // end loop over i
-
-      /** Calculate the derivative of the linearity condition. */
-      if (ImageDimension == 2)
-      {
-        itLCp[0][0].Set(2.0 * itD[0].Get());
-        itLCp[0][1].Set(2.0 * itE[0].Get());
-        itLCp[0][2].Set(2.0 * itG[0].Get());
-        itLCp[1][0].Set(2.0 * itD[1].Get());
-        itLCp[1][1].Set(2.0 * itE[1].Get());
-        itLCp[1][2].Set(2.0 * itG[1].Get());
-      } // end if dim == 2
-      else if (ImageDimension == 3)
-      {
-        itLCp[0][0].Set(2.0 * itD[0].Get());
-        itLCp[0][1].Set(2.0 * itE[0].Get());
-        itLCp[0][2].Set(2.0 * itG[0].Get());
-        itLCp[0][3].Set(2.0 * itF[0].Get());
-        itLCp[0][4].Set(2.0 * itH[0].Get());
-        itLCp[0][5].Set(2.0 * itI[0].Get());
-        itLCp[1][0].Set(2.0 * itD[1].Get());
-        itLCp[1][1].Set(2.0 * itE[1].Get());
-        itLCp[1][2].Set(2.0 * itG[1].Get());
-        itLCp[1][3].Set(2.0 * itF[1].Get());
-        itLCp[1][4].Set(2.0 * itH[1].Get());
-        itLCp[1][5].Set(2.0 * itI[1].Get());
-        itLCp[2][0].Set(2.0 * itD[2].Get());
-        itLCp[2][1].Set(2.0 * itE[2].Get());
-        itLCp[2][2].Set(2.0 * itG[2].Get());
-        itLCp[2][3].Set(2.0 * itF[2].Get());
-        itLCp[2][4].Set(2.0 * itH[2].Get());
-        itLCp[2][5].Set(2.0 * itI[2].Get());
-      } // end if dim == 3
-
-      /** Increase all iterators. */
-      for (unsigned int i = 0; i < ImageDimension; i++)
-      {
-        ++itD[i];
-        ++itE[i];
-        ++itG[i];
-        if (ImageDimension == 3)
-        {
-          ++itF[i];
-          ++itH[i];
-          ++itI[i];
-        }
-        for (unsigned int j = 0; j < NofLParts; j++)
-        {
-          ++itLCp[i][j];
+          data.LCparts[i][j][point] = 2.0 * rc * filtered[ImageDimension + j][i];
         }
       }
-      ++it_RCI;
-
-    } // end while
-  }   // end if do linearity
-
-  /** TASK 5:
-   * Do the actual calculation of the rigidity penalty term value.
-   *
-   ************************************************************************* */
-
-  /** Calculate the rigidity penalty term value. */
-  if (this->m_CalculateLinearityCondition)
-  {
-    this->m_LinearityConditionValue /= rigidityCoefficientSum;
-  }
-  if (this->m_CalculateOrthonormalityCondition)
-  {
-    this->m_OrthonormalityConditionValue /= rigidityCoefficientSum;
-  }
-  if (this->m_CalculatePropernessCondition)
-  {
-    this->m_PropernessConditionValue /= rigidityCoefficientSum;
-  }
+    }
+  } // end for x0
 
-  if (this->m_UseLinearityCondition)
-  {
-    this->m_RigidityPenaltyTermValue += this->m_LinearityConditionWeight * this->m_LinearityConditionValue;
-  }
-  if (this->m_UseOrthonormalityCondition)
-  {
-    this->m_RigidityPenaltyTermValue += this->m_OrthonormalityConditionWeight * this->m_OrthonormalityConditionValue;
-  }
-  if (this->m_UsePropernessCondition)
-  {
-    this->m_RigidityPenaltyTermValue += this->m_PropernessConditionWeight * this->m_PropernessConditionValue;
-  }
-  value = this->m_RigidityPenaltyTermValue;
+  /** Store the values of this line. */
+  data.LineSums[3 * line] = lineValueOC;
+  data.LineSums[3 * line + 1] = lineValuePC;
+  data.LineSums[3 * line + 2] = lineValueLC;
 
-  /** TASK 6:
-   * Create filtered versions of the subparts.
-   * Create all necessary iterators and operators.
-   ************************************************************************* */
+} // end ComputeConditionsOnLine()
 
-  /** Create filtered orthonormality, properness and linearity parts. */
-  std::vector<CoefficientImagePointer> OCpartsF(ImageDimension);
-  std::vector<CoefficientImagePointer> PCpartsF(ImageDimension);
-  std::vector<CoefficientImagePointer> LCpartsF(ImageDimension);
-  for (unsigned int i = 0; i < ImageDimension; i++)
-  {
-    OCpartsF[i] = CoefficientImageType::New();
-    OCpartsF[i]->SetRegions(inputImages[0]->GetLargestPossibleRegion());
-    OCpartsF[i]->Allocate();
-    PCpartsF[i] = CoefficientImageType::New();
-    PCpartsF[i]->SetRegions(inputImages[0]->GetLargestPossibleRegion());
-    PCpartsF[i]->Allocate();
-    LCpartsF[i] = CoefficientImageType::New();
-    LCpartsF[i]->SetRegions(inputImages[0]->GetLargestPossibleRegion());
-    LCpartsF[i]->Allocate();
-  }
-
-  /** Create neighborhood iterators over the subparts. */
-  std::vector<std::vector<NeighborhoodIteratorType>> nitOCp(ImageDimension);
-  std::vector<std::vector<NeighborhoodIteratorType>> nitPCp(ImageDimension);
-  std::vector<std::vector<NeighborhoodIteratorType>> nitLCp(ImageDimension);
-  RadiusType                                         radius;
-  radius.Fill(1);
-  for (unsigned int i = 0; i < ImageDimension; i++)
-  {
-    nitOCp[i].resize(ImageDimension);
-    nitPCp[i].resize(ImageDimension);
-    nitLCp[i].resize(NofLParts);
-    for (unsigned int j = 0; j < ImageDimension; j++)
-    {
-      nitOCp[i][j] = NeighborhoodIteratorType(radius, OCparts[i][j], OCparts[i][j]->GetLargestPossibleRegion());
-      nitOCp[i][j].GoToBegin();
-      nitPCp[i][j] = NeighborhoodIteratorType(radius, PCparts[i][j], PCparts[i][j]->GetLargestPossibleRegion());
-      nitPCp[i][j].GoToBegin();
-    }
-    for (unsigned int j = 0; j < NofLParts; j++)
-    {
-      nitLCp[i][j] = NeighborhoodIteratorType(radius, LCparts[i][j], LCparts[i][j]->GetLargestPossibleRegion());
-      nitLCp[i][j].GoToBegin();
-    }
-  }
 
-  /** Create iterators over the filtered parts. */
-  std::vector<CoefficientImageIteratorType> itOCpf(ImageDimension);
-  std::vector<CoefficientImageIteratorType> itPCpf(ImageDimension);
-  std::vector<CoefficientImageIteratorType> itLCpf(ImageDimension);
-  for (unsigned int i = 0; i < ImageDimension; i++)
-  {
-    itOCpf[i] = CoefficientImageIteratorType(OCpartsF[i], OCpartsF[i]->GetLargestPossibleRegion());
-    itOCpf[i].GoToBegin();
-    itPCpf[i] = CoefficientImageIteratorType(PCpartsF[i], PCpartsF[i]->GetLargestPossibleRegion());
-    itPCpf[i].GoToBegin();
-    itLCpf[i] = CoefficientImageIteratorType(LCpartsF[i], LCpartsF[i]->GetLargestPossibleRegion());
-    itLCpf[i].GoToBegin();
-  }
+/**
+ * ********************* ComputeDerivativeOnLine ****************
+ */
 
-  /** Create a neigborhood iterator over the rigidity image. */
-  NeighborhoodIteratorType nit_RCI(
-    radius, this->m_RigidityCoefficientImage, this->m_RigidityCoefficientImage->GetLargestPossibleRegion());
-  nit_RCI.GoToBegin();
-  unsigned int neighborhoodSize = nit_RCI.Size();
+template <class TFixedImage, class TScalarType>
+void
+TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::ComputeDerivativeOnLine(const GridDataType & data,
+                                                                                const SizeValueType  line) const
+{
+  const ScalarType * derivativeStencils = this->m_DerivativeStencils.data();
+  const double       rigidityCoefficientSumSqr = data.RigidityCoefficientSum * data.RigidityCoefficientSum;
 
-  /** Create ND operators. */
-  NeighborhoodType Operator_A, Operator_B, Operator_C, Operator_D, Operator_E, Operator_F, Operator_G, Operator_H,
-    Operator_I;
-  this->CreateNDOperator(Operator_A, "FA", spacing);
-  this->CreateNDOperator(Operator_B, "FB", spacing);
-  if (ImageDimension == 3)
-  {
-    this->CreateNDOperator(Operator_C, "FC", spacing);
-  }
+  SizeValueType lineOffsets[StencilSize / 3];
+  SizeValueType neighbours[StencilSize];
+  MeasureType   gradMagLC = NumericTraits<MeasureType>::Zero;
+  MeasureType   gradMagOC = NumericTraits<MeasureType>::Zero;
+  MeasureType   gradMagPC = NumericTraits<MeasureType>::Zero;
 
-  if (this->m_CalculateLinearityCondition)
+  this->ComputeLineOffsets(data, line, lineOffsets);
+  for (SizeValueType x0 = 0; x0 < data.GridSize[0]; ++x0)
   {
-    this->CreateNDOperator(Operator_D, "FD", spacing);
-    this->CreateNDOperator(Operator_E, "FE", spacing);
-    this->CreateNDOperator(Operator_G, "FG", spacing);
-    if (ImageDimension == 3)
-    {
-      this->CreateNDOperator(Operator_F, "FF", spacing);
-      this->CreateNDOperator(Operator_H, "FH", spacing);
-      this->CreateNDOperator(Operator_I, "FI", spacing);
-    }
-  }
-
-  /** TASK 7A:
-   * Calculate the filtered versions of the orthonormality subparts.
-   * These are F_A * {subpart_0} + F_B * {subpart_1},
-   * and (for 3D) + F_C * {subpart_2}, for all dimensions.
-   ************************************************************************* */
+    const SizeValueType point = line * data.GridSize[0] + x0;
+    this->ComputeNeighbours(data, lineOffsets, x0, neighbours);
 
-  if (this->m_CalculateOrthonormalityCondition)
-  {
-    while (!itOCpf[0].IsAtEnd())
+    /** Filter the subparts, which were already multiplied by the rigidity coefficients.
+     * The orthonormality and properness subparts are filtered with F_A, F_B (and F_C),
+     * the linearity subparts with F_D, F_E, F_G (and F_F, F_H, F_I).
+     */
+    for (unsigned int i = 0; i < ImageDimension; i++)
     {
-      /** Create and reset tmp with zeros. */
-      std::vector<double> tmp(ImageDimension, 0.0);
-
-      /** Loop over all dimensions. */
-      for (unsigned int i = 0; i < ImageDimension; i++)
+      ScalarType tmpOC = NumericTraits<ScalarType>::Zero;
+      ScalarType tmpPC = NumericTraits<ScalarType>::Zero;
+      ScalarType tmpLC = NumericTraits<ScalarType>::Zero;
+      if (this->m_CalculateOrthonormalityCondition)
       {
-        /** Loop over the neighborhood. */
-        for (unsigned int k = 0; k < neighborhoodSize; ++k)
+        for (unsigned int k = 0; k < StencilSize; ++k)
         {
-          /** Calculation of the inner product. */
-          tmp[i] += Operator_A.GetElement(k)   // FA *
-                    * nitOCp[i][0].GetPixel(k) // subpart[ i ][ 0 ]
-                    * nit_RCI.GetPixel(k);     // c(k)
-          tmp[i] += Operator_B.GetElement(k)   // FB *
-                    * nitOCp[i][1].GetPixel(k) // subpart[ i ][ 1 ]
-                    * nit_RCI.GetPixel(k);     // c(k)
-          if (ImageDimension == 3)
+          for (unsigned int j = 0; j < ImageDimension; j++)
           {
-            tmp[i] += Operator_C.GetElement(k)   // FC *
-                      * nitOCp[i][2].GetPixel(k) // subpart[ i ][ 2 ]
-                      * nit_RCI.GetPixel(k);     // c(k)
+            tmpOC += derivativeStencils[j * StencilSize + k] * data.OCparts[i][j][neighbours[k]];
           }
-        } // end loop over neighborhood
-
-        /** Set the result in the filtered part. */
-        itOCpf[i].Set(tmp[i]);
-
-      } // end loop over dimension i
-
-      /** Increase all iterators. */
-      ++nit_RCI;
-      for (unsigned int i = 0; i < ImageDimension; i++)
-      {
-        ++itOCpf[i];
-        for (unsigned int j = 0; j < ImageDimension; j++)
-        {
-          ++nitOCp[i][j];
         }
       }
-    } // end while
-  }   // end if do orthonormality
-
-  /** TASK 7B:
-   * Calculate the filtered versions of the properness subparts.
-   * These are F_A * {subpart_0} + F_B * {subpart_1},
-   * and (for 3D) + F_C * {subpart_2}, for all dimensions.
-   ************************************************************************* */
-
-  nit_RCI.GoToBegin();
-  if (this->m_CalculatePropernessCondition)
-  {
-    while (!itPCpf[0].IsAtEnd())
-    {
-      /** Create and reset tmp with zeros. */
-      std::vector<double> tmp(ImageDimension, 0.0);
-
-      /** Loop over all dimensions. */
-      for (unsigned int i = 0; i < ImageDimension; i++)
+      if (this->m_CalculatePropernessCondition)
       {
-        /** Loop over the neighborhood. */
-        for (unsigned int k = 0; k < neighborhoodSize; ++k)
+        for (unsigned int k = 0; k < StencilSize; ++k)
         {
-          /** Calculation of the inner product. */
-          tmp[i] += Operator_A.GetElement(k)   // FA *
-                    * nitPCp[i][0].GetPixel(k) // subpart[ i ][ 0 ]
-                    * nit_RCI.GetPixel(k);     // c(k)
-          tmp[i] += Operator_B.GetElement(k)   // FB *
-                    * nitPCp[i][1].GetPixel(k) // subpart[ i ][ 1 ]
-                    * nit_RCI.GetPixel(k);     // c(k)
-          if (ImageDimension == 3)
+          for (unsigned int j = 0; j < ImageDimension; j++)
           {
-            tmp[i] += Operator_C.GetElement(k)   // FC *
-                      * nitPCp[i][2].GetPixel(k) // subpart[ i ][ 2 ]
-                      * nit_RCI.GetPixel(k);     // c(k)
+            tmpPC += derivativeStencils[j * StencilSize + k] * data.PCparts[i][j][neighbours[k]];
           }
-        } // end loop over neighborhood
-
-        /** Set the result in the filtered part. */
-        itPCpf[i].Set(tmp[i]);
-
-      } // end loop over dimension i
-
-      /** Increase all iterators. */
-      ++nit_RCI;
-      for (unsigned int i = 0; i < ImageDimension; i++)
-      {
-        ++itPCpf[i];
-        for (unsigned int j = 0; j < ImageDimension; j++)
-        {
-          ++nitPCp[i][j];
         }
       }
-    } // end while
-  }   // end if do properness
-
-  /** TASK 7C:
-   * Calculate the filtered versions of the linearity subparts.
-   * These are sum_{i=1}^{NofLParts} F_{D,E,G,F,H,I} * {subpart_i}.
-   ************************************************************************* */
-
-  nit_RCI.GoToBegin();
-  if (this->m_CalculateLinearityCondition)
-  {
-    while (!itLCpf[0].IsAtEnd())
-    {
-      /** Create and reset tmp with zeros. */
-      std::vector<double> tmp(ImageDimension, 0.0);
-
-      /** Loop over all dimensions. */
-      for (unsigned int i = 0; i < ImageDimension; i++)
+      if (this->m_CalculateLinearityCondition)
       {
-        /** Loop over the neighborhood. */
-        for (unsigned int k = 0; k < neighborhoodSize; ++k)
+        for (unsigned int k = 0; k < StencilSize; ++k)
         {
-          /** Calculation of the inner product. */
-          tmp[i] += Operator_D.GetElement(k)   // FD *
-                    * nitLCp[i][0].GetPixel(k) // subpart[ i ][ 0 ]
-                    * nit_RCI.GetPixel(k);     // c(k)
-          tmp[i] += Operator_E.GetElement(k)   // FE *
-                    * nitLCp[i][1].GetPixel(k) // subpart[ i ][ 1 ]
-                    * nit_RCI.GetPixel(k);     // c(k)
-          tmp[i] += Operator_G.GetElement(k)   // FG *
-                    * nitLCp[i][2].GetPixel(k) // subpart[ i ][ 1 ]
-                    * nit_RCI.GetPixel(k);     // c(k)
-          if (ImageDimension == 3)
+          for (unsigned int j = 0; j < 3 * ImageDimension - 3; j++)
           {
-            tmp[i] += Operator_F.GetElement(k)   // FF *
-                      * nitLCp[i][3].GetPixel(k) // subpart[ i ][ 1 ]
-                      * nit_RCI.GetPixel(k);     // c(k)
-            tmp[i] += Operator_H.GetElement(k)   // FH *
-                      * nitLCp[i][4].GetPixel(k) // subpart[ i ][ 1 ]
-                      * nit_RCI.GetPixel(k);     // c(k)
-            tmp[i] += Operator_I.GetElement(k)   // FI *
-                      * nitLCp[i][5].GetPixel(k) // subpart[ i ][ 1 ]
-                      * nit_RCI.GetPixel(k);     // c(k)
+            tmpLC += derivativeStencils[(ImageDimension + j) * StencilSize + k] * data.LCparts[i][j][neighbours[k]];
           }
-        } // end loop over neighborhood
-
-        /** Set the result in the filtered part. */
-        itLCpf[i].Set(tmp[i]);
-
-      } // end loop over dimension i
-
-      /** Increase all iterators. */
-      ++nit_RCI;
-      for (unsigned int i = 0; i < ImageDimension; i++)
-      {
-        ++itLCpf[i];
-        for (unsigned int j = 0; j < NofLParts; j++)
-        {
-          ++nitLCp[i][j];
         }
       }
-    } // end while
-  }   // end if do linearity
-
-  /** TASK 8:
-   * Add it all to create the final derivative images.
-   ************************************************************************* */
-
-  /** Create derivative images, each holding a component of the vector field. */
-  std::vector<CoefficientImagePointer> derivativeImages(ImageDimension);
-  for (unsigned int i = 0; i < ImageDimension; i++)
-  {
-    derivativeImages[i] = CoefficientImageType::New();
-    derivativeImages[i]->SetRegions(inputImages[i]->GetLargestPossibleRegion());
-    derivativeImages[i]->Allocate();
-  }
-
-  /** Create iterators over the derivative images. */
-  std::vector<CoefficientImageIteratorType> itDIs(ImageDimension);
-  for (unsigned int i = 0; i < ImageDimension; i++)
-  {
-    itDIs[i] = CoefficientImageIteratorType(derivativeImages[i], derivativeImages[i]->GetLargestPossibleRegion());
-    itDIs[i].GoToBegin();
-    itOCpf[i].GoToBegin();
-    itPCpf[i].GoToBegin();
-    itLCpf[i].GoToBegin();
-  }
 
-  /** Do the addition. */
-  // NOTE: unlike the values, for the derivatives weight * derivative is returned.
-  MeasureType gradMagLC = NumericTraits<MeasureType>::Zero;
-  MeasureType gradMagOC = NumericTraits<MeasureType>::Zero;
-  MeasureType gradMagPC = NumericTraits<MeasureType>::Zero;
-  double      rigidityCoefficientSumSqr = rigidityCoefficientSum * rigidityCoefficientSum;
-  while (!itDIs[0].IsAtEnd())
-  {
-    for (unsigned int i = 0; i < ImageDimension; i++)
-    {
+      /** Compute the gradient magnitudes and the derivative contribution.
+       * NOTE: unlike the values, for the derivatives weight * derivative is returned.
+       */
       ScalarType tmpDIs = NumericTraits<ScalarType>::Zero;
-
-      /** Compute gradient magnitude of LC. */
-      ScalarType tmpLC = this->m_LinearityConditionWeight * itLCpf[i].Get();
+      tmpLC *= this->m_LinearityConditionWeight;
       gradMagLC += tmpLC * tmpLC / rigidityCoefficientSumSqr;
-
-      /** Compute gradient magnitude of OC. */
-      ScalarType tmpOC = this->m_OrthonormalityConditionWeight * itOCpf[i].Get();
+      tmpOC *= this->m_OrthonormalityConditionWeight;
       gradMagOC += tmpOC * tmpOC / rigidityCoefficientSumSqr;
-
-      /** Compute gradient magnitude of PC. */
-      ScalarType tmpPC = this->m_PropernessConditionWeight * itPCpf[i].Get();
+      tmpPC *= this->m_PropernessConditionWeight;
       gradMagPC += tmpPC * tmpPC / rigidityCoefficientSumSqr;
-
-      /** Compute derivative contribution. */
       if (this->m_UseLinearityCondition)
       {
         tmpDIs += tmpLC;
@@ -1879,35 +1215,137 @@ TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::GetValueAndDerivative(co
       {
         tmpDIs += tmpPC;
       }
-      itDIs[i].Set(tmpDIs);
+      data.Derivative[i * data.NumberOfPoints + point] = tmpDIs / data.RigidityCoefficientSum;
+    } // end for i
+  }   // end for x0
+
+  /** Store the squared gradient magnitudes of this line. */
+  data.LineSums[3 * line] = gradMagOC;
+  data.LineSums[3 * line + 1] = gradMagPC;
+  data.LineSums[3 * line + 2] = gradMagLC;
+
+} // end ComputeDerivativeOnLine()
+
+
+/**
+ * ********************* ComputeLineOffsets ****************
+ */
+
+template <class TFixedImage, class TScalarType>
+void
+TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::ComputeLineOffsets(const GridDataType & data,
+                                                                           const SizeValueType  line,
+                                                                           SizeValueType        lineOffsets[]) const
+{
+  /** Get the grid index of the line along the dimensions 1, ..., D - 1. */
+  SizeValueType lineIndex[ImageDimension];
+  SizeValueType remainder = line;
+  for (unsigned int d = 1; d < ImageDimension; d++)
+  {
+    lineIndex[d] = remainder % data.GridSize[d];
+    remainder /= data.GridSize[d];
+  }
 
-      /** Update iterators. */
-      ++itDIs[i];
-      ++itOCpf[i];
-      ++itPCpf[i];
-      ++itLCpf[i];
+  /** Compute the buffer offsets of the neighbouring lines. At the border of the grid the
+   * line itself is used, like the ZeroFluxNeumannBoundaryCondition does.
+   */
+  for (unsigned int k = 0; k < StencilSize / 3; ++k)
+  {
+    SizeValueType offset = 0;
+    SizeValueType stride = data.GridSize[0];
+    unsigned int  which = k;
+    for (unsigned int d = 1; d < ImageDimension; d++)
+    {
+      SizeValueType index = lineIndex[d];
+      if (which % 3 == 0 && index > 0)
+      {
+        --index;
+      }
+      else if (which % 3 == 2 && index + 1 < data.GridSize[d])
+      {
+        ++index;
+      }
+      offset += index * stride;
+      stride *= data.GridSize[d];
+      which /= 3;
     }
-  } // end while
+    lineOffsets[k] = offset;
+  }
 
-  /** Set the gradient magnitudes of the several terms. */
-  this->m_LinearityConditionGradientMagnitude = std::sqrt(gradMagLC);
-  this->m_OrthonormalityConditionGradientMagnitude = std::sqrt(gradMagOC);
-  this->m_PropernessConditionGradientMagnitude = std::sqrt(gradMagPC);
+} // end ComputeLineOffsets()
 
-  /** Rearrange to create a derivative. */
-  unsigned int j = 0;
-  for (unsigned int i = 0; i < ImageDimension; i++)
+
+/**
+ * ********************* ComputeNeighbours ****************
+ */
+
+template <class TFixedImage, class TScalarType>
+void
+TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::ComputeNeighbours(const GridDataType & data,
+                                                                          const SizeValueType  lineOffsets[],
+                                                                          const SizeValueType  x0,
+                                                                          SizeValueType        neighbours[]) const
+{
+  /** The neighbours are ordered like the elements of a Neighborhood, so with dimension 0 running fastest. */
+  const SizeValueType previous = x0 > 0 ? x0 - 1 : x0;
+  const SizeValueType next = x0 + 1 < data.GridSize[0] ? x0 + 1 : x0;
+  for (unsigned int k = 0; k < StencilSize; k += 3)
+  {
+    neighbours[k] = lineOffsets[k / 3] + previous;
+    neighbours[k + 1] = lineOffsets[k / 3] + x0;
+    neighbours[k + 2] = lineOffsets[k / 3] + next;
+  }
+
+} // end ComputeNeighbours()
+
+
+/**
+ * ************************ CreateStencils *********************
+ */
+
+template <class TFixedImage, class TScalarType>
+void
+TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::CreateStencils(
+  const CoefficientImageSpacingType & spacing) const
+{
+  /** The operators A, B (and C) of the orthonormality and properness conditions,
+   * followed by the operators D, E, G (and F, H, I) of the linearity condition.
+   */
+  const char * const operatorNames[] = { "FA", "FB", "FC", "FD", "FE", "FG", "FF", "FH", "FI" };
+
+  this->m_FilterStencils.resize(NumberOfOperators * StencilSize);
+  this->m_DerivativeStencils.resize(NumberOfOperators * StencilSize);
+  for (unsigned int op = 0; op < NumberOfOperators; ++op)
   {
-    itDIs[i].GoToBegin();
-    while (!itDIs[i].IsAtEnd())
+    const std::string whichF = op < ImageDimension ? operatorNames[op] : operatorNames[3 + op - ImageDimension];
+
+    /** Create the 1D operators of the separable filter and the ND operator of the derivative. */
+    std::vector<NeighborhoodType> operators1D(ImageDimension);
+    for (unsigned int i = 0; i < ImageDimension; i++)
     {
-      derivative[j] = itDIs[i].Get() / rigidityCoefficientSum;
-      ++itDIs[i];
-      j++;
-    } // end while
-  }   // end for
+      this->Create1DOperator(operators1D[i], whichF + "_xi", i + 1, spacing);
+    }
+    NeighborhoodType operatorND;
+    this->CreateNDOperator(operatorND, whichF, spacing);
 
-} // end GetValueAndDerivative()
+    /** The stencil of the separable filter is the outer product of the 1D operators. */
+    for (unsigned int k = 0; k < StencilSize; ++k)
+    {
+      ScalarType   weight = NumericTraits<ScalarType>::One;
+      unsigned int which = k;
+      for (unsigned int i = 0; i < ImageDimension; i++)
+      {
+        weight *= operators1D[i][which % 3];
+        which /= 3;
+      }
+      this->m_FilterStencils[op * StencilSize + k] = weight;
+      this->m_DerivativeStencils[op * StencilSize + k] = operatorND[k];
+    }
+  }
+
+  this->m_StencilSpacing = spacing;
+
+} // end CreateStencils()
 
 
 /**
@@ -2157,40 +1595,6 @@ TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::Create1DOperator(
 } // end Create1DOperator()
 
 
-/**
- * ************************** FilterSeparable ********************
- */
-
-template <class TFixedImage, class TScalarType>
-typename TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::CoefficientImagePointer
-TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::FilterSeparable(
-  const CoefficientImageType *          image,
-  const std::vector<NeighborhoodType> & Operators) const
-{
-  /** Create filters, supply them with boundary conditions and operators. */
-  std::vector<typename NOIFType::Pointer> filters(ImageDimension);
-  for (unsigned int i = 0; i < ImageDimension; i++)
-  {
-    filters[i] = NOIFType::New();
-    filters[i]->SetOperator(Operators[i]);
-  }
-
-  /** Set up the mini-pipline. */
-  filters[0]->SetInput(image);
-  for (unsigned int i = 1; i < ImageDimension; i++)
-  {
-    filters[i]->SetInput(filters[i - 1]->GetOutput());
-  }
-
-  /** Execute the mini-pipeline. */
-  filters[ImageDimension - 1]->Update();
-
-  /** Return the filtered image. */
-  return filters[ImageDimension - 1]->GetOutput();
-
-} // end FilterSeparable()
-
-
 /**
  * ************************ CreateNDOperator *********************
  */
@@ -691,9 +691,8 @@ SumSquaredTissueVolumeDifferenceImageToImageMetric<TFixedImage, TMovingImage>::A
     this->m_ThreaderMetricParameters.st_NormalizationFactor =
       static_cast<DerivativeValueType>(this->m_NumberOfPixelsCounted);
 
-    this->m_Threader->SetSingleMethod(this->AccumulateDerivativesThreaderCallback,
-                                      const_cast<void *>(static_cast<const void *>(&this->m_ThreaderMetricParameters)));
-    this->m_Threader->SingleMethodExecute();
+    this->LaunchThreaderCallback(this->AccumulateDerivativesThreaderCallback,
+                                 const_cast<void *>(static_cast<const void *>(&this->m_ThreaderMetricParameters)));
   }
 
 #ifdef ELASTIX_USE_OPENMP
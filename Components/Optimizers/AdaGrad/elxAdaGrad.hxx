@@ -633,6 +633,7 @@ AdaGrad<TElastix>::AutomaticPreconditionerEstimation(void)
   computeDisplacementDistribution->SetTransform(this->GetRegistration()->GetAsITKBaseType()->GetModifiableTransform());
   computeDisplacementDistribution->SetCostFunction(this->m_CostFunction);
   computeDisplacementDistribution->SetNumberOfJacobianMeasurements(this->m_NumberOfJacobianMeasurements);
+  computeDisplacementDistribution->SetUseThreadPool(testPtr->GetUseThreadPool());
 
 
   std::string maximumDisplacementEstimationMethod = "2sigma";
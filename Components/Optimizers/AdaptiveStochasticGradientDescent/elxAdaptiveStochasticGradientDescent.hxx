@@ -536,6 +536,7 @@ AdaptiveStochasticGradientDescent<TElastix>::AutomaticParameterEstimationOrigina
   computeJacobianTerms->SetMaxBandCovSize(this->m_MaxBandCovSize);
   computeJacobianTerms->SetNumberOfBandStructureSamples(this->m_NumberOfBandStructureSamples);
   computeJacobianTerms->SetNumberOfJacobianMeasurements(this->m_NumberOfJacobianMeasurements);
+  computeJacobianTerms->SetUseThreadPool(testPtr->GetUseThreadPool());
 
   /** Check if use scales. */
   bool useScales = this->GetUseScales();
@@ -675,6 +676,7 @@ AdaptiveStochasticGradientDescent<TElastix>::AutomaticParameterEstimationUsingDi
   computeDisplacementDistribution->SetTransform(this->GetRegistration()->GetAsITKBaseType()->GetModifiableTransform());
   computeDisplacementDistribution->SetCostFunction(this->m_CostFunction);
   computeDisplacementDistribution->SetNumberOfJacobianMeasurements(this->m_NumberOfJacobianMeasurements);
+  computeDisplacementDistribution->SetUseThreadPool(testPtr->GetUseThreadPool());
 
   /** Check if use scales. */
   if (this->GetUseScales())
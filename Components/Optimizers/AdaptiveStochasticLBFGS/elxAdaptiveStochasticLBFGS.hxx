@@ -940,6 +940,7 @@ AdaptiveStochasticLBFGS<TElastix>::AutomaticParameterEstimationOriginal(void)
   computeJacobianTerms->SetMaxBandCovSize(this->m_MaxBandCovSize);
   computeJacobianTerms->SetNumberOfBandStructureSamples(this->m_NumberOfBandStructureSamples);
   computeJacobianTerms->SetNumberOfJacobianMeasurements(this->m_NumberOfJacobianMeasurements);
+  computeJacobianTerms->SetUseThreadPool(testPtr->GetUseThreadPool());
 
   /** Check if use scales. */
   bool useScales = this->GetUseScales();
@@ -1079,6 +1080,7 @@ AdaptiveStochasticLBFGS<TElastix>::AutomaticParameterEstimationUsingDisplacement
   computeDisplacementDistribution->SetTransform(this->GetRegistration()->GetAsITKBaseType()->GetModifiableTransform());
   computeDisplacementDistribution->SetCostFunction(this->m_CostFunction);
   computeDisplacementDistribution->SetNumberOfJacobianMeasurements(this->m_NumberOfJacobianMeasurements);
+  computeDisplacementDistribution->SetUseThreadPool(testPtr->GetUseThreadPool());
 
   /** Check if use scales. */
   if (this->GetUseScales())
@@ -1190,6 +1192,7 @@ AdaptiveStochasticLBFGS<TElastix>::AutomaticLBFGSStepsizeEstimation(void)
   computeDisplacementDistribution->SetTransform(this->GetRegistration()->GetAsITKBaseType()->GetModifiableTransform());
   computeDisplacementDistribution->SetCostFunction(this->m_CostFunction);
   computeDisplacementDistribution->SetNumberOfJacobianMeasurements(this->m_NumberOfJacobianMeasurements);
+  computeDisplacementDistribution->SetUseThreadPool(testPtr->GetUseThreadPool());
 
   /** Check if use scales. */
   if (this->GetUseScales())
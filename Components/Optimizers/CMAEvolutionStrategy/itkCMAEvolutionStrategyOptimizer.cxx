@@ -24,6 +24,7 @@
 #include "itkCommand.h"
 #include "itkEventObject.h"
 #include "itkMacro.h"
+#include "itkMultiThreaderBase.h"
 
 namespace itk
 {
@@ -735,44 +736,58 @@ CMAEvolutionStrategyOptimizer::UpdateC(void)
   const double       mu_cov = this->m_CovarianceMatrixAdaptationWeight;
   const double       sigma = this->m_CurrentSigma;
 
-  /** Multiply old m_C with some factor */
+  /** Factor for the old m_C */
   double oldCfactor = 1.0 - c_cov;
   if (!this->m_Heaviside)
   {
     oldCfactor += (c_cov * c_c * (2.0 - c_c) / mu_cov);
   }
-  this->m_C *= oldCfactor;
 
-  /** Do rank-one update */
-  const double rankonefactor = c_cov / mu_cov;
-  for (unsigned int i = 0; i < N; ++i)
+  /** The weighted search directions of the rank-mu update */
+  const double           rankonefactor = c_cov / mu_cov;
+  const double           rankmufactor = c_cov * (1.0 - 1.0 / mu_cov);
+  ParameterContainerType weightedSearchDirs(mu);
+  for (unsigned int m = 0; m < mu; ++m)
   {
+    const unsigned int lam = this->m_CostFunctionValues[m].second;
+    const double       sqrtweight = std::sqrt(this->m_RecombinationWeights[m]);
+    weightedSearchDirs[m] = this->m_SearchDirs[lam];
+    weightedSearchDirs[m] *= (sqrtweight / sigma);
+  }
+
+  /** Multiply old m_C with some factor, and do the rank-one and rank-mu
+   * updates, row by row. The rows are independent, and are computed in
+   * parallel for larger numbers of parameters. */
+  const auto updateRow = [&](SizeValueType i) {
+    double *     C_i = this->m_C[i];
     const double evolutionPath_i = this->m_EvolutionPath[i];
     for (unsigned int j = 0; j < N; ++j)
     {
-      const double update = rankonefactor * evolutionPath_i * this->m_EvolutionPath[j];
-      this->m_C[i][j] += update;
+      C_i[j] *= oldCfactor;
+      C_i[j] += rankonefactor * evolutionPath_i * this->m_EvolutionPath[j];
     }
-  }
-
-  /** Do rank-mu update */
-  const double rankmufactor = c_cov * (1.0 - 1.0 / mu_cov);
-  for (unsigned int m = 0; m < mu; ++m)
-  {
-    const unsigned int lam = this->m_CostFunctionValues[m].second;
-    const double       sqrtweight = std::sqrt(this->m_RecombinationWeights[m]);
-    ParametersType     weightedSearchDir = this->m_SearchDirs[lam];
-    weightedSearchDir *= (sqrtweight / sigma);
-    for (unsigned int i = 0; i < N; ++i)
+    for (unsigned int m = 0; m < mu; ++m)
     {
-      const double weightedSearchDir_i = weightedSearchDir[i];
+      const ParametersType & weightedSearchDir = weightedSearchDirs[m];
+      const double           weightedSearchDir_i = weightedSearchDir[i];
       for (unsigned int j = 0; j < N; ++j)
       {
-        const double update = rankmufactor * weightedSearchDir_i * weightedSearchDir[j];
-        this->m_C[i][j] += update;
+        C_i[j] += rankmufactor * weightedSearchDir_i * weightedSearchDir[j];
       }
     }
-  } // end for m
+  };
+
+  if (N >= 64)
+  {
+    MultiThreaderBase::New()->ParallelizeArray(0, N, updateRow, nullptr);
+  }
+  else
+  {
+    for (unsigned int i = 0; i < N; ++i)
+    {
+      updateRow(i);
+    }
+  }
 
 } // end UpdateC
 
@@ -48,6 +48,16 @@ namespace elastix
  *   This varies the second transform parameter in the range [-4.0 3.0] with steps of 1.0
  *   and the third parameter in the range [-1.0 1.0] with steps of 0.5. The names are used
  *   as column headers in the screen output.
+ * \parameter FullSearchNumberOfRefinementLevels: Enables a coarse-to-fine search with this number of
+ *   refinement levels. The search space is first scanned with a step of 2^levels grid points; at each
+ *   next level the step is halved and only the neighbourhoods of the best grid points are scanned.
+ *   Grid points that are not scanned are NaN in the OptimizationSurface image. \n
+ *   example: <tt>(FullSearchNumberOfRefinementLevels 3 2)</tt> \n
+ *   Can be given for each resolution. Default: 0, which scans the full search space.
+ * \parameter FullSearchNumberOfBestCells: The number of best grid points around which the
+ *   coarse-to-fine search is refined. \n
+ *   example: <tt>(FullSearchNumberOfBestCells 4)</tt> \n
+ *   Can be given for each resolution. Default: 1.
  *
  * \ingroup Optimizers
  * \sa FullSearchOptimizer
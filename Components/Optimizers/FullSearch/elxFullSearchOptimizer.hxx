@@ -144,6 +144,16 @@ FullSearch<TElastix>::BeforeEachResolution(void)
 
   if (realGood)
   {
+    /** Read the settings of the coarse-to-fine search. */
+    unsigned int numberOfRefinementLevels = 0;
+    unsigned int numberOfBestCells = 1;
+    this->GetConfiguration()->ReadParameter(
+      numberOfRefinementLevels, "FullSearchNumberOfRefinementLevels", this->GetComponentLabel(), level, 0);
+    this->GetConfiguration()->ReadParameter(
+      numberOfBestCells, "FullSearchNumberOfBestCells", this->GetComponentLabel(), level, 0);
+    this->SetNumberOfRefinementLevels(numberOfRefinementLevels);
+    this->SetNumberOfBestCells(numberOfBestCells);
+
     /** The number of dimensions. */
     nrOfSearchSpaceDimensions = this->GetNumberOfSearchSpaceDimensions();
 
@@ -157,6 +167,9 @@ FullSearch<TElastix>::BeforeEachResolution(void)
     this->m_OptimizationSurface->Allocate();
     /** \todo try/catch block around Allocate? */
 
+    /** Grid points that are skipped by the coarse-to-fine search remain NaN. */
+    this->m_OptimizationSurface->FillBuffer(itk::NumericTraits<float>::quiet_NaN());
+
     /** Set the name of this image on disk. */
     std::string resultImageFormat = "mhd";
     this->m_Configuration->ReadParameter(resultImageFormat, "ResultImageFormat", 0, false);
@@ -165,8 +178,16 @@ FullSearch<TElastix>::BeforeEachResolution(void)
                << this->GetConfiguration()->GetElastixLevel() << ".R" << level << "." << resultImageFormat;
     this->m_OptimizationSurface->SetOutputFileName(makeString.str().c_str());
 
-    elxout << "Total number of iterations needed in this resolution: " << this->GetNumberOfIterations() << "."
-           << std::endl;
+    if (this->GetNumberOfRefinementLevels() > 0)
+    {
+      elxout << "Maximum number of iterations needed in this resolution: " << this->GetNumberOfIterations() << "."
+             << std::endl;
+    }
+    else
+    {
+      elxout << "Total number of iterations needed in this resolution: " << this->GetNumberOfIterations() << "."
+             << std::endl;
+    }
   }
   else
   {
@@ -21,6 +21,8 @@
 #include "itkEventObject.h"
 #include "itkMacro.h"
 #include "itkNumericTraits.h"
+#include <algorithm>
+#include <set>
 
 namespace itk
 {
@@ -41,6 +43,10 @@ FullSearchOptimizer::FullSearchOptimizer()
   m_NumberOfSearchSpaceDimensions = 0;
   m_SearchSpace = nullptr;
   m_LastSearchSpaceChanges = 0;
+  m_NumberOfRefinementLevels = 0;
+  m_NumberOfBestCells = 1;
+  m_NextCandidate = 0;
+  m_CurrentLevel = 0;
 
 } // end constructor
 
@@ -75,6 +81,16 @@ FullSearchOptimizer::StartOptimization(void)
     m_BestValue = NumericTraits<double>::max();
   }
 
+  /** Initialise the search state; the coarse-to-fine search starts at the coarsest level. */
+  m_NextCandidate = 0;
+  m_CurrentLevel = m_NumberOfRefinementLevels;
+  m_Candidates.clear();
+  m_EvaluatedValues.clear();
+  if (m_NumberOfRefinementLevels > 0)
+  {
+    this->ComputeCoarseCandidates();
+  }
+
   this->ResumeOptimization();
 }
 
@@ -93,6 +109,17 @@ FullSearchOptimizer::ResumeOptimization(void)
   InvokeEvent(StartEvent());
   while (!m_Stop)
   {
+    if (!this->GetNextCandidate(m_CurrentIndexInSearchSpace))
+    {
+      m_StopCondition = FullRangeSearched;
+      StopOptimization();
+      break;
+    }
+
+    /** Set the position of the grid point. */
+    m_CurrentPointInSearchSpace = this->IndexToPoint(m_CurrentIndexInSearchSpace);
+    this->SetCurrentPosition(this->PointToPosition(m_CurrentPointInSearchSpace));
+    ++m_NextCandidate;
 
     try
     {
@@ -114,6 +141,12 @@ FullSearchOptimizer::ResumeOptimization(void)
       break;
     }
 
+    /** Remember the values for the refinement of the coarse-to-fine search. */
+    if (m_NumberOfRefinementLevels > 0)
+    {
+      m_EvaluatedValues[this->IndexToLinearIndex(m_CurrentIndexInSearchSpace)] = m_Value;
+    }
+
     /** Check if the value is a minimum or maximum */
     if ((m_Value < m_BestValue) ^ m_Maximize) // ^ = xor, yields true if only one of the expressions is true
     {
@@ -127,16 +160,6 @@ FullSearchOptimizer::ResumeOptimization(void)
     /** Prepare for next step */
     m_CurrentIteration++;
 
-    if (m_CurrentIteration >= this->GetNumberOfIterations())
-    {
-      m_StopCondition = FullRangeSearched;
-      StopOptimization();
-      break;
-    }
-
-    /** Set the next position in search space. */
-    this->UpdateCurrentPosition();
-
   } // end while
 
 } // end function ResumeOptimization
@@ -159,6 +182,156 @@ FullSearchOptimizer::StopOptimization(void)
 } // end function StopOptimization
 
 
+/**
+ * ********************* GetNextCandidate ************************
+ */
+bool
+FullSearchOptimizer::GetNextCandidate(SearchSpaceIndexType & index)
+{
+  if (m_NumberOfRefinementLevels == 0)
+  {
+    /** Full search: the next grid point in scan order. */
+    if (m_NextCandidate >= this->GetNumberOfIterations())
+    {
+      return false;
+    }
+    index = this->LinearIndexToIndex(m_NextCandidate);
+    return true;
+  }
+
+  /** Coarse-to-fine search: go to a finer level when the current one is finished. */
+  while (m_NextCandidate >= m_Candidates.size() && m_CurrentLevel > 0)
+  {
+    --m_CurrentLevel;
+    this->ComputeRefinementCandidates();
+  }
+  if (m_NextCandidate >= m_Candidates.size())
+  {
+    return false;
+  }
+  index = m_Candidates[m_NextCandidate];
+  return true;
+
+} // end GetNextCandidate()
+
+
+/**
+ * ********************* ComputeCoarseCandidates *****************
+ */
+void
+FullSearchOptimizer::ComputeCoarseCandidates(void)
+{
+  const unsigned int          searchSpaceDimension = this->GetNumberOfSearchSpaceDimensions();
+  const SearchSpaceSizeType & searchSpaceSize = this->GetSearchSpaceSize();
+  const IndexValueType        step = static_cast<IndexValueType>(1) << m_CurrentLevel;
+
+  m_Candidates.clear();
+  m_NextCandidate = 0;
+
+  /** Scan the grid with the coarse step; dimension 0 varies fastest. */
+  SearchSpaceIndexType index(searchSpaceDimension);
+  index.Fill(0);
+  bool done = (searchSpaceDimension == 0);
+  while (!done)
+  {
+    m_Candidates.push_back(index);
+
+    done = true;
+    for (unsigned int ssdim = 0; ssdim < searchSpaceDimension && done; ssdim++)
+    {
+      index[ssdim] += step;
+      if (index[ssdim] < static_cast<IndexValueType>(searchSpaceSize[ssdim]))
+      {
+        done = false;
+      }
+      else
+      {
+        index[ssdim] = 0;
+      }
+    }
+  }
+
+} // end ComputeCoarseCandidates()
+
+
+/**
+ * ********************* ComputeRefinementCandidates *************
+ */
+void
+FullSearchOptimizer::ComputeRefinementCandidates(void)
+{
+  const unsigned int          searchSpaceDimension = this->GetNumberOfSearchSpaceDimensions();
+  const SearchSpaceSizeType & searchSpaceSize = this->GetSearchSpaceSize();
+  const IndexValueType        step = static_cast<IndexValueType>(1) << m_CurrentLevel;
+
+  m_Candidates.clear();
+  m_NextCandidate = 0;
+
+  /** Select the best grid points found so far. Ties are broken by the linear index,
+   * so that the selection does not depend on the evaluation order. */
+  std::vector<std::pair<MeasureType, unsigned long>> ranking;
+  ranking.reserve(m_EvaluatedValues.size());
+  for (const auto & evaluated : m_EvaluatedValues)
+  {
+    ranking.emplace_back(m_Maximize ? -evaluated.second : evaluated.second, evaluated.first);
+  }
+  const std::size_t numberOfBest = std::min<std::size_t>(m_NumberOfBestCells, ranking.size());
+  std::partial_sort(ranking.begin(), ranking.begin() + numberOfBest, ranking.end());
+
+  /** Collect their neighbours at -step, 0 and +step in each dimension, that are
+   * inside the search space and have not been evaluated yet. The set keeps them
+   * unique and in scan order. */
+  std::set<unsigned long> candidates;
+  SearchSpaceIndexType    offset(searchSpaceDimension);
+  SearchSpaceIndexType    index(searchSpaceDimension);
+  for (std::size_t b = 0; b < numberOfBest; ++b)
+  {
+    const SearchSpaceIndexType center = this->LinearIndexToIndex(ranking[b].second);
+
+    offset.Fill(-1);
+    bool done = (searchSpaceDimension == 0);
+    while (!done)
+    {
+      bool inside = true;
+      for (unsigned int ssdim = 0; ssdim < searchSpaceDimension; ssdim++)
+      {
+        index[ssdim] = center[ssdim] + offset[ssdim] * step;
+        inside &= (index[ssdim] >= 0) && (index[ssdim] < static_cast<IndexValueType>(searchSpaceSize[ssdim]));
+      }
+      if (inside)
+      {
+        const unsigned long linearIndex = this->IndexToLinearIndex(index);
+        if (m_EvaluatedValues.find(linearIndex) == m_EvaluatedValues.end())
+        {
+          candidates.insert(linearIndex);
+        }
+      }
+
+      /** Next offset in {-1, 0, 1}^dim. */
+      done = true;
+      for (unsigned int ssdim = 0; ssdim < searchSpaceDimension && done; ssdim++)
+      {
+        if (offset[ssdim] < 1)
+        {
+          ++offset[ssdim];
+          done = false;
+        }
+        else
+        {
+          offset[ssdim] = -1;
+        }
+      }
+    }
+  }
+
+  for (const unsigned long linearIndex : candidates)
+  {
+    m_Candidates.push_back(this->LinearIndexToIndex(linearIndex));
+  }
+
+} // end ComputeRefinementCandidates()
+
+
 /**
  * ********************* UpdateCurrentPosition *******************
  *
@@ -412,6 +585,48 @@ FullSearchOptimizer::IndexToPosition(const SearchSpaceIndexType & index)
 }
 
 
+/**
+ * ********************* IndexToLinearIndex *********************
+ */
+unsigned long
+FullSearchOptimizer::IndexToLinearIndex(const SearchSpaceIndexType & index)
+{
+  const unsigned int          searchSpaceDimension = this->GetNumberOfSearchSpaceDimensions();
+  const SearchSpaceSizeType & searchSpaceSize = this->GetSearchSpaceSize();
+
+  /** Dimension 0 varies fastest, see UpdateCurrentPosition. */
+  unsigned long linearIndex = 0;
+  for (unsigned int ssdim = searchSpaceDimension; ssdim > 0; ssdim--)
+  {
+    linearIndex = linearIndex * searchSpaceSize[ssdim - 1] + static_cast<unsigned long>(index[ssdim - 1]);
+  }
+
+  return linearIndex;
+
+} // end IndexToLinearIndex
+
+
+/**
+ * ********************* LinearIndexToIndex *********************
+ */
+FullSearchOptimizer::SearchSpaceIndexType
+FullSearchOptimizer::LinearIndexToIndex(unsigned long linearIndex)
+{
+  const unsigned int          searchSpaceDimension = this->GetNumberOfSearchSpaceDimensions();
+  const SearchSpaceSizeType & searchSpaceSize = this->GetSearchSpaceSize();
+  SearchSpaceIndexType        index(searchSpaceDimension);
+
+  for (unsigned int ssdim = 0; ssdim < searchSpaceDimension; ssdim++)
+  {
+    index[ssdim] = static_cast<IndexValueType>(linearIndex % searchSpaceSize[ssdim]);
+    linearIndex /= searchSpaceSize[ssdim];
+  }
+
+  return index;
+
+} // end LinearIndexToIndex
+
+
 /**
  * ********************* IndexToPoint ***************************
  */
@@ -24,6 +24,8 @@
 #include "itkImage.h"
 #include "itkArray.h"
 #include "itkFixedArray.h"
+#include <map>
+#include <vector>
 
 namespace itk
 {
@@ -35,6 +37,9 @@ namespace itk
  * Optimizer that scans a subspace of the parameter space
  * and searches for the best parameters.
  *
+ * The number of grid points that is evaluated can be reduced with a
+ * coarse-to-fine search, see SetNumberOfRefinementLevels().
+ *
  * \todo This optimizer has similar functionality as the recently added
  * itkExhaustiveOptimizer. See if we can replace it by that optimizer,
  * or inherit from it.
@@ -171,7 +176,22 @@ public:
   virtual void
   RemoveSearchDimension(unsigned int param_nr);
 
-  /** Get the total number of iterations = sizes[0]*sizes[1]*sizes[2]* etc..... */
+  /** Setting: the number of coarse-to-fine refinement levels L. If L > 0, the search
+   * space is first scanned with a step of 2^L grid points in each dimension. At each
+   * next level the step is halved, and only the neighbours (at -step, 0, +step in each
+   * dimension) of the NumberOfBestCells best grid points found so far are evaluated,
+   * until the step equals one grid point. Each grid point is evaluated at most once.
+   * Default: 0, which scans the full grid. */
+  itkSetClampMacro(NumberOfRefinementLevels, unsigned int, 0, 31);
+  itkGetConstMacro(NumberOfRefinementLevels, unsigned int);
+
+  /** Setting: the number of best grid points around which the search is refined,
+   * when NumberOfRefinementLevels > 0. Default: 1. */
+  itkSetClampMacro(NumberOfBestCells, unsigned int, 1, NumericTraits<unsigned int>::max());
+  itkGetConstMacro(NumberOfBestCells, unsigned int);
+
+  /** Get the total number of iterations = sizes[0]*sizes[1]*sizes[2]* etc.....
+   * With NumberOfRefinementLevels > 0 this is an upper bound. */
   virtual unsigned long
   GetNumberOfIterations(void);
 
@@ -194,6 +214,13 @@ public:
   virtual SearchSpacePointType
   IndexToPoint(const SearchSpaceIndexType & index);
 
+  /** Convert an index to its number in the scan order of the full search space, and back. */
+  virtual unsigned long
+  IndexToLinearIndex(const SearchSpaceIndexType & index);
+
+  virtual SearchSpaceIndexType
+  LinearIndexToIndex(unsigned long linearIndex);
+
   /** Get the current iteration number. */
   itkGetConstMacro(CurrentIteration, unsigned long);
 
@@ -238,12 +265,36 @@ protected:
   virtual void
   ProcessSearchSpaceChanges(void);
 
+  /** Get the index of the grid point that is to be evaluated next.
+   * Returns false if the search is finished. */
+  virtual bool
+  GetNextCandidate(SearchSpaceIndexType & index);
+
+  /** Fill m_Candidates with the grid points of the coarsest level. */
+  virtual void
+  ComputeCoarseCandidates(void);
+
+  /** Fill m_Candidates with the not yet evaluated neighbours of the best grid points,
+   * at the step of m_CurrentLevel. */
+  virtual void
+  ComputeRefinementCandidates(void);
+
 private:
   FullSearchOptimizer(const Self &) = delete;
   void
   operator=(const Self &) = delete;
 
   unsigned long m_CurrentIteration;
+
+  unsigned int m_NumberOfRefinementLevels;
+  unsigned int m_NumberOfBestCells;
+
+  /** The state of the search: in a full search m_NextCandidate is the linear index of
+   * the next grid point; in a coarse-to-fine search it points into m_Candidates. */
+  unsigned long                        m_NextCandidate;
+  unsigned int                         m_CurrentLevel;
+  std::vector<SearchSpaceIndexType>    m_Candidates;
+  std::map<unsigned long, MeasureType> m_EvaluatedValues;
 };
 
 } // end namespace itk
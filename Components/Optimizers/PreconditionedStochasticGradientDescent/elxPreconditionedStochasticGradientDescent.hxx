@@ -574,6 +574,7 @@ PreconditionedStochasticGradientDescent<TElastix>::AutomaticPreconditionerEstima
   preconditionerEstimator->SetMaximumStepLength(this->m_MaximumStepLength);
   preconditionerEstimator->SetConditionNumber(this->m_ConditionNumber);
   preconditionerEstimator->SetUseScales(false); // Make sure scales are not used
+  preconditionerEstimator->SetUseThreadPool(testPtr->GetUseThreadPool());
 
   /** Construct the preconditioner and initialize. */
   this->m_PreconditionVector = ParametersType(P);
@@ -631,6 +632,7 @@ PreconditionedStochasticGradientDescent<TElastix>::AutomaticPreconditionerEstima
       this->GetRegistration()->GetAsITKBaseType()->GetModifiableTransform());
     computeDisplacementDistribution->SetCostFunction(this->m_CostFunction);
     computeDisplacementDistribution->SetNumberOfJacobianMeasurements(this->m_NumberOfJacobianMeasurements);
+    computeDisplacementDistribution->SetUseThreadPool(testPtr->GetUseThreadPool());
 
     std::string maximumDisplacementEstimationMethod = "2sigma";
     this->GetConfiguration()->ReadParameter(
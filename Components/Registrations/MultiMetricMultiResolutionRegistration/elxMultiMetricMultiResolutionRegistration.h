@@ -87,6 +87,25 @@ namespace elastix
  *    example: <tt>(Metric0Use "false" "true")</tt> \n
  *    example: <tt>(Metric1Use "true" "false")</tt> \n
  *    The default is "true".
+ * \parameter UseParallelMetricEvaluation: Whether the metrics are evaluated
+ *    concurrently, in each resolution. Each metric then runs in a thread of its own,
+ *    still multi-threaded itself, and the derivatives are combined multi-threadedly.
+ *    This is useful when combining several metrics that do not benefit from all
+ *    threads themselves. Since the metrics share the transform, this is only
+ *    supported for the AdvancedMeanSquares, AdvancedNormalizedCorrelation,
+ *    AdvancedMattesMutualInformation, NormalizedMutualInformation,
+ *    TransformBendingEnergyPenalty and CorrespondingPointsEuclideanDistanceMetric
+ *    metrics. If any other metric is used, like the TransformRigidityPenalty, the
+ *    metrics are evaluated one by one. \n
+ *    example: <tt>(UseParallelMetricEvaluation "true")</tt> \n
+ *    The default is "false".
+ * \parameter UseSharedSampleCache: Whether metrics that use the same ImageSampler
+ *    share the mapped points and transform Jacobians of the samples, in each resolution.
+ *    These are then computed by the first metric only. This is useful when combining
+ *    several image metrics with a single sampler. It has no effect in combination
+ *    with UseParallelMetricEvaluation. \n
+ *    example: <tt>(UseSharedSampleCache "true")</tt> \n
+ *    The default is "false".
  *
  * \ingroup Registrations
  */
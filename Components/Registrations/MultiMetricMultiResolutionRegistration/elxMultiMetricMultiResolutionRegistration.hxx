@@ -191,6 +191,16 @@ MultiMetricMultiResolutionRegistration<TElastix>::BeforeEachResolution(void)
   this->GetConfiguration()->ReadParameter(useRelativeWeights, "UseRelativeWeights", 0);
   this->GetCombinationMetric()->SetUseRelativeWeights(useRelativeWeights);
 
+  /** Set the parallel evaluation of the metrics. */
+  bool useParallelMetricEvaluation = false;
+  this->GetConfiguration()->ReadParameter(useParallelMetricEvaluation, "UseParallelMetricEvaluation", "", level, 0);
+  this->GetCombinationMetric()->SetUseParallelMetricEvaluation(useParallelMetricEvaluation);
+
+  /** Set the sharing of the mapped points and Jacobians between the metrics. */
+  bool useSharedSampleCache = false;
+  this->GetConfiguration()->ReadParameter(useSharedSampleCache, "UseSharedSampleCache", "", level, 0);
+  this->GetCombinationMetric()->SetUseSharedSampleCache(useSharedSampleCache);
+
   /** Set the metric weights. The default metric weight is 1.0 / nrOfMetrics. */
   if (!useRelativeWeights)
   {
@@ -20,6 +20,11 @@
 
 #include "itkAdvancedImageToImageMetric.h"
 #include "itkSingleValuedPointSetToPointSetMetric.h"
+#include "itkPlatformMultiThreader.h"
+
+#include <atomic>
+#include <exception>
+#include <utility>
 
 namespace itk
 {
@@ -123,6 +128,8 @@ public:
   typedef typename Superclass::MovingImageLimiterOutputType MovingImageLimiterOutputType;
   typedef typename Superclass::ScalarType                   ScalarType;
   typedef typename Superclass::AdvancedTransformType        AdvancedTransformType;
+  typedef typename Superclass::SampleTransformCacheType     SampleTransformCacheType;
+  typedef typename Superclass::SampleTransformCachePointer  SampleTransformCachePointer;
   */
 
   /** Typedefs for the metrics. */
@@ -202,6 +209,40 @@ public:
   itkSetMacro(UseRelativeWeights, bool);
   itkGetMacro(UseRelativeWeights, bool);
 
+  /** Select the parallel evaluation of the sub-metrics.
+   * When switched on (and UseMultiThread is on), GetValueAndDerivative() runs
+   * each sub-metric in a thread of its own, and combines their derivatives with
+   * a multi-threaded weighted sum. The sub-metrics keep their own multi-threading.
+   * This mode is beneficial when combining several metrics that do not scale well
+   * over all threads. The sub-metrics are only evaluated concurrently when
+   * CanEvaluateMetricsInParallel() holds; otherwise the sequential evaluation
+   * is used. Default: false.
+   */
+  itkSetMacro(UseParallelMetricEvaluation, bool);
+  itkGetConstReferenceMacro(UseParallelMetricEvaluation, bool);
+  itkBooleanMacro(UseParallelMetricEvaluation);
+
+  /** Check if all sub-metrics may be evaluated concurrently. The sub-metrics share the
+   * transform, so this is only the case when every sub-metric reports
+   * CanBeEvaluatedConcurrently(), i.e. it sets the transform parameters in
+   * BeforeThreadedGetValueAndDerivative() only, which is called single-threadedly
+   * by GetValueAndDerivative(). Metrics that set the transform parameters themselves,
+   * such as the rigidity penalty, are therefore evaluated sequentially.
+   */
+  bool
+  CanEvaluateMetricsInParallel(void) const;
+
+  /** Select the sharing of mapped points and transform Jacobians between sub-metrics.
+   * When switched on, GetValueAndDerivative() gives all image metrics that use the same
+   * image sampler and transform a shared SampleTransformCache, so that T(x), the nonzero
+   * Jacobian indices and dT/dmu of each sample are computed by the first metric only.
+   * The cache is not used in combination with UseParallelMetricEvaluation, since the
+   * metrics sharing it would then write it concurrently. Default: false.
+   */
+  itkSetMacro(UseSharedSampleCache, bool);
+  itkGetConstReferenceMacro(UseSharedSampleCache, bool);
+  itkBooleanMacro(UseSharedSampleCache);
+
   /** Select which metrics are used.
    * This is useful in case you want to compute a certain measure, but not
    * actually use it during the registration.
@@ -456,6 +497,8 @@ protected:
   mutable std::vector<DerivativeType>          m_MetricDerivatives;
   mutable std::vector<double>                  m_MetricDerivativesMagnitude;
   mutable std::vector<double>                  m_MetricComputationTime;
+  bool                                         m_UseParallelMetricEvaluation;
+  bool                                         m_UseSharedSampleCache;
 
   /** Dummy image region and derivatives. */
   FixedImageRegionType m_NullFixedImageRegion;
@@ -478,6 +521,50 @@ private:
    */
   double
   GetFinalMetricWeight(unsigned int pos) const;
+
+  /** Give the image metrics that share an image sampler and transform a synchronized
+   * sample transform cache, one per combination of image sampler and transform.
+   */
+  void
+  AttachSampleTransformCaches(const ParametersType & parameters) const;
+
+  /** Remove the sample transform caches from the image metrics. */
+  void
+  DetachSampleTransformCaches(void) const;
+
+  /** Compute the values and derivatives of all sub-metrics concurrently. */
+  void
+  EvaluateMetricsInParallel(const ParametersType & parameters) const;
+
+  /** Evaluate the sub-metrics claimed by a work unit, until none are left. */
+  void
+  ThreadedEvaluateMetrics(void) const;
+
+  /** Compute the weighted sum of the sub-metric derivatives for a block of parameters. */
+  void
+  ThreadedCombineDerivatives(ThreadIdType threadId, ThreadIdType numberOfThreads) const;
+
+  /** Threader callbacks for the parallel evaluation. */
+  static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+  EvaluateMetricsThreaderCallback(void * arg);
+
+  static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+  CombineDerivativesThreaderCallback(void * arg);
+
+  /** The threader that gives every sub-metric a thread of its own. */
+  typedef PlatformMultiThreader MetricThreaderType;
+  MetricThreaderType::Pointer   m_MetricThreader;
+
+  /** State of the parallel evaluation, only valid during GetValueAndDerivative(). */
+  mutable const ParametersType *          m_CurrentParameters;
+  mutable std::atomic<unsigned int>       m_NextMetricToEvaluate;
+  mutable std::vector<std::exception_ptr> m_MetricExceptions;
+  mutable std::vector<double>             m_FinalMetricWeights;
+
+  /** The sample transform caches, and the image samplers and transforms they belong to. */
+  typedef std::pair<const ImageSamplerType *, const TransformType *> SampleTransformCacheKeyType;
+  mutable std::vector<SampleTransformCacheKeyType> m_SampleTransformCacheKeys;
+  mutable std::vector<SampleTransformCachePointer> m_SampleTransformCaches;
 };
 
 } // end namespace itk
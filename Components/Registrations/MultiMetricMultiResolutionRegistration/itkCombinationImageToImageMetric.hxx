@@ -22,6 +22,9 @@
 #include "itkTimeProbe.h"
 #include "itkMath.h"
 
+#include <algorithm>
+#include <cmath>
+
 /** Macros to reduce some copy-paste work.
  * These macros provide the implementation of
  * all Set/GetFixedImage, Set/GetInterpolator etc methods
@@ -146,6 +149,11 @@ CombinationImageToImageMetric<TFixedImage, TMovingImage>::CombinationImageToImag
 {
   this->m_NumberOfMetrics = 0;
   this->m_UseRelativeWeights = false;
+  this->m_UseParallelMetricEvaluation = false;
+  this->m_UseSharedSampleCache = false;
+  this->m_CurrentParameters = nullptr;
+  this->m_NextMetricToEvaluate = 0;
+  this->m_MetricThreader = MetricThreaderType::New();
   this->ComputeGradientOff();
 
 } // end Constructor
@@ -164,6 +172,8 @@ CombinationImageToImageMetric<TFixedImage, TMovingImage>::PrintSelf(std::ostream
 
   /** Add debugging information. */
   os << "NumberOfMetrics: " << this->m_NumberOfMetrics << std::endl;
+  os << "UseParallelMetricEvaluation: " << (this->m_UseParallelMetricEvaluation ? "true" : "false") << std::endl;
+  os << "UseSharedSampleCache: " << (this->m_UseSharedSampleCache ? "true" : "false") << std::endl;
   for (unsigned int i = 0; i < this->m_NumberOfMetrics; i++)
   {
     os << "Metric " << i << ":\n";
@@ -808,16 +818,42 @@ CombinationImageToImageMetric<TFixedImage, TMovingImage>::GetValueAndDerivative(
   this->InitializeThreadingParameters();
 
   /** Compute all metric values and derivatives. */
-  for (unsigned int i = 0; i < this->m_NumberOfMetrics; i++)
+  const bool parallel = this->m_UseParallelMetricEvaluation && this->m_UseMultiThread && this->m_NumberOfMetrics > 1 &&
+                        this->CanEvaluateMetricsInParallel();
+  if (parallel)
   {
-    /** Compute ... */
-    timer.Reset();
-    timer.Start();
-    this->m_Metrics[i]->GetValueAndDerivative(parameters, this->m_MetricValues[i], this->m_MetricDerivatives[i]);
-    timer.Stop();
+    this->EvaluateMetricsInParallel(parameters);
+  }
+  else
+  {
+    /** Let the metrics that share an image sampler also share the mapped points and Jacobians.
+     * The caches are only attached during this loop, in which the samples do not change.
+     */
+    if (this->m_UseSharedSampleCache)
+    {
+      this->AttachSampleTransformCaches(parameters);
+    }
 
-    /** Store computation time. */
-    this->m_MetricComputationTime[i] = timer.GetMean() * 1000.0;
+    try
+    {
+      for (unsigned int i = 0; i < this->m_NumberOfMetrics; i++)
+      {
+        /** Compute ... */
+        timer.Reset();
+        timer.Start();
+        this->m_Metrics[i]->GetValueAndDerivative(parameters, this->m_MetricValues[i], this->m_MetricDerivatives[i]);
+        timer.Stop();
+
+        /** Store computation time. */
+        this->m_MetricComputationTime[i] = timer.GetMean() * 1000.0;
+      }
+    }
+    catch (...)
+    {
+      this->DetachSampleTransformCaches();
+      throw;
+    }
+    this->DetachSampleTransformCaches();
   }
 
   /** Compute the derivative magnitude. */
@@ -837,6 +873,25 @@ CombinationImageToImageMetric<TFixedImage, TMovingImage>::GetValueAndDerivative(
     }
   }
 
+  /** Combine the metric derivatives. For many parameters this is done multi-threadedly:
+   * each thread computes the weighted sum over all metrics for a block of parameters.
+   * The metrics are added in the same order as in the single-threaded code below.
+   */
+  const unsigned int numberOfParameters = this->GetNumberOfParameters();
+  if (parallel && numberOfParameters >= 10000)
+  {
+    this->m_FinalMetricWeights.resize(this->m_NumberOfMetrics);
+    for (unsigned int i = 0; i < this->m_NumberOfMetrics; i++)
+    {
+      this->m_FinalMetricWeights[i] = this->m_UseMetric[i] ? this->GetFinalMetricWeight(i) : 0.0;
+    }
+    derivative.SetSize(numberOfParameters);
+    this->m_ThreaderMetricParameters.st_DerivativePointer = derivative.begin();
+    this->LaunchThreaderCallback(this->CombineDerivativesThreaderCallback,
+                                 const_cast<void *>(static_cast<const void *>(&this->m_ThreaderMetricParameters)));
+    return;
+  }
+
   /** Combine the metric derivatives. First, the first derivative. */
   if (this->m_UseMetric[0])
   {
@@ -861,6 +916,253 @@ CombinationImageToImageMetric<TFixedImage, TMovingImage>::GetValueAndDerivative(
 } // end GetValueAndDerivative()
 
 
+/**
+ * ********************* AttachSampleTransformCaches ****************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+CombinationImageToImageMetric<TFixedImage, TMovingImage>::AttachSampleTransformCaches(
+  const ParametersType & parameters) const
+{
+  /** Find the image sampler and the transform of each image metric. */
+  std::vector<ImageMetricType *>           metrics(this->m_NumberOfMetrics, nullptr);
+  std::vector<SampleTransformCacheKeyType> keys(this->m_NumberOfMetrics);
+  for (unsigned int i = 0; i < this->m_NumberOfMetrics; i++)
+  {
+    ImageMetricType * metric = dynamic_cast<ImageMetricType *>(this->GetMetric(i));
+    if (metric && metric->GetUseImageSampler() && metric->GetImageSampler() && metric->GetTransform())
+    {
+      metrics[i] = metric;
+      keys[i] = SampleTransformCacheKeyType(metric->GetImageSampler(), metric->GetTransform());
+    }
+  }
+
+  for (unsigned int i = 0; i < this->m_NumberOfMetrics; i++)
+  {
+    /** A cache only pays off when the samples and the transform are shared with another metric. */
+    if (metrics[i] == nullptr || std::count(keys.begin(), keys.end(), keys[i]) < 2)
+    {
+      continue;
+    }
+
+    /** Get the cache for this image sampler and transform, or create one. */
+    const auto keyIt =
+      std::find(this->m_SampleTransformCacheKeys.begin(), this->m_SampleTransformCacheKeys.end(), keys[i]);
+    SampleTransformCacheType * cache = nullptr;
+    if (keyIt == this->m_SampleTransformCacheKeys.end())
+    {
+      this->m_SampleTransformCacheKeys.push_back(keys[i]);
+      this->m_SampleTransformCaches.push_back(SampleTransformCacheType::New());
+      cache = this->m_SampleTransformCaches.back().GetPointer();
+    }
+    else
+    {
+      cache = this->m_SampleTransformCaches[keyIt - this->m_SampleTransformCacheKeys.begin()].GetPointer();
+    }
+
+    /** The image samplers have been updated by BeforeThreadedGetValueAndDerivative().
+     * Synchronizing the same cache again for another metric does not invalidate it.
+     */
+    const ImageSampleContainerType * sampleContainer = metrics[i]->GetImageSampler()->GetOutput();
+    cache->Synchronize(sampleContainer,
+                       sampleContainer->Size(),
+                       parameters,
+                       metrics[i]->GetTransform()->GetNumberOfNonZeroJacobianIndices());
+    metrics[i]->SetSampleTransformCache(cache);
+  }
+
+} // end AttachSampleTransformCaches()
+
+
+/**
+ * ********************* DetachSampleTransformCaches ****************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+CombinationImageToImageMetric<TFixedImage, TMovingImage>::DetachSampleTransformCaches(void) const
+{
+  for (unsigned int i = 0; i < this->m_NumberOfMetrics; i++)
+  {
+    ImageMetricType * metric = dynamic_cast<ImageMetricType *>(this->GetMetric(i));
+    if (metric && metric->GetSampleTransformCache() != nullptr)
+    {
+      metric->SetSampleTransformCache(nullptr);
+    }
+  }
+
+} // end DetachSampleTransformCaches()
+
+
+/**
+ * ********************* CanEvaluateMetricsInParallel ****************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+bool
+CombinationImageToImageMetric<TFixedImage, TMovingImage>::CanEvaluateMetricsInParallel(void) const
+{
+  /** Each sub-metric tells if its GetValueAndDerivative() leaves the shared transform
+   * and image sampler alone, once BeforeThreadedGetValueAndDerivative() has been called.
+   */
+  for (unsigned int i = 0; i < this->m_NumberOfMetrics; i++)
+  {
+    const ImageMetricType *    imageMetric = dynamic_cast<const ImageMetricType *>(this->GetMetric(i));
+    const PointSetMetricType * pointSetMetric = dynamic_cast<const PointSetMetricType *>(this->GetMetric(i));
+    if (!(imageMetric && imageMetric->CanBeEvaluatedConcurrently()) &&
+        !(pointSetMetric && pointSetMetric->CanBeEvaluatedConcurrently()))
+    {
+      return false;
+    }
+  }
+  return true;
+
+} // end CanEvaluateMetricsInParallel()
+
+
+/**
+ * ********************* EvaluateMetricsInParallel ****************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+CombinationImageToImageMetric<TFixedImage, TMovingImage>::EvaluateMetricsInParallel(
+  const ParametersType & parameters) const
+{
+  /** Every metric gets a thread of its own, that is not taken from the thread pool.
+   * Within it, the sub-metric launches its own work units as usual, so a single
+   * expensive metric still uses all threads, and the nested launches cannot wait
+   * on pool threads that are occupied by the metrics themselves.
+   */
+  this->m_CurrentParameters = &parameters;
+  this->m_NextMetricToEvaluate = 0;
+  this->m_MetricExceptions.assign(this->m_NumberOfMetrics, std::exception_ptr());
+  this->m_MetricThreader->SetNumberOfWorkUnits(this->m_NumberOfMetrics);
+  this->m_MetricThreader->SetSingleMethod(
+    this->EvaluateMetricsThreaderCallback,
+    const_cast<void *>(static_cast<const void *>(&this->m_ThreaderMetricParameters)));
+  this->m_MetricThreader->SingleMethodExecute();
+  this->m_CurrentParameters = nullptr;
+
+  /** Exceptions cannot cross the thread boundary, so rethrow them here. */
+  for (unsigned int i = 0; i < this->m_NumberOfMetrics; i++)
+  {
+    if (this->m_MetricExceptions[i])
+    {
+      std::rethrow_exception(this->m_MetricExceptions[i]);
+    }
+  }
+
+} // end EvaluateMetricsInParallel()
+
+
+/**
+ * ********************* ThreadedEvaluateMetrics ****************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+CombinationImageToImageMetric<TFixedImage, TMovingImage>::ThreadedEvaluateMetrics(void) const
+{
+  unsigned int i = this->m_NextMetricToEvaluate++;
+  while (i < this->m_NumberOfMetrics)
+  {
+    itk::TimeProbe timer;
+    timer.Start();
+    try
+    {
+      this->m_Metrics[i]->GetValueAndDerivative(
+        *this->m_CurrentParameters, this->m_MetricValues[i], this->m_MetricDerivatives[i]);
+    }
+    catch (...)
+    {
+      this->m_MetricExceptions[i] = std::current_exception();
+    }
+    timer.Stop();
+    this->m_MetricComputationTime[i] = timer.GetMean() * 1000.0;
+
+    i = this->m_NextMetricToEvaluate++;
+  }
+
+} // end ThreadedEvaluateMetrics()
+
+
+/**
+ * ********************* ThreadedCombineDerivatives ****************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+CombinationImageToImageMetric<TFixedImage, TMovingImage>::ThreadedCombineDerivatives(
+  ThreadIdType threadId,
+  ThreadIdType numberOfThreads) const
+{
+  const unsigned int numPar = this->GetNumberOfParameters();
+  const unsigned int subSize =
+    static_cast<unsigned int>(std::ceil(static_cast<double>(numPar) / static_cast<double>(numberOfThreads)));
+  const unsigned int jmin = std::min(threadId * subSize, numPar);
+  const unsigned int jmax = std::min(jmin + subSize, numPar);
+
+  DerivativeValueType * derivative = this->m_ThreaderMetricParameters.st_DerivativePointer;
+  for (unsigned int j = jmin; j < jmax; ++j)
+  {
+    DerivativeValueType sum = NumericTraits<DerivativeValueType>::Zero;
+    for (unsigned int i = 0; i < this->m_NumberOfMetrics; i++)
+    {
+      if (this->m_UseMetric[i])
+      {
+        sum += this->m_FinalMetricWeights[i] * this->m_MetricDerivatives[i][j];
+      }
+    }
+    derivative[j] = sum;
+  }
+
+} // end ThreadedCombineDerivatives()
+
+
+/**
+ * **************** EvaluateMetricsThreaderCallback *******
+ */
+
+template <class TFixedImage, class TMovingImage>
+ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+CombinationImageToImageMetric<TFixedImage, TMovingImage>::EvaluateMetricsThreaderCallback(void * arg)
+{
+  ThreadInfoType * infoStruct = static_cast<ThreadInfoType *>(arg);
+
+  typename Superclass::MultiThreaderParameterType * temp =
+    static_cast<typename Superclass::MultiThreaderParameterType *>(infoStruct->UserData);
+
+  static_cast<Self *>(temp->st_Metric)->ThreadedEvaluateMetrics();
+
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+
+} // end EvaluateMetricsThreaderCallback()
+
+
+/**
+ * **************** CombineDerivativesThreaderCallback *******
+ */
+
+template <class TFixedImage, class TMovingImage>
+ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+CombinationImageToImageMetric<TFixedImage, TMovingImage>::CombineDerivativesThreaderCallback(void * arg)
+{
+  ThreadInfoType * infoStruct = static_cast<ThreadInfoType *>(arg);
+  ThreadIdType     threadId = infoStruct->WorkUnitID;
+  ThreadIdType     numberOfThreads = infoStruct->NumberOfWorkUnits;
+
+  typename Superclass::MultiThreaderParameterType * temp =
+    static_cast<typename Superclass::MultiThreaderParameterType *>(infoStruct->UserData);
+
+  static_cast<Self *>(temp->st_Metric)->ThreadedCombineDerivatives(threadId, numberOfThreads);
+
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+
+} // end CombineDerivativesThreaderCallback()
+
+
 /**
  * ********************* GetSelfHessian ****************************
  */
@@ -70,6 +70,12 @@ namespace elastix
  * Default: 0.3. You cannot specify this parameter for each resolution differently.\n
  * Valid values are withing -1.0 and 0.5. 0.5 means incompressible.
  * Negative values are a bit odd, but possible. See Wikipedia on PoissonRatio.
+ * \parameter SplineFarFieldTolerance: For the ThinPlateSpline with many landmarks,
+ * approximate the contribution of clusters of distant landmarks, such that the
+ * error in the transformed point is below this tolerance (in mm). A value of 0.0
+ * gives an exact evaluation. Other SplineKernelTypes ignore this parameter.\n
+ *   example: <tt>(SplineFarFieldTolerance 0.001 )</tt>\n
+ * Default: 0.0. You cannot specify this parameter for each resolution differently.
  *
  * \commandlinearg -fp: a file specifying a set of points that will serve
  * as fixed image landmarks.\n
@@ -104,6 +110,9 @@ namespace elastix
  *   example: <tt>(SplinePoissonRatio 0.3 )</tt>\n
  * Valid values are withing -1.0 and 0.5. 0.5 means incompressible.
  * Negative values are a bit odd, but possible. See Wikipedia on PoissonRatio.
+ * \transformparameter SplineFarFieldTolerance: The tolerance of the far-field
+ * approximation of the ThinPlateSpline. 0.0 means exact evaluation.\n
+ *   example: <tt>(SplineFarFieldTolerance 0.001 )</tt>
  * \transformparameter FixedImageLandmarks: The landmark positions in the
  * fixed image, in world coordinates. Positions written as x1 y1 [z1] x2 y2 [z2] etc.\n
  *   example: <tt>(FixedImageLandmarks 10.0 11.0 12.0 4.0 4.0 4.0 6.0 6.0 6.0 )</tt>
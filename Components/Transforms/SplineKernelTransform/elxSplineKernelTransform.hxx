@@ -188,6 +188,12 @@ SplineKernelTransform<TElastix>::BeforeRegistration(void)
   this->GetConfiguration()->ReadParameter(matrixInversionMethod, "TPSMatrixInversionMethod", 0, true);
   this->m_KernelTransform->SetMatrixInversionMethod(matrixInversionMethod);
 
+  /** Set the tolerance of the far-field approximation; default 0.0 = exact. */
+  double farFieldTolerance = 0.0;
+  this->GetConfiguration()->ReadParameter(
+    farFieldTolerance, "SplineFarFieldTolerance", this->GetComponentLabel(), 0, -1);
+  this->m_KernelTransform->SetFarFieldTolerance(farFieldTolerance);
+
   /** Load fixed image (source) landmark positions. */
   this->DetermineSourceLandmarks();
 
@@ -405,6 +411,11 @@ SplineKernelTransform<TElastix>::ReadFromFile(void)
   this->GetConfiguration()->ReadParameter(poissonRatio, "SplinePoissonRatio", this->GetComponentLabel(), 0, -1);
   this->m_KernelTransform->SetPoissonRatio(poissonRatio);
 
+  /** Set the tolerance of the far-field approximation. */
+  double farFieldTolerance = 0.0;
+  this->GetConfiguration()->ReadParameter(farFieldTolerance, "SplineFarFieldTolerance", 0, false);
+  this->m_KernelTransform->SetFarFieldTolerance(farFieldTolerance);
+
   /** Read number of parameters. */
   unsigned int numberOfParameters = 0;
   this->GetConfiguration()->ReadParameter(numberOfParameters, "NumberOfParameters", 0);
@@ -451,6 +462,7 @@ SplineKernelTransform<TElastix>::CreateDerivedTransformParametersMap(void) const
   return { { "SplineKernelType", { m_SplineKernelType } },
            { "SplinePoissonRatio", { BaseComponent::ToString(itkTransform.GetPoissonRatio()) } },
            { "SplineRelaxationFactor", { BaseComponent::ToString(itkTransform.GetStiffness()) } },
+           { "SplineFarFieldTolerance", { BaseComponent::ToString(itkTransform.GetFarFieldTolerance()) } },
            { "FixedImageLandmarks", BaseComponent::ToVectorOfStrings(itkTransform.GetFixedParameters()) } };
 
 } // end CustomizeTransformParametersMap()
@@ -147,6 +147,12 @@ protected:
   void
   ComputeG(const InputVectorType & x, GMatrixType & GMatrix) const override;
 
+  /** Compute the contribution of the landmarks weighted by the kernel function
+   * to the global deformation of the space.
+   */
+  void
+  ComputeDeformationContribution(const InputPointType & inputPoint, OutputPointType & result) const override;
+
   /** alpha, Poisson's ratio */
   TScalarType m_Alpha;
 
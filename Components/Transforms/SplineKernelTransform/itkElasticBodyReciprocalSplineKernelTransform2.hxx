@@ -70,6 +70,33 @@ ElasticBodyReciprocalSplineKernelTransform2<TScalarType, NDimensions>::ComputeG(
 } // end ComputeG()
 
 
+/**
+ * ******************* ComputeDeformationContribution *******************
+ */
+
+template <class TScalarType, unsigned int NDimensions>
+void
+ElasticBodyReciprocalSplineKernelTransform2<TScalarType, NDimensions>::ComputeDeformationContribution(
+  const InputPointType & thisPoint,
+  OutputPointType &      opp) const
+{
+  /** G(x) = alpha r I - x x^T / r, see ComputeG(). */
+  const TScalarType   alpha = this->m_Alpha;
+  const unsigned long numberOfLandmarks = this->m_LandmarkCoordinates.size() / NDimensions;
+  this->AccumulateElasticContribution(
+    thisPoint,
+    0,
+    numberOfLandmarks,
+    [alpha](const TScalarType r2, TScalarType & a, TScalarType & b) {
+      const TScalarType r = std::sqrt(r2);
+      a = alpha * r;
+      b = (r > 1e-8) ? (-1.0 / r) : NumericTraits<TScalarType>::Zero;
+    },
+    opp);
+
+} // end ComputeDeformationContribution()
+
+
 template <class TScalarType, unsigned int NDimensions>
 void
 ElasticBodyReciprocalSplineKernelTransform2<TScalarType, NDimensions>::PrintSelf(std::ostream & os, Indent indent) const
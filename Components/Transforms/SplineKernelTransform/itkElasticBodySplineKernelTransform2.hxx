@@ -70,6 +70,33 @@ ElasticBodySplineKernelTransform2<TScalarType, NDimensions>::ComputeG(const Inpu
 } // end ComputeG()
 
 
+/**
+ * ******************* ComputeDeformationContribution *******************
+ */
+
+template <class TScalarType, unsigned int NDimensions>
+void
+ElasticBodySplineKernelTransform2<TScalarType, NDimensions>::ComputeDeformationContribution(
+  const InputPointType & thisPoint,
+  OutputPointType &      opp) const
+{
+  /** G(x) = alpha r^3 I - 3 r x x^T. */
+  const TScalarType   alpha = this->m_Alpha;
+  const unsigned long numberOfLandmarks = this->m_LandmarkCoordinates.size() / NDimensions;
+  this->AccumulateElasticContribution(
+    thisPoint,
+    0,
+    numberOfLandmarks,
+    [alpha](const TScalarType r2, TScalarType & a, TScalarType & b) {
+      const TScalarType r = std::sqrt(r2);
+      a = alpha * r2 * r;
+      b = -3.0 * r;
+    },
+    opp);
+
+} // end ComputeDeformationContribution()
+
+
 template <class TScalarType, unsigned int NDimensions>
 void
 ElasticBodySplineKernelTransform2<TScalarType, NDimensions>::PrintSelf(std::ostream & os, Indent indent) const
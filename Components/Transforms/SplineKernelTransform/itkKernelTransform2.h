@@ -41,6 +41,7 @@ PURPOSE.  See the above copyright notices for more information.
 #include "itkPointSet.h"
 #include <deque>
 #include <math.h>
+#include <vector>
 #include "vnl/vnl_matrix_fixed.h"
 #include "vnl/vnl_matrix.h"
 #include "vnl/vnl_vector.h"
@@ -86,6 +87,10 @@ namespace itk
  * - Support for matrix inversion by QR decomposition, instead of SVD.
  *   QR is much faster. Used in SetParameters() and SetFixedParameters().
  * - Much faster Jacobian computation for some of the derived kernel transforms.
+ * - For kernels with a diagonal G, the L matrix is decomposed per dimension,
+ *   which is a system NDimensions times smaller.
+ * - The deformation contribution is evaluated in blocks of landmarks, stored
+ *   in contiguous arrays, and optionally by a far-field approximation.
  *
  * \ingroup Transforms
  *
@@ -306,6 +311,17 @@ public:
   itkSetMacro(MatrixInversionMethod, std::string);
   itkGetConstReferenceMacro(MatrixInversionMethod, std::string);
 
+  /** Tolerance of the far-field approximation of the deformation contribution, i.e. the
+   * maximum error of the computed displacement, in physical units. Landmarks far away from
+   * the transformed point are then evaluated per cluster, instead of one by one.
+   * The default tolerance of 0 means no approximation. Only kernels that override
+   * PrecomputeDeformationContribution() use it, currently the ThinPlateSpline.
+   */
+  virtual void
+  SetFarFieldTolerance(double tolerance);
+
+  itkGetConstMacro(FarFieldTolerance, double);
+
   /** Must be provided. */
   void
   GetSpatialJacobian(const InputPointType & ipp, SpatialJacobianType & sj) const override
@@ -432,11 +448,48 @@ protected:
   virtual void
   ComputeDeformationContribution(const InputPointType & inputPoint, OutputPointType & result) const;
 
+  /** Precompute the data used by ComputeDeformationContribution(), called after the W
+   * matrix is computed. The default implementation stores the source landmarks and the
+   * deformation coefficients per dimension in contiguous arrays.
+   */
+  virtual void
+  PrecomputeDeformationContribution(void);
+
+  /** Add the contribution of the landmarks [begin, end) in the contiguous arrays, for a
+   * kernel \f$ G(x) = g(r) I \f$. The radial function gets \f$ r^2 \f$ and returns
+   * \f$ g(r) \f$. The landmarks are processed in blocks of contiguous arrays. The distances are
+   * element-wise loops; the weighted sums use four independent partial sums, added in a fixed
+   * order, so that consecutive additions do not wait for each other. Without -ffast-math the
+   * compiler does not reorder a single sum, nor vectorize a radial function that calls std::sqrt.
+   */
+  template <class TRadialFunction>
+  void
+  AccumulateRadialContribution(const InputPointType &  inputPoint,
+                               const unsigned long     begin,
+                               const unsigned long     end,
+                               const TRadialFunction & radialFunction,
+                               OutputPointType &       result) const;
+
+  /** Add the contribution of the landmarks [begin, end) in the contiguous arrays, for a
+   * kernel \f$ G(x) = a(r) I + b(r) x x^T \f$. The kernel function is called as
+   * kernelFunction(r2, a, b), with \f$ r^2 \f$ by value, and sets a and b. The weighted sums
+   * are computed like in AccumulateRadialContribution().
+   */
+  template <class TKernelFunction>
+  void
+  AccumulateElasticContribution(const InputPointType &  inputPoint,
+                                const unsigned long     begin,
+                                const unsigned long     end,
+                                const TKernelFunction & kernelFunction,
+                                OutputPointType &       result) const;
+
   /** Compute K matrix. */
   void
   ComputeK(void);
 
-  /** Compute L matrix. */
+  /** Compute L matrix. For kernels with a diagonal G, i.e. when m_FastComputationPossible,
+   * also the decoupled L matrix.
+   */
   void
   ComputeL(void);
 
@@ -473,6 +526,12 @@ protected:
   /** The inverse of L, which we also cache. */
   LMatrixType m_LMatrixInverse;
 
+  /** For kernels with a diagonal G, the L matrix consists of NDimensions identical systems,
+   * one per dimension: L(i*d+k, j*d+l) = delta(k,l) * Ld(i,j). The decoupled L matrix is Ld,
+   * which is decomposed instead of L.
+   */
+  LMatrixType m_DecoupledLMatrix;
+
   /** The K matrix. */
   KMatrixType m_KMatrix;
 
@@ -529,6 +588,16 @@ protected:
   /** Identity matrix. */
   IMatrixType m_I;
 
+  /** The source landmarks and the deformation coefficients (the D matrix), stored per
+   * dimension in contiguous arrays: element [dim * n + i] belongs to landmark i.
+   * Subclasses may reorder the landmarks, consistently in both arrays.
+   */
+  std::vector<TScalarType> m_LandmarkCoordinates;
+  std::vector<TScalarType> m_LandmarkCoefficients;
+
+  /** Tolerance of the far-field approximation. */
+  double m_FarFieldTolerance;
+
   /** Precomputed nonzero Jacobian indices (simply all params) */
   NonZeroJacobianIndicesType m_NonZeroJacobianIndices;
 
@@ -35,6 +35,8 @@ PURPOSE.  See the above copyright notices for more information.
 #define _itkKernelTransform2_hxx
 
 #include "itkKernelTransform2.h"
+#include <algorithm> // For min and fill_n.
+#include <cmath>
 
 namespace itk
 {
@@ -70,6 +72,7 @@ KernelTransform2<TScalarType, NDimensions>::KernelTransform2()
 
   this->m_MatrixInversionMethod = "SVD";
   this->m_FastComputationPossible = false;
+  this->m_FarFieldTolerance = 0.0;
 
   this->m_HasNonZeroSpatialHessian = true;
   this->m_HasNonZeroJacobianOfSpatialHessian = true;
@@ -208,6 +211,216 @@ KernelTransform2<TScalarType, NDimensions>::ComputeDeformationContribution(const
 } // end ComputeDeformationContribution()
 
 
+/**
+ * ******************* PrecomputeDeformationContribution *******************
+ */
+
+template <class TScalarType, unsigned int NDimensions>
+void
+KernelTransform2<TScalarType, NDimensions>::PrecomputeDeformationContribution(void)
+{
+  const unsigned long numberOfLandmarks = this->m_SourceLandmarks->GetNumberOfPoints();
+
+  this->m_LandmarkCoordinates.resize(NDimensions * numberOfLandmarks);
+  this->m_LandmarkCoefficients.resize(NDimensions * numberOfLandmarks);
+
+  PointsIterator sp = this->m_SourceLandmarks->GetPoints()->Begin();
+  for (unsigned long lnd = 0; lnd < numberOfLandmarks; lnd++)
+  {
+    for (unsigned int dim = 0; dim < NDimensions; dim++)
+    {
+      this->m_LandmarkCoordinates[dim * numberOfLandmarks + lnd] = sp->Value()[dim];
+      this->m_LandmarkCoefficients[dim * numberOfLandmarks + lnd] = this->m_DMatrix(dim, lnd);
+    }
+    ++sp;
+  }
+
+} // end PrecomputeDeformationContribution()
+
+
+/**
+ * ******************* AccumulateRadialContribution *******************
+ */
+
+template <class TScalarType, unsigned int NDimensions>
+template <class TRadialFunction>
+void
+KernelTransform2<TScalarType, NDimensions>::AccumulateRadialContribution(const InputPointType &  thisPoint,
+                                                                         const unsigned long     begin,
+                                                                         const unsigned long     end,
+                                                                         const TRadialFunction & radialFunction,
+                                                                         OutputPointType &       opp) const
+{
+  const unsigned int  blockSize = 64;
+  const unsigned long numberOfLandmarks = this->m_LandmarkCoordinates.size() / NDimensions;
+  const TScalarType * coordinates = this->m_LandmarkCoordinates.data();
+  const TScalarType * coefficients = this->m_LandmarkCoefficients.data();
+
+  TScalarType g[blockSize];
+  TScalarType sum[NDimensions];
+  std::fill_n(sum, NDimensions, NumericTraits<TScalarType>::ZeroValue());
+
+  for (unsigned long first = begin; first < end; first += blockSize)
+  {
+    const unsigned int size = static_cast<unsigned int>(std::min<unsigned long>(blockSize, end - first));
+
+    /** Squared distances to the landmarks in this block. */
+    std::fill_n(g, size, NumericTraits<TScalarType>::ZeroValue());
+    for (unsigned int dim = 0; dim < NDimensions; dim++)
+    {
+      const TScalarType * c = coordinates + dim * numberOfLandmarks + first;
+      const TScalarType   x = thisPoint[dim];
+      for (unsigned int i = 0; i < size; i++)
+      {
+        const TScalarType diff = x - c[i];
+        g[i] += diff * diff;
+      }
+    }
+
+    /** Kernel values. */
+    for (unsigned int i = 0; i < size; i++)
+    {
+      g[i] = radialFunction(g[i]);
+    }
+
+    /** Kernel weighted sum of the coefficients, in four independent partial sums. */
+    for (unsigned int dim = 0; dim < NDimensions; dim++)
+    {
+      const TScalarType * d = coefficients + dim * numberOfLandmarks + first;
+      TScalarType         partialSum[4] = { 0, 0, 0, 0 };
+      unsigned int        i = 0;
+      for (; i + 4 <= size; i += 4)
+      {
+        partialSum[0] += g[i] * d[i];
+        partialSum[1] += g[i + 1] * d[i + 1];
+        partialSum[2] += g[i + 2] * d[i + 2];
+        partialSum[3] += g[i + 3] * d[i + 3];
+      }
+      for (; i < size; i++)
+      {
+        partialSum[0] += g[i] * d[i];
+      }
+      sum[dim] += (partialSum[0] + partialSum[1]) + (partialSum[2] + partialSum[3]);
+    }
+  }
+
+  for (unsigned int dim = 0; dim < NDimensions; dim++)
+  {
+    opp[dim] += sum[dim];
+  }
+
+} // end AccumulateRadialContribution()
+
+
+/**
+ * ******************* AccumulateElasticContribution *******************
+ *
+ * With x the vector from the landmark to the point, and d the coefficients
+ * of the landmark, the contribution is G(x) d = a(r) d + b(r) x (x . d).
+ */
+
+template <class TScalarType, unsigned int NDimensions>
+template <class TKernelFunction>
+void
+KernelTransform2<TScalarType, NDimensions>::AccumulateElasticContribution(const InputPointType &  thisPoint,
+                                                                          const unsigned long     begin,
+                                                                          const unsigned long     end,
+                                                                          const TKernelFunction & kernelFunction,
+                                                                          OutputPointType &       opp) const
+{
+  const unsigned int  blockSize = 64;
+  const unsigned long numberOfLandmarks = this->m_LandmarkCoordinates.size() / NDimensions;
+  const TScalarType * coordinates = this->m_LandmarkCoordinates.data();
+  const TScalarType * coefficients = this->m_LandmarkCoefficients.data();
+
+  TScalarType x[NDimensions][blockSize];
+  TScalarType a[blockSize];
+  TScalarType b[blockSize];
+  TScalarType dot[blockSize];
+  TScalarType sum[NDimensions];
+  std::fill_n(sum, NDimensions, NumericTraits<TScalarType>::ZeroValue());
+
+  for (unsigned long first = begin; first < end; first += blockSize)
+  {
+    const unsigned int size = static_cast<unsigned int>(std::min<unsigned long>(blockSize, end - first));
+
+    /** Difference vectors, squared distances and x . d. */
+    std::fill_n(a, size, NumericTraits<TScalarType>::ZeroValue());
+    std::fill_n(dot, size, NumericTraits<TScalarType>::ZeroValue());
+    for (unsigned int dim = 0; dim < NDimensions; dim++)
+    {
+      const TScalarType * c = coordinates + dim * numberOfLandmarks + first;
+      const TScalarType * d = coefficients + dim * numberOfLandmarks + first;
+      const TScalarType   p = thisPoint[dim];
+      for (unsigned int i = 0; i < size; i++)
+      {
+        const TScalarType diff = p - c[i];
+        x[dim][i] = diff;
+        a[i] += diff * diff;
+        dot[i] += diff * d[i];
+      }
+    }
+
+    /** Kernel values. */
+    for (unsigned int i = 0; i < size; i++)
+    {
+      const TScalarType r2 = a[i];
+      kernelFunction(r2, a[i], b[i]);
+      b[i] *= dot[i];
+    }
+
+    /** Kernel weighted sum of the coefficients, in four independent partial sums. */
+    for (unsigned int dim = 0; dim < NDimensions; dim++)
+    {
+      const TScalarType * d = coefficients + dim * numberOfLandmarks + first;
+      const TScalarType * xd = x[dim];
+      TScalarType         partialSum[4] = { 0, 0, 0, 0 };
+      unsigned int        i = 0;
+      for (; i + 4 <= size; i += 4)
+      {
+        partialSum[0] += a[i] * d[i] + b[i] * xd[i];
+        partialSum[1] += a[i + 1] * d[i + 1] + b[i + 1] * xd[i + 1];
+        partialSum[2] += a[i + 2] * d[i + 2] + b[i + 2] * xd[i + 2];
+        partialSum[3] += a[i + 3] * d[i + 3] + b[i + 3] * xd[i + 3];
+      }
+      for (; i < size; i++)
+      {
+        partialSum[0] += a[i] * d[i] + b[i] * xd[i];
+      }
+      sum[dim] += (partialSum[0] + partialSum[1]) + (partialSum[2] + partialSum[3]);
+    }
+  }
+
+  for (unsigned int dim = 0; dim < NDimensions; dim++)
+  {
+    opp[dim] += sum[dim];
+  }
+
+} // end AccumulateElasticContribution()
+
+
+/**
+ * ******************* SetFarFieldTolerance *******************
+ */
+
+template <class TScalarType, unsigned int NDimensions>
+void
+KernelTransform2<TScalarType, NDimensions>::SetFarFieldTolerance(double tolerance)
+{
+  tolerance = tolerance > 0.0 ? tolerance : 0.0;
+  if (this->m_FarFieldTolerance != tolerance)
+  {
+    this->m_FarFieldTolerance = tolerance;
+    if (this->m_WMatrixComputed)
+    {
+      this->PrecomputeDeformationContribution();
+    }
+    this->Modified();
+  }
+
+} // end SetFarFieldTolerance()
+
+
 /**
  * ******************* ComputeD *******************
  */
@@ -250,7 +463,13 @@ KernelTransform2<TScalarType, NDimensions>::ComputeWMatrix(void)
   }
   this->ComputeY();
 
-  /** L matrix decomposition and solving for Y matrix. */
+  /** For kernels with a diagonal G the decoupled L matrix is decomposed,
+   * and solved for each dimension separately.
+   */
+  const bool          decoupled = this->m_FastComputationPossible;
+  const LMatrixType & lMatrix = decoupled ? this->m_DecoupledLMatrix : this->m_LMatrix;
+
+  /** L matrix decomposition. */
   if (this->m_MatrixInversionMethod == "SVD")
   {
     if (!this->m_LMatrixDecompositionComputed)
@@ -259,12 +478,9 @@ KernelTransform2<TScalarType, NDimensions>::ComputeWMatrix(void)
       {
         delete this->m_LMatrixDecompositionSVD;
       }
-      this->m_LMatrixDecompositionSVD = new SVDDecompositionType(this->m_LMatrix, 1e-8);
+      this->m_LMatrixDecompositionSVD = new SVDDecompositionType(lMatrix, 1e-8);
       this->m_LMatrixDecompositionComputed = true;
     }
-    this->m_WMatrix = this->m_LMatrixDecompositionSVD->solve(this->m_YMatrix);
-    // vnl_svd<TScalarType> svd( this->m_LMatrix, 1e-8 );
-    // this->m_WMatrix = svd.solve( this->m_YMatrix );
   }
   else if (this->m_MatrixInversionMethod == "QR")
   {
@@ -274,22 +490,49 @@ KernelTransform2<TScalarType, NDimensions>::ComputeWMatrix(void)
       {
         delete this->m_LMatrixDecompositionQR;
       }
-      this->m_LMatrixDecompositionQR = new QRDecompositionType(this->m_LMatrix);
+      this->m_LMatrixDecompositionQR = new QRDecompositionType(lMatrix);
       this->m_LMatrixDecompositionComputed = true;
     }
-    this->m_WMatrix = this->m_LMatrixDecompositionQR->solve(this->m_YMatrix);
-    //     vnl_qr<TScalarType> qr( this->m_LMatrix );
-    //     this->m_WMatrix = qr.solve( this->m_YMatrix );
   }
   else
   {
     itkExceptionMacro(<< "ERROR: invalid matrix inversion method (" << this->m_MatrixInversionMethod << ")");
   }
 
+  /** Solving for Y matrix. */
+  const bool useSVD = this->m_MatrixInversionMethod == "SVD";
+  if (!decoupled)
+  {
+    this->m_WMatrix = useSVD ? this->m_LMatrixDecompositionSVD->solve(this->m_YMatrix)
+                             : this->m_LMatrixDecompositionQR->solve(this->m_YMatrix);
+  }
+  else
+  {
+    const unsigned int      numberOfRows = lMatrix.rows();
+    vnl_vector<TScalarType> y(numberOfRows);
+    this->m_WMatrix.set_size(this->m_YMatrix.rows(), 1);
+    for (unsigned int dim = 0; dim < NDimensions; dim++)
+    {
+      for (unsigned int i = 0; i < numberOfRows; i++)
+      {
+        y[i] = this->m_YMatrix(i * NDimensions + dim, 0);
+      }
+      const vnl_vector<TScalarType> w =
+        useSVD ? this->m_LMatrixDecompositionSVD->solve(y) : this->m_LMatrixDecompositionQR->solve(y);
+      for (unsigned int i = 0; i < numberOfRows; i++)
+      {
+        this->m_WMatrix(i * NDimensions + dim, 0) = w[i];
+      }
+    }
+  }
+
   /** Reorganize W. */
   this->ReorganizeW();
   this->m_WMatrixComputed = true;
 
+  /** Prepare the evaluation of the transform. */
+  this->PrecomputeDeformationContribution();
+
 } // end ComputeWMatrix()
 
 
@@ -306,22 +549,48 @@ KernelTransform2<TScalarType, NDimensions>::ComputeLInverse(void)
     this->ComputeL();
   }
 
+  /** For kernels with a diagonal G only the decoupled L matrix is inverted. */
+  const bool          decoupled = this->m_FastComputationPossible;
+  const LMatrixType & lMatrix = decoupled ? this->m_DecoupledLMatrix : this->m_LMatrix;
+  LMatrixType         lMatrixInverse;
+
   if (this->m_MatrixInversionMethod == "SVD")
   {
     // this->m_LMatrixInverse = vnl_matrix_inverse<TScalarType>( this->m_LMatrix );
-    this->m_LMatrixInverse = vnl_svd<TScalarType>(this->m_LMatrix).inverse();
-    this->m_LInverseComputed = true;
+    lMatrixInverse = vnl_svd<TScalarType>(lMatrix).inverse();
   }
   else if (this->m_MatrixInversionMethod == "QR")
   {
-    this->m_LMatrixInverse = vnl_qr<TScalarType>(this->m_LMatrix).inverse();
-    this->m_LInverseComputed = true;
+    lMatrixInverse = vnl_qr<TScalarType>(lMatrix).inverse();
   }
   else
   {
     itkExceptionMacro(<< "ERROR: invalid matrix inversion method (" << this->m_MatrixInversionMethod << ")");
   }
 
+  if (!decoupled)
+  {
+    this->m_LMatrixInverse.swap(lMatrixInverse);
+  }
+  else
+  {
+    /** The inverse of L has the same block structure as L. */
+    const unsigned int numberOfRows = lMatrix.rows();
+    this->m_LMatrixInverse.set_size(this->m_LMatrix.rows(), this->m_LMatrix.cols());
+    this->m_LMatrixInverse.fill(0.0);
+    for (unsigned int i = 0; i < numberOfRows; i++)
+    {
+      for (unsigned int j = 0; j < numberOfRows; j++)
+      {
+        for (unsigned int dim = 0; dim < NDimensions; dim++)
+        {
+          this->m_LMatrixInverse(i * NDimensions + dim, j * NDimensions + dim) = lMatrixInverse(i, j);
+        }
+      }
+    }
+  }
+  this->m_LInverseComputed = true;
+
 } // end ComputeLInverse()
 
 
@@ -346,6 +615,20 @@ KernelTransform2<TScalarType, NDimensions>::ComputeL(void)
   this->m_LMatrix.update(this->m_PMatrix, 0, this->m_KMatrix.columns());
   this->m_LMatrix.update(this->m_PMatrix.transpose(), this->m_KMatrix.rows(), 0);
   this->m_LMatrix.update(O2, this->m_KMatrix.rows(), this->m_KMatrix.columns());
+
+  /** Extract the system of the first dimension, which equals that of the others. */
+  if (this->m_FastComputationPossible)
+  {
+    const unsigned int numberOfRows = numberOfLandmarks + NDimensions + 1;
+    this->m_DecoupledLMatrix.set_size(numberOfRows, numberOfRows);
+    for (unsigned int i = 0; i < numberOfRows; i++)
+    {
+      for (unsigned int j = 0; j < numberOfRows; j++)
+      {
+        this->m_DecoupledLMatrix(i, j) = this->m_LMatrix(i * NDimensions, j * NDimensions);
+      }
+    }
+  }
   this->m_LMatrixComputed = true;
   this->m_LMatrixDecompositionComputed = false;
 
@@ -895,11 +1178,14 @@ KernelTransform2<TScalarType, NDimensions>::PrintSelf(std::ostream & os, Indent
   os << indent << "FastComputationPossible: " << this->m_FastComputationPossible << std::endl;
   os << indent << "PoissonRatio: " << this->m_PoissonRatio << std::endl;
   os << indent << "MatrixInversionMethod: " << this->m_MatrixInversionMethod << std::endl;
+  os << indent << "FarFieldTolerance: " << this->m_FarFieldTolerance << std::endl;
 
   /** Just print the sizes of these matrices, not their contents. */
   os << indent << "LMatrix: " << this->m_LMatrix.rows() << " x " << this->m_LMatrix.cols() << std::endl;
   os << indent << "LMatrixInverse: " << this->m_LMatrixInverse.rows() << " x " << this->m_LMatrixInverse.cols()
      << std::endl;
+  os << indent << "DecoupledLMatrix: " << this->m_DecoupledLMatrix.rows() << " x " << this->m_DecoupledLMatrix.cols()
+     << std::endl;
   os << indent << "KMatrix: " << this->m_KMatrix.rows() << " x " << this->m_KMatrix.cols() << std::endl;
   os << indent << "PMatrix: " << this->m_PMatrix.rows() << " x " << this->m_PMatrix.cols() << std::endl;
   os << indent << "YMatrix: " << this->m_YMatrix.rows() << " x " << this->m_YMatrix.cols() << std::endl;
@@ -58,21 +58,14 @@ ThinPlateR2LogRSplineKernelTransform2<TScalarType, NDimensions>::ComputeDeformat
   const InputPointType & thisPoint,
   OutputPointType &      result) const
 {
-  const unsigned long numberOfLandmarks = this->m_SourceLandmarks->GetNumberOfPoints();
-
-  PointsIterator sp = this->m_SourceLandmarks->GetPoints()->Begin();
-
-  for (unsigned int lnd = 0; lnd < numberOfLandmarks; lnd++)
-  {
-    InputVectorType   position = thisPoint - sp->Value();
-    const TScalarType r = position.GetNorm();
-    const TScalarType R2logR = (r > 1e-8) ? r * r * std::log(r) : NumericTraits<TScalarType>::Zero;
-    for (unsigned int odim = 0; odim < NDimensions; odim++)
-    {
-      result[odim] += R2logR * this->m_DMatrix(odim, lnd);
-    }
-    ++sp;
-  }
+  /** r^2 log(r) = 0.5 r^2 log(r^2). */
+  const unsigned long numberOfLandmarks = this->m_LandmarkCoordinates.size() / NDimensions;
+  this->AccumulateRadialContribution(
+    thisPoint,
+    0,
+    numberOfLandmarks,
+    [](const TScalarType r2) { return (r2 > 1e-16) ? 0.5 * r2 * std::log(r2) : NumericTraits<TScalarType>::Zero; },
+    result);
 }
 
 
@@ -35,6 +35,7 @@
 #define itkThinPlateSplineKernelTransform2_h
 
 #include "itkKernelTransform2.h"
+#include <vector>
 
 namespace itk
 {
@@ -44,6 +45,14 @@ namespace itk
  * the IEEE TMI paper by Davis, Khotanzad, Flamig, and Harms,
  * Vol. 16 No. 3 June 1997
  *
+ * For many landmarks the deformation contribution can be approximated, see
+ * SetFarFieldTolerance(). The landmarks are then grouped in clusters on a regular
+ * grid. A cluster that is far enough from the transformed point is evaluated by a
+ * first order expansion of the kernel around its centroid, whose error is bounded by
+ * \f$ \sum_i |d_i| |p_i - c|^2 / (2 (|x - c| - R)) \f$, with R the cluster radius.
+ * The distance at which this bound is below the tolerance, divided by the number of
+ * clusters, is precomputed per cluster.
+ *
  * \ingroup Transforms
  */
 template <class TScalarType, // Data type for scalars (float or double)
@@ -116,6 +125,27 @@ protected:
   void
   ComputeDeformationContribution(const InputPointType & inputPoint, OutputPointType & result) const override;
 
+  /** Group the landmarks in clusters for the far-field approximation. */
+  void
+  PrecomputeDeformationContribution(void) override;
+
+  /** A cluster of landmarks, [m_Begin, m_End) in the contiguous landmark arrays.
+   * m_CoefficientSum is the sum of the coefficients d_i, m_FirstMoment(k, j) is the sum
+   * of d_ik (c_j - p_ij), with c the centroid. Beyond m_FarFieldSquaredDistance from
+   * the centroid the approximation is used.
+   */
+  struct FarFieldClusterType
+  {
+    unsigned long                                           m_Begin;
+    unsigned long                                           m_End;
+    InputPointType                                          m_Centroid;
+    vnl_vector_fixed<TScalarType, NDimensions>              m_CoefficientSum;
+    vnl_matrix_fixed<TScalarType, NDimensions, NDimensions> m_FirstMoment;
+    TScalarType                                             m_FarFieldSquaredDistance;
+  };
+
+  std::vector<FarFieldClusterType> m_FarFieldClusters;
+
 private:
   ThinPlateSplineKernelTransform2(const Self &) = delete;
   void
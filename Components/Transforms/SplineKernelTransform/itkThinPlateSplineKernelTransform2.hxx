@@ -35,6 +35,8 @@
 #define _itkThinPlateSplineKernelTransform2_hxx
 
 #include "itkThinPlateSplineKernelTransform2.h"
+#include <algorithm> // For max and min.
+#include <cmath>
 
 namespace itk
 {
@@ -65,24 +67,194 @@ ThinPlateSplineKernelTransform2<TScalarType, NDimensions>::ComputeDeformationCon
   const InputPointType & thisPoint,
   OutputPointType &      opp) const
 {
-  const unsigned long numberOfLandmarks = this->m_SourceLandmarks->GetNumberOfPoints();
-  PointsIterator      sp = this->m_SourceLandmarks->GetPoints()->Begin();
+  const auto radialFunction = [](const TScalarType r2) { return std::sqrt(r2); };
 
-  for (unsigned long lnd = 0; lnd < numberOfLandmarks; lnd++)
+  /** Exact evaluation. */
+  if (this->m_FarFieldClusters.empty())
   {
-    InputVectorType   position = thisPoint - sp->Value();
-    const TScalarType r = position.GetNorm();
+    const unsigned long numberOfLandmarks = this->m_LandmarkCoordinates.size() / NDimensions;
+    this->AccumulateRadialContribution(thisPoint, 0, numberOfLandmarks, radialFunction, opp);
+    return;
+  }
 
-    for (unsigned int odim = 0; odim < NDimensions; odim++)
+  /** Far-field approximation of the clusters far enough away, and exact evaluation of the others. */
+  for (const FarFieldClusterType & cluster : this->m_FarFieldClusters)
+  {
+    const InputVectorType x = thisPoint - cluster.m_Centroid;
+    const TScalarType     r2 = x.GetSquaredNorm();
+    if (r2 > cluster.m_FarFieldSquaredDistance)
     {
-      opp[odim] += r * this->m_DMatrix(odim, lnd);
+      /** First order expansion around the centroid: sum_i d_i ( r + x . (c - p_i) / r ). */
+      const TScalarType r = std::sqrt(r2);
+      for (unsigned int odim = 0; odim < NDimensions; odim++)
+      {
+        TScalarType moment = NumericTraits<TScalarType>::ZeroValue();
+        for (unsigned int dim = 0; dim < NDimensions; dim++)
+        {
+          moment += cluster.m_FirstMoment(odim, dim) * x[dim];
+        }
+        opp[odim] += r * cluster.m_CoefficientSum[odim] + moment / r;
+      }
+    }
+    else
+    {
+      this->AccumulateRadialContribution(thisPoint, cluster.m_Begin, cluster.m_End, radialFunction, opp);
     }
-    ++sp;
   }
 
 } // end ComputeDeformationContribution()
 
 
+/**
+ * ******************* PrecomputeDeformationContribution *******************
+ */
+
+template <class TScalarType, unsigned int NDimensions>
+void
+ThinPlateSplineKernelTransform2<TScalarType, NDimensions>::PrecomputeDeformationContribution(void)
+{
+  this->Superclass::PrecomputeDeformationContribution();
+  this->m_FarFieldClusters.clear();
+
+  /** The approximation only pays off for a sufficient number of landmarks. */
+  const double        landmarksPerCluster = 64.0;
+  const unsigned long numberOfLandmarks = this->m_LandmarkCoordinates.size() / NDimensions;
+  if (!(this->m_FarFieldTolerance > 0.0) || numberOfLandmarks < 4 * landmarksPerCluster)
+  {
+    return;
+  }
+
+  /** A regular grid over the bounding box of the landmarks. */
+  const unsigned int cellsPerDimension = std::max(
+    1u, static_cast<unsigned int>(std::pow(numberOfLandmarks / landmarksPerCluster, 1.0 / NDimensions)));
+  unsigned long numberOfCells = 1;
+  TScalarType   minimum[NDimensions];
+  TScalarType   cellSize[NDimensions];
+  for (unsigned int dim = 0; dim < NDimensions; dim++)
+  {
+    const auto range = std::minmax_element(this->m_LandmarkCoordinates.begin() + dim * numberOfLandmarks,
+                                           this->m_LandmarkCoordinates.begin() + (dim + 1) * numberOfLandmarks);
+    minimum[dim] = *range.first;
+    cellSize[dim] = (*range.second - *range.first) / cellsPerDimension;
+    if (!(cellSize[dim] > 0.0))
+    {
+      cellSize[dim] = 1.0;
+    }
+    numberOfCells *= cellsPerDimension;
+  }
+
+  /** Determine the cell of each landmark, and the first landmark of each cell. */
+  std::vector<unsigned long> cellOfLandmark(numberOfLandmarks);
+  std::vector<unsigned long> cellBegin(numberOfCells + 1, 0);
+  for (unsigned long lnd = 0; lnd < numberOfLandmarks; lnd++)
+  {
+    unsigned long cell = 0;
+    unsigned long stride = 1;
+    for (unsigned int dim = 0; dim < NDimensions; dim++)
+    {
+      const TScalarType  position = this->m_LandmarkCoordinates[dim * numberOfLandmarks + lnd] - minimum[dim];
+      const unsigned int cellIndex =
+        std::min(cellsPerDimension - 1, static_cast<unsigned int>(position / cellSize[dim]));
+      cell += cellIndex * stride;
+      stride *= cellsPerDimension;
+    }
+    cellOfLandmark[lnd] = cell;
+    ++cellBegin[cell + 1];
+  }
+  for (unsigned long cell = 0; cell < numberOfCells; cell++)
+  {
+    cellBegin[cell + 1] += cellBegin[cell];
+  }
+
+  /** Reorder the landmarks per cell. */
+  std::vector<TScalarType>   coordinates(this->m_LandmarkCoordinates.size());
+  std::vector<TScalarType>   coefficients(this->m_LandmarkCoefficients.size());
+  std::vector<unsigned long> nextPosition(cellBegin.begin(), cellBegin.end() - 1);
+  for (unsigned long lnd = 0; lnd < numberOfLandmarks; lnd++)
+  {
+    const unsigned long position = nextPosition[cellOfLandmark[lnd]]++;
+    for (unsigned int dim = 0; dim < NDimensions; dim++)
+    {
+      coordinates[dim * numberOfLandmarks + position] = this->m_LandmarkCoordinates[dim * numberOfLandmarks + lnd];
+      coefficients[dim * numberOfLandmarks + position] = this->m_LandmarkCoefficients[dim * numberOfLandmarks + lnd];
+    }
+  }
+  this->m_LandmarkCoordinates.swap(coordinates);
+  this->m_LandmarkCoefficients.swap(coefficients);
+
+  /** Compute the expansion of each cluster, and its radius and error bound numerator. */
+  std::vector<TScalarType> radii;
+  std::vector<TScalarType> errorNumerators;
+  for (unsigned long cell = 0; cell < numberOfCells; cell++)
+  {
+    FarFieldClusterType cluster;
+    cluster.m_Begin = cellBegin[cell];
+    cluster.m_End = cellBegin[cell + 1];
+    if (cluster.m_Begin == cluster.m_End)
+    {
+      continue;
+    }
+
+    cluster.m_Centroid.Fill(0.0);
+    for (unsigned long i = cluster.m_Begin; i < cluster.m_End; i++)
+    {
+      for (unsigned int dim = 0; dim < NDimensions; dim++)
+      {
+        cluster.m_Centroid[dim] += this->m_LandmarkCoordinates[dim * numberOfLandmarks + i];
+      }
+    }
+    for (unsigned int dim = 0; dim < NDimensions; dim++)
+    {
+      cluster.m_Centroid[dim] /= static_cast<TScalarType>(cluster.m_End - cluster.m_Begin);
+    }
+
+    cluster.m_CoefficientSum.fill(0.0);
+    cluster.m_FirstMoment.fill(0.0);
+    TScalarType radius = 0.0;
+    TScalarType errorNumerator = 0.0;
+    for (unsigned long i = cluster.m_Begin; i < cluster.m_End; i++)
+    {
+      TScalarType h[NDimensions];
+      TScalarType squaredDistance = 0.0;
+      TScalarType squaredCoefficient = 0.0;
+      for (unsigned int dim = 0; dim < NDimensions; dim++)
+      {
+        h[dim] = cluster.m_Centroid[dim] - this->m_LandmarkCoordinates[dim * numberOfLandmarks + i];
+        squaredDistance += h[dim] * h[dim];
+        const TScalarType d = this->m_LandmarkCoefficients[dim * numberOfLandmarks + i];
+        squaredCoefficient += d * d;
+      }
+      for (unsigned int odim = 0; odim < NDimensions; odim++)
+      {
+        const TScalarType d = this->m_LandmarkCoefficients[odim * numberOfLandmarks + i];
+        cluster.m_CoefficientSum[odim] += d;
+        for (unsigned int dim = 0; dim < NDimensions; dim++)
+        {
+          cluster.m_FirstMoment(odim, dim) += d * h[dim];
+        }
+      }
+      radius = std::max(radius, static_cast<TScalarType>(std::sqrt(squaredDistance)));
+      errorNumerator += std::sqrt(squaredCoefficient) * squaredDistance;
+    }
+
+    this->m_FarFieldClusters.push_back(cluster);
+    radii.push_back(radius);
+    errorNumerators.push_back(errorNumerator);
+  }
+
+  /** Distribute the tolerance over the clusters, and compute the distance
+   * beyond which the error bound of each cluster is below its share.
+   */
+  const double clusterTolerance = this->m_FarFieldTolerance / this->m_FarFieldClusters.size();
+  for (std::size_t c = 0; c < this->m_FarFieldClusters.size(); c++)
+  {
+    const double farFieldDistance = radii[c] + errorNumerators[c] / (2.0 * clusterTolerance);
+    this->m_FarFieldClusters[c].m_FarFieldSquaredDistance = farFieldDistance * farFieldDistance;
+  }
+
+} // end PrecomputeDeformationContribution()
+
+
 } // namespace itk
 
 #endif
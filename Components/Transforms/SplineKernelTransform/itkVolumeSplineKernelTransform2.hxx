@@ -60,21 +60,9 @@ void
 VolumeSplineKernelTransform2<TScalarType, NDimensions>::ComputeDeformationContribution(const InputPointType & thisPoint,
                                                                                        OutputPointType &      opp) const
 {
-  const unsigned long numberOfLandmarks = this->m_SourceLandmarks->GetNumberOfPoints();
-  PointsIterator      sp = this->m_SourceLandmarks->GetPoints()->Begin();
-
-  for (unsigned int lnd = 0; lnd < numberOfLandmarks; lnd++)
-  {
-    InputVectorType   position = thisPoint - sp->Value();
-    const TScalarType r = position.GetNorm();
-    const TScalarType r3 = r * r * r;
-
-    for (unsigned int odim = 0; odim < NDimensions; odim++)
-    {
-      opp[odim] += r3 * this->m_DMatrix(odim, lnd);
-    }
-    ++sp;
-  }
+  const unsigned long numberOfLandmarks = this->m_LandmarkCoordinates.size() / NDimensions;
+  this->AccumulateRadialContribution(
+    thisPoint, 0, numberOfLandmarks, [](const TScalarType r2) { return r2 * std::sqrt(r2); }, opp);
 
 } // end ComputeDeformationContribution()
 
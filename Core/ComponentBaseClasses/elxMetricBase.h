@@ -63,6 +63,40 @@ namespace elastix
  *    CheckNumberOfSamples. \n
  *    example: <tt>(RequiredRatioOfValidSamples 0.1)</tt> \n
  *    The default is 0.25.
+ * \parameter UseThreadPoolForMetrics: Whether the multi-threaded metric computations
+ *    run on a persistent pool of threads, which stay alive between iterations, instead
+ *    of creating and joining new threads in every iteration. Only relevant when
+ *    UseMultiThreadingForMetrics is true. Can be given for each resolution. \n
+ *    example: <tt>(UseThreadPoolForMetrics "true")</tt> \n
+ *    The default is "false".
+ * \parameter UseDynamicSampleScheduling: Whether the threads of the metric fetch small
+ *    chunks of samples on demand, instead of each processing one fixed block of samples.
+ *    This balances the load when some samples are much more expensive than others,
+ *    for example when many samples map outside the moving mask. Note that the summation
+ *    order, and thereby the last digits of the results, may then differ between runs.
+ *    Can be given for each resolution. \n
+ *    example: <tt>(UseDynamicSampleScheduling "true")</tt> \n
+ *    The default is "false".
+ * \parameter SampleChunkSize: The number of samples per chunk when UseDynamicSampleScheduling
+ *    is true. Can be given for each resolution. \n
+ *    example: <tt>(SampleChunkSize 256)</tt> \n
+ *    The default is 0, which means about eight chunks per thread.
+ * \parameter UsePrecomputedBSplineWeights: Whether the B-spline interpolation weights of the
+ *    samples are computed once per resolution, instead of in every iteration. This only has an
+ *    effect for a B-spline transform together with the "Full" or "Grid" image sampler, which
+ *    select the same samples in every iteration. The weights of at most 2^25 values are stored.
+ *    Can be given for each resolution. \n
+ *    example: <tt>(UsePrecomputedBSplineWeights "true")</tt> \n
+ *    The default is "false".
+ * \parameter UseSinglePrecisionThreadDerivatives: Whether the threads of the metric accumulate
+ *    their partial derivatives in single precision. This halves the memory used for them, and
+ *    speeds up their accumulation for transforms with many parameters, at the cost of accuracy:
+ *    the rounding errors add up with the number of samples per thread. Currently only supported
+ *    by the AdvancedMeanSquares metric, and only used when UseMultiThreadingForMetrics is true.
+ *    All other metrics ignore the option, and give a warning when it is set. Can be given for
+ *    each resolution. \n
+ *    example: <tt>(UseSinglePrecisionThreadDerivatives "true")</tt> \n
+ *    The default is "false".
  *
  * \ingroup Metrics
  * \ingroup ComponentBaseClasses
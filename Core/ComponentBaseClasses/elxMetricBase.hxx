@@ -168,6 +168,41 @@ MetricBase<TElastix>::BeforeEachResolutionBase(void)
       }
     }
 
+    /** Should the metric use the persistent thread pool? */
+    bool useThreadPool = false;
+    this->GetConfiguration()->ReadParameter(
+      useThreadPool, "UseThreadPoolForMetrics", this->GetComponentLabel(), level, 0);
+    thisAsAdvanced->SetUseThreadPool(useMultiThreading && useThreadPool);
+
+    /** Should the samples be handed out to the threads in small chunks on demand? */
+    bool useDynamicSampleScheduling = false;
+    this->GetConfiguration()->ReadParameter(
+      useDynamicSampleScheduling, "UseDynamicSampleScheduling", this->GetComponentLabel(), level, 0);
+    thisAsAdvanced->SetUseDynamicSampleScheduling(useDynamicSampleScheduling);
+
+    /** The number of samples per chunk; 0 means automatic. */
+    unsigned long sampleChunkSize = 0;
+    this->GetConfiguration()->ReadParameter(
+      sampleChunkSize, "SampleChunkSize", this->GetComponentLabel(), level, 0, false);
+    thisAsAdvanced->SetSampleChunkSize(sampleChunkSize);
+
+    /** Precompute the B-spline weights of the samples of a full or grid sampler. */
+    bool usePrecomputedBSplineWeights = false;
+    this->GetConfiguration()->ReadParameter(
+      usePrecomputedBSplineWeights, "UsePrecomputedBSplineWeights", this->GetComponentLabel(), level, 0);
+    thisAsAdvanced->SetUsePrecomputedBSplineWeights(usePrecomputedBSplineWeights);
+
+    /** Accumulate the per-thread derivatives in single precision. */
+    bool useSinglePrecisionThreadDerivatives = false;
+    this->GetConfiguration()->ReadParameter(
+      useSinglePrecisionThreadDerivatives, "UseSinglePrecisionThreadDerivatives", this->GetComponentLabel(), level, 0);
+    thisAsAdvanced->SetUseSinglePrecisionThreadDerivatives(useSinglePrecisionThreadDerivatives);
+    if (useSinglePrecisionThreadDerivatives && !thisAsAdvanced->GetSupportsSinglePrecisionThreadDerivatives())
+    {
+      xl::xout["warning"] << "WARNING: The UseSinglePrecisionThreadDerivatives option was set to \"true\", but "
+                          << this->GetComponentLabel() << " does not support it. The option is ignored." << std::endl;
+    }
+
   } // end advanced metric
 
 } // end BeforeEachResolutionBase()
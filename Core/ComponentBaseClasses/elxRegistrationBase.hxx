@@ -106,6 +106,34 @@ RegistrationBase<TElastix>::GenerateFixedMaskSpatialObject(const FixedMaskImageT
   {
     return fixedMaskSpatialObject;
   }
+
+  /** Reuse the spatial object of a previous registration, if there is a cache and the
+   * mask has not been modified since. The cache has an entry per level and fixed mask.
+   */
+  typename ElastixType::ObjectContainerType * const cache = this->GetElastix()->GetFixedMaskSpatialObjectCache();
+  const auto                                        masks = this->GetElastix()->GetFixedMaskContainer();
+  bool                                              useCache = false;
+  unsigned int                                      cacheIndex = 0;
+  if (cache != nullptr && masks != nullptr)
+  {
+    for (unsigned int i = 0; i < masks->Size(); ++i)
+    {
+      if (masks->ElementAt(i).GetPointer() == static_cast<const itk::DataObject *>(maskImage))
+      {
+        useCache = true;
+        cacheIndex = level * masks->Size() + i;
+        break;
+      }
+    }
+  }
+  if (useCache && cache->IndexExists(cacheIndex))
+  {
+    fixedMaskSpatialObject = dynamic_cast<FixedMaskSpatialObjectType *>(cache->ElementAt(cacheIndex).GetPointer());
+    if (fixedMaskSpatialObject && fixedMaskSpatialObject->GetMTime() > maskImage->GetMTime())
+    {
+      return fixedMaskSpatialObject;
+    }
+  }
   fixedMaskSpatialObject = FixedMaskSpatialObjectType::New();
 
   /** Just convert to spatial object if no erosion is needed. */
@@ -113,40 +141,47 @@ RegistrationBase<TElastix>::GenerateFixedMaskSpatialObject(const FixedMaskImageT
   {
     fixedMaskSpatialObject->SetImage(maskImage);
     fixedMaskSpatialObject->Update();
-    return fixedMaskSpatialObject;
   }
+  else
+  {
+    /** Erode, and convert to spatial object. */
+    FixedMaskErodeFilterPointer erosion = FixedMaskErodeFilterType::New();
+    erosion->SetInput(maskImage);
+    erosion->SetSchedule(pyramid->GetSchedule());
+    erosion->SetIsMovingMask(false);
+    erosion->SetResolutionLevel(level);
+
+    /** Set output of the erosion to fixedImageMaskAsImage. */
+    FixedMaskImagePointer erodedFixedMaskAsImage = erosion->GetOutput();
+
+    /** Do the erosion. */
+    try
+    {
+      erodedFixedMaskAsImage->Update();
+    }
+    catch (itk::ExceptionObject & excp)
+    {
+      /** Add information to the exception. */
+      excp.SetLocation("RegistrationBase - UpdateMasks()");
+      std::string err_str = excp.GetDescription();
+      err_str += "\nError while eroding the fixed mask.\n";
+      excp.SetDescription(err_str);
+      /** Pass the exception to an higher level. */
+      throw excp;
+    }
 
-  /** Erode, and convert to spatial object. */
-  FixedMaskErodeFilterPointer erosion = FixedMaskErodeFilterType::New();
-  erosion->SetInput(maskImage);
-  erosion->SetSchedule(pyramid->GetSchedule());
-  erosion->SetIsMovingMask(false);
-  erosion->SetResolutionLevel(level);
-
-  /** Set output of the erosion to fixedImageMaskAsImage. */
-  FixedMaskImagePointer erodedFixedMaskAsImage = erosion->GetOutput();
+    /** Release some memory. */
+    erodedFixedMaskAsImage->DisconnectPipeline();
 
-  /** Do the erosion. */
-  try
-  {
-    erodedFixedMaskAsImage->Update();
+    fixedMaskSpatialObject->SetImage(erodedFixedMaskAsImage);
+    fixedMaskSpatialObject->Update();
   }
-  catch (itk::ExceptionObject & excp)
+
+  /** Store the spatial object for a next registration. */
+  if (useCache)
   {
-    /** Add information to the exception. */
-    excp.SetLocation("RegistrationBase - UpdateMasks()");
-    std::string err_str = excp.GetDescription();
-    err_str += "\nError while eroding the fixed mask.\n";
-    excp.SetDescription(err_str);
-    /** Pass the exception to an higher level. */
-    throw excp;
+    cache->InsertElement(cacheIndex, fixedMaskSpatialObject.GetPointer());
   }
-
-  /** Release some memory. */
-  erodedFixedMaskAsImage->DisconnectPipeline();
-
-  fixedMaskSpatialObject->SetImage(erodedFixedMaskAsImage);
-  fixedMaskSpatialObject->Update();
   return fixedMaskSpatialObject;
 
 } // end GenerateFixedMaskSpatialObject()
@@ -64,6 +64,14 @@ namespace elastix
  *    of the written image is desired.\n
  *    example: <tt>(CompressResultImage "true")</tt> \n
  *    The default is "false".
+ * \parameter ResultImageMemoryBudget: the approximate maximum amount of memory, in megabytes,
+ *    used for the resampled image while it is written, and in transformix for the deformation
+ *    field and spatial Jacobian images. If an image is larger, it is computed and written
+ *    in slabs, which requires an image format that supports
+ *    streamed writing (for example mha, mhd, nrrd or nii, without compression). For other
+ *    formats the image is still written at once.\n
+ *    example: <tt>(ResultImageMemoryBudget 1024)</tt> \n
+ *    The default is 0, which means no limit: the image is resampled at once.
  *
  * \ingroup Resamplers
  * \ingroup ComponentBaseClasses
@@ -193,6 +201,13 @@ public:
   virtual void
   CreateItkResultImage(void);
 
+  /** Function to compute the number of slabs in which an image on the output grid of
+   * the resampler is computed and written, such that each slab fits in the
+   * ResultImageMemoryBudget. The argument is the memory needed per pixel, in bytes.
+   */
+  virtual unsigned int
+  ComputeNumberOfStreamDivisions(const double numberOfBytesPerPixel) const;
+
 protected:
   /** The constructor. */
   ResamplerBase();
@@ -24,6 +24,8 @@
 #include "itkChangeInformationImageFilter.h"
 #include "itkAdvancedRayCastInterpolateImageFunction.h"
 #include "itkTimeProbe.h"
+#include <algorithm>
+#include <cmath>
 
 namespace elastix
 {
@@ -307,21 +309,26 @@ ResamplerBase<TElastix>::ResampleAndWriteResultImage(const char * filename, cons
     progressObserver->SetEndString("%");
   }
 
-  /** Do the resampling. */
-  try
-  {
-    this->GetAsITKBaseType()->Update();
-  }
-  catch (itk::ExceptionObject & excp)
+  /** Do the resampling. When the result image is streamed, the writer
+   * drives the resampler slab by slab instead.
+   */
+  if (this->ComputeNumberOfStreamDivisions(2.0 * sizeof(OutputPixelType)) == 1)
   {
-    /** Add information to the exception. */
-    excp.SetLocation("ResamplerBase - WriteResultImage()");
-    std::string err_str = excp.GetDescription();
-    err_str += "\nError occurred while resampling the image.\n";
-    excp.SetDescription(err_str);
-
-    /** Pass the exception to an higher level. */
-    throw excp;
+    try
+    {
+      this->GetAsITKBaseType()->Update();
+    }
+    catch (itk::ExceptionObject & excp)
+    {
+      /** Add information to the exception. */
+      excp.SetLocation("ResamplerBase - WriteResultImage()");
+      std::string err_str = excp.GetDescription();
+      err_str += "\nError occurred while resampling the image.\n";
+      excp.SetDescription(err_str);
+
+      /** Pass the exception to an higher level. */
+      throw excp;
+    }
   }
 
   /** Perform the writing. */
@@ -397,6 +404,21 @@ ResamplerBase<TElastix>::WriteResultImage(OutputImageType * image, const char *
   writer->SetOutputComponentType(resultImagePixelType.c_str());
   writer->SetUseCompression(doCompression);
 
+  /** Possibly stream the image in slabs, to bound the memory usage. While writing,
+   * both the resampled slab and its copy in the result image pixel type may be in
+   * memory, so the output pixel is counted twice.
+   */
+  const unsigned int numberOfStreamDivisions = this->ComputeNumberOfStreamDivisions(2.0 * sizeof(OutputPixelType));
+  writer->SetNumberOfStreamDivisions(numberOfStreamDivisions);
+  if (numberOfStreamDivisions > 1)
+  {
+    elxout << "  The result image is resampled and written in " << numberOfStreamDivisions << " slabs." << std::endl;
+    if (doCompression)
+    {
+      elxout << "  WARNING: compressed images cannot be streamed; the image is written at once." << std::endl;
+    }
+  }
+
   /** Do the writing. */
   if (showProgress)
   {
@@ -421,6 +443,34 @@ ResamplerBase<TElastix>::WriteResultImage(OutputImageType * image, const char *
 } // end WriteResultImage()
 
 
+/**
+ * ******************* ComputeNumberOfStreamDivisions ********************
+ */
+
+template <class TElastix>
+unsigned int
+ResamplerBase<TElastix>::ComputeNumberOfStreamDivisions(const double numberOfBytesPerPixel) const
+{
+  /** Read the memory budget in megabytes; 0 means no limit. */
+  double memoryBudget = 0.0;
+  this->m_Configuration->ReadParameter(memoryBudget, "ResultImageMemoryBudget", 0, false);
+  if (memoryBudget <= 0.0)
+  {
+    return 1;
+  }
+
+  const SizeType size = this->GetAsITKBaseType()->GetSize();
+  const double   numberOfPixels = static_cast<double>(size.CalculateProductOfElements());
+  const double   imageSize = numberOfPixels * numberOfBytesPerPixel;
+  double         numberOfDivisions = std::ceil(imageSize / (memoryBudget * 1024.0 * 1024.0));
+
+  /** The image is split along its slowest dimension, so there cannot be more slabs than slices. */
+  numberOfDivisions = std::min(numberOfDivisions, static_cast<double>(size[ImageDimension - 1]));
+  return static_cast<unsigned int>(std::max(1.0, numberOfDivisions));
+
+} // end ComputeNumberOfStreamDivisions()
+
+
 /*
  * ******************* CreateItkResultImage ********************
  * \todo: avoid code duplication with WriteResultImage function
@@ -25,11 +25,13 @@
 #include "elxElastixBase.h"
 #include "itkAdvancedTransform.h"
 #include "itkAdvancedCombinationTransform.h"
+#include "itkTransformToDisplacementFieldFilter.h"
 #include "elxComponentDatabase.h"
 #include "elxProgressCommand.h"
 
 // ITK header files:
 #include <itkImage.h>
+#include <itkMultiThreaderBase.h>
 #include <itkOptimizerParameters.h>
 
 #include <memory> // For unique_ptr.
@@ -188,6 +190,8 @@ public:
   /** Typedef's for TransformPointsAllPoints. */
   typedef itk::Vector<float, FixedImageDimension>          VectorPixelType;
   typedef itk::Image<VectorPixelType, FixedImageDimension> DeformationFieldImageType;
+  typedef itk::TransformToDisplacementFieldFilter<DeformationFieldImageType, CoordRepType>
+    DeformationFieldGeneratorType;
 
   /** Typedefs needed for AutomaticScalesEstimation function */
   typedef typename RegistrationType::ITKBaseType      ITKRegistrationType;
@@ -351,6 +355,18 @@ private:
   void
   TransformPointsSomePointsVTK(const std::string filename) const;
 
+  /** Function to transform coordinates from fixed to moving image, given as binary file.
+   * This format is meant for large point sets, which are read and written without parsing,
+   * and transformed in parallel. The file consists of a 24 byte header: the 8 characters
+   * "ELXPTS\0\0", the version (1) and the dimension as 32-bit unsigned integers, and the
+   * number of points as a 64-bit unsigned integer. It is followed by the world coordinates
+   * of the points, as float32, x, y(, z) per point. All values are little endian.
+   * The transformed points are saved as outputpoints.bin, in the same format.
+   * An exception is thrown if the file cannot be read, or does not contain all points.
+   */
+  void
+  TransformPointsSomePointsBinary(const std::string filename) const;
+
   /** Deprecation note: The plan is to split all Compute* and TransformPoints* functions
    *  into Generate* and Write* functions, since that would facilitate a proper library
    *  interface. To keep everything functional during the transition period we need to
@@ -362,6 +378,9 @@ private:
   typename DeformationFieldImageType::Pointer
   GenerateDeformationFieldImage(void) const;
 
+  /** Function to write the deformation field. When it is the output of a pipeline that is
+   * not updated yet, it may be computed and written in slabs, see ResultImageMemoryBudget.
+   */
   void WriteDeformationFieldImage(typename DeformationFieldImageType::Pointer) const;
 
   /** Legacy function that calls GenerateDeformationFieldImage and WriteDeformationFieldImage. */
@@ -382,6 +401,15 @@ private:
 
   virtual ParameterMapType
   CreateDerivedTransformParametersMap(void) const = 0;
+
+  /** Function to create the generator of the deformation field on the output grid of the resampler. */
+  typename DeformationFieldGeneratorType::Pointer
+  CreateDeformationFieldGenerator(void) const;
+
+  /** Function to create the threader that transforms the input points, using the "-threads" command line argument. */
+  itk::MultiThreaderBase::Pointer
+  CreatePointsThreader(void) const;
+
   /** Member variables. */
   std::unique_ptr<ParametersType> m_TransformParametersPointer{};
   std::string                     m_TransformParametersFileName;
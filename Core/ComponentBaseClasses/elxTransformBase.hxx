@@ -39,8 +39,12 @@
 #include "itkMeshFileWriter.h"
 #include "itkTransformMeshFilter.h"
 #include "itkCommonEnums.h"
+#include "itkMultiThreaderBase.h"
+#include "itkByteSwapper.h"
 
 #include <cassert>
+#include <cstdint>
+#include <cstring>
 #include <fstream>
 #include <iomanip> // For setprecision.
 
@@ -765,6 +769,13 @@ TransformBase<TElastix>::TransformPoints(void) const
              << "specified in a VTK input point file." << std::endl;
       this->TransformPointsSomePointsVTK(def);
     }
+    else if (itksys::SystemTools::StringEndsWith(def.c_str(), ".bin") ||
+             itksys::SystemTools::StringEndsWith(def.c_str(), ".BIN"))
+    {
+      elxout << "  The transform is evaluated on some points, "
+             << "specified in a binary input point file." << std::endl;
+      this->TransformPointsSomePointsBinary(def);
+    }
     else
     {
       elxout << "  The transform is evaluated on some points, "
@@ -878,8 +889,7 @@ TransformBase<TElastix>::TransformPointsSomePoints(const std::string filename) c
   dummyImage->SetDirection(direction);
 
   /** Temp vars */
-  FixedImageContinuousIndexType  fixedcindex;
-  MovingImageContinuousIndexType movingcindex;
+  FixedImageContinuousIndexType fixedcindex;
 
   /** Also output moving image indices if a moving image was supplied. */
   bool                              alsoMovingIndices = false;
@@ -925,33 +935,42 @@ TransformBase<TElastix>::TransformPointsSomePoints(const std::string filename) c
     }
   }
 
-  /** Apply the transform. */
+  /** Apply the transform. The points are independent, so they are transformed in parallel. */
   elxout << "  The input points are transformed." << std::endl;
-  for (unsigned int j = 0; j < nrofpoints; j++)
-  {
-    /** Call TransformPoint. */
-    outputpointvec[j] = this->GetAsITKBaseType()->TransformPoint(inputpointvec[j]);
-
-    /** Transform back to index in fixed image domain. */
-    dummyImage->TransformPhysicalPointToContinuousIndex(outputpointvec[j], fixedcindex);
-    for (unsigned int i = 0; i < FixedImageDimension; i++)
-    {
-      outputindexfixedvec[j][i] = static_cast<FixedImageIndexValueType>(itk::Math::Round<double>(fixedcindex[i]));
-    }
+  const ITKBaseType *                   transform = this->GetAsITKBaseType();
+  const itk::MultiThreaderBase::Pointer multiThreader = this->CreatePointsThreader();
+  multiThreader->ParallelizeArray(
+    0,
+    nrofpoints,
+    [&](const itk::SizeValueType j) {
+      /** Call TransformPoint. */
+      outputpointvec[j] = transform->TransformPoint(inputpointvec[j]);
+
+      /** Transform back to index in fixed image domain. */
+      FixedImageContinuousIndexType outputfixedcindex;
+      dummyImage->TransformPhysicalPointToContinuousIndex(outputpointvec[j], outputfixedcindex);
+      for (unsigned int i = 0; i < FixedImageDimension; i++)
+      {
+        outputindexfixedvec[j][i] =
+          static_cast<FixedImageIndexValueType>(itk::Math::Round<double>(outputfixedcindex[i]));
+      }
 
-    if (alsoMovingIndices)
-    {
-      /** Transform back to index in moving image domain. */
-      movingImage->TransformPhysicalPointToContinuousIndex(outputpointvec[j], movingcindex);
-      for (unsigned int i = 0; i < MovingImageDimension; i++)
+      if (alsoMovingIndices)
       {
-        outputindexmovingvec[j][i] = static_cast<MovingImageIndexValueType>(itk::Math::Round<double>(movingcindex[i]));
+        /** Transform back to index in moving image domain. */
+        MovingImageContinuousIndexType movingcindex;
+        movingImage->TransformPhysicalPointToContinuousIndex(outputpointvec[j], movingcindex);
+        for (unsigned int i = 0; i < MovingImageDimension; i++)
+        {
+          outputindexmovingvec[j][i] =
+            static_cast<MovingImageIndexValueType>(itk::Math::Round<double>(movingcindex[i]));
+        }
       }
-    }
 
-    /** Compute displacement. */
-    deformationvec[j].CastFrom(outputpointvec[j] - inputpointvec[j]);
-  }
+      /** Compute displacement. */
+      deformationvec[j].CastFrom(outputpointvec[j] - inputpointvec[j]);
+    },
+    nullptr);
 
   /** Create filename and file stream. */
   std::string outputPointsFileName = this->m_Configuration->GetCommandLineArgument("-out");
@@ -1014,6 +1033,154 @@ TransformBase<TElastix>::TransformPointsSomePoints(const std::string filename) c
 } // end TransformPointsSomePoints()
 
 
+/**
+ * ************** TransformPointsSomePointsBinary *********************
+ *
+ * This function reads points from a binary file and transforms
+ * these fixed-image coordinates to moving-image coordinates.
+ *
+ * Reads the input points in world coordinates, transforms them in
+ * parallel, and saves the transformed points as outputpoints.bin,
+ * in the same format. See the header file for the format.
+ */
+
+template <class TElastix>
+void
+TransformBase<TElastix>::TransformPointsSomePointsBinary(const std::string filename) const
+{
+  /** The header: magic, version, dimension, number of points. */
+  const char          magic[8] = { 'E', 'L', 'X', 'P', 'T', 'S', '\0', '\0' };
+  const std::uint32_t version = 1;
+
+  /** Open the file and determine its size. */
+  elxout << "  Reading input point file: " << filename << std::endl;
+  std::ifstream inputPointsFile(filename, std::ios::binary | std::ios::ate);
+  if (!inputPointsFile.is_open())
+  {
+    itkExceptionMacro(<< "ERROR: could not open the binary input point file " << filename << ".");
+  }
+  const std::streamoff fileSize = inputPointsFile.tellg();
+  inputPointsFile.seekg(0, std::ios::beg);
+
+  /** Read and check the header. */
+  char          fileMagic[8] = {};
+  std::uint32_t fileVersion = 0;
+  std::uint32_t fileDimension = 0;
+  std::uint64_t nrofpoints = 0;
+  inputPointsFile.read(fileMagic, sizeof(fileMagic));
+  inputPointsFile.read(reinterpret_cast<char *>(&fileVersion), sizeof(fileVersion));
+  inputPointsFile.read(reinterpret_cast<char *>(&fileDimension), sizeof(fileDimension));
+  inputPointsFile.read(reinterpret_cast<char *>(&nrofpoints), sizeof(nrofpoints));
+  if (!inputPointsFile)
+  {
+    itkExceptionMacro(<< "ERROR: could not read the header of the binary input point file " << filename << ".");
+  }
+  itk::ByteSwapper<std::uint32_t>::SwapFromSystemToLittleEndian(&fileVersion);
+  itk::ByteSwapper<std::uint32_t>::SwapFromSystemToLittleEndian(&fileDimension);
+  itk::ByteSwapper<std::uint64_t>::SwapFromSystemToLittleEndian(&nrofpoints);
+  if (std::memcmp(fileMagic, magic, sizeof(magic)) != 0 || fileVersion != version)
+  {
+    itkExceptionMacro(<< "ERROR: the file " << filename << " is not a binary point file of version " << version
+                      << ".");
+  }
+  if (fileDimension != FixedImageDimension)
+  {
+    itkExceptionMacro(<< "ERROR: the points in " << filename << " have dimension " << fileDimension
+                      << ", while the fixed image has dimension " << FixedImageDimension << ".");
+  }
+
+  /** Check the number of points against the file size, before allocating memory for them. */
+  const std::uint64_t headerSize = sizeof(magic) + 2 * sizeof(std::uint32_t) + sizeof(std::uint64_t);
+  const std::uint64_t pointSize = FixedImageDimension * sizeof(float);
+  const std::uint64_t dataSize = static_cast<std::uint64_t>(fileSize) - headerSize;
+  if (nrofpoints > dataSize / pointSize)
+  {
+    itkExceptionMacro(<< "ERROR: the binary input point file " << filename << " is truncated: it should contain "
+                      << nrofpoints << " points, but it has room for " << dataSize / pointSize << " points only.");
+  }
+
+  /** Read the coordinates, as little endian float32. */
+  elxout << "  Input points are specified in world coordinates." << std::endl;
+  elxout << "  Number of specified input points: " << nrofpoints << std::endl;
+  const std::size_t  numberOfCoordinates = static_cast<std::size_t>(nrofpoints) * FixedImageDimension;
+  std::vector<float> coordinates(numberOfCoordinates);
+  inputPointsFile.read(reinterpret_cast<char *>(coordinates.data()), numberOfCoordinates * sizeof(float));
+  if (!inputPointsFile)
+  {
+    itkExceptionMacro(<< "ERROR: could not read the points from the binary input point file " << filename << ".");
+  }
+  itk::ByteSwapper<float>::SwapRangeFromSystemToLittleEndian(coordinates.data(), numberOfCoordinates);
+
+  /** Apply the transform, in place and in parallel. */
+  elxout << "  The input points are transformed." << std::endl;
+  const ITKBaseType *                   transform = this->GetAsITKBaseType();
+  const itk::MultiThreaderBase::Pointer multiThreader = this->CreatePointsThreader();
+  multiThreader->ParallelizeArray(
+    0,
+    static_cast<itk::SizeValueType>(nrofpoints),
+    [&](const itk::SizeValueType j) {
+      float *        coordinate = &coordinates[j * FixedImageDimension];
+      InputPointType inputPoint;
+      for (unsigned int i = 0; i < FixedImageDimension; i++)
+      {
+        inputPoint[i] = coordinate[i];
+      }
+      const OutputPointType outputPoint = transform->TransformPoint(inputPoint);
+      for (unsigned int i = 0; i < FixedImageDimension; i++)
+      {
+        coordinate[i] = static_cast<float>(outputPoint[i]);
+      }
+    },
+    nullptr);
+
+  /** Write the transformed points in the same format. */
+  std::string outputPointsFileName = this->m_Configuration->GetCommandLineArgument("-out");
+  outputPointsFileName += "outputpoints.bin";
+  elxout << "  The transformed points are saved in: " << outputPointsFileName << std::endl;
+  std::uint32_t outputVersion = version;
+  std::uint32_t outputDimension = FixedImageDimension;
+  std::uint64_t outputNumberOfPoints = nrofpoints;
+  itk::ByteSwapper<std::uint32_t>::SwapFromSystemToLittleEndian(&outputVersion);
+  itk::ByteSwapper<std::uint32_t>::SwapFromSystemToLittleEndian(&outputDimension);
+  itk::ByteSwapper<std::uint64_t>::SwapFromSystemToLittleEndian(&outputNumberOfPoints);
+  itk::ByteSwapper<float>::SwapRangeFromSystemToLittleEndian(coordinates.data(), numberOfCoordinates);
+
+  std::ofstream outputPointsFile(outputPointsFileName, std::ios::binary);
+  outputPointsFile.write(magic, sizeof(magic));
+  outputPointsFile.write(reinterpret_cast<const char *>(&outputVersion), sizeof(outputVersion));
+  outputPointsFile.write(reinterpret_cast<const char *>(&outputDimension), sizeof(outputDimension));
+  outputPointsFile.write(reinterpret_cast<const char *>(&outputNumberOfPoints), sizeof(outputNumberOfPoints));
+  outputPointsFile.write(reinterpret_cast<const char *>(coordinates.data()), numberOfCoordinates * sizeof(float));
+  if (!outputPointsFile)
+  {
+    itkExceptionMacro(<< "ERROR: could not write the transformed points to " << outputPointsFileName << ".");
+  }
+
+} // end TransformPointsSomePointsBinary()
+
+
+/**
+ * ************** CreatePointsThreader *********************
+ */
+
+template <class TElastix>
+itk::MultiThreaderBase::Pointer
+TransformBase<TElastix>::CreatePointsThreader(void) const
+{
+  /** Use the number of threads from the command line, like the metrics do. */
+  const auto  multiThreader = itk::MultiThreaderBase::New();
+  std::string tmp = this->m_Configuration->GetCommandLineArgument("-threads");
+  if (tmp != "")
+  {
+    const unsigned int nrOfThreads = atoi(tmp.c_str());
+    multiThreader->SetMaximumNumberOfThreads(nrOfThreads);
+    multiThreader->SetNumberOfWorkUnits(nrOfThreads);
+  }
+  return multiThreader;
+
+} // end CreatePointsThreader()
+
+
 /**
  * ************** TransformPointsSomePointsVTK *********************
  *
@@ -1105,18 +1272,58 @@ template <class TElastix>
 void
 TransformBase<TElastix>::TransformPointsAllPoints(void) const
 {
-  typename DeformationFieldImageType::Pointer deformationfield = this->GenerateDeformationFieldImage();
-  // put deformation field in container
-  this->m_Elastix->SetResultDeformationField(deformationfield.GetPointer());
-
-  if (!BaseComponent::IsElastixLibrary())
+  if (BaseComponent::IsElastixLibrary())
   {
-    WriteDeformationFieldImage(deformationfield);
+    // put deformation field in container
+    this->m_Elastix->SetResultDeformationField(this->GenerateDeformationFieldImage().GetPointer());
+    return;
   }
 
+  /** Let the writer drive the pipeline, such that the deformation field
+   * is possibly computed and written in slabs, instead of as a whole.
+   */
+  typedef itk::ChangeInformationImageFilter<DeformationFieldImageType> ChangeInfoFilterType;
+  typedef typename FixedImageType::DirectionType                       FixedImageDirectionType;
+
+  const auto defGenerator = this->CreateDeformationFieldGenerator();
+
+  /** Possibly change direction cosines to their original value. */
+  const auto              infoChanger = ChangeInfoFilterType::New();
+  FixedImageDirectionType originalDirection;
+  bool                    retdc = this->GetElastix()->GetOriginalFixedImageDirection(originalDirection);
+  infoChanger->SetOutputDirection(originalDirection);
+  infoChanger->SetChangeDirection(retdc & !this->GetElastix()->GetUseDirectionCosines());
+  infoChanger->SetInput(defGenerator->GetOutput());
+
+  /** Track the progress of the generation of the deformation field. */
+  const auto progressObserver = ProgressCommandType::CreateAndConnect(*defGenerator);
+
+  this->WriteDeformationFieldImage(infoChanger->GetOutput());
+
 } // end TransformPointsAllPoints()
 
 
+/**
+ * ************** CreateDeformationFieldGenerator **********************
+ */
+
+template <class TElastix>
+typename TransformBase<TElastix>::DeformationFieldGeneratorType::Pointer
+TransformBase<TElastix>::CreateDeformationFieldGenerator(void) const
+{
+  const auto defGenerator = DeformationFieldGeneratorType::New();
+  defGenerator->SetSize(this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetSize());
+  defGenerator->SetOutputSpacing(this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetOutputSpacing());
+  defGenerator->SetOutputOrigin(this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetOutputOrigin());
+  defGenerator->SetOutputStartIndex(this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetOutputStartIndex());
+  defGenerator->SetOutputDirection(this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetOutputDirection());
+  defGenerator->SetTransform(const_cast<const ITKBaseType *>(this->GetAsITKBaseType()));
+
+  return defGenerator;
+
+} // end CreateDeformationFieldGenerator()
+
+
 /**
  * ************** GenerateDeformationFieldImage **********************
  *
@@ -1130,19 +1337,11 @@ typename TransformBase<TElastix>::DeformationFieldImageType::Pointer
 TransformBase<TElastix>::GenerateDeformationFieldImage(void) const
 {
   /** Typedef's. */
-  typedef typename FixedImageType::DirectionType FixedImageDirectionType;
-  typedef itk::TransformToDisplacementFieldFilter<DeformationFieldImageType, CoordRepType>
-                                                                       DeformationFieldGeneratorType;
+  typedef typename FixedImageType::DirectionType                       FixedImageDirectionType;
   typedef itk::ChangeInformationImageFilter<DeformationFieldImageType> ChangeInfoFilterType;
 
   /** Create an setup deformation field generator. */
-  const auto defGenerator = DeformationFieldGeneratorType::New();
-  defGenerator->SetSize(this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetSize());
-  defGenerator->SetOutputSpacing(this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetOutputSpacing());
-  defGenerator->SetOutputOrigin(this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetOutputOrigin());
-  defGenerator->SetOutputStartIndex(this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetOutputStartIndex());
-  defGenerator->SetOutputDirection(this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetOutputDirection());
-  defGenerator->SetTransform(const_cast<const ITKBaseType *>(this->GetAsITKBaseType()));
+  const auto defGenerator = this->CreateDeformationFieldGenerator();
 
   /** Possibly change direction cosines to their original value, as specified
    * in the tp-file, or by the fixed image. This is only necessary when
@@ -1199,6 +1398,8 @@ TransformBase<TElastix>::WriteDeformationFieldImage(
   const auto defWriter = DeformationFieldWriterType::New();
   defWriter->SetInput(deformationfield);
   defWriter->SetFileName(makeFileName.str().c_str());
+  defWriter->SetNumberOfStreamDivisions(
+    this->m_Elastix->GetElxResamplerBase()->ComputeNumberOfStreamDivisions(sizeof(VectorPixelType)));
 
   /** Do the writing. */
   elxout << "  Computing and writing the deformation field ..." << std::endl;
@@ -1288,6 +1489,8 @@ TransformBase<TElastix>::ComputeDeterminantOfSpatialJacobian(void) const
   const auto jacWriter = JacobianWriterType::New();
   jacWriter->SetInput(infoChanger->GetOutput());
   jacWriter->SetFileName(makeFileName.str().c_str());
+  jacWriter->SetNumberOfStreamDivisions(
+    this->m_Elastix->GetElxResamplerBase()->ComputeNumberOfStreamDivisions(sizeof(float)));
 
   /** Do the writing. */
   elxout << "  Computing and writing the spatial Jacobian determinant..." << std::endl;
@@ -1375,6 +1578,8 @@ TransformBase<TElastix>::ComputeSpatialJacobian(void) const
   const auto jacWriter = JacobianWriterType::New();
   jacWriter->SetInput(infoChanger->GetOutput());
   jacWriter->SetFileName(makeFileName.str().c_str());
+  jacWriter->SetNumberOfStreamDivisions(
+    this->m_Elastix->GetElxResamplerBase()->ComputeNumberOfStreamDivisions(sizeof(OutputSpatialJacobianType)));
   /** Hack to change the pixel type to vector. Not necessary for mhd. */
   const auto jacStartWriteCommand = PixelTypeChangeCommandType::New();
   if (resultImageFormat != "mhd")
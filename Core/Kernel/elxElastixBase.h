@@ -240,6 +240,14 @@ public:
   elxSetObjectMacro(FixedMaskContainer, DataObjectContainerType);
   elxSetObjectMacro(MovingMaskContainer, DataObjectContainerType);
 
+  /** Set/Get a cache for the fixed mask spatial objects, one per resolution and fixed mask.
+   * If set, the registration component reuses the spatial objects of a previous registration
+   * instead of converting (and eroding) the fixed masks again. Only set it when the fixed
+   * masks and the parameter map are the same as for that registration. Default: not set.
+   */
+  elxGetObjectMacro(FixedMaskSpatialObjectCache, ObjectContainerType);
+  elxSetObjectMacro(FixedMaskSpatialObjectCache, ObjectContainerType);
+
   /** Set/Get the result image container. */
   elxGetObjectMacro(ResultImageContainer, DataObjectContainerType);
   elxSetObjectMacro(ResultImageContainer, DataObjectContainerType);
@@ -522,6 +530,9 @@ private:
   DataObjectContainerPointer m_FixedMaskContainer;
   DataObjectContainerPointer m_MovingMaskContainer;
 
+  /** The cache of fixed mask spatial objects. */
+  ObjectContainerPointer m_FixedMaskSpatialObjectCache;
+
   /** The result image container. These are stored as pointers to itk::DataObject. */
   DataObjectContainerPointer m_ResultImageContainer;
 
@@ -363,13 +363,22 @@ ElastixMain::Run(void)
   this->GetElastixBase()->SetRegistrationContainer(
     this->CreateComponents("Registration", "MultiResolutionRegistration", errorCode));
 
-  this->GetElastixBase()->SetFixedImagePyramidContainer(
-    this->CreateComponents("FixedImagePyramid", "FixedSmoothingImagePyramid", errorCode));
+  /** The fixed image pyramids and image samplers may be reused from a previous run. */
+  if (this->m_FixedImagePyramidContainer.IsNull())
+  {
+    this->m_FixedImagePyramidContainer =
+      this->CreateComponents("FixedImagePyramid", "FixedSmoothingImagePyramid", errorCode);
+  }
+  this->GetElastixBase()->SetFixedImagePyramidContainer(this->m_FixedImagePyramidContainer);
 
   this->GetElastixBase()->SetMovingImagePyramidContainer(
     this->CreateComponents("MovingImagePyramid", "MovingSmoothingImagePyramid", errorCode));
 
-  this->GetElastixBase()->SetImageSamplerContainer(this->CreateComponents("ImageSampler", "", errorCode, false));
+  if (this->m_ImageSamplerContainer.IsNull())
+  {
+    this->m_ImageSamplerContainer = this->CreateComponents("ImageSampler", "", errorCode, false);
+  }
+  this->GetElastixBase()->SetImageSamplerContainer(this->m_ImageSamplerContainer);
 
   this->GetElastixBase()->SetInterpolatorContainer(
     this->CreateComponents("Interpolator", "BSplineInterpolator", errorCode));
@@ -401,6 +410,7 @@ ElastixMain::Run(void)
   this->GetElastixBase()->SetFixedMaskContainer(this->GetModifiableFixedMaskContainer());
   this->GetElastixBase()->SetMovingMaskContainer(this->GetModifiableMovingMaskContainer());
   this->GetElastixBase()->SetResultImageContainer(this->GetModifiableResultImageContainer());
+  this->GetElastixBase()->SetFixedMaskSpatialObjectCache(this->m_FixedMaskSpatialObjectCache);
 
   /** Set the initial transform, if it happens to be there. */
   this->GetElastixBase()->SetInitialTransform(this->GetModifiableInitialTransform());
@@ -209,6 +209,19 @@ public:
   itkSetObjectMacro(ResultDeformationFieldContainer, DataObjectContainerType);
   itkGetModifiableObjectMacro(ResultDeformationFieldContainer, DataObjectContainerType);
 
+  /** Set/Get the FixedImagePyramid and ImageSampler components of a previous Run() with the
+   * same fixed images, fixed masks and parameter map. If set, Run() uses them instead of
+   * creating new ones, so that their outputs, which only depend on the fixed side, are not
+   * recomputed by the ITK pipeline. After Run(), the getters return the components that
+   * were used. The cache of fixed mask spatial objects is passed on to ElastixBase.
+   */
+  itkSetObjectMacro(FixedImagePyramidContainer, ObjectContainerType);
+  itkSetObjectMacro(ImageSamplerContainer, ObjectContainerType);
+  itkSetObjectMacro(FixedMaskSpatialObjectCache, ObjectContainerType);
+  itkGetModifiableObjectMacro(FixedImagePyramidContainer, ObjectContainerType);
+  itkGetModifiableObjectMacro(ImageSamplerContainer, ObjectContainerType);
+  itkGetModifiableObjectMacro(FixedMaskSpatialObjectCache, ObjectContainerType);
+
   /** Set/Get the configuration object. */
   itkSetObjectMacro(Configuration, ConfigurationType);
   itkGetModifiableObjectMacro(Configuration, ConfigurationType);
@@ -349,6 +362,11 @@ protected:
   DataObjectContainerPointer m_ResultImageContainer;
   DataObjectContainerPointer m_ResultDeformationFieldContainer;
 
+  /** Components and data that may be reused from a previous Run(). */
+  ObjectContainerPointer m_FixedImagePyramidContainer;
+  ObjectContainerPointer m_ImageSamplerContainer;
+  ObjectContainerPointer m_FixedMaskSpatialObjectCache;
+
   /** A transform that is the result of registration. */
   ObjectPointer m_FinalTransform;
 
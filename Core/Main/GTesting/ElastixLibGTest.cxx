@@ -372,3 +372,47 @@ GTEST_TEST(ElastixLib, Translation3D)
   ASSERT_EQ(elastixObject.RegisterImages(fixedImage, movingImage, parameterMap, ".", false, false), 0);
   ExpectRoundedTransformParametersEqualOffset(elastixObject, translationOffset);
 }
+
+
+// Tests registering several moving images to the same fixed image, in one session.
+GTEST_TEST(ElastixLib, Translation3DSession)
+{
+  constexpr auto ImageDimension = 3;
+  using ImageType = itk::Image<float, ImageDimension>;
+
+  const auto parameterMap = CreateParameterMap<ImageDimension>({ { "ImageSampler", "Full" },
+                                                                 { "MaximumNumberOfIterations", "3" },
+                                                                 { "Metric", "AdvancedNormalizedCorrelation" },
+                                                                 { "Optimizer", "AdaptiveStochasticGradientDescent" },
+                                                                 { "Transform", "TranslationTransform" } });
+
+  const itk::Size<ImageDimension>  imageSize{ { 5, 7, 9 } };
+  const itk::Size<ImageDimension>  regionSize = itk::Size<ImageDimension>::Filled(2);
+  const itk::Index<ImageDimension> fixedImageRegionIndex{ { 1, 2, 3 } };
+
+  const auto fixedImage = ImageType::New();
+  fixedImage->SetRegions(imageSize);
+  fixedImage->Allocate(true);
+  FillImageRegion(*fixedImage, fixedImageRegionIndex, regionSize);
+
+  elastix::ELASTIX elastixObject;
+
+  ASSERT_EQ(elastixObject.RegisterMovingImage(fixedImage), -3);
+  ASSERT_EQ(elastixObject.StartSession(fixedImage, { parameterMap }, ".", false, false), 0);
+
+  for (const auto translationOffset : { itk::Offset<ImageDimension>{ { 1, 2, 3 } },
+                                        itk::Offset<ImageDimension>{ { 2, 1, 0 } },
+                                        itk::Offset<ImageDimension>{ { 1, 2, 3 } } })
+  {
+    const auto movingImage = ImageType::New();
+    movingImage->SetRegions(imageSize);
+    movingImage->Allocate(true);
+    FillImageRegion(*movingImage, fixedImageRegionIndex + translationOffset, regionSize);
+
+    ASSERT_EQ(elastixObject.RegisterMovingImage(movingImage), 0);
+    ExpectRoundedTransformParametersEqualOffset(elastixObject, translationOffset);
+  }
+
+  elastixObject.EndSession();
+  ASSERT_EQ(elastixObject.RegisterMovingImage(fixedImage), -3);
+}
@@ -47,6 +47,9 @@ namespace elastix
  */
 
 ELASTIX::ELASTIX()
+  : m_SessionStarted(false)
+  , m_SessionPerformLogging(false)
+  , m_SessionPerformCout(false)
 {
   assert(BaseComponent::IsElastixLibrary());
 }
@@ -136,6 +139,140 @@ ELASTIX::RegisterImages(ImagePointer                          fixedImage,
                         ImagePointer                          fixedMask,
                         ImagePointer                          movingMask,
                         ObjectPointer                         transform)
+{
+  return this->RegisterImagesImplementation(fixedImage,
+                                            movingImage,
+                                            parameterMaps,
+                                            outputPath,
+                                            performLogging,
+                                            performCout,
+                                            fixedMask,
+                                            movingMask,
+                                            transform,
+                                            false);
+
+} // end RegisterImages()
+
+
+/**
+ * ******************* StartSession ***********************
+ */
+
+int
+ELASTIX::StartSession(ImagePointer                          fixedImage,
+                      const std::vector<ParameterMapType> & parameterMaps,
+                      const std::string &                   outputPath,
+                      bool                                  performLogging,
+                      bool                                  performCout,
+                      ImagePointer                          fixedMask)
+{
+  this->EndSession();
+
+  /** Check if the output directory exists, as RegisterImages does. */
+  if (performLogging)
+  {
+    std::string outFolder = outputPath;
+    if (outFolder.find_last_of("/") != outFolder.size() - 1)
+    {
+      outFolder.append("/");
+    }
+    if (!itksys::SystemTools::FileIsDirectory(outFolder))
+    {
+      if (performCout)
+      {
+        std::cerr << "ERROR: the output directory does not exist." << std::endl;
+        std::cerr << "You are responsible for creating it." << std::endl;
+      }
+      return -2;
+    }
+  }
+
+  this->m_SessionFixedImage = fixedImage;
+  this->m_SessionFixedMask = fixedMask;
+  this->m_SessionParameterMaps = parameterMaps;
+  this->m_SessionOutputPath = outputPath;
+  this->m_SessionPerformLogging = performLogging;
+  this->m_SessionPerformCout = performCout;
+
+  /** The components are created by the first registration; the caches are filled by it. */
+  const auto nrOfParameterFiles = parameterMaps.size();
+  this->m_SessionFixedImagePyramids.assign(nrOfParameterFiles, nullptr);
+  this->m_SessionImageSamplers.assign(nrOfParameterFiles, nullptr);
+  this->m_SessionFixedMaskSpatialObjects.resize(nrOfParameterFiles);
+  for (auto & cache : this->m_SessionFixedMaskSpatialObjects)
+  {
+    cache = ElastixMain::ObjectContainerType::New();
+  }
+
+  this->m_SessionStarted = true;
+  return 0;
+
+} // end StartSession()
+
+
+/**
+ * ******************* RegisterMovingImage ***********************
+ */
+
+int
+ELASTIX::RegisterMovingImage(ImagePointer movingImage, ImagePointer movingMask, ObjectPointer transform)
+{
+  if (!this->m_SessionStarted)
+  {
+    if (this->m_SessionPerformCout)
+    {
+      std::cerr << "ERROR: RegisterMovingImage is called without StartSession." << std::endl;
+    }
+    return -3;
+  }
+
+  return this->RegisterImagesImplementation(this->m_SessionFixedImage,
+                                            movingImage,
+                                            this->m_SessionParameterMaps,
+                                            this->m_SessionOutputPath,
+                                            this->m_SessionPerformLogging,
+                                            this->m_SessionPerformCout,
+                                            this->m_SessionFixedMask,
+                                            movingMask,
+                                            transform,
+                                            true);
+
+} // end RegisterMovingImage()
+
+
+/**
+ * ******************* EndSession ***********************
+ */
+
+void
+ELASTIX::EndSession(void)
+{
+  this->m_SessionStarted = false;
+  this->m_SessionFixedImage = nullptr;
+  this->m_SessionFixedMask = nullptr;
+  this->m_SessionParameterMaps.clear();
+  this->m_SessionFixedImagePyramids.clear();
+  this->m_SessionImageSamplers.clear();
+  this->m_SessionFixedMaskSpatialObjects.clear();
+
+} // end EndSession()
+
+
+/**
+ * ******************* RegisterImagesImplementation ***********************
+ */
+
+int
+ELASTIX::RegisterImagesImplementation(ImagePointer                          fixedImage,
+                                      ImagePointer                          movingImage,
+                                      const std::vector<ParameterMapType> & parameterMaps,
+                                      const std::string &                   outputPath,
+                                      bool                                  performLogging,
+                                      bool                                  performCout,
+                                      ImagePointer                          fixedMask,
+                                      ImagePointer                          movingMask,
+                                      ObjectPointer                         transform,
+                                      bool                                  reuseSession)
 {
   /** Some typedef's. */
   typedef elx::ElastixMain                            ElastixMainType;
@@ -265,6 +402,14 @@ ELASTIX::RegisterImages(ImagePointer                          fixedImage,
     elastixMain->SetResultImageContainer(resultImageContainer);
     elastixMain->SetOriginalFixedImageDirectionFlat(fixedImageOriginalDirection);
 
+    /** Reuse the fixed side of the previous registration in this session. */
+    if (reuseSession)
+    {
+      elastixMain->SetFixedImagePyramidContainer(this->m_SessionFixedImagePyramids[i]);
+      elastixMain->SetImageSamplerContainer(this->m_SessionImageSamplers[i]);
+      elastixMain->SetFixedMaskSpatialObjectCache(this->m_SessionFixedMaskSpatialObjects[i]);
+    }
+
     /** Set the current elastix-level. */
     elastixMain->SetElastixLevel(i);
     elastixMain->SetTotalNumberOfElastixLevels(nrOfParameterFiles);
@@ -301,6 +446,13 @@ ELASTIX::RegisterImages(ImagePointer                          fixedImage,
     resultImageContainer = elastixMain->GetModifiableResultImageContainer();
     fixedImageOriginalDirection = elastixMain->GetOriginalFixedImageDirectionFlat();
 
+    /** Keep the fixed side components for the next registration in this session. */
+    if (reuseSession)
+    {
+      this->m_SessionFixedImagePyramids[i] = elastixMain->GetModifiableFixedImagePyramidContainer();
+      this->m_SessionImageSamplers[i] = elastixMain->GetModifiableImageSamplerContainer();
+    }
+
     /** Stop timer and print it. */
     timer.Stop();
     elxout << "\nCurrent time: " << GetCurrentDateAndTime() << "." << std::endl;
@@ -356,7 +508,7 @@ ELASTIX::RegisterImages(ImagePointer                          fixedImage,
   /** Exit and return the error code. */
   return 0;
 
-} // end RegisterImages()
+} // end RegisterImagesImplementation()
 
 
 } // end namespace elastix
@@ -50,7 +50,8 @@ public:
   typedef std::vector<itk::ParameterFileParser::ParameterMapType> ParameterMapListType;
 
   // typedefs for ObjectPointer
-  typedef elastix::ElastixMain::ObjectPointer ObjectPointer;
+  typedef elastix::ElastixMain::ObjectPointer          ObjectPointer;
+  typedef elastix::ElastixMain::ObjectContainerPointer ObjectContainerPointer;
 
   /**
    *  Constructor and destructor
@@ -104,6 +105,34 @@ public:
                  ImagePointer                          movingMask = nullptr,
                  ObjectPointer                         transform = nullptr);
 
+  /**
+   *  Reusable registration session, for registering many moving images to the same fixed image
+   *  Note:
+   *    - StartSession stores the fixed image, fixed mask, parameter maps and output settings
+   *      (see RegisterImages), and returns 0, or -2 if logging is requested but the output
+   *      folder does not exist.
+   *    - RegisterMovingImage then registers a moving image like RegisterImages does, but reuses
+   *      the fixed image pyramids, image samplers and fixed mask spatial objects of the previous
+   *      call, so that the ITK pipeline only recomputes the moving side. Samplers that select
+   *      new random samples still do so. Returns -3 if no session has been started.
+   *    - The fixed image, fixed mask and parameter maps must not be changed during the session.
+   *    - EndSession releases the stored data. A session is not thread-safe; use one ELASTIX
+   *      object per thread.
+   */
+  int
+  StartSession(ImagePointer                          fixedImage,
+               const std::vector<ParameterMapType> & parameterMaps,
+               const std::string &                   outputPath,
+               bool                                  performLogging,
+               bool                                  performCout,
+               ImagePointer                          fixedMask = nullptr);
+
+  int
+  RegisterMovingImage(ImagePointer movingImage, ImagePointer movingMask = nullptr, ObjectPointer transform = nullptr);
+
+  void
+  EndSession(void);
+
   /** Getter for result image. */
   ConstImagePointer
   GetResultImage(void) const;
@@ -121,11 +150,36 @@ public:
   GetTransformParameterMapList(void) const;
 
 private:
+  /* Implementation of RegisterImages; if reuseSession is true, the session data is used and updated */
+  int
+  RegisterImagesImplementation(ImagePointer                          fixedImage,
+                               ImagePointer                          movingImage,
+                               const std::vector<ParameterMapType> & parameterMaps,
+                               const std::string &                   outputPath,
+                               bool                                  performLogging,
+                               bool                                  performCout,
+                               ImagePointer                          fixedMask,
+                               ImagePointer                          movingMask,
+                               ObjectPointer                         transform,
+                               bool                                  reuseSession);
+
   /* the result images */
   ImagePointer m_ResultImage;
 
   /* Final transformation*/
   ParameterMapListType m_TransformParametersList;
+
+  /* The session data, with the reusable components per parameter map */
+  bool                                m_SessionStarted;
+  ImagePointer                        m_SessionFixedImage;
+  ImagePointer                        m_SessionFixedMask;
+  ParameterMapListType                m_SessionParameterMaps;
+  std::string                         m_SessionOutputPath;
+  bool                                m_SessionPerformLogging;
+  bool                                m_SessionPerformCout;
+  std::vector<ObjectContainerPointer> m_SessionFixedImagePyramids;
+  std::vector<ObjectContainerPointer> m_SessionImageSamplers;
+  std::vector<ObjectContainerPointer> m_SessionFixedMaskSpatialObjects;
 };
 
 // end class ELASTIX
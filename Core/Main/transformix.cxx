@@ -261,6 +261,8 @@ PrintHelp(void)
   std::cout << "  -in       input image to deform\n";
   std::cout << "  -def      file containing input-image points; the point are transformed\n"
             << "            according to the specified transform-parameter file\n";
+  std::cout << "            a \".bin\" file holds float32 points in a binary format, which are\n"
+            << "            transformed in parallel and saved as outputpoints.bin\n";
   std::cout << "            use \"-def all\" to transform all points from the input-image, which\n"
             << "            effectively generates a deformation field.\n";
   std::cout << "  -jac      use \"-jac all\" to generate an image with the determinant of the\n"
@@ -0,0 +1,126 @@
+import sys
+import os
+import os.path
+import re
+import struct
+from optparse import OptionParser
+
+# The header of a binary point file: magic, version, dimension, number of points.
+magic = b"ELXPTS\0\0"
+version = 1
+
+#-------------------------------------------------------------------------------
+# Write the same grid of points as a binary and as a text input point file
+def writePoints( binaryFileName, textFileName, dimension ):
+    points = []
+    numberOfPointsPerDimension = 5
+    for i in range( numberOfPointsPerDimension ** dimension ):
+        point = []
+        for d in range( dimension ):
+            index = ( i // numberOfPointsPerDimension ** d ) % numberOfPointsPerDimension
+            # Multiples of 1/8 are exact in float32 and in the text file.
+            point.append( 10.125 + 20.25 * index + 0.375 * d )
+        points.append( point )
+
+    f = open( binaryFileName, "wb" )
+    f.write( magic )
+    f.write( struct.pack( "<IIQ", version, dimension, len( points ) ) )
+    for point in points:
+        f.write( struct.pack( "<" + "f" * dimension, *point ) )
+    f.close()
+
+    f = open( textFileName, "w" )
+    f.write( "point\n" + str( len( points ) ) + "\n" )
+    for point in points:
+        f.write( " ".join( repr( x ) for x in point ) + "\n" )
+    f.close()
+    return 0
+
+#-------------------------------------------------------------------------------
+# Read the points of a binary point file
+def readBinaryPoints( fileName ):
+    f = open( fileName, "rb" )
+    data = f.read()
+    f.close()
+    if len( data ) < 24 or data[ 0:8 ] != magic:
+        print( "ERROR: " + fileName + " is not a binary point file" )
+        return None
+    fileVersion, dimension, numberOfPoints = struct.unpack( "<IIQ", data[ 8:24 ] )
+    if fileVersion != version or len( data ) != 24 + 4 * dimension * numberOfPoints:
+        print( "ERROR: " + fileName + " has an unexpected version or size" )
+        return None
+    coordinates = struct.unpack( "<" + "f" * ( dimension * numberOfPoints ), data[ 24: ] )
+    return [ list( coordinates[ j * dimension:( j + 1 ) * dimension ] ) for j in range( numberOfPoints ) ]
+
+#-------------------------------------------------------------------------------
+# Read the output points of an outputpoints.txt file
+def readTextPoints( fileName ):
+    pattern = re.compile( r"OutputPoint = \[ ([^\]]*)\]" )
+    points = []
+    f = open( fileName )
+    for line in f:
+        match = pattern.search( line )
+        if match:
+            points.append( [ float( x ) for x in match.group( 1 ).split() ] )
+    f.close()
+    return points
+
+#-------------------------------------------------------------------------------
+# Compare the output points of the binary and the text point file
+def comparePoints( binaryFileName, textFileName, tolerance ):
+    for fileName in [ binaryFileName, textFileName ]:
+        if not os.path.exists( fileName ):
+            print( "ERROR: the file " + fileName + " does not exist" )
+            return 1
+
+    binaryPoints = readBinaryPoints( binaryFileName )
+    textPoints = readTextPoints( textFileName )
+    if binaryPoints == None:
+        return 1
+    if len( binaryPoints ) == 0 or len( binaryPoints ) != len( textPoints ):
+        print( "ERROR: the number of points differs: " + str( len( binaryPoints ) ) + " in the binary file and "
+            + str( len( textPoints ) ) + " in the text file" )
+        return 1
+
+    maximumDifference = 0.0
+    for binaryPoint, textPoint in zip( binaryPoints, textPoints ):
+        for b, t in zip( binaryPoint, textPoint ):
+            maximumDifference = max( maximumDifference, abs( b - t ) )
+    print( "Number of points: " + str( len( binaryPoints ) ) )
+    print( "Maximum difference: " + str( maximumDifference ) )
+    if maximumDifference > tolerance:
+        print( "ERROR: the maximum difference exceeds the tolerance " + str( tolerance ) )
+        return 1
+    return 0
+
+#-------------------------------------------------------------------------------
+# the main function
+def main():
+    # usage, parse parameters
+    usage = "usage: %prog [options] arg"
+    parser = OptionParser( usage )
+
+    # options to control files
+    parser.add_option( "-w", "--write", action="store_true", dest="write", default=False,
+        help="write the input point files, instead of comparing the output point files" )
+    parser.add_option( "-b", "--binary", dest="binary", help="binary point file" )
+    parser.add_option( "-t", "--text", dest="text", help="text point file" )
+    parser.add_option( "-d", "--dimension", dest="dimension", type="int", default=3, help="point dimension" )
+    parser.add_option( "-a", "--tolerance", dest="tolerance", type="float", default=1e-3,
+        help="absolute tolerance on the coordinates" )
+
+    (options, args) = parser.parse_args()
+
+    # Check if option -b and -t are given
+    if options.binary == None :
+        parser.error( "The option binary (-b) should be given" )
+    if options.text == None :
+        parser.error( "The option text (-t) should be given" )
+
+    if options.write:
+        return writePoints( options.binary, options.text, options.dimension )
+    return comparePoints( options.binary, options.text, options.tolerance )
+
+#-------------------------------------------------------------------------------
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,59 @@
+import sys
+import os
+import os.path
+import re
+from optparse import OptionParser
+
+#-------------------------------------------------------------------------------
+# Sum the time spent in all resolutions, as reported in elastix.log
+def getTotalResolutionTime( directory ):
+    fileName = os.path.join( directory, "elastix.log" )
+    if not os.path.exists( fileName ):
+        print( "ERROR: the file " + fileName + " does not exist" )
+        return -1.0
+
+    pattern = re.compile( r"Time spent in resolution \d+ .*: ([0-9.eE+-]+) s\." )
+    total = 0.0
+    f = open( fileName )
+    for line in f:
+        match = pattern.search( line )
+        if match:
+            total = total + float( match.group( 1 ) )
+    f.close()
+    return total
+
+#-------------------------------------------------------------------------------
+# the main function
+def main():
+    # usage, parse parameters
+    usage = "usage: %prog [options] arg"
+    parser = OptionParser( usage )
+
+    # options to control files
+    parser.add_option( "-d", "--directory", dest="directory", help="elastix output directory" )
+    parser.add_option( "-r", "--reference", dest="reference", help="elastix output directory of the reference run" )
+
+    (options, args) = parser.parse_args()
+
+    # Check if option -d and -r are given
+    if options.directory == None :
+        parser.error( "The option directory (-d) should be given" )
+    if options.reference == None :
+        parser.error( "The option reference (-r) should be given" )
+
+    testTime = getTotalResolutionTime( options.directory )
+    referenceTime = getTotalResolutionTime( options.reference )
+    if testTime < 0.0 or referenceTime < 0.0 :
+        return 1
+
+    # Report the timings, this is a benchmark and not a pass/fail criterion
+    print( "Reference run: " + "{0:.3f}".format( referenceTime ) + " s (" + options.reference + ")" )
+    print( "Test run:      " + "{0:.3f}".format( testTime ) + " s (" + options.directory + ")" )
+    if testTime > 0.0 :
+        print( "Speedup:       " + "{0:.3f}".format( referenceTime / testTime ) )
+
+    return 0
+
+#-------------------------------------------------------------------------------
+if __name__ == '__main__':
+    sys.exit(main())
@@ -21,6 +21,8 @@
 #include <algorithm>
 #include <iomanip>
 #include "itkNumericTraits.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include <cmath>
 
 // Report timings
 #include <ctime>
@@ -57,6 +59,11 @@ public:
   unsigned long                       m_NumberOfParameters;
   mutable std::vector<DerivativeType> m_ThreaderDerivatives;
 
+  /** Single precision per-thread derivatives, as used with UseSinglePrecisionThreadDerivatives. */
+  typedef itk::Array<float>                          SinglePrecisionDerivativeType;
+  mutable std::vector<SinglePrecisionDerivativeType> m_SinglePrecisionThreaderDerivatives;
+  bool                                               m_UseSinglePrecision;
+
   typedef itk::PlatformMultiThreader ThreaderType;
   typedef ThreaderType::WorkUnitInfo ThreadInfoType;
   ThreaderType::Pointer              m_Threader;
@@ -87,6 +94,7 @@ public:
     this->m_NumberOfThreads = this->m_Threader->GetNumberOfWorkUnits();
     this->m_UseOpenMP = false;
     this->m_UseMultiThreaded = false;
+    this->m_UseSinglePrecision = false;
     this->m_NormalSum = 3.1415926;
 
 #ifdef ELASTIX_USE_OPENMP
@@ -163,6 +171,23 @@ public:
     unsigned int       jmax = (threadID + 1) * subSize;
     jmax = (jmax > numPar) ? numPar : jmax;
 
+    /** Single precision per-thread derivatives are summed in double precision, and reset. */
+    if (temp->st_Metric->m_UseSinglePrecision)
+    {
+      for (unsigned int j = jmin; j < jmax; ++j)
+      {
+        double tmp = 0.0;
+        for (ThreadIdType i = 0; i < nrOfThreads; ++i)
+        {
+          float & threadDerivative = temp->st_Metric->m_SinglePrecisionThreaderDerivatives[i][j];
+          tmp += threadDerivative;
+          threadDerivative = 0.0f;
+        }
+        temp->st_DerivativePointer[j] = tmp / temp->st_NormalizationFactor;
+      }
+      return ITK_THREAD_RETURN_DEFAULT_VALUE;
+    }
+
     for (unsigned int j = jmin; j < jmax; ++j)
     {
       DerivativeValueType tmp = itk::NumericTraits<DerivativeValueType>::Zero;
@@ -227,12 +252,14 @@ main(int argc, char * argv[])
     derivative.Fill(0.0);
 
     metric->m_ThreaderDerivatives.resize(nrThreads);
+    metric->m_SinglePrecisionThreaderDerivatives.resize(nrThreads);
     metric->m_NumberOfParameters = arraySizes[s];
     for (ThreadIdType t = 0; t < nrThreads; ++t)
     {
       // Allocate
       metric->m_ThreaderDerivatives[t].SetSize(metric->m_NumberOfParameters);
       metric->m_ThreaderDerivatives[t].Fill(0);
+      metric->m_SinglePrecisionThreaderDerivatives[t].SetSize(metric->m_NumberOfParameters);
 
       for (unsigned int i = 0; i < arraySizes[s]; ++i)
       {
@@ -272,6 +299,22 @@ main(int argc, char * argv[])
       timeCollector.Stop("ITK (mt)");
     }
 
+    /** Time the ITK multi-threaded implementation with single precision per-thread derivatives.
+     * The arrays are refilled, because the accumulation resets them, like in the metrics.
+     */
+    metric->m_UseSinglePrecision = true;
+    for (unsigned int i = 0; i < rep; ++i)
+    {
+      for (ThreadIdType t = 0; t < nrThreads; ++t)
+      {
+        metric->m_SinglePrecisionThreaderDerivatives[t].Fill(2.1f);
+      }
+      timeCollector.Start("ITK (mt, float)");
+      metric->AccumulateDerivatives(derivative);
+      timeCollector.Stop("ITK (mt, float)");
+    }
+    metric->m_UseSinglePrecision = false;
+
     /** Time the OpenMP multi-threaded implementation. */
 #ifdef ELASTIX_USE_OPENMP
     metric->m_UseOpenMP = true;
@@ -302,6 +345,72 @@ main(int argc, char * argv[])
 
   } // end loop over array sizes
 
+  /** Accuracy of single precision per-thread derivatives: every thread adds a number of
+   * random per-sample contributions to each parameter, like the metrics do, in double and in
+   * single precision. The accumulated derivatives are compared to a long double reference.
+   */
+  std::cout << "Accuracy of single precision per-thread derivatives" << std::endl;
+  const unsigned int        numberOfParameters = 1000;
+  std::vector<unsigned int> contributionsPerThread = { 10, 100, 1000, 10000 };
+  for (const unsigned int contributions : contributionsPerThread)
+  {
+    metric->m_NumberOfParameters = numberOfParameters;
+    DerivativeType           derivative(numberOfParameters);
+    DerivativeType           singlePrecisionResult(numberOfParameters);
+    std::vector<long double> reference(numberOfParameters, 0.0L);
+
+    typedef itk::Statistics::MersenneTwisterRandomVariateGenerator RandomGeneratorType;
+    RandomGeneratorType::Pointer                                    random = RandomGeneratorType::New();
+    random->SetSeed(1);
+
+    for (ThreadIdType t = 0; t < nrThreads; ++t)
+    {
+      metric->m_ThreaderDerivatives[t].SetSize(numberOfParameters);
+      metric->m_ThreaderDerivatives[t].Fill(0.0);
+      metric->m_SinglePrecisionThreaderDerivatives[t].SetSize(numberOfParameters);
+      metric->m_SinglePrecisionThreaderDerivatives[t].Fill(0.0f);
+      for (unsigned int j = 0; j < numberOfParameters; ++j)
+      {
+        for (unsigned int c = 0; c < contributions; ++c)
+        {
+          const double contribution = random->GetNormalVariate(0.0, 1.0);
+          metric->m_ThreaderDerivatives[t][j] += contribution;
+          metric->m_SinglePrecisionThreaderDerivatives[t][j] += contribution;
+          reference[j] += contribution;
+        }
+      }
+    }
+
+    metric->m_UseMultiThreaded = true;
+    metric->m_UseOpenMP = false;
+    metric->AccumulateDerivatives(derivative);
+    metric->m_UseSinglePrecision = true;
+    metric->AccumulateDerivatives(singlePrecisionResult);
+    metric->m_UseSinglePrecision = false;
+
+    /** Report the relative error of the derivative vector, in the 2-norm. */
+    long double referenceNorm = 0.0L;
+    long double doubleError = 0.0L;
+    long double floatError = 0.0L;
+    for (unsigned int j = 0; j < numberOfParameters; ++j)
+    {
+      const long double ref = reference[j] / metric->m_NormalSum;
+      referenceNorm += ref * ref;
+      doubleError += (derivative[j] - ref) * (derivative[j] - ref);
+      floatError += (singlePrecisionResult[j] - ref) * (singlePrecisionResult[j] - ref);
+    }
+    std::cout << "  contributions per thread per parameter = " << contributions
+              << "  relative error double = " << std::scientific << std::sqrt(doubleError / referenceNorm)
+              << "  relative error float = " << std::sqrt(floatError / referenceNorm) << std::fixed << std::endl;
+
+    /** Single precision accumulation should still give a usable search direction. */
+    if (std::sqrt(floatError / referenceNorm) > 1e-3)
+    {
+      std::cerr << "ERROR: single precision per-thread derivatives are too inaccurate." << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
   return EXIT_SUCCESS;
 
 } // end main
@@ -16,12 +16,14 @@
  *
  *=========================================================================*/
 #include "itkAdvancedBSplineDeformableTransform.h"
+#include "itkRecursiveBSplineTransform.h"
 
 #include "itkImageRegionIterator.h"
 
 // Report timings
 #include "itkTimeProbe.h"
 
+#include <algorithm>
 #include <fstream>
 #include <iomanip>
 
@@ -299,6 +301,114 @@ main(int argc, char * argv[])
   std::cerr << "Time NEW = " << newTime << " " << timeProbeNEW.GetUnit() << std::endl;
   std::cerr << "Speedup factor = " << oldTime / newTime << std::endl;
 
+  /** Compare the scalar recursive implementation with the SIMD kernels,
+   * for TransformPoint(), GetJacobian() and EvaluateJacobianWithImageGradientProduct().
+   */
+  typedef itk::RecursiveBSplineTransform<CoordinateRepresentationType, Dimension, SplineOrder> RecursiveTransformType;
+
+  typedef RecursiveTransformType::JacobianType               JacobianType;
+  typedef RecursiveTransformType::DerivativeType             DerivativeType;
+  typedef RecursiveTransformType::NonZeroJacobianIndicesType NonZeroJacobianIndicesType;
+  typedef RecursiveTransformType::MovingImageGradientType    MovingImageGradientType;
+  typedef itk::RecursiveBSplineSIMDDispatch                  DispatchType;
+
+  RecursiveTransformType::Pointer recursiveTransform = RecursiveTransformType::New();
+  recursiveTransform->SetGridOrigin(gridOrigin);
+  recursiveTransform->SetGridSpacing(gridSpacing);
+  recursiveTransform->SetGridRegion(gridRegion);
+  recursiveTransform->SetGridDirection(gridDirection);
+  recursiveTransform->SetParameters(parameters);
+
+  const unsigned long        nnzji = recursiveTransform->GetNumberOfNonZeroJacobianIndices();
+  JacobianType               jacobian(Dimension, nnzji);
+  DerivativeType             imageJacobian(nnzji);
+  NonZeroJacobianIndicesType nzji(nnzji);
+  MovingImageGradientType    movingImageGradient;
+  movingImageGradient[0] = 29.43;
+  movingImageGradient[1] = 18.21;
+  movingImageGradient[2] = 1.7;
+
+  /** Results of the last iteration, to compare the instruction sets. */
+  OutputPointType outputPointScalar;
+  JacobianType    jacobianScalar;
+  DerivativeType  imageJacobianScalar;
+  double          scalarTime[3] = { 0.0, 0.0, 0.0 };
+
+  const DispatchType::InstructionSetType supported = DispatchType::GetSupportedInstructionSet();
+  bool                                   equal = true;
+  for (int is = DispatchType::Scalar; is <= supported; ++is)
+  {
+    const DispatchType::InstructionSetType instructionSet = static_cast<DispatchType::InstructionSetType>(is);
+    DispatchType::SetInstructionSet(instructionSet);
+    itk::TimeProbe timeProbeTP, timeProbeJ, timeProbeJGP;
+
+    /** Time TransformPoint(). */
+    timeProbeTP.Start();
+    for (unsigned int i = 0; i < N; ++i)
+    {
+      outputPoint = recursiveTransform->TransformPoint(inputPoint);
+      sum += outputPoint[0] + outputPoint[1] + outputPoint[2];
+    }
+    timeProbeTP.Stop();
+
+    /** Time GetJacobian(). */
+    timeProbeJ.Start();
+    for (unsigned int i = 0; i < N; ++i)
+    {
+      recursiveTransform->GetJacobian(inputPoint, jacobian, nzji);
+      sum += jacobian[0][0];
+    }
+    timeProbeJ.Stop();
+
+    /** Time EvaluateJacobianWithImageGradientProduct(). */
+    timeProbeJGP.Start();
+    for (unsigned int i = 0; i < N; ++i)
+    {
+      recursiveTransform->EvaluateJacobianWithImageGradientProduct(
+        inputPoint, movingImageGradient, imageJacobian, nzji);
+      sum += imageJacobian[0];
+    }
+    timeProbeJGP.Stop();
+
+    const double times[3] = { timeProbeTP.GetMean(), timeProbeJ.GetMean(), timeProbeJGP.GetMean() };
+    if (instructionSet == DispatchType::Scalar)
+    {
+      outputPointScalar = outputPoint;
+      jacobianScalar = jacobian;
+      imageJacobianScalar = imageJacobian;
+      std::copy(times, times + 3, scalarTime);
+    }
+    else
+    {
+      /** The summation order differs, so allow for small differences. */
+      const double diffTP = outputPoint.EuclideanDistanceTo(outputPointScalar);
+      const double diffJ = (jacobian - jacobianScalar).frobenius_norm();
+      const double diffJGP = (imageJacobian - imageJacobianScalar).two_norm();
+      if (diffTP > 1e-10 || diffJ > 1e-10 || diffJGP > 1e-10)
+      {
+        std::cerr << "ERROR: " << DispatchType::GetInstructionSetName(instructionSet)
+                  << " kernels differ from the scalar implementation: " << diffTP << " " << diffJ << " " << diffJGP
+                  << std::endl;
+        equal = false;
+      }
+    }
+
+    std::cerr << "Recursive B-spline, " << DispatchType::GetInstructionSetName(instructionSet) << ":" << std::endl;
+    std::cerr << "  TransformPoint = " << times[0] << " " << timeProbeTP.GetUnit()
+              << ", speedup = " << scalarTime[0] / times[0] << std::endl;
+    std::cerr << "  GetJacobian = " << times[1] << " " << timeProbeJ.GetUnit()
+              << ", speedup = " << scalarTime[1] / times[1] << std::endl;
+    std::cerr << "  EvaluateJacobianWithImageGradientProduct = " << times[2] << " " << timeProbeJGP.GetUnit()
+              << ", speedup = " << scalarTime[2] / times[2] << std::endl;
+  }
+  DispatchType::SetInstructionSet(supported);
+  std::cerr << sum << std::endl;
+
+  if (!equal)
+  {
+    return 1;
+  }
+
   /** Return a value. */
   return 0;
 